@@ -45,17 +45,6 @@ typedef struct ExternalInsertDescData
 
 typedef ExternalInsertDescData *ExternalInsertDesc;
 
-/*
- * ExternalSelectDescData is used for storing state related
- * to selecting data from an external table.
- */
-typedef struct ExternalSelectDescData
-{
-	ProjectionInfo *projInfo;   /* Information for column projection */
-	List *filter_quals;         /* Information for filter pushdown */
-
-} ExternalSelectDescData;
-
 /*
  * used for scan of external relations with the file protocol
  */
@@ -2,8 +2,22 @@
 
 bool hasHeader;
 
+bool isTextFormat;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+char textDelimiter = '\t';
+
+char textEscape = '\\';
+
+string textNullString = "\\N";
+
+vector<string> columnNames;
+
+vector<bool> columnReferenced;
+
+vector<ColumnPredicate> columnPredicates;
+
 string s3extErrorMessage;
 
 volatile sig_atomic_t QueryCancelPending = false;
@@ -142,6 +156,8 @@ static void printTemplate() {
         "secret = \"aws secret\"\n"
         "threadnum = 4\n"
         "chunksize = 67108864\n"
+        "splitsize = 1073741824\n"
+        "objectsize = 0\n"
         "low_speed_limit = 10240\n"
         "low_speed_time = 60\n"
         "encryption = true\n"
@@ -149,6 +165,7 @@ static void printTemplate() {
         "proxy = \"\"\n"
         "autocompress = true\n"
         "verifycert = true\n"
+        "keepalive = true\n"
         "server_side_encryption = \"\"\n"
         "# gpcheckcloud config\n"
         "gpcheckcloud_newline = \"\\n\"\n");
@@ -201,6 +218,9 @@ static bool downloadS3(const char *urlWithOptions) {
 
     thread_setup();
 
+    // print the rows of parquet keys as TEXT format
+    isTextFormat = true;
+
     GPReader *reader = reader_init(urlWithOptions);
     if (!reader) {
         return false;
@@ -223,6 +243,10 @@ static bool downloadS3(const char *urlWithOptions) {
 
     reader_cleanup(&reader);
 
+    // stdout has the data, the decompression throughput and connection reuse go to stderr
+    fprintf(stderr, "%s", GetDecompressStatsSummary().c_str());
+    fprintf(stderr, "connections: %s\n", GetConnectionStatsSummary().c_str());
+
     thread_cleanup();
 
     return ret;
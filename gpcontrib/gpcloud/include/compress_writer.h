@@ -1,6 +1,8 @@
 #ifndef INCLUDE_COMPRESS_WRITER_H_
 #define INCLUDE_COMPRESS_WRITER_H_
 
+#include <deque>
+
 #include "s3common_headers.h"
 #include "s3exception.h"
 #include "s3macros.h"
@@ -9,6 +11,12 @@
 // 2MB by default
 extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
+struct CompressBlock;
+
+// CompressWriter gzips data on worker threads, S3_ZIP_COMPRESS_CHUNKSIZE bytes at a
+// time. Each block is deflated with the end of the previous block as its dictionary
+// and ends on a byte boundary, so the blocks joined in order make a single gzip
+// member, just like compressing the data on one thread.
 class CompressWriter : public Writer {
    public:
     CompressWriter();
@@ -27,14 +35,28 @@ class CompressWriter : public Writer {
     void setWriter(Writer *writer);
 
    private:
-    void flush();
-    uint64_t writeOneChunk(const char *buf, uint64_t count);
+    // Hand the pending data to a worker thread as a new block.
+    void dispatchBlock();
+
+    // Wait for the oldest block, and write it to the writer.
+    void writeOldestBlock();
+
+    // Wait for all blocks without writing them, after an error.
+    void abandonBlocks();
+
+    void writeHeader();
 
     Writer *writer;
 
-    // zlib related variables.
-    z_stream zstream;
-    char *out;  // Output buffer for compression.
+    std::deque<CompressBlock *> blocks;  // blocks being compressed, in order
+    uint64_t maxBlocks;                  // how many blocks are compressed at a time
+
+    vector<char> pending;  // data for the next block
+    string dictionary;     // the end of the last block dispatched
+
+    bool headerWritten;
+    uLong crc;         // of all data written out
+    uint64_t dataLen;  // length of all data written out
 
     // add this flag to make close() reentrant
     bool isClosed;
@@ -1,6 +1,7 @@
 #ifndef INCLUDE_DECOMPRESS_READER_H_
 #define INCLUDE_DECOMPRESS_READER_H_
 
+#include "decompressor.h"
 #include "reader.h"
 #include "s3common_headers.h"
 #include "s3exception.h"
@@ -26,22 +27,32 @@ class DecompressReader : public Reader {
 
     void setReader(Reader *reader);
 
+    // GZIP by default, which decodes zlib streams as well.
+    void setCompressionType(S3CompressionType type) {
+        this->compressionType = type;
+    }
+
     void resizeDecompressReaderBuffer(uint64_t size);
 
    private:
     void decompress();
+    bool readCompressedData();
 
     uint64_t getDecompressedBytesNum() {
-        return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
+        return this->outLen;
     }
 
     Reader *reader;
 
-    // zlib related variables.
-    z_stream zstream;
+    S3CompressionType compressionType;
+    Decompressor *decompressor;
+
     char *in;            // Input buffer for decompression.
+    uint64_t inOffset;   // Next position to decompress in in buffer.
+    uint64_t inLen;      // Bytes left to decompress in in buffer.
     char *out;           // Output buffer for decompression.
     uint64_t outOffset;  // Next position to read in out buffer.
+    uint64_t outLen;     // Bytes decompressed to out buffer.
 
     bool isClosed;
 };
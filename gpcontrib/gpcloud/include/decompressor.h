@@ -0,0 +1,57 @@
+#ifndef INCLUDE_DECOMPRESSOR_H_
+#define INCLUDE_DECOMPRESSOR_H_
+
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+#include "s3macros.h"
+
+// Decompressor decodes one compressed format, a buffer at a time.
+class Decompressor {
+   public:
+    virtual ~Decompressor() {
+    }
+
+    // Decompress on up to this many threads, for formats that can. Called
+    // before init().
+    virtual void setParallelism(uint64_t threads) {
+    }
+
+    virtual void init() = 0;
+
+    // Decompress from [in, in + inLen) to [out, out + outLen), advancing both.
+    // Progress is made unless there is no input left, or no output room left.
+    // Throw exception if encounters errors.
+    virtual void decompress(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) = 0;
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void end() = 0;
+};
+
+// Return the compressed format whose magic number starts data, or
+// S3_COMPRESSION_PLAIN if none does.
+S3CompressionType DetectCompressionType(const uint8_t *data, uint64_t len);
+
+const char *GetCompressionName(S3CompressionType type);
+
+// Return NULL if the format is not supported by this build.
+Decompressor *CreateDecompressor(S3CompressionType type);
+
+struct DecompressStats {
+    DecompressStats() : inBytes(0), outBytes(0), usecs(0) {
+    }
+
+    uint64_t inBytes;
+    uint64_t outBytes;
+    uint64_t usecs;
+};
+
+DecompressStats &GetDecompressStats(S3CompressionType type);
+
+// One line per format used so far, with its throughput.
+string GetDecompressStatsSummary();
+
+// Decode a raw snappy block of exactly dstLen bytes.
+void SnappyRawDecompress(const uint8_t *src, uint64_t srcLen, uint8_t *dst, uint64_t dstLen);
+
+#endif /* INCLUDE_DECOMPRESSOR_H_ */
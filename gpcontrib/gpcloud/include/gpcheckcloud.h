@@ -1,6 +1,7 @@
 #ifndef __GP_CHECK_CLOUD_H__
 #define __GP_CHECK_CLOUD_H__
 
+#include "decompressor.h"
 #include "gpreader.h"
 #include "gpwriter.h"
 #include "s3common_headers.h"
@@ -10,6 +10,38 @@ extern bool S3QueryIsAbortInProgress(void);
 #define EOL_CHARS_MAX_LEN 2   // '\n', '\r', '\r\n'
 extern char eolString[];
 extern bool hasHeader;
+extern bool isTextFormat;
+
+// TEXT format options and the column names of the table, for keys that are
+// converted to rows, i.e. parquet files.
+extern char textDelimiter;  // '\0' for DELIMITER 'OFF'
+extern char textEscape;     // '\0' for ESCAPE 'OFF'
+extern string textNullString;
+extern vector<string> columnNames;
+
+// The columns of columnNames the scan references, empty when it may use all
+// of them. The others are returned as nulls, without reading them.
+extern vector<bool> columnReferenced;
+
+// A comparison of a column of columnNames with a constant, taken from the
+// quals of the scan. Every row returned has to pass it, so row groups whose
+// min/max statistics rule it out are skipped.
+enum ColumnPredicateOp { PREDICATE_LT, PREDICATE_LE, PREDICATE_EQ, PREDICATE_GE, PREDICATE_GT };
+enum ColumnPredicateKind {
+    PREDICATE_INTEGER,
+    PREDICATE_DATE,  // days since 1970-01-01
+    PREDICATE_STRING,
+};
+
+struct ColumnPredicate {
+    uint64_t column;
+    ColumnPredicateOp op;
+    ColumnPredicateKind kind;
+    int64_t intValue;
+    string stringValue;
+};
+
+extern vector<ColumnPredicate> columnPredicates;
 
 // TODO change to functions getgpsegmentId() and getgpsegmentCount()
 
@@ -36,6 +36,9 @@ class GPWriter : public Writer {
     string constructRandomStr();
     string genUniqueKeyName(const S3Url &s3Url);
 
+    // Finish the current key, and go on writing to a new one.
+    void rollToNewKey();
+
    protected:
     string format;
     S3Params params;
@@ -43,6 +46,9 @@ class GPWriter : public Writer {
     S3InterfaceService s3InterfaceService;
     S3CommonWriter commonWriter;
 
+    string basePrefix;       // the prefix the keys are named after
+    uint64_t keyDataLength;  // data written to the current key
+
     // it links to itself by default
     // but the pointer here leaves a chance to mock it in unit test
     S3RESTfulService *restfulServicePtr;
@@ -0,0 +1,157 @@
+#ifndef INCLUDE_PARQUET_READER_H_
+#define INCLUDE_PARQUET_READER_H_
+
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+
+#define PARQUET_FOOTER_LEN 8  // metadata length and magic
+
+// How the values of a leaf column are converted to text.
+enum ParquetValueKind {
+    PARQUET_BOOLEAN,
+    PARQUET_INT32,
+    PARQUET_UINT32,
+    PARQUET_INT64,
+    PARQUET_UINT64,
+    PARQUET_INT96_TIMESTAMP,
+    PARQUET_FLOAT,
+    PARQUET_DOUBLE,
+    PARQUET_STRING,
+    PARQUET_BYTES,
+    PARQUET_DECIMAL,
+    PARQUET_DATE,
+    PARQUET_TIME,
+    PARQUET_TIMESTAMP,
+    PARQUET_UUID,
+    PARQUET_UNSUPPORTED,  // nested or repeated column
+};
+
+struct ParquetColumnInfo {
+    ParquetColumnInfo()
+        : physicalType(-1),
+          typeLength(0),
+          kind(PARQUET_UNSUPPORTED),
+          scale(0),
+          unitsPerSecond(1000000),
+          adjustedToUTC(false),
+          optional(false) {
+    }
+
+    string name;  // dotted path of the column
+    int32_t physicalType;
+    int32_t typeLength;  // of FIXED_LEN_BYTE_ARRAY
+    ParquetValueKind kind;
+    int32_t scale;           // of DECIMAL
+    int64_t unitsPerSecond;  // of TIME and TIMESTAMP
+    bool adjustedToUTC;      // of TIMESTAMP
+    bool optional;
+};
+
+struct ParquetColumnChunkInfo {
+    ParquetColumnChunkInfo()
+        : codec(0),
+          numValues(0),
+          offset(0),
+          compressedSize(0),
+          external(false),
+          nullCount(-1),
+          hasMinMax(false),
+          legacyMinMax(false) {
+    }
+
+    int32_t codec;
+    int64_t numValues;
+    int64_t offset;  // of its first page, the dictionary page if any
+    int64_t compressedSize;
+    bool external;  // stored in another file
+
+    // statistics, in the plain encoding of the values
+    int64_t nullCount;  // -1 when unknown
+    bool hasMinMax;
+    bool legacyMinMax;  // from the deprecated fields, compared as signed
+    string minValue;
+    string maxValue;
+};
+
+struct ParquetRowGroupInfo {
+    ParquetRowGroupInfo() : numRows(0) {
+    }
+
+    int64_t numRows;
+    vector<ParquetColumnChunkInfo> columns;
+};
+
+struct ParquetFileInfo {
+    ParquetFileInfo() : numRows(0) {
+    }
+
+    int64_t numRows;
+    vector<ParquetColumnInfo> columns;  // leaf columns
+    vector<ParquetRowGroupInfo> rowGroups;
+};
+
+// Parse the thrift encoded FileMetaData of a parquet file.
+void ParseParquetFileInfo(const uint8_t *data, uint64_t len, ParquetFileInfo &fileInfo);
+
+class ParquetColumnReader;
+
+// In ParquetReader::getProjection(), a column that is returned as nulls.
+#define PARQUET_NO_COLUMN UINT64_MAX
+
+// ParquetReader converts a parquet key to TEXT format rows.
+//
+// Only the footer and the column chunks of the columns in columnNames are
+// fetched, with one range request each, one row group at a time. Columns are
+// matched by name, all columns are read in file order when no names are set.
+// Columns not in columnReferenced are not fetched, and row groups that
+// columnPredicates rule out by their statistics are skipped.
+class ParquetReader : public Reader {
+   public:
+    ParquetReader();
+    virtual ~ParquetReader();
+
+    void open(const S3Params &params);
+    uint64_t read(char *buf, uint64_t count);
+    void close();
+
+    void setS3InterfaceService(S3Interface *s3) {
+        this->s3Interface = s3;
+    }
+
+    const ParquetFileInfo &getFileInfo() const {
+        return fileInfo;
+    }
+
+    const vector<uint64_t> &getProjection() const {
+        return projection;
+    }
+
+    uint64_t getSkippedRowGroups() const {
+        return skippedRowGroups;
+    }
+
+   private:
+    S3Interface *s3Interface;
+    S3Url s3Url;
+
+    ParquetFileInfo fileInfo;
+    vector<uint64_t> projection;  // leaf column of each output column
+
+    uint64_t nextRowGroup;
+    uint64_t skippedRowGroups;
+    int64_t rowsLeft;  // in the current row group
+    vector<std::unique_ptr<ParquetColumnReader>> columnReaders;
+
+    string rows;  // formatted rows not returned yet
+    uint64_t rowsOffset;
+
+    void readFileInfo(uint64_t keySize);
+    void selectColumns();
+    bool rowGroupMayMatch(const ParquetRowGroupInfo &rowGroup) const;
+    bool openNextRowGroup();
+    bool formatRows();
+};
+
+#endif /* INCLUDE_PARQUET_READER_H_ */
@@ -6,6 +6,26 @@
 #include "s3exception.h"
 #include "s3interface.h"
 
+// A part of a key read by one segment: either the whole key, or a byte range of it
+// when large keys are split among the segments.
+struct KeyRange {
+    KeyRange(uint64_t keyIndex, uint64_t offset, uint64_t length, bool split)
+        : keyIndex(keyIndex), offset(offset), length(length), split(split) {
+    }
+
+    uint64_t keyIndex;  // index of the key in keyList.contents
+    uint64_t offset;
+    uint64_t length;
+    bool split;
+};
+
+enum RangeReadState {
+    RangeSkipHead,  // skipping the line that started before the range
+    RangeBody,      // reading the range
+    RangeTail,      // reading on past the range up to the end of its last line
+    RangeDone,
+};
+
 // S3BucketReader read multiple files in a bucket.
 class S3BucketReader : public Reader {
    public:
@@ -25,9 +45,18 @@ class S3BucketReader : public Reader {
     }
 
     const ListBucketResult &getKeyList() {
+        this->waitForListing();
         return keyList;
     }
 
+    const vector<KeyRange> &getKeyRanges() {
+        this->waitForListing();
+        return keyRanges;
+    }
+
+    // Run by the listing thread.
+    void listRemainingPages();
+
    private:
     S3Params params;
 
@@ -46,9 +75,46 @@ class S3BucketReader : public Reader {
     uint64_t readWithoutHeaderLine(char *buf, uint64_t count);
 
     ListBucketResult keyList;  // List of matched keys/files.
-    uint64_t keyIndex;         // BucketContent index of keylist->contents.
 
-    BucketContent &getNextKey();
+    vector<KeyRange> keyRanges;  // Keys or parts of keys to read on this segment.
+    uint64_t rangeIndex;         // Next entry of keyRanges.
+
+    KeyRange curRange;
+    BucketContent curKey;  // the key of curRange, keyList may grow meanwhile
+    RangeReadState rangeState;
+    char lastChar;  // last char returned from the current range
+
+    // The pages after the first one are listed by a thread, while this segment
+    // reads the first keys. keyList, keyRanges, segmentLoads and the states below
+    // are guarded by listMutex while the thread runs.
+    pthread_t listThread;
+    bool listThreadRunning;
+    pthread_mutex_t listMutex;
+    pthread_cond_t listCond;
+    string listMarker;  // where the next page starts
+    bool listDone;
+    bool listStopping;  // close() asks the listing thread to stop
+    std::exception_ptr listException;
+
+    // Bytes assigned to each segment so far, when keys are split.
+    vector<uint64_t> segmentLoads;
+
+    bool isRoundRobin();
+    vector<KeyRange> splitKeys(const vector<BucketContent> &keys, uint64_t from);
+    void appendKeyRanges(uint64_t from, const vector<KeyRange> &pageRanges);
+    void appendRoundRobinRanges(uint64_t from);
+    bool isSplittable(BucketContent &key);
+
+    // Wait for the next key range of this segment, return false if there is none.
+    bool nextKeyRange(BucketContent &key);
+
+    void waitForListing();
+    void stopListing();
+
+    // Read a byte range of a key, from the first line starting in it to
+    // the end of the last line starting in it.
+    uint64_t readRange(char *buf, uint64_t count);
+
     S3Params constructReaderParams(BucketContent &key);
 };
 
@@ -10,6 +10,9 @@
 
 #define S3_MAGIC_BYTES_NUM 4
 
+#define PARQUET_MAGIC "PAR1"
+#define PARQUET_MAGIC_LEN 4
+
 #define S3_REQUEST_NO_RETRY 1
 #define S3_REQUEST_MAX_RETRIES 5
 
@@ -19,6 +22,10 @@ enum S3CompressionType {
     S3_COMPRESSION_GZIP,
     S3_COMPRESSION_PLAIN,
     S3_COMPRESSION_DEFLATE,
+    S3_COMPRESSION_PARQUET,  // not compressed as a whole, but converted to rows
+    S3_COMPRESSION_ZSTD,
+    S3_COMPRESSION_SNAPPY,  // the framing format
+    S3_COMPRESSION_LZ4,     // the frame format
 };
 
 struct BucketContent {
@@ -55,6 +62,19 @@ class S3Interface {
 
     virtual ListBucketResult listBucket(S3Url &s3Url) = 0;
 
+    // List the page of keys after marker, and append them to result. marker is set to
+    // where the next page starts, or cleared after the last page. By default the whole
+    // listing is a single page.
+    virtual void listBucketPage(const S3Url &s3Url, string &marker, ListBucketResult &result) {
+        S3Url url(s3Url);
+        ListBucketResult page = this->listBucket(url);
+
+        result.Name = page.Name;
+        result.Prefix = page.Prefix;
+        result.contents.insert(result.contents.end(), page.contents.begin(), page.contents.end());
+        marker.clear();
+    }
+
     virtual uint64_t fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
                                const S3Url &s3Url) = 0;
 
@@ -81,6 +101,8 @@ class S3InterfaceService : public S3Interface {
 
     ListBucketResult listBucket(S3Url &s3Url);
 
+    void listBucketPage(const S3Url &s3Url, string &marker, ListBucketResult &result);
+
     uint64_t fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url);
 
     S3CompressionType checkCompressionType(const S3Url &s3Url);
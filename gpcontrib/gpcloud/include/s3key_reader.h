@@ -73,6 +73,8 @@ class S3KeyReader : public Reader {
           numOfChunks(0),
           curReadingChunk(0),
           transferredKeyLen(0),
+          rangeStart(0),
+          atKeyEnd(true),
           s3Interface(NULL),
           hasEol(false),
           eolAppended(false) {
@@ -152,6 +154,11 @@ class S3KeyReader : public Reader {
     uint64_t numOfChunks;
     uint64_t curReadingChunk;
     uint64_t transferredKeyLen;
+
+    // Start of the byte range being read, and whether the range ends at the end of the key.
+    uint64_t rangeStart;
+    bool atKeyEnd;
+
     string region;
     OffsetMgr offsetMgr;
 
@@ -8,9 +8,13 @@
 
 class WriterBuffer : public vector<uint8_t> {};
 
+// S3 rejects parts smaller than 5MB, except the last one.
+extern uint64_t S3_UPLOAD_MIN_PARTSIZE;
+
 class S3KeyWriter : public Writer {
    public:
-    S3KeyWriter() : sharedError(false), s3Interface(NULL), partNumber(0), activeThreads(0) {
+    S3KeyWriter()
+        : sharedError(false), s3Interface(NULL), partSize(0), partNumber(0), activeThreads(0) {
         pthread_mutex_init(&this->mutex, NULL);
         pthread_cond_init(&this->cv, NULL);
         pthread_mutex_init(&this->exceptionMutex, NULL);
@@ -38,10 +42,15 @@ class S3KeyWriter : public Writer {
         this->s3Interface = s3;
     }
 
+    uint64_t getPartSize() const {
+        return partSize;
+    }
+
    protected:
     static void* UploadThreadFunc(void* p);
 
     void flushBuffer();
+    void adaptPartSize(bool waited);
     void completeKeyWriting();
     void checkQueryCancelSignal();
 
@@ -55,6 +64,10 @@ class S3KeyWriter : public Writer {
     string uploadId;
     map<uint64_t, string> etagList;
 
+    // Parts start small, and grow up to the chunk size while uploading is the
+    // bottleneck. The buffers are chunks of the memory context whatever their size.
+    uint64_t partSize;
+
     vector<pthread_t> threadList;
     pthread_mutex_t mutex;
     pthread_cond_t cv;
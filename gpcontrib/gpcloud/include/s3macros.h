@@ -27,6 +27,9 @@ extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
 #define S3_ZIP_DEFAULT_CHUNKSIZE (1024 * 1024 * 2)
 
+// chunk size used to read the end of the last line of a byte range, past the range
+#define S3_RANGE_TAIL_CHUNKSIZE (256 * 1024)
+
 // For deflate, windowBits can be greater than 15 for optional gzip encoding. Add 16 to windowBits
 // to write a simple gzip header and trailer around the compressed data instead of a zlib wrapper.
 #define S3_DEFLATE_WINDOWSBITS (MAX_WBITS + 16)
@@ -101,6 +101,10 @@ struct PGAllocator {
     typedef const T& const_reference;
     typedef T value_type;
 
+    // Memory must go back to the allocator it came from.
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
     size_type max_size() const {
         if (prealloc) {
             return prealloc->MaxSize();
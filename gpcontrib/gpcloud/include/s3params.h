@@ -15,12 +15,17 @@ class S3Params {
           keySize(0),
           chunkSize(0),
           numOfChunks(0),
+          splitSize(0),
+          objectSize(0),
+          rangeOffset(0),
+          rangeLength(0),
           lowSpeedLimit(0),
           lowSpeedTime(0),
           proxy(""),
           debugCurl(false),
           autoCompress(false),
           verifyCert(false),
+          keepAlive(true),
           sseType(SSE_NONE),
           gpcheckcloud_newline("") {
     }
@@ -72,6 +77,36 @@ class S3Params {
         this->keySize = size;
     }
 
+    uint64_t getSplitSize() const {
+        return splitSize;
+    }
+
+    void setSplitSize(uint64_t splitSize) {
+        this->splitSize = splitSize;
+    }
+
+    uint64_t getObjectSize() const {
+        return objectSize;
+    }
+
+    void setObjectSize(uint64_t objectSize) {
+        this->objectSize = objectSize;
+    }
+
+    uint64_t getRangeOffset() const {
+        return rangeOffset;
+    }
+
+    uint64_t getRangeLength() const {
+        return rangeLength;
+    }
+
+    // Read only 'length' bytes of the key from 'offset', length 0 means up to the end.
+    void setRange(uint64_t offset, uint64_t length) {
+        this->rangeOffset = offset;
+        this->rangeLength = length;
+    }
+
     uint64_t getLowSpeedLimit() const {
         return lowSpeedLimit;
     }
@@ -111,6 +146,14 @@ class S3Params {
         this->autoCompress = autoCompress;
     }
 
+    bool isKeepAlive() const {
+        return keepAlive;
+    }
+
+    void setKeepAlive(bool keepAlive) {
+        this->keepAlive = keepAlive;
+    }
+
     const S3MemoryContext& getMemoryContext() const {
         return memoryContext;
     }
@@ -157,6 +200,11 @@ class S3Params {
     uint64_t chunkSize;    // chunk size
     uint64_t numOfChunks;  // number of chunks(threads).
 
+    uint64_t splitSize;    // smallest byte range a key is split into, 0 disables it.
+    uint64_t objectSize;   // data written to a key before moving on to a new one, 0 disables it.
+    uint64_t rangeOffset;  // byte range of the key to read.
+    uint64_t rangeLength;
+
     uint64_t lowSpeedLimit;  // low speed limit
     uint64_t lowSpeedTime;   // low speed timeout
 
@@ -166,6 +214,7 @@ class S3Params {
     bool autoCompress;  // whether to compress data before uploading
     bool verifyCert;  // This option determines whether curl verifies the authenticity of the peer's
                       // certificate.
+    bool keepAlive;   // whether connections are kept open and reused by later requests
 
     S3SSEType sseType;
 
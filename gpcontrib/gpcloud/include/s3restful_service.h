@@ -10,6 +10,56 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+// Requests made and connections opened by the curl handle pool.
+struct ConnectionStats {
+    ConnectionStats() : requests(0), newConnections(0) {
+    }
+
+    uint64_t requests;
+    uint64_t newConnections;
+};
+
+// CURLHandlePool keeps the curl handles of finished requests for the next ones. A
+// handle keeps its connections open, so requests to the same host skip the TCP and
+// TLS setup; all handles share the DNS cache and the TLS sessions. There is one pool
+// per process, emptied when the last S3RESTfulService is destroyed.
+class CURLHandlePool {
+   public:
+    static CURLHandlePool& getInstance();
+
+    void attach();
+    void detach();
+
+    CURL* acquire();
+    void release(CURL* curl, bool reusable);
+
+    void countRequest(CURL* curl);
+    ConnectionStats getStats();
+
+   private:
+    CURLHandlePool();
+    ~CURLHandlePool();
+
+    void cleanup();
+
+    pthread_mutex_t mutex;
+    pthread_mutex_t shareLocks[CURL_LOCK_DATA_LAST];
+
+    CURLSH* share;
+    vector<CURL*> idleHandles;
+    uint64_t users;
+
+    ConnectionStats stats;
+
+    static void lockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userp);
+    static void unlockShare(CURL* curl, curl_lock_data data, void* userp);
+};
+
+// Requests, new connections and the rate of reused connections so far.
+string GetConnectionStatsSummary();
+
+struct CURLWrapper;
+
 class S3RESTfulService : public RESTfulService {
    public:
     S3RESTfulService();
@@ -35,11 +85,12 @@ class S3RESTfulService : public RESTfulService {
 
     bool debugCurl;
     bool verifyCert;
+    bool keepAlive;
 
     uint64_t chunkBufferSize;
     S3MemoryContext s3MemContext;
 
-    void performCurl(CURL* curl, Response& response);
+    void performCurl(CURLWrapper& wrapper, Response& response);
 };
 
 class S3MessageParser {
@@ -2,8 +2,92 @@
 
 uint64_t S3_ZIP_COMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-CompressWriter::CompressWriter() : writer(NULL), isClosed(true) {
-    this->out = new char[S3_ZIP_COMPRESS_CHUNKSIZE];
+// deflate looks back at most this far, so it is all a block needs of the previous one.
+#define S3_DEFLATE_DICTIONARY_SIZE (1 << MAX_WBITS)
+
+// What deflateInit2() with S3_DEFLATE_WINDOWSBITS writes: no name, no time, Unix.
+static const char gzipHeader[] = {0x1f, (char)0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+
+// A final, empty block of fixed Huffman codes, to end the deflate stream.
+static const char deflateLastBlock[] = {3, 0};
+
+struct CompressBlock {
+    vector<char> in;
+    string dictionary;
+
+    vector<char> out;
+    uLong crc;
+
+    pthread_t thread;
+    std::exception_ptr exception;
+};
+
+static void CompressBlockData(CompressBlock* block) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+
+    // A raw deflate stream, the header and trailer are written by CompressWriter.
+    int ret =
+        deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError,
+                    string("Failed to initialize zlib library: ") + zstream.msg);
+
+    if (!block->dictionary.empty()) {
+        deflateSetDictionary(&zstream, (const Byte*)block->dictionary.data(),
+                             block->dictionary.size());
+    }
+
+    // A sync flush adds at most a few bytes, on top of the worst case of deflate.
+    block->out.resize(deflateBound(&zstream, block->in.size()) + 16);
+
+    zstream.next_in = (Byte*)block->in.data();
+    zstream.avail_in = block->in.size();
+    zstream.next_out = (Byte*)block->out.data();
+    zstream.avail_out = block->out.size();
+
+    // Z_SYNC_FLUSH ends the block on a byte boundary, for the next block to follow.
+    int status;
+    while (true) {
+        status = deflate(&zstream, Z_SYNC_FLUSH);
+        if ((status != Z_OK && status != Z_BUF_ERROR) ||
+            (zstream.avail_in == 0 && zstream.avail_out > 0)) {
+            break;
+        }
+
+        uint64_t used = block->out.size() - zstream.avail_out;
+        block->out.resize(block->out.size() * 2);
+        zstream.next_out = (Byte*)block->out.data() + used;
+        zstream.avail_out = block->out.size() - used;
+    }
+
+    block->out.resize(block->out.size() - zstream.avail_out);
+    deflateEnd(&zstream);
+
+    S3_CHECK_OR_DIE(status == Z_OK || status == Z_BUF_ERROR, S3RuntimeError,
+                    string("Failed to compress data: ") +
+                        std::to_string((unsigned long long)status));
+
+    block->crc = crc32(0L, (const Byte*)block->in.data(), block->in.size());
+}
+
+static void* CompressThreadFunc(void* data) {
+    MaskThreadSignals();
+
+    CompressBlock* block = static_cast<CompressBlock*>(data);
+
+    try {
+        CompressBlockData(block);
+    } catch (...) {
+        block->exception = std::current_exception();
+    }
+
+    return NULL;
+}
+
+CompressWriter::CompressWriter()
+    : writer(NULL), maxBlocks(1), headerWritten(false), crc(0), dataLen(0), isClosed(true) {
 }
 
 CompressWriter::~CompressWriter() {
@@ -11,80 +95,100 @@ CompressWriter::~CompressWriter() {
         this->close();
     } catch (...) {
     }
-    delete this->out;
+    this->abandonBlocks();
 }
 
 void CompressWriter::open(const S3Params& params) {
-    this->zstream.zalloc = Z_NULL;
-    this->zstream.zfree = Z_NULL;
-    this->zstream.opaque = Z_NULL;
+    this->abandonBlocks();
 
-    // With S3_DEFLATE_WINDOWSBITS, it generates gzip stream with header and trailer
-    int ret = deflateInit2(&this->zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-                           S3_DEFLATE_WINDOWSBITS, 8, Z_DEFAULT_STRATEGY);
+    // as many blocks as upload threads, so that compressing keeps up with uploading
+    this->maxBlocks = std::max(params.getNumOfChunks(), (uint64_t)1);
 
-    this->isClosed = false;
+    this->pending.clear();
+    this->pending.reserve(S3_ZIP_COMPRESS_CHUNKSIZE);
+    this->dictionary.clear();
 
-    // init them here to get ready for both writer() and close()
-    this->zstream.next_in = NULL;
-    this->zstream.avail_in = 0;
-    this->zstream.next_out = (Byte*)this->out;
-    this->zstream.avail_out = S3_ZIP_COMPRESS_CHUNKSIZE;
+    this->headerWritten = false;
+    this->crc = crc32(0L, Z_NULL, 0);
+    this->dataLen = 0;
 
-    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError,
-                    string("Failed to initialize zlib library: ") + this->zstream.msg);
+    this->isClosed = false;
 
     this->writer->open(params);
 }
 
-uint64_t CompressWriter::writeOneChunk(const char* buf, uint64_t count) {
+uint64_t CompressWriter::write(const char* buf, uint64_t count) {
     // Defensive code
     if (buf == NULL || count == 0) {
         return 0;
     }
 
-    this->zstream.next_in = (Byte*)buf;
-    this->zstream.avail_in = count;
+    uint64_t writtenLen = 0;
 
-    int status;
-    do {
-        status = deflate(&this->zstream, Z_NO_FLUSH);
-        if (status < 0 && status != Z_BUF_ERROR) {
-            deflateEnd(&this->zstream);
-            S3_CHECK_OR_DIE(false, S3RuntimeError,
-                            string("Failed to compress data: ") +
-                                std::to_string((unsigned long long)status) + ", " +
-                                this->zstream.msg);
+    while (writtenLen < count) {
+        uint64_t len =
+            std::min(count - writtenLen, S3_ZIP_COMPRESS_CHUNKSIZE - this->pending.size());
+        this->pending.insert(this->pending.end(), buf + writtenLen, buf + writtenLen + len);
+        writtenLen += len;
+
+        if (this->pending.size() == S3_ZIP_COMPRESS_CHUNKSIZE) {
+            this->dispatchBlock();
         }
+    }
+
+    return writtenLen;
+}
+
+void CompressWriter::dispatchBlock() {
+    while (this->blocks.size() >= this->maxBlocks) {
+        this->writeOldestBlock();
+    }
+
+    CompressBlock* block = new CompressBlock();
+    block->in.swap(this->pending);
+    block->dictionary.swap(this->dictionary);
 
-        this->flush();
+    uint64_t dictionaryLen = std::min(block->in.size(), (size_t)S3_DEFLATE_DICTIONARY_SIZE);
+    this->dictionary.assign(block->in.end() - dictionaryLen, block->in.end());
 
-        // output buffer is same size to input buffer, most cases data
-        // is smaller after compressed. But if this->zstream.avail_in > 0 after deflate(), then data
-        // is larger after compressed and some input data is pending. For example when compressing a
-        // chunk that is already compressed, we will encounter this case. So we need to loop here.
-    } while (status == Z_OK && (this->zstream.avail_in > 0));
+    pthread_create(&block->thread, NULL, CompressThreadFunc, block);
+    this->blocks.push_back(block);
 
-    return count;
+    this->pending.reserve(S3_ZIP_COMPRESS_CHUNKSIZE);
 }
 
-uint64_t CompressWriter::write(const char* buf, uint64_t count) {
-    // Defensive code
-    if (buf == NULL || count == 0) {
-        return 0;
-    }
+void CompressWriter::writeOldestBlock() {
+    CompressBlock* block = this->blocks.front();
+    this->blocks.pop_front();
 
-    uint64_t writtenLen = 0;
+    pthread_join(block->thread, NULL);
 
-    for (uint64_t i = 0; i < (count / S3_ZIP_COMPRESS_CHUNKSIZE); i++) {
-        writtenLen += this->writeOneChunk(buf + writtenLen, S3_ZIP_COMPRESS_CHUNKSIZE);
+    std::unique_ptr<CompressBlock> holder(block);
+    if (block->exception != NULL) {
+        this->abandonBlocks();
+        std::rethrow_exception(block->exception);
     }
 
-    if (writtenLen < count) {
-        writtenLen += this->writeOneChunk(buf + writtenLen, count - writtenLen);
+    this->writeHeader();
+    this->writer->write(block->out.data(), block->out.size());
+
+    this->crc = crc32_combine(this->crc, block->crc, block->in.size());
+    this->dataLen += block->in.size();
+}
+
+void CompressWriter::abandonBlocks() {
+    while (!this->blocks.empty()) {
+        pthread_join(this->blocks.front()->thread, NULL);
+        delete this->blocks.front();
+        this->blocks.pop_front();
     }
+}
 
-    return writtenLen;
+void CompressWriter::writeHeader() {
+    if (!this->headerWritten) {
+        this->writer->write(gzipHeader, sizeof(gzipHeader));
+        this->headerWritten = true;
+    }
 }
 
 void CompressWriter::close() {
@@ -92,21 +196,26 @@ void CompressWriter::close() {
         return;
     }
 
-    int status;
-    do {
-        status = deflate(&this->zstream, Z_FINISH);
-        this->flush();
-    } while (status == Z_OK);
+    if (!this->pending.empty()) {
+        this->dispatchBlock();
+    }
 
-    deflateEnd(&this->zstream);
+    while (!this->blocks.empty()) {
+        this->writeOldestBlock();
+    }
 
-    if (status != Z_STREAM_END) {
-        S3_CHECK_OR_DIE(false, S3RuntimeError,
-                        string("Failed to compress data: ") +
-                            std::to_string((unsigned long long)status) + ", " + this->zstream.msg);
+    // CRC-32 and length of the data, little endian
+    char trailer[8];
+    for (int i = 0; i < 4; i++) {
+        trailer[i] = (char)((this->crc >> (8 * i)) & 0xff);
+        trailer[4 + i] = (char)((this->dataLen >> (8 * i)) & 0xff);
     }
 
-    S3DEBUG("Compression finished: Z_STREAM_END.");
+    this->writeHeader();
+    this->writer->write(deflateLastBlock, sizeof(deflateLastBlock));
+    this->writer->write(trailer, sizeof(trailer));
+
+    S3DEBUG("Compression finished, %" PRIu64 " bytes compressed.", this->dataLen);
 
     this->writer->close();
     this->isClosed = true;
@@ -115,11 +224,3 @@ void CompressWriter::close() {
 void CompressWriter::setWriter(Writer* writer) {
     this->writer = writer;
 }
-
-void CompressWriter::flush() {
-    if (this->zstream.avail_out < S3_ZIP_COMPRESS_CHUNKSIZE) {
-        this->writer->write(this->out, S3_ZIP_COMPRESS_CHUNKSIZE - this->zstream.avail_out);
-        this->zstream.next_out = (Byte*)this->out;
-        this->zstream.avail_out = S3_ZIP_COMPRESS_CHUNKSIZE;
-    }
-}
@@ -1,29 +1,38 @@
 #include "decompress_reader.h"
 
+#include <chrono>
+
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
 DecompressReader::DecompressReader() : isClosed(true) {
     this->reader = NULL;
+    this->compressionType = S3_COMPRESSION_GZIP;
+    this->decompressor = NULL;
     this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
+    this->inOffset = 0;
+    this->inLen = 0;
     this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
     this->outOffset = 0;
+    this->outLen = 0;
 }
 
 DecompressReader::~DecompressReader() {
     this->close();
 
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
+    delete[] this->out;
 }
 
 // Used for unit test to adjust buffer size
 void DecompressReader::resizeDecompressReaderBuffer(uint64_t size) {
-    delete this->in;
-    delete this->out;
+    delete[] this->in;
+    delete[] this->out;
     this->in = new char[size];
     this->out = new char[size];
+    this->inOffset = 0;
+    this->inLen = 0;
     this->outOffset = 0;
-    this->zstream.avail_out = size;
+    this->outLen = 0;
 }
 
 void DecompressReader::setReader(Reader *reader) {
@@ -31,21 +40,17 @@ void DecompressReader::setReader(Reader *reader) {
 }
 
 void DecompressReader::open(const S3Params &params) {
-    // allocate inflate state for zlib
-    zstream.zalloc = Z_NULL;
-    zstream.zfree = Z_NULL;
-    zstream.opaque = Z_NULL;
-    zstream.next_in = Z_NULL;
-    zstream.next_out = (Byte *)this->out;
-
-    zstream.avail_in = 0;
-    zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-
+    this->inOffset = 0;
+    this->inLen = 0;
     this->outOffset = 0;
+    this->outLen = 0;
 
-    // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
-    int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
-    S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+    this->decompressor = CreateDecompressor(this->compressionType);
+    S3_CHECK_OR_DIE(this->decompressor != NULL, S3RuntimeError,
+                    string(GetCompressionName(this->compressionType)) +
+                        " compressed files are not supported by this build");
+    this->decompressor->setParallelism(params.getNumOfChunks());
+    this->decompressor->init();
 
     this->isClosed = false;
 
@@ -69,63 +74,83 @@ uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
     return count;
 }
 
+// Read S3_ZIP_DECOMPRESS_CHUNKSIZE data from underlying reader and put into this->in buffer.
+// Return false if EOF.
+bool DecompressReader::readCompressedData() {
+    // read() might happen more than once when reaching EOF, make sure every time read() will
+    // return 0.
+    uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    if (hasRead == 0) {
+        return false;
+    }
+
+    // Fill this->in as possible as it could, fewer calls to the decompressor are cheaper.
+    while (hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+        uint64_t count =
+            this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+
+        if (count == 0) {
+            break;
+        }
+
+        hasRead += count;
+    }
+
+    this->inOffset = 0;
+    this->inLen = hasRead;
+
+    return true;
+}
+
 // Read compressed data from underlying reader and decompress to this->out buffer.
-// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
+// If no more data to consume, this->outLen == 0.
 void DecompressReader::decompress() {
-    if (this->zstream.avail_in == 0) {
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
-
-        // read S3_ZIP_DECOMPRESS_CHUNKSIZE data from underlying reader and put into this->in
-        // buffer. read() might happen more than once when reaching EOF, make sure every time read()
-        // will return 0.
-        uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
-
-        // EOF, no more data to decompress.
-        if (hasRead == 0) {
-            S3DEBUG(
-                "No more data to decompress: avail_in = %u, avail_out = %u, total_in = %u, "
-                "total_out = %u",
-                zstream.avail_in, zstream.avail_out,
-		(unsigned int) zstream.total_in, (unsigned int) zstream.total_out);
-            return;
-        }
+    DecompressStats &stats = GetDecompressStats(this->compressionType);
+
+    this->outLen = 0;
+
+    while (true) {
+        // At EOF the decompressor is still called, to flush what it holds.
+        bool eof = (this->inLen == 0) && !this->readCompressedData();
 
-        // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
-        // inflated.
-        while (hasRead < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
-            uint64_t count =
-                this->reader->read(this->in + hasRead, S3_ZIP_DECOMPRESS_CHUNKSIZE - hasRead);
+        const char *next = this->in + this->inOffset;
+        uint64_t availIn = this->inLen;
+        char *nextOut = this->out;
+        uint64_t availOut = S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
-            if (count == 0) {
-                break;
-            }
+        auto start = std::chrono::steady_clock::now();
+        this->decompressor->decompress(next, availIn, nextOut, availOut);
+        auto elapsed = std::chrono::steady_clock::now() - start;
 
-            hasRead += count;
+        uint64_t consumed = this->inLen - availIn;
+        stats.inBytes += consumed;
+        stats.outBytes += S3_ZIP_DECOMPRESS_CHUNKSIZE - availOut;
+        stats.usecs += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+        this->inOffset += consumed;
+        this->inLen = availIn;
+        this->outLen = S3_ZIP_DECOMPRESS_CHUNKSIZE - availOut;
+
+        if (eof) {
+            S3DEBUG("No more %s data to decompress.", GetCompressionName(this->compressionType));
         }
 
-        this->zstream.next_in = (Byte *)this->in;
-        this->zstream.avail_in = hasRead;
-    } else {
-        // Still have more data in 'in' buffer to decode.
-        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
-        this->zstream.next_out = (Byte *)this->out;
-    }
+        if (this->outLen > 0 || eof) {
+            return;
+        }
 
-    int status = inflate(&this->zstream, Z_NO_FLUSH);
-    if (status == Z_STREAM_END) {
-        S3DEBUG("Decompression finished: Z_STREAM_END.");
-    } else if (status < 0 || status == Z_NEED_DICT) {
-        inflateEnd(&this->zstream);
-        S3_CHECK_OR_DIE(
-            false, S3RuntimeError,
-            string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
+        S3_CHECK_OR_DIE(consumed > 0, S3RuntimeError,
+                        "Failed to decompress data: no progress with input left");
     }
 }
 
 void DecompressReader::close() {
     if (!this->isClosed) {
-        inflateEnd(&zstream);
+        this->decompressor->end();
+        delete this->decompressor;
+        this->decompressor = NULL;
+
         this->reader->close();
         this->isClosed = true;
     }
@@ -0,0 +1,750 @@
+#include "decompressor.h"
+
+#include <deque>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+
+#define SNAPPY_MAX_BLOCK_SIZE 65536
+#define SNAPPY_CHUNK_HEADER_LEN 4  // chunk type and 3 bytes of length
+#define SNAPPY_CHECKSUM_LEN 4
+
+static inline uint32_t ReadLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+// Both gzip and zlib streams, with S3_INFLATE_WINDOWSBITS. A gzip stream
+// may have more members after the first one, as pigz and concatenated
+// files do.
+class ZlibDecompressor : public Decompressor {
+   public:
+    ZlibDecompressor() : initialized(false), streamEnded(false) {
+    }
+
+    virtual ~ZlibDecompressor() {
+        this->end();
+    }
+
+    void init() {
+        memset(&zstream, 0, sizeof(zstream));
+
+        int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
+        S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+        this->initialized = true;
+        this->streamEnded = false;
+    }
+
+    void decompress(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) {
+        if (this->streamEnded && inLen > 0) {
+            inflateReset(&zstream);
+            this->streamEnded = false;
+        }
+
+        zstream.next_in = (Byte *)in;
+        zstream.avail_in = inLen;
+        zstream.next_out = (Byte *)out;
+        zstream.avail_out = outLen;
+
+        int status = inflate(&zstream, Z_NO_FLUSH);
+
+        in += inLen - zstream.avail_in;
+        inLen = zstream.avail_in;
+        out += outLen - zstream.avail_out;
+        outLen = zstream.avail_out;
+
+        if (status == Z_STREAM_END) {
+            S3DEBUG("Decompression finished: Z_STREAM_END.");
+            this->streamEnded = true;
+        } else if (status == Z_BUF_ERROR) {
+            // no input or no output room, nothing to do
+        } else if (status < 0 || status == Z_NEED_DICT) {
+            S3_CHECK_OR_DIE(
+                false, S3RuntimeError,
+                string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
+        }
+    }
+
+    void end() {
+        if (this->initialized) {
+            inflateEnd(&zstream);
+            this->initialized = false;
+        }
+    }
+
+   private:
+    z_stream zstream;
+    bool initialized;
+    bool streamEnded;
+};
+
+#ifdef USE_ZSTD
+// Frames with more content than this, or of unknown content size, are
+// streamed rather than decompressed on worker threads. It also bounds the
+// compressed data buffered for the threads.
+#define ZSTD_PARALLEL_MAX_FRAME_SIZE (32 * 1024 * 1024)
+
+// A frame header takes at most this many bytes.
+#define ZSTD_FRAME_HEADER_MAX_LEN 18
+
+// Consecutive complete frames, decompressed by one worker thread.
+struct ZstdFrameBlock {
+    vector<char> in;
+    vector<char> out;  // sized to the content of the frames
+
+    pthread_t thread;
+    std::exception_ptr exception;
+};
+
+static void *DecompressZstdThreadFunc(void *data) {
+    MaskThreadSignals();
+
+    ZstdFrameBlock *block = static_cast<ZstdFrameBlock *>(data);
+
+    try {
+        size_t ret = ZSTD_decompress(block->out.data(), block->out.size(), block->in.data(),
+                                     block->in.size());
+        S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                        string("Failed to decompress data: ") + ZSTD_getErrorName(ret));
+        S3_CHECK_OR_DIE(ret == block->out.size(), S3RuntimeError,
+                        "Failed to decompress data: zstd frame has unexpected content size");
+    } catch (...) {
+        block->exception = std::current_exception();
+    }
+
+    return NULL;
+}
+
+// A zstd stream of any number of frames.
+//
+// With several threads, the frames are gathered into blocks of about
+// S3_ZIP_DECOMPRESS_CHUNKSIZE bytes of content, and as many blocks as threads
+// are decompressed at a time, while the oldest one is returned. Frames too
+// large for that are streamed, once the blocks before them are returned.
+class ZstdDecompressor : public Decompressor {
+   public:
+    ZstdDecompressor()
+        : dstream(NULL),
+          maxBlocks(1),
+          streaming(true),
+          pendingOffset(0),
+          current(NULL),
+          currentOffset(0) {
+    }
+
+    virtual ~ZstdDecompressor() {
+        this->end();
+    }
+
+    void setParallelism(uint64_t threads) {
+        this->maxBlocks = std::max(threads, (uint64_t)1);
+    }
+
+    void init() {
+        if (this->dstream == NULL) {
+            this->dstream = ZSTD_createDStream();
+            S3_CHECK_OR_DIE(this->dstream != NULL, S3RuntimeError,
+                            "failed to initialize zstd library");
+        }
+
+        size_t ret = ZSTD_initDStream(this->dstream);
+        S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                        string("failed to initialize zstd library: ") + ZSTD_getErrorName(ret));
+
+        this->abandonBlocks();
+        this->pending.clear();
+        this->pendingOffset = 0;
+        this->streaming = (this->maxBlocks == 1);
+    }
+
+    void decompress(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) {
+        if (this->maxBlocks == 1) {
+            this->streamFrame(in, inLen, out, outLen);
+            return;
+        }
+
+        // called without input only to flush, at the end of the data
+        bool flush = (inLen == 0);
+        bool tookInput = false;
+
+        while (outLen > 0) {
+            if (this->current != NULL) {
+                uint64_t n = std::min(outLen, this->current->out.size() - this->currentOffset);
+                memcpy(out, this->current->out.data() + this->currentOffset, n);
+                this->currentOffset += n;
+                out += n;
+                outLen -= n;
+
+                if (this->currentOffset == this->current->out.size()) {
+                    delete this->current;
+                    this->current = NULL;
+                }
+                continue;
+            }
+
+            if (this->streaming) {
+                if (!this->blocks.empty()) {
+                    this->finishOldestBlock();
+                } else if (!this->streamFrame(in, inLen, out, outLen)) {
+                    return;
+                }
+                continue;
+            }
+
+            uint64_t pendingLen = this->pending.size() - this->pendingOffset;
+            if (inLen > 0 && pendingLen < ZSTD_PARALLEL_MAX_FRAME_SIZE) {
+                uint64_t n = std::min(inLen, ZSTD_PARALLEL_MAX_FRAME_SIZE - pendingLen);
+                this->pending.insert(this->pending.end(), in, in + n);
+                in += n;
+                inLen -= n;
+                tookInput = true;
+            }
+
+            if (this->blocks.size() < this->maxBlocks && this->dispatchBlock(flush)) {
+                continue;
+            }
+
+            if (this->streaming) {
+                continue;
+            }
+
+            // Let the caller bring more input while the blocks are decompressed.
+            if (this->blocks.empty() ||
+                (this->blocks.size() < this->maxBlocks && inLen == 0 && tookInput)) {
+                return;
+            }
+
+            this->finishOldestBlock();
+        }
+    }
+
+    void end() {
+        this->abandonBlocks();
+        vector<char>().swap(this->pending);
+        this->pendingOffset = 0;
+
+        if (this->dstream != NULL) {
+            ZSTD_freeDStream(this->dstream);
+            this->dstream = NULL;
+        }
+    }
+
+   private:
+    ZSTD_DStream *dstream;
+
+    uint64_t maxBlocks;  // how many blocks are decompressed at a time
+    bool streaming;      // the next frame is streamed, rather than put in a block
+
+    vector<char> pending;  // input not in a block yet
+    uint64_t pendingOffset;
+
+    std::deque<ZstdFrameBlock *> blocks;  // blocks being decompressed, in order
+    ZstdFrameBlock *current;              // the block being returned
+    uint64_t currentOffset;
+
+    // Stream the pending input first, then the caller's, up to the end of a
+    // frame. Return false if no progress is made.
+    bool streamFrame(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) {
+        bool fromPending = (this->pendingOffset < this->pending.size());
+        ZSTD_inBuffer input;
+        if (fromPending) {
+            input = {this->pending.data() + this->pendingOffset,
+                     this->pending.size() - this->pendingOffset, 0};
+        } else {
+            input = {in, inLen, 0};
+        }
+        ZSTD_outBuffer output = {out, outLen, 0};
+
+        size_t ret = ZSTD_decompressStream(this->dstream, &output, &input);
+        S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                        string("Failed to decompress data: ") + ZSTD_getErrorName(ret));
+
+        if (fromPending) {
+            this->pendingOffset += input.pos;
+            this->compactPending();
+        } else {
+            in += input.pos;
+            inLen -= input.pos;
+        }
+        out += output.pos;
+        outLen -= output.pos;
+
+        // the frame is complete and flushed
+        if (ret == 0 && this->maxBlocks > 1) {
+            this->streaming = false;
+        }
+
+        return input.pos > 0 || output.pos > 0;
+    }
+
+    // Put the complete frames at the start of the pending input into a new
+    // block. Return false if there are none, after switching to streaming
+    // when the next frame has to be streamed.
+    bool dispatchBlock(bool flush) {
+        const char *data = this->pending.data() + this->pendingOffset;
+        uint64_t len = this->pending.size() - this->pendingOffset;
+        uint64_t blockLen = 0;
+        uint64_t contentLen = 0;
+        bool streamNext = false;
+
+        while (blockLen < len && contentLen < S3_ZIP_DECOMPRESS_CHUNKSIZE) {
+            const char *frame = data + blockLen;
+            uint64_t frameAvail = len - blockLen;
+
+            unsigned long long size = ZSTD_getFrameContentSize(frame, frameAvail);
+            if (size == ZSTD_CONTENTSIZE_ERROR) {
+                // not a frame, or its header is not complete yet
+                streamNext = (frameAvail >= ZSTD_FRAME_HEADER_MAX_LEN || flush);
+                break;
+            }
+            if (size == ZSTD_CONTENTSIZE_UNKNOWN || size > ZSTD_PARALLEL_MAX_FRAME_SIZE) {
+                streamNext = true;
+                break;
+            }
+
+            size_t frameLen = ZSTD_findFrameCompressedSize(frame, frameAvail);
+            if (ZSTD_isError(frameLen)) {
+                // not complete yet, and maybe never if it is corrupt
+                streamNext = (frameAvail >= ZSTD_PARALLEL_MAX_FRAME_SIZE || flush);
+                break;
+            }
+
+            blockLen += frameLen;
+            contentLen += size;
+        }
+
+        if (blockLen == 0) {
+            this->streaming = streamNext;
+            return false;
+        }
+
+        ZstdFrameBlock *block = new ZstdFrameBlock();
+        block->in.assign(data, data + blockLen);
+        block->out.resize(contentLen);
+        this->pendingOffset += blockLen;
+        this->compactPending();
+
+        pthread_create(&block->thread, NULL, DecompressZstdThreadFunc, block);
+        this->blocks.push_back(block);
+
+        return true;
+    }
+
+    // Wait for the oldest block, to return its content.
+    void finishOldestBlock() {
+        ZstdFrameBlock *block = this->blocks.front();
+        this->blocks.pop_front();
+
+        pthread_join(block->thread, NULL);
+
+        if (block->exception != NULL) {
+            std::exception_ptr exception = block->exception;
+            delete block;
+            this->abandonBlocks();
+            std::rethrow_exception(exception);
+        }
+
+        this->current = block;
+        this->currentOffset = 0;
+    }
+
+    // Wait for all blocks without returning them, after an error or at the end.
+    void abandonBlocks() {
+        while (!this->blocks.empty()) {
+            pthread_join(this->blocks.front()->thread, NULL);
+            delete this->blocks.front();
+            this->blocks.pop_front();
+        }
+
+        delete this->current;
+        this->current = NULL;
+        this->currentOffset = 0;
+    }
+
+    void compactPending() {
+        if (this->pendingOffset == this->pending.size()) {
+            this->pending.clear();
+            this->pendingOffset = 0;
+        } else if (this->pendingOffset >= this->pending.size() / 2) {
+            this->pending.erase(this->pending.begin(), this->pending.begin() + this->pendingOffset);
+            this->pendingOffset = 0;
+        }
+    }
+};
+#endif
+
+#ifdef USE_LZ4
+// An lz4 stream of any number of frames, in the lz4 frame format.
+class Lz4Decompressor : public Decompressor {
+   public:
+    Lz4Decompressor() : dctx(NULL) {
+    }
+
+    virtual ~Lz4Decompressor() {
+        this->end();
+    }
+
+    void init() {
+        if (this->dctx == NULL) {
+            LZ4F_errorCode_t ret = LZ4F_createDecompressionContext(&this->dctx, LZ4F_VERSION);
+            S3_CHECK_OR_DIE(!LZ4F_isError(ret), S3RuntimeError,
+                            string("failed to initialize lz4 library: ") + LZ4F_getErrorName(ret));
+        } else {
+            LZ4F_resetDecompressionContext(this->dctx);
+        }
+    }
+
+    void decompress(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) {
+        size_t srcSize = inLen;
+        size_t dstSize = outLen;
+
+        // a frame is ended by a call returning 0, the next call starts another
+        size_t ret = LZ4F_decompress(this->dctx, out, &dstSize, in, &srcSize, NULL);
+        S3_CHECK_OR_DIE(!LZ4F_isError(ret), S3RuntimeError,
+                        string("Failed to decompress data: ") + LZ4F_getErrorName(ret));
+
+        in += srcSize;
+        inLen -= srcSize;
+        out += dstSize;
+        outLen -= dstSize;
+    }
+
+    void end() {
+        if (this->dctx != NULL) {
+            LZ4F_freeDecompressionContext(this->dctx);
+            this->dctx = NULL;
+        }
+    }
+
+   private:
+    LZ4F_dctx *dctx;
+};
+#endif
+
+struct Crc32cTable {
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; j++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+
+    uint32_t entries[256];
+};
+
+// CRC-32C, masked as the snappy framing format stores it.
+static uint32_t SnappyMaskedCrc32c(const uint8_t *data, uint64_t len) {
+    static const Crc32cTable table;
+
+    uint32_t crc = 0xffffffff;
+    for (uint64_t i = 0; i < len; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    crc = ~crc;
+
+    return ((crc >> 15) | (crc << 17)) + 0xa282ead8;
+}
+
+// The snappy framing format, a sequence of chunks of at most 64kB of data
+// each. A chunk is gathered whole before it is decoded.
+class SnappyDecompressor : public Decompressor {
+   public:
+    SnappyDecompressor() : decodedOffset(0) {
+    }
+
+    void init() {
+        this->chunk.clear();
+        this->decoded.clear();
+        this->decodedOffset = 0;
+    }
+
+    void decompress(const char *&in, uint64_t &inLen, char *&out, uint64_t &outLen) {
+        while (outLen > 0) {
+            if (this->decodedOffset < this->decoded.size()) {
+                uint64_t n = std::min(outLen, this->decoded.size() - this->decodedOffset);
+                memcpy(out, this->decoded.data() + this->decodedOffset, n);
+                this->decodedOffset += n;
+                out += n;
+                outLen -= n;
+                continue;
+            }
+
+            uint64_t chunkLen = this->chunkLength();
+            if (this->chunk.size() < chunkLen) {
+                if (inLen == 0) {
+                    return;
+                }
+
+                uint64_t n = std::min(chunkLen - this->chunk.size(), inLen);
+                this->chunk.insert(this->chunk.end(), in, in + n);
+                in += n;
+                inLen -= n;
+                continue;
+            }
+
+            this->decodeChunk();
+            this->chunk.clear();
+        }
+    }
+
+    void end() {
+        vector<uint8_t>().swap(this->chunk);
+        vector<uint8_t>().swap(this->decoded);
+        this->decodedOffset = 0;
+    }
+
+   private:
+    vector<uint8_t> chunk;    // header included
+    vector<uint8_t> decoded;  // data of the last chunk
+    uint64_t decodedOffset;
+
+    uint64_t chunkLength() const {
+        if (this->chunk.size() < SNAPPY_CHUNK_HEADER_LEN) {
+            return SNAPPY_CHUNK_HEADER_LEN;
+        }
+        return SNAPPY_CHUNK_HEADER_LEN + ((uint64_t)this->chunk[1] |
+                                          ((uint64_t)this->chunk[2] << 8) |
+                                          ((uint64_t)this->chunk[3] << 16));
+    }
+
+    void decodeChunk() {
+        uint8_t type = this->chunk[0];
+        const uint8_t *body = this->chunk.data() + SNAPPY_CHUNK_HEADER_LEN;
+        uint64_t len = this->chunk.size() - SNAPPY_CHUNK_HEADER_LEN;
+
+        this->decoded.clear();
+        this->decodedOffset = 0;
+
+        if (type == 0xff) {  // stream identifier
+            S3_CHECK_OR_DIE(len == 6 && memcmp(body, "sNaPpY", 6) == 0, S3RuntimeError,
+                            "Failed to decompress data: invalid snappy stream identifier");
+            return;
+        }
+
+        if (type >= 0x80) {  // skippable, padding included
+            return;
+        }
+
+        S3_CHECK_OR_DIE(type <= 0x01, S3RuntimeError,
+                        "Failed to decompress data: unsupported snappy chunk type " +
+                            std::to_string(type));
+        S3_CHECK_OR_DIE(len >= SNAPPY_CHECKSUM_LEN, S3RuntimeError,
+                        "Failed to decompress data: invalid snappy chunk");
+
+        uint32_t checksum = ReadLE32(body);
+        const uint8_t *data = body + SNAPPY_CHECKSUM_LEN;
+        uint64_t dataLen = len - SNAPPY_CHECKSUM_LEN;
+
+        if (type == 0x00) {
+            uint64_t rawLen = 0;
+            for (uint64_t i = 0, shift = 0;; i++, shift += 7) {
+                S3_CHECK_OR_DIE(i < dataLen && shift <= 28, S3RuntimeError,
+                                "Failed to decompress data: invalid snappy chunk");
+                rawLen |= (uint64_t)(data[i] & 0x7f) << shift;
+                if ((data[i] & 0x80) == 0) {
+                    break;
+                }
+            }
+            S3_CHECK_OR_DIE(rawLen <= SNAPPY_MAX_BLOCK_SIZE, S3RuntimeError,
+                            "Failed to decompress data: invalid snappy chunk");
+
+            this->decoded.resize(rawLen);
+            SnappyRawDecompress(data, dataLen, this->decoded.data(), rawLen);
+        } else {
+            S3_CHECK_OR_DIE(dataLen <= SNAPPY_MAX_BLOCK_SIZE, S3RuntimeError,
+                            "Failed to decompress data: invalid snappy chunk");
+            this->decoded.assign(data, data + dataLen);
+        }
+
+        S3_CHECK_OR_DIE(SnappyMaskedCrc32c(this->decoded.data(), this->decoded.size()) == checksum,
+                        S3RuntimeError, "Failed to decompress data: snappy checksum mismatch");
+    }
+};
+
+void SnappyRawDecompress(const uint8_t *src, uint64_t srcLen, uint8_t *dst, uint64_t dstLen) {
+    const uint8_t *p = src;
+    const uint8_t *end = src + srcLen;
+    uint8_t *out = dst;
+    uint8_t *outEnd = dst + dstLen;
+
+    uint64_t len = 0;
+    for (int shift = 0;; shift += 7) {
+        S3_CHECK_OR_DIE(p < end && shift <= 28, S3RuntimeError, "invalid snappy block");
+        len |= (uint64_t)(*p & 0x7f) << shift;
+        if ((*p++ & 0x80) == 0) {
+            break;
+        }
+    }
+    S3_CHECK_OR_DIE(len == dstLen, S3RuntimeError, "snappy block has unexpected length");
+
+    while (p < end) {
+        uint8_t tag = *p++;
+        uint64_t length, offset;
+
+        if ((tag & 3) == 0) {  // literal
+            length = tag >> 2;
+            if (length >= 60) {
+                uint64_t n = length - 59;
+                S3_CHECK_OR_DIE((uint64_t)(end - p) >= n, S3RuntimeError, "invalid snappy block");
+                length = 0;
+                for (uint64_t i = 0; i < n; i++) {
+                    length |= (uint64_t)p[i] << (8 * i);
+                }
+                p += n;
+            }
+            length += 1;
+            S3_CHECK_OR_DIE(
+                (uint64_t)(end - p) >= length && (uint64_t)(outEnd - out) >= length,
+                S3RuntimeError, "invalid snappy block");
+            memcpy(out, p, length);
+            p += length;
+            out += length;
+            continue;
+        }
+
+        if ((tag & 3) == 1) {
+            S3_CHECK_OR_DIE(end - p >= 1, S3RuntimeError, "invalid snappy block");
+            length = ((tag >> 2) & 7) + 4;
+            offset = ((uint64_t)(tag >> 5) << 8) | p[0];
+            p += 1;
+        } else if ((tag & 3) == 2) {
+            S3_CHECK_OR_DIE(end - p >= 2, S3RuntimeError, "invalid snappy block");
+            length = (tag >> 2) + 1;
+            offset = (uint64_t)p[0] | ((uint64_t)p[1] << 8);
+            p += 2;
+        } else {
+            S3_CHECK_OR_DIE(end - p >= 4, S3RuntimeError, "invalid snappy block");
+            length = (tag >> 2) + 1;
+            offset = ReadLE32(p);
+            p += 4;
+        }
+
+        S3_CHECK_OR_DIE(
+            offset > 0 && offset <= (uint64_t)(out - dst) && length <= (uint64_t)(outEnd - out),
+            S3RuntimeError, "invalid snappy block");
+        // the copy may overlap its own output
+        for (uint64_t i = 0; i < length; i++) {
+            out[i] = out[i - offset];
+        }
+        out += length;
+    }
+
+    S3_CHECK_OR_DIE(out == outEnd, S3RuntimeError, "snappy block has unexpected length");
+}
+
+static Decompressor *CreateZlibDecompressor() {
+    return new ZlibDecompressor();
+}
+
+#ifdef USE_ZSTD
+static Decompressor *CreateZstdDecompressor() {
+    return new ZstdDecompressor();
+}
+#else
+#define CreateZstdDecompressor NULL
+#endif
+
+#ifdef USE_LZ4
+static Decompressor *CreateLz4Decompressor() {
+    return new Lz4Decompressor();
+}
+#else
+#define CreateLz4Decompressor NULL
+#endif
+
+static Decompressor *CreateSnappyDecompressor() {
+    return new SnappyDecompressor();
+}
+
+// The registry of compressed formats. Formats without a decompressor in
+// this build are still detected, to fail with a clear message instead of
+// loading compressed bytes as rows.
+struct CompressionFormat {
+    S3CompressionType type;
+    const char *name;
+    const char *magic;  // NULL if detected by extension
+    uint64_t magicLen;
+    Decompressor *(*create)();
+};
+
+static const CompressionFormat compressionFormats[] = {
+    {S3_COMPRESSION_GZIP, "gzip", "\x1f\x8b", 2, CreateZlibDecompressor},
+    {S3_COMPRESSION_DEFLATE, "deflate", NULL, 0, CreateZlibDecompressor},
+    {S3_COMPRESSION_ZSTD, "zstd", "\x28\xb5\x2f\xfd", 4, CreateZstdDecompressor},
+    {S3_COMPRESSION_SNAPPY, "snappy", "\xff\x06\x00\x00", 4, CreateSnappyDecompressor},
+    {S3_COMPRESSION_LZ4, "lz4", "\x04\x22\x4d\x18", 4, CreateLz4Decompressor},
+};
+
+#define COMPRESSION_FORMAT_NUM (sizeof(compressionFormats) / sizeof(compressionFormats[0]))
+
+static DecompressStats decompressStats[COMPRESSION_FORMAT_NUM];
+
+static int FindCompressionFormat(S3CompressionType type) {
+    for (uint64_t i = 0; i < COMPRESSION_FORMAT_NUM; i++) {
+        if (compressionFormats[i].type == type) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+S3CompressionType DetectCompressionType(const uint8_t *data, uint64_t len) {
+    for (uint64_t i = 0; i < COMPRESSION_FORMAT_NUM; i++) {
+        const CompressionFormat &format = compressionFormats[i];
+        if (format.magic != NULL && len >= format.magicLen &&
+            memcmp(data, format.magic, format.magicLen) == 0) {
+            return format.type;
+        }
+    }
+    return S3_COMPRESSION_PLAIN;
+}
+
+const char *GetCompressionName(S3CompressionType type) {
+    int i = FindCompressionFormat(type);
+    return (i >= 0) ? compressionFormats[i].name : "plain";
+}
+
+Decompressor *CreateDecompressor(S3CompressionType type) {
+    int i = FindCompressionFormat(type);
+    if (i < 0 || compressionFormats[i].create == NULL) {
+        return NULL;
+    }
+    return compressionFormats[i].create();
+}
+
+DecompressStats &GetDecompressStats(S3CompressionType type) {
+    int i = FindCompressionFormat(type);
+    S3_CHECK_OR_DIE(i >= 0, S3RuntimeError, "not a compressed format");
+    return decompressStats[i];
+}
+
+string GetDecompressStatsSummary() {
+    stringstream summary;
+    char buf[256];
+
+    for (uint64_t i = 0; i < COMPRESSION_FORMAT_NUM; i++) {
+        const DecompressStats &stats = decompressStats[i];
+        if (stats.inBytes == 0) {
+            continue;
+        }
+
+        double seconds = stats.usecs / 1000000.0;
+        double outMB = stats.outBytes / (1024.0 * 1024.0);
+        snprintf(buf, sizeof(buf),
+                 "%s: %" PRIu64 " bytes decompressed to %" PRIu64 " bytes in %.3f s, %.1f MB/s\n",
+                 compressionFormats[i].name, stats.inBytes, stats.outBytes, seconds,
+                 (seconds > 0) ? outMB / seconds : 0.0);
+        summary << buf;
+    }
+
+    return summary.str();
+}
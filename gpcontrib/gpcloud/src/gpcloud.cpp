@@ -13,14 +13,26 @@ extern "C" {
 
 #include "access/external.h"
 #include "access/extprotocol.h"
+#include "access/stratnum.h"
+#include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_opfamily.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "commands/defrem.h"
 #include "fmgr.h"
 #include "funcapi.h"
+#include "mb/pg_wchar.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodeFuncs.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/pg_locale.h"
 #include "utils/resowner.h"
 
 #ifdef __clang__
@@ -122,8 +134,25 @@ static const char *getFormatStr(FunctionCallInfo fcinfo) {
 
 bool hasHeader = false;
 
+// Rows of TEXT format data are not expected to contain a raw EOL (CSV ones may
+// have it quoted), so such keys can be split into byte ranges at any EOL.
+bool isTextFormat = false;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+char textDelimiter = '\t';
+char textEscape = '\\';
+string textNullString = "\\N";
+vector<string> columnNames;
+vector<bool> columnReferenced;
+vector<ColumnPredicate> columnPredicates;
+
+// DELIMITER and ESCAPE are single characters, or 'OFF'.
+static char parseTextChar(DefElem *defel) {
+    const char *value = defGetString(defel);
+    return (pg_strcasecmp(value, "off") == 0) ? '\0' : value[0];
+}
+
 static void parseFormatOpts(FunctionCallInfo fcinfo) {
     Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
     ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
@@ -132,6 +161,21 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     const List *fmtopts = exttbl->options;
     char *newline_str = NULL;
 
+    isTextFormat = fmttype_is_text(fmtcode);
+
+    textDelimiter = '\t';
+    textEscape = '\\';
+    textNullString = "\\N";
+    columnNames.clear();
+
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+        if (!attr->attisdropped) {
+            columnNames.push_back(NameStr(attr->attname));
+        }
+    }
+
     // only TEXT and CSV have detailed options
     if (fmttype_is_csv(fmtcode) || fmttype_is_text(fmtcode)) {
         ListCell *option;
@@ -142,6 +186,12 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
                 hasHeader = defGetBoolean(defel);
             } else if (strcmp(defel->defname, "newline") == 0) {
                 newline_str = defGetString(defel);
+            } else if (strcmp(defel->defname, "delimiter") == 0) {
+                textDelimiter = parseTextChar(defel);
+            } else if (strcmp(defel->defname, "escape") == 0) {
+                textEscape = parseTextChar(defel);
+            } else if (strcmp(defel->defname, "null") == 0) {
+                textNullString = defGetString(defel);
             }
         }
 
@@ -169,6 +219,179 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     }
 }
 
+// Collect the attributes of the Vars in an expression of the scan, which all
+// refer to the scanned table.
+static bool collectScanAttrs(Node *node, void *context) {
+    Bitmapset **attrs = (Bitmapset **)context;
+
+    if (node == NULL) return false;
+
+    if (IsA(node, Var)) {
+        Var *var = (Var *)node;
+        if (var->varlevelsup == 0) {
+            *attrs = bms_add_member(*attrs, var->varattno - FirstLowInvalidHeapAttributeNumber);
+        }
+        return false;
+    }
+
+    return expression_tree_walker_wrapper(node, collectScanAttrs, context);
+}
+
+// Turn a qual comparing a column with a constant into a ColumnPredicate,
+// if it is one that row groups can be skipped by.
+static bool makeColumnPredicate(Node *qual, const vector<int> &columnOfAtt, bool utf8,
+                                ColumnPredicate &predicate) {
+    if (!IsA(qual, OpExpr)) return false;
+
+    OpExpr *opexpr = (OpExpr *)qual;
+    if (list_length(opexpr->args) != 2) return false;
+
+    Node *colnode = (Node *)linitial(opexpr->args);
+    Node *constnode = (Node *)lsecond(opexpr->args);
+    bool commuted = false;
+    if (IsA(colnode, Const)) {
+        std::swap(colnode, constnode);
+        commuted = true;
+    }
+
+    // varchar columns are compared as text
+    Node *varnode = colnode;
+    if (IsA(varnode, RelabelType)) {
+        varnode = (Node *)((RelabelType *)varnode)->arg;
+    }
+    if (!IsA(varnode, Var) || !IsA(constnode, Const)) return false;
+
+    Var *var = (Var *)varnode;
+    Const *constval = (Const *)constnode;
+    if (var->varlevelsup != 0 || var->varattno <= 0 || var->varattno > (int)columnOfAtt.size() ||
+        columnOfAtt[var->varattno - 1] < 0 || constval->constisnull) {
+        return false;
+    }
+
+    Oid coltype = exprType(colnode);
+    Oid opfamily;
+    if (coltype == INT2OID || coltype == INT4OID || coltype == INT8OID) {
+        predicate.kind = PREDICATE_INTEGER;
+        opfamily = INTEGER_BTREE_FAM_OID;
+        if (constval->consttype == INT2OID) {
+            predicate.intValue = DatumGetInt16(constval->constvalue);
+        } else if (constval->consttype == INT4OID) {
+            predicate.intValue = DatumGetInt32(constval->constvalue);
+        } else if (constval->consttype == INT8OID) {
+            predicate.intValue = DatumGetInt64(constval->constvalue);
+        } else {
+            return false;
+        }
+    } else if (coltype == DATEOID) {
+        DateADT date = DatumGetDateADT(constval->constvalue);
+        if (constval->consttype != DATEOID || DATE_NOT_FINITE(date)) return false;
+
+        predicate.kind = PREDICATE_DATE;
+        opfamily = get_opclass_family(GetDefaultOpClass(DATEOID, BTREE_AM_OID));
+        predicate.intValue = (int64)date + (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
+    } else if (coltype == TEXTOID) {
+        // parquet strings are UTF-8, compared bytewise
+        if (constval->consttype != TEXTOID || !utf8) return false;
+
+        predicate.kind = PREDICATE_STRING;
+        opfamily = TEXT_BTREE_FAM_OID;
+        char *value = TextDatumGetCString(constval->constvalue);
+        predicate.stringValue = value;
+        pfree(value);
+    } else {
+        return false;
+    }
+
+    int strategy = get_op_opfamily_strategy(opexpr->opno, opfamily);
+    switch (strategy) {
+        case BTLessStrategyNumber:
+            predicate.op = commuted ? PREDICATE_GT : PREDICATE_LT;
+            break;
+        case BTLessEqualStrategyNumber:
+            predicate.op = commuted ? PREDICATE_GE : PREDICATE_LE;
+            break;
+        case BTEqualStrategyNumber:
+            predicate.op = PREDICATE_EQ;
+            break;
+        case BTGreaterEqualStrategyNumber:
+            predicate.op = commuted ? PREDICATE_LE : PREDICATE_GE;
+            break;
+        case BTGreaterStrategyNumber:
+            predicate.op = commuted ? PREDICATE_LT : PREDICATE_GT;
+            break;
+        default:
+            return false;
+    }
+
+    // only the C collation orders strings bytewise
+    if (predicate.kind == PREDICATE_STRING && OidIsValid(opexpr->inputcollid) &&
+        !(predicate.op == PREDICATE_EQ ? get_collation_isdeterministic(opexpr->inputcollid)
+                                       : lc_collate_is_c(opexpr->inputcollid))) {
+        return false;
+    }
+
+    predicate.column = columnOfAtt[var->varattno - 1];
+    return true;
+}
+
+/*
+ * Find the columns the scan references, and the quals row groups of parquet
+ * keys can be skipped by, see gpcommon.h.
+ */
+static void parseSelectDesc(FunctionCallInfo fcinfo) {
+    columnReferenced.clear();
+    columnPredicates.clear();
+
+    // Without filter pushdown, the quals of the scan are not known.
+    ExternalSelectDesc desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
+    if (desc == NULL || !gp_external_enable_filter_pushdown) return;
+
+    Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
+    ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    bool utf8 = (exttbl->encoding == PG_UTF8 && GetDatabaseEncoding() == PG_UTF8);
+
+    // the position in columnNames of each attribute
+    vector<int> columnOfAtt(tupdesc->natts, -1);
+    int numColumns = 0;
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (!TupleDescAttr(tupdesc, i)->attisdropped) {
+            columnOfAtt[i] = numColumns++;
+        }
+    }
+
+    ListCell *lc;
+    foreach (lc, desc->filter_quals) {
+        ColumnPredicate predicate;
+        if (makeColumnPredicate((Node *)lfirst(lc), columnOfAtt, utf8, predicate)) {
+            columnPredicates.push_back(predicate);
+        }
+    }
+
+    // Without a projection the scan returns all columns, and check
+    // constraints are evaluated on all of them.
+    if (desc->projInfo == NULL || (tupdesc->constr && tupdesc->constr->num_check > 0)) return;
+
+    Bitmapset *attrs = NULL;
+    collectScanAttrs((Node *)desc->projInfo->pi_state.expr, &attrs);
+    collectScanAttrs((Node *)desc->filter_quals, &attrs);
+
+    // a whole-row reference
+    if (bms_is_member(0 - FirstLowInvalidHeapAttributeNumber, attrs)) {
+        bms_free(attrs);
+        return;
+    }
+
+    columnReferenced.assign(numColumns, false);
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (columnOfAtt[i] >= 0 &&
+            bms_is_member(i + 1 - FirstLowInvalidHeapAttributeNumber, attrs)) {
+            columnReferenced[columnOfAtt[i]] = true;
+        }
+    }
+    bms_free(attrs);
+}
+
 typedef struct gpcloudResHandle {
     GPReader *gpreader;
     GPWriter *gpwriter;
@@ -291,6 +514,7 @@ Datum s3_import(PG_FUNCTION_ARGS) {
 
         // has HEADER? and newline EOL?
         parseFormatOpts(fcinfo);
+        parseSelectDesc(fcinfo);
 
         thread_setup();
 
@@ -2,19 +2,46 @@
 #include "s3memory_mgmt.h"
 
 GPWriter::GPWriter(const S3Params& params, string fmt)
-    : format(fmt), params(params), restfulService(this->params), s3InterfaceService(this->params) {
+    : format(fmt),
+      params(params),
+      restfulService(this->params),
+      s3InterfaceService(this->params),
+      keyDataLength(0) {
     restfulServicePtr = &restfulService;
 }
 
 void GPWriter::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
+    this->basePrefix = this->params.getS3Url().getPrefix();
     this->params = this->params.setPrefix(this->genUniqueKeyName(this->params.getS3Url()));
     this->commonWriter.setS3InterfaceService(&this->s3InterfaceService);
     this->commonWriter.open(this->params);
+    this->keyDataLength = 0;
 }
 
 uint64_t GPWriter::write(const char* buf, uint64_t count) {
-    return this->commonWriter.write(buf, count);
+    // s3_export() writes whole rows, so every key starts with a new row. Roll over
+    // before writing rather than after, not to leave an empty key at the end.
+    uint64_t objectSize = this->params.getObjectSize();
+    if (objectSize > 0 && this->keyDataLength >= objectSize) {
+        this->rollToNewKey();
+    }
+
+    uint64_t written = this->commonWriter.write(buf, count);
+    this->keyDataLength += written;
+    return written;
+}
+
+void GPWriter::rollToNewKey() {
+    this->commonWriter.close();
+
+    S3DEBUG("Finished key \"%s\" with %" PRIu64 " bytes of data",
+            this->params.getS3Url().getFullUrlForCurl().c_str(), this->keyDataLength);
+
+    S3Params baseParams = this->params.setPrefix(this->basePrefix);
+    this->params = this->params.setPrefix(this->genUniqueKeyName(baseParams.getS3Url()));
+    this->commonWriter.open(this->params);
+    this->keyDataLength = 0;
 }
 
 void GPWriter::close() {
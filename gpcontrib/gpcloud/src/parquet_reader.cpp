@@ -0,0 +1,1671 @@
+#include "parquet_reader.h"
+
+#include <strings.h>
+#include <cmath>
+
+#include "decompressor.h"
+#include "gpcommon.h"
+
+// Parsing and decoding of parquet files, following parquet.thrift of the
+// Apache Parquet format. Only the parts needed to read flat schemas are here.
+
+#define PARQUET_FOOTER_PREFETCH (64 * 1024)
+#define PARQUET_ROWS_BUFFER_SIZE (64 * 1024)
+#define PARQUET_THRIFT_MAX_DEPTH 64
+
+#define PARQUET_CHECK(_condition, _message) \
+    S3_CHECK_OR_DIE(_condition, S3RuntimeError, string("corrupt parquet file: ") + _message)
+
+enum ParquetPhysicalType {
+    PT_BOOLEAN = 0,
+    PT_INT32 = 1,
+    PT_INT64 = 2,
+    PT_INT96 = 3,
+    PT_FLOAT = 4,
+    PT_DOUBLE = 5,
+    PT_BYTE_ARRAY = 6,
+    PT_FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+enum ParquetConvertedType {
+    CT_UTF8 = 0,
+    CT_ENUM = 4,
+    CT_DECIMAL = 5,
+    CT_DATE = 6,
+    CT_TIME_MILLIS = 7,
+    CT_TIME_MICROS = 8,
+    CT_TIMESTAMP_MILLIS = 9,
+    CT_TIMESTAMP_MICROS = 10,
+    CT_UINT_8 = 11,
+    CT_UINT_16 = 12,
+    CT_UINT_32 = 13,
+    CT_UINT_64 = 14,
+    CT_JSON = 19,
+};
+
+// Field ids of the LogicalType union.
+enum ParquetLogicalType {
+    LT_NONE = 0,
+    LT_STRING = 1,
+    LT_ENUM = 4,
+    LT_DECIMAL = 5,
+    LT_DATE = 6,
+    LT_TIME = 7,
+    LT_TIMESTAMP = 8,
+    LT_INTEGER = 10,
+    LT_JSON = 12,
+    LT_UUID = 14,
+};
+
+enum ParquetRepetition { REP_REQUIRED = 0, REP_OPTIONAL = 1, REP_REPEATED = 2 };
+
+enum ParquetPageType { PAGE_DATA = 0, PAGE_INDEX = 1, PAGE_DICTIONARY = 2, PAGE_DATA_V2 = 3 };
+
+enum ParquetEncoding {
+    ENC_PLAIN = 0,
+    ENC_PLAIN_DICTIONARY = 2,
+    ENC_RLE = 3,
+    ENC_RLE_DICTIONARY = 8,
+};
+
+enum ParquetCodec { CODEC_UNCOMPRESSED = 0, CODEC_SNAPPY = 1, CODEC_GZIP = 2 };
+
+// Days between the julian day number 0 and 1970-01-01, for INT96 timestamps.
+#define JULIAN_DAY_OF_EPOCH 2440588
+
+static inline uint32_t ReadLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t ReadLE64(const uint8_t *p) {
+    return (uint64_t)ReadLE32(p) | ((uint64_t)ReadLE32(p + 4) << 32);
+}
+
+// ThriftReader reads structs in the thrift compact protocol, which is what
+// the parquet footer and page headers are encoded with.
+class ThriftReader {
+   public:
+    enum Type {
+        T_STOP = 0,
+        T_BOOL_TRUE = 1,
+        T_BOOL_FALSE = 2,
+        T_BYTE = 3,
+        T_I16 = 4,
+        T_I32 = 5,
+        T_I64 = 6,
+        T_DOUBLE = 7,
+        T_BINARY = 8,
+        T_LIST = 9,
+        T_SET = 10,
+        T_MAP = 11,
+        T_STRUCT = 12,
+    };
+
+    ThriftReader(const uint8_t *data, uint64_t len) : p(data), end(data + len), lastFieldId(0) {
+    }
+
+    const uint8_t *position() const {
+        return p;
+    }
+
+    void structBegin() {
+        PARQUET_CHECK(fieldIds.size() < PARQUET_THRIFT_MAX_DEPTH, "metadata nested too deep");
+        fieldIds.push_back(lastFieldId);
+        lastFieldId = 0;
+    }
+
+    void structEnd() {
+        lastFieldId = fieldIds.back();
+        fieldIds.pop_back();
+    }
+
+    // Return false at the end of the current struct.
+    bool readFieldBegin(int16_t &id, uint8_t &type) {
+        uint8_t b = readByte();
+        type = b & 0x0f;
+        if (type == T_STOP) {
+            return false;
+        }
+
+        int16_t delta = b >> 4;
+        id = (delta != 0) ? lastFieldId + delta : (int16_t)readZigzag();
+        lastFieldId = id;
+        return true;
+    }
+
+    bool readBool(uint8_t type) {
+        return type == T_BOOL_TRUE;
+    }
+
+    int32_t readI32() {
+        return (int32_t)readZigzag();
+    }
+
+    int64_t readI64() {
+        return readZigzag();
+    }
+
+    string readBinary() {
+        uint64_t len = readVarint();
+        PARQUET_CHECK(len <= (uint64_t)(end - p), "truncated metadata");
+        string s((const char *)p, len);
+        p += len;
+        return s;
+    }
+
+    uint64_t readListBegin(uint8_t &elemType) {
+        uint8_t b = readByte();
+        elemType = b & 0x0f;
+        uint64_t size = b >> 4;
+        if (size == 15) {
+            size = readVarint();
+        }
+        // every element takes one byte at least
+        PARQUET_CHECK(size <= (uint64_t)(end - p), "truncated metadata");
+        return size;
+    }
+
+    void skip(uint8_t type) {
+        switch (type) {
+            case T_BOOL_TRUE:
+            case T_BOOL_FALSE:
+                // the value of a bool field is in its type
+                break;
+            case T_BYTE:
+                readByte();
+                break;
+            case T_I16:
+            case T_I32:
+            case T_I64:
+                readVarint();
+                break;
+            case T_DOUBLE:
+                PARQUET_CHECK(end - p >= 8, "truncated metadata");
+                p += 8;
+                break;
+            case T_BINARY:
+                readBinary();
+                break;
+            case T_LIST:
+            case T_SET: {
+                uint8_t elemType;
+                uint64_t size = readListBegin(elemType);
+                for (uint64_t i = 0; i < size; i++) {
+                    skipElement(elemType);
+                }
+                break;
+            }
+            case T_MAP: {
+                uint64_t size = readVarint();
+                if (size > 0) {
+                    uint8_t types = readByte();
+                    for (uint64_t i = 0; i < size; i++) {
+                        skipElement(types >> 4);
+                        skipElement(types & 0x0f);
+                    }
+                }
+                break;
+            }
+            case T_STRUCT: {
+                int16_t id;
+                uint8_t fieldType;
+                structBegin();
+                while (readFieldBegin(id, fieldType)) {
+                    skip(fieldType);
+                }
+                structEnd();
+                break;
+            }
+            default:
+                PARQUET_CHECK(false, "unknown thrift type " + std::to_string(type));
+        }
+    }
+
+   private:
+    const uint8_t *p;
+    const uint8_t *end;
+    int16_t lastFieldId;
+    vector<int16_t> fieldIds;  // of the enclosing structs
+
+    uint8_t readByte() {
+        PARQUET_CHECK(p < end, "truncated metadata");
+        return *p++;
+    }
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = readByte();
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        PARQUET_CHECK(false, "invalid varint in metadata");
+        return 0;
+    }
+
+    int64_t readZigzag() {
+        uint64_t n = readVarint();
+        return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+    }
+
+    // Elements of collections are not fields, a bool takes a byte there.
+    void skipElement(uint8_t type) {
+        if (type == T_BOOL_TRUE || type == T_BOOL_FALSE) {
+            readByte();
+        } else {
+            skip(type);
+        }
+    }
+};
+
+struct ParquetSchemaElement {
+    ParquetSchemaElement()
+        : type(-1),
+          typeLength(0),
+          repetition(REP_REQUIRED),
+          numChildren(0),
+          convertedType(-1),
+          scale(0),
+          logicalType(LT_NONE),
+          logicalScale(0),
+          logicalUnitsPerSecond(1000000),
+          logicalUTC(false),
+          logicalSigned(true) {
+    }
+
+    int32_t type;
+    int32_t typeLength;
+    int32_t repetition;
+    string name;
+    int32_t numChildren;
+    int32_t convertedType;
+    int32_t scale;
+
+    int16_t logicalType;
+    int32_t logicalScale;
+    int64_t logicalUnitsPerSecond;
+    bool logicalUTC;
+    bool logicalSigned;
+};
+
+static int64_t ParseTimeUnit(ThriftReader &thrift) {
+    int16_t id;
+    uint8_t type;
+    int64_t unitsPerSecond = 1000000;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1) {
+            unitsPerSecond = 1000;
+        } else if (id == 2) {
+            unitsPerSecond = 1000000;
+        } else if (id == 3) {
+            unitsPerSecond = 1000000000;
+        }
+        thrift.skip(type);
+    }
+    thrift.structEnd();
+
+    return unitsPerSecond;
+}
+
+static void ParseLogicalType(ThriftReader &thrift, ParquetSchemaElement &element) {
+    int16_t id, subId;
+    uint8_t type, subType;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        element.logicalType = id;
+        if (type != ThriftReader::T_STRUCT ||
+            (id != LT_DECIMAL && id != LT_TIME && id != LT_TIMESTAMP && id != LT_INTEGER)) {
+            thrift.skip(type);
+            continue;
+        }
+
+        thrift.structBegin();
+        while (thrift.readFieldBegin(subId, subType)) {
+            if (id == LT_DECIMAL && subId == 1 && subType == ThriftReader::T_I32) {
+                element.logicalScale = thrift.readI32();
+            } else if ((id == LT_TIME || id == LT_TIMESTAMP) && subId == 1) {
+                element.logicalUTC = thrift.readBool(subType);
+            } else if ((id == LT_TIME || id == LT_TIMESTAMP) && subId == 2 &&
+                       subType == ThriftReader::T_STRUCT) {
+                element.logicalUnitsPerSecond = ParseTimeUnit(thrift);
+            } else if (id == LT_INTEGER && subId == 2) {
+                element.logicalSigned = thrift.readBool(subType);
+            } else {
+                thrift.skip(subType);
+            }
+        }
+        thrift.structEnd();
+    }
+    thrift.structEnd();
+}
+
+static void ParseSchemaElement(ThriftReader &thrift, ParquetSchemaElement &element) {
+    int16_t id;
+    uint8_t type;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1 && type == ThriftReader::T_I32) {
+            element.type = thrift.readI32();
+        } else if (id == 2 && type == ThriftReader::T_I32) {
+            element.typeLength = thrift.readI32();
+        } else if (id == 3 && type == ThriftReader::T_I32) {
+            element.repetition = thrift.readI32();
+        } else if (id == 4 && type == ThriftReader::T_BINARY) {
+            element.name = thrift.readBinary();
+        } else if (id == 5 && type == ThriftReader::T_I32) {
+            element.numChildren = thrift.readI32();
+        } else if (id == 6 && type == ThriftReader::T_I32) {
+            element.convertedType = thrift.readI32();
+        } else if (id == 7 && type == ThriftReader::T_I32) {
+            element.scale = thrift.readI32();
+        } else if (id == 10 && type == ThriftReader::T_STRUCT) {
+            ParseLogicalType(thrift, element);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+}
+
+static void ParseStatistics(ThriftReader &thrift, ParquetColumnChunkInfo &chunk) {
+    int16_t id;
+    uint8_t type;
+    bool hasLegacyMax = false, hasLegacyMin = false, hasMax = false, hasMin = false;
+    string legacyMax, legacyMin, max, min;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1 && type == ThriftReader::T_BINARY) {
+            legacyMax = thrift.readBinary();
+            hasLegacyMax = true;
+        } else if (id == 2 && type == ThriftReader::T_BINARY) {
+            legacyMin = thrift.readBinary();
+            hasLegacyMin = true;
+        } else if (id == 3 && type == ThriftReader::T_I64) {
+            chunk.nullCount = thrift.readI64();
+        } else if (id == 5 && type == ThriftReader::T_BINARY) {
+            max = thrift.readBinary();
+            hasMax = true;
+        } else if (id == 6 && type == ThriftReader::T_BINARY) {
+            min = thrift.readBinary();
+            hasMin = true;
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+
+    // max_value and min_value follow the sort order of the logical type, the
+    // deprecated max and min the signed one of the physical type.
+    if (hasMax && hasMin) {
+        chunk.hasMinMax = true;
+        chunk.maxValue.swap(max);
+        chunk.minValue.swap(min);
+    } else if (hasLegacyMax && hasLegacyMin) {
+        chunk.hasMinMax = true;
+        chunk.legacyMinMax = true;
+        chunk.maxValue.swap(legacyMax);
+        chunk.minValue.swap(legacyMin);
+    }
+}
+
+static void ParseColumnMetaData(ThriftReader &thrift, ParquetColumnChunkInfo &chunk) {
+    int16_t id;
+    uint8_t type;
+    int64_t dataPageOffset = -1;
+    int64_t dictionaryPageOffset = -1;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 4 && type == ThriftReader::T_I32) {
+            chunk.codec = thrift.readI32();
+        } else if (id == 5 && type == ThriftReader::T_I64) {
+            chunk.numValues = thrift.readI64();
+        } else if (id == 7 && type == ThriftReader::T_I64) {
+            chunk.compressedSize = thrift.readI64();
+        } else if (id == 9 && type == ThriftReader::T_I64) {
+            dataPageOffset = thrift.readI64();
+        } else if (id == 11 && type == ThriftReader::T_I64) {
+            dictionaryPageOffset = thrift.readI64();
+        } else if (id == 12 && type == ThriftReader::T_STRUCT) {
+            ParseStatistics(thrift, chunk);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+
+    // Some writers set a zero dictionary page offset when there is none.
+    if (dictionaryPageOffset > 0 && dictionaryPageOffset < dataPageOffset) {
+        chunk.offset = dictionaryPageOffset;
+    } else {
+        chunk.offset = dataPageOffset;
+    }
+}
+
+static void ParseColumnChunk(ThriftReader &thrift, ParquetColumnChunkInfo &chunk) {
+    int16_t id;
+    uint8_t type;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1 && type == ThriftReader::T_BINARY) {
+            chunk.external = !thrift.readBinary().empty();
+        } else if (id == 3 && type == ThriftReader::T_STRUCT) {
+            ParseColumnMetaData(thrift, chunk);
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+}
+
+static void ParseRowGroup(ThriftReader &thrift, ParquetRowGroupInfo &rowGroup) {
+    int16_t id;
+    uint8_t type;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1 && type == ThriftReader::T_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListBegin(elemType);
+            PARQUET_CHECK(elemType == ThriftReader::T_STRUCT, "invalid column chunk list");
+            rowGroup.columns.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseColumnChunk(thrift, rowGroup.columns[i]);
+            }
+        } else if (id == 3 && type == ThriftReader::T_I64) {
+            rowGroup.numRows = thrift.readI64();
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+}
+
+static ParquetColumnInfo MakeColumnInfo(const ParquetSchemaElement &e, const string &name,
+                                        bool nested) {
+    ParquetColumnInfo column;
+    column.name = name;
+    column.physicalType = e.type;
+    column.typeLength = e.typeLength;
+    column.optional = (e.repetition == REP_OPTIONAL);
+
+    if (nested || e.repetition == REP_REPEATED) {
+        column.kind = PARQUET_UNSUPPORTED;
+        return column;
+    }
+
+    // The logical type supersedes the converted type when both are set.
+    int16_t lt = e.logicalType;
+    int32_t ct = e.convertedType;
+    bool isDecimal = (lt == LT_DECIMAL) || (lt == LT_NONE && ct == CT_DECIMAL);
+    column.scale = (lt == LT_DECIMAL) ? e.logicalScale : e.scale;
+
+    switch (e.type) {
+        case PT_BOOLEAN:
+            column.kind = PARQUET_BOOLEAN;
+            break;
+        case PT_INT32:
+            if (lt == LT_DATE || (lt == LT_NONE && ct == CT_DATE)) {
+                column.kind = PARQUET_DATE;
+            } else if (isDecimal) {
+                column.kind = PARQUET_DECIMAL;
+            } else if (lt == LT_TIME || (lt == LT_NONE && ct == CT_TIME_MILLIS)) {
+                column.kind = PARQUET_TIME;
+                column.unitsPerSecond = (lt == LT_TIME) ? e.logicalUnitsPerSecond : 1000;
+            } else if ((lt == LT_INTEGER && !e.logicalSigned) ||
+                       (lt == LT_NONE &&
+                        (ct == CT_UINT_8 || ct == CT_UINT_16 || ct == CT_UINT_32))) {
+                column.kind = PARQUET_UINT32;
+            } else {
+                column.kind = PARQUET_INT32;
+            }
+            break;
+        case PT_INT64:
+            if (isDecimal) {
+                column.kind = PARQUET_DECIMAL;
+            } else if (lt == LT_TIMESTAMP) {
+                column.kind = PARQUET_TIMESTAMP;
+                column.unitsPerSecond = e.logicalUnitsPerSecond;
+                column.adjustedToUTC = e.logicalUTC;
+            } else if (lt == LT_NONE && (ct == CT_TIMESTAMP_MILLIS || ct == CT_TIMESTAMP_MICROS)) {
+                column.kind = PARQUET_TIMESTAMP;
+                column.unitsPerSecond = (ct == CT_TIMESTAMP_MILLIS) ? 1000 : 1000000;
+                column.adjustedToUTC = true;
+            } else if (lt == LT_TIME || (lt == LT_NONE && ct == CT_TIME_MICROS)) {
+                column.kind = PARQUET_TIME;
+                column.unitsPerSecond = (lt == LT_TIME) ? e.logicalUnitsPerSecond : 1000000;
+            } else if ((lt == LT_INTEGER && !e.logicalSigned) ||
+                       (lt == LT_NONE && ct == CT_UINT_64)) {
+                column.kind = PARQUET_UINT64;
+            } else {
+                column.kind = PARQUET_INT64;
+            }
+            break;
+        case PT_INT96:
+            column.kind = PARQUET_INT96_TIMESTAMP;
+            break;
+        case PT_FLOAT:
+            column.kind = PARQUET_FLOAT;
+            break;
+        case PT_DOUBLE:
+            column.kind = PARQUET_DOUBLE;
+            break;
+        case PT_BYTE_ARRAY:
+            if (isDecimal) {
+                column.kind = PARQUET_DECIMAL;
+            } else if (lt == LT_STRING || lt == LT_ENUM || lt == LT_JSON ||
+                       (lt == LT_NONE && (ct == CT_UTF8 || ct == CT_ENUM || ct == CT_JSON))) {
+                column.kind = PARQUET_STRING;
+            } else {
+                column.kind = PARQUET_BYTES;
+            }
+            break;
+        case PT_FIXED_LEN_BYTE_ARRAY:
+            PARQUET_CHECK(e.typeLength > 0, "invalid length of column " + name);
+            if (isDecimal) {
+                column.kind = PARQUET_DECIMAL;
+            } else if (lt == LT_UUID && e.typeLength == 16) {
+                column.kind = PARQUET_UUID;
+            } else {
+                column.kind = PARQUET_BYTES;
+            }
+            break;
+        default:
+            PARQUET_CHECK(false, "unknown type of column " + name);
+    }
+
+    return column;
+}
+
+// The schema is a depth first list of its nodes, the first one is the root.
+static void CollectLeafColumns(const vector<ParquetSchemaElement> &schema, uint64_t &pos,
+                               const string &prefix, bool nested, int depth,
+                               vector<ParquetColumnInfo> &columns) {
+    PARQUET_CHECK(pos < schema.size(), "schema has fewer nodes than referenced");
+    PARQUET_CHECK(depth < PARQUET_THRIFT_MAX_DEPTH, "schema nested too deep");
+
+    const ParquetSchemaElement &element = schema[pos++];
+    bool isRoot = (depth == 0);
+
+    if (element.numChildren > 0 || isRoot) {
+        string childPrefix = isRoot ? "" : prefix + element.name + ".";
+        bool childNested = !isRoot;
+        for (int32_t i = 0; i < element.numChildren; i++) {
+            CollectLeafColumns(schema, pos, childPrefix, childNested, depth + 1, columns);
+        }
+    } else {
+        columns.push_back(MakeColumnInfo(element, prefix + element.name, nested));
+    }
+}
+
+void ParseParquetFileInfo(const uint8_t *data, uint64_t len, ParquetFileInfo &fileInfo) {
+    ThriftReader thrift(data, len);
+    vector<ParquetSchemaElement> schema;
+    int16_t id;
+    uint8_t type;
+
+    fileInfo = ParquetFileInfo();
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 2 && type == ThriftReader::T_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListBegin(elemType);
+            PARQUET_CHECK(elemType == ThriftReader::T_STRUCT, "invalid schema list");
+            schema.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseSchemaElement(thrift, schema[i]);
+            }
+        } else if (id == 3 && type == ThriftReader::T_I64) {
+            fileInfo.numRows = thrift.readI64();
+        } else if (id == 4 && type == ThriftReader::T_LIST) {
+            uint8_t elemType;
+            uint64_t size = thrift.readListBegin(elemType);
+            PARQUET_CHECK(elemType == ThriftReader::T_STRUCT, "invalid row group list");
+            fileInfo.rowGroups.resize(size);
+            for (uint64_t i = 0; i < size; i++) {
+                ParseRowGroup(thrift, fileInfo.rowGroups[i]);
+            }
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+
+    PARQUET_CHECK(!schema.empty(), "no schema");
+
+    uint64_t pos = 0;
+    CollectLeafColumns(schema, pos, "", false, 0, fileInfo.columns);
+    PARQUET_CHECK(pos == schema.size(), "schema has more nodes than referenced");
+
+    for (uint64_t i = 0; i < fileInfo.rowGroups.size(); i++) {
+        PARQUET_CHECK(fileInfo.rowGroups[i].columns.size() == fileInfo.columns.size(),
+                      "row group " + std::to_string(i) + " does not have all columns");
+    }
+}
+
+struct ParquetPageHeader {
+    ParquetPageHeader()
+        : type(-1),
+          uncompressedSize(0),
+          compressedSize(0),
+          numValues(0),
+          encoding(ENC_PLAIN),
+          defLevelEncoding(ENC_RLE),
+          defLevelsLength(0),
+          repLevelsLength(0),
+          isCompressed(true) {
+    }
+
+    int32_t type;
+    int32_t uncompressedSize;
+    int32_t compressedSize;
+    int32_t numValues;
+    int32_t encoding;
+    int32_t defLevelEncoding;  // of DATA_PAGE
+    int32_t defLevelsLength;   // of DATA_PAGE_V2
+    int32_t repLevelsLength;   // of DATA_PAGE_V2
+    bool isCompressed;         // of DATA_PAGE_V2
+};
+
+static void ParsePageHeader(ThriftReader &thrift, ParquetPageHeader &header) {
+    int16_t id, subId;
+    uint8_t type, subType;
+
+    thrift.structBegin();
+    while (thrift.readFieldBegin(id, type)) {
+        if (id == 1 && type == ThriftReader::T_I32) {
+            header.type = thrift.readI32();
+        } else if (id == 2 && type == ThriftReader::T_I32) {
+            header.uncompressedSize = thrift.readI32();
+        } else if (id == 3 && type == ThriftReader::T_I32) {
+            header.compressedSize = thrift.readI32();
+        } else if ((id == 5 || id == 7 || id == 8) && type == ThriftReader::T_STRUCT) {
+            // DataPageHeader, DictionaryPageHeader and DataPageHeaderV2
+            thrift.structBegin();
+            while (thrift.readFieldBegin(subId, subType)) {
+                if (subId == 1 && subType == ThriftReader::T_I32) {
+                    header.numValues = thrift.readI32();
+                } else if (subId == 2 && subType == ThriftReader::T_I32) {
+                    header.encoding = thrift.readI32();
+                } else if (id == 5 && subId == 3 && subType == ThriftReader::T_I32) {
+                    header.defLevelEncoding = thrift.readI32();
+                } else if (id == 8 && subId == 4 && subType == ThriftReader::T_I32) {
+                    header.encoding = thrift.readI32();
+                } else if (id == 8 && subId == 5 && subType == ThriftReader::T_I32) {
+                    header.defLevelsLength = thrift.readI32();
+                } else if (id == 8 && subId == 6 && subType == ThriftReader::T_I32) {
+                    header.repLevelsLength = thrift.readI32();
+                } else if (id == 8 && subId == 7) {
+                    header.isCompressed = thrift.readBool(subType);
+                } else {
+                    thrift.skip(subType);
+                }
+            }
+            thrift.structEnd();
+        } else {
+            thrift.skip(type);
+        }
+    }
+    thrift.structEnd();
+
+    PARQUET_CHECK(header.compressedSize >= 0 && header.uncompressedSize >= 0 &&
+                      header.numValues >= 0,
+                  "invalid page header");
+}
+
+static void GzipDecompress(const uint8_t *src, uint64_t srcLen, uint8_t *dst, uint64_t dstLen) {
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+
+    S3_CHECK_OR_DIE(inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS) == Z_OK, S3RuntimeError,
+                    "failed to initialize zlib library");
+
+    zstream.next_in = (Bytef *)src;
+    zstream.avail_in = srcLen;
+    zstream.next_out = (Bytef *)dst;
+    zstream.avail_out = dstLen;
+
+    int status = inflate(&zstream, Z_FINISH);
+    uint64_t totalOut = zstream.total_out;
+    inflateEnd(&zstream);
+
+    PARQUET_CHECK(status == Z_STREAM_END && totalOut == dstLen, "invalid gzip page");
+}
+
+// RleBitPackedDecoder decodes the RLE/bit-packing hybrid encoding of
+// definition levels, dictionary indices and booleans.
+class RleBitPackedDecoder {
+   public:
+    RleBitPackedDecoder()
+        : p(NULL),
+          end(NULL),
+          bitWidth(0),
+          repeatCount(0),
+          repeatValue(0),
+          literalCount(0),
+          literals(NULL),
+          literalsEnd(NULL),
+          literalBit(0) {
+    }
+
+    void init(const uint8_t *data, uint64_t len, int bitWidth) {
+        PARQUET_CHECK(bitWidth >= 0 && bitWidth <= 32, "invalid bit width");
+        this->p = data;
+        this->end = data + len;
+        this->bitWidth = bitWidth;
+        this->repeatCount = 0;
+        this->literalCount = 0;
+    }
+
+    uint32_t next() {
+        while (true) {
+            if (repeatCount > 0) {
+                repeatCount--;
+                return repeatValue;
+            }
+            if (literalCount > 0) {
+                literalCount--;
+                return nextLiteral();
+            }
+            readRunHeader();
+        }
+    }
+
+   private:
+    const uint8_t *p;
+    const uint8_t *end;
+    int bitWidth;
+
+    uint64_t repeatCount;
+    uint32_t repeatValue;
+
+    uint64_t literalCount;
+    const uint8_t *literals;
+    const uint8_t *literalsEnd;
+    uint64_t literalBit;
+
+    void readRunHeader() {
+        uint64_t header = 0;
+        for (int shift = 0;; shift += 7) {
+            PARQUET_CHECK(p < end && shift <= 28, "page has fewer values than expected");
+            header |= (uint64_t)(*p & 0x7f) << shift;
+            if ((*p++ & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if (header & 1) {
+            // Groups of 8 bit-packed values. The last group may be cut
+            // short by writers when its values are not all used.
+            uint64_t groups = header >> 1;
+            uint64_t bytes = groups * bitWidth;
+            literalCount = groups * 8;
+            literals = p;
+            literalsEnd = ((uint64_t)(end - p) < bytes) ? end : p + bytes;
+            literalBit = 0;
+            p = literalsEnd;
+        } else {
+            int n = (bitWidth + 7) / 8;
+            PARQUET_CHECK(end - p >= n, "page has fewer values than expected");
+            repeatCount = header >> 1;
+            repeatValue = 0;
+            for (int i = 0; i < n; i++) {
+                repeatValue |= (uint32_t)p[i] << (8 * i);
+            }
+            p += n;
+        }
+
+        PARQUET_CHECK(repeatCount > 0 || literalCount > 0, "empty run in page");
+    }
+
+    uint32_t nextLiteral() {
+        uint64_t byte = literalBit >> 3;
+        int shift = literalBit & 7;
+        int n = (shift + bitWidth + 7) / 8;
+        PARQUET_CHECK((uint64_t)(literalsEnd - literals) >= byte + n,
+                      "page has fewer values than expected");
+
+        uint64_t word = 0;
+        for (int i = 0; i < n; i++) {
+            word |= (uint64_t)literals[byte + i] << (8 * i);
+        }
+        literalBit += bitWidth;
+
+        return (uint32_t)((word >> shift) & ((1ULL << bitWidth) - 1));
+    }
+};
+
+// Text of TEXT format rows: the escape character, and line terminators and
+// delimiters in values, have to be escaped.
+static void AppendEscaped(const char *data, uint64_t len, string &out) {
+    for (uint64_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (textEscape == '\0') {
+            S3_CHECK_OR_DIE(c != '\n' && c != '\r', S3RuntimeError,
+                            "parquet value contains a line terminator, which cannot be read "
+                            "with ESCAPE 'OFF'");
+            out += c;
+        } else if (c == '\n') {
+            out += textEscape;
+            out += 'n';
+        } else if (c == '\r') {
+            out += textEscape;
+            out += 'r';
+        } else if (c == textEscape || c == textDelimiter) {
+            out += textEscape;
+            out += c;
+        } else {
+            out += c;
+        }
+    }
+}
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static void AppendHex(const uint8_t *data, uint64_t len, string &out) {
+    for (uint64_t i = 0; i < len; i++) {
+        out += hexDigits[data[i] >> 4];
+        out += hexDigits[data[i] & 0x0f];
+    }
+}
+
+static void AppendScaledDigits(bool negative, string digits, int32_t scale, string &out) {
+    if (digits == "0") {
+        negative = false;
+    }
+
+    if (scale > 0) {
+        if (digits.size() <= (uint64_t)scale) {
+            digits.insert(0, scale - digits.size() + 1, '0');
+        }
+        digits.insert(digits.size() - scale, 1, '.');
+    } else if (scale < 0 && digits != "0") {
+        digits.append(-scale, '0');
+    }
+
+    if (negative) {
+        out += '-';
+    }
+    out += digits;
+}
+
+static void AppendDecimal(int64_t unscaled, int32_t scale, string &out) {
+    bool negative = unscaled < 0;
+    uint64_t magnitude = negative ? -(uint64_t)unscaled : (uint64_t)unscaled;
+    AppendScaledDigits(negative, std::to_string(magnitude), scale, out);
+}
+
+// The unscaled value of a binary decimal is big endian two's complement.
+static void AppendBinaryDecimal(const uint8_t *data, uint64_t len, int32_t scale, string &out) {
+    if (len <= 8) {
+        uint64_t value = (len > 0 && (data[0] & 0x80)) ? ~0ULL : 0;
+        for (uint64_t i = 0; i < len; i++) {
+            value = (value << 8) | data[i];
+        }
+        AppendDecimal((int64_t)value, scale, out);
+        return;
+    }
+
+    bool negative = (data[0] & 0x80) != 0;
+    vector<uint8_t> magnitude(data, data + len);
+    if (negative) {
+        int carry = 1;
+        for (uint64_t i = len; i-- > 0;) {
+            int v = (uint8_t)~magnitude[i] + carry;
+            magnitude[i] = (uint8_t)v;
+            carry = v >> 8;
+        }
+    }
+
+    string digits;
+    uint64_t start = 0;
+    while (start < len) {
+        int remainder = 0;
+        for (uint64_t i = start; i < len; i++) {
+            int v = (remainder << 8) | magnitude[i];
+            magnitude[i] = v / 10;
+            remainder = v % 10;
+        }
+        digits += (char)('0' + remainder);
+        while (start < len && magnitude[start] == 0) {
+            start++;
+        }
+    }
+    if (digits.empty()) {
+        digits = "0";
+    }
+
+    AppendScaledDigits(negative, string(digits.rbegin(), digits.rend()), scale, out);
+}
+
+// Convert days since 1970-01-01 to a proleptic gregorian date.
+static void CivilFromDays(int64_t days, int64_t &year, unsigned &month, unsigned &day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = (unsigned)(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned mp = (5 * dayOfYear + 2) / 153;
+
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = (int64_t)yearOfEra + era * 400 + (month <= 2);
+}
+
+// Return true for a date before year 1, which is printed with a BC suffix.
+static bool AppendDate(int64_t days, string &out) {
+    int64_t year;
+    unsigned month, day;
+    char buf[64];
+
+    CivilFromDays(days, year, month, day);
+
+    bool bc = (year <= 0);
+    snprintf(buf, sizeof(buf), "%04" PRId64 "-%02u-%02u", bc ? 1 - year : year, month, day);
+    out += buf;
+
+    return bc;
+}
+
+static void AppendTimeOfDay(int64_t seconds, int64_t fraction, int64_t unitsPerSecond,
+                            string &out) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", (int)(seconds / 3600), (int)(seconds / 60 % 60),
+             (int)(seconds % 60));
+    out += buf;
+
+    // PostgreSQL keeps microseconds
+    int64_t micros = fraction * 1000000 / unitsPerSecond;
+    if (micros != 0) {
+        snprintf(buf, sizeof(buf), ".%06d", (int)micros);
+        out += buf;
+    }
+}
+
+static void AppendTimestamp(int64_t value, int64_t unitsPerSecond, bool utc, string &out) {
+    int64_t seconds = value / unitsPerSecond;
+    int64_t fraction = value % unitsPerSecond;
+    if (fraction < 0) {
+        fraction += unitsPerSecond;
+        seconds--;
+    }
+
+    int64_t days = seconds / 86400;
+    int64_t secondOfDay = seconds % 86400;
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        days--;
+    }
+
+    bool bc = AppendDate(days, out);
+    out += ' ';
+    AppendTimeOfDay(secondOfDay, fraction, unitsPerSecond, out);
+    if (utc) {
+        out += "+00";
+    }
+    if (bc) {
+        out += " BC";
+    }
+}
+
+static void AppendTime(int64_t value, int64_t unitsPerSecond, string &out) {
+    PARQUET_CHECK(value >= 0 && value / unitsPerSecond <= 86400, "invalid time value");
+    AppendTimeOfDay(value / unitsPerSecond, value % unitsPerSecond, unitsPerSecond, out);
+}
+
+static void AppendFloat(double value, int digits, string &out) {
+    if (std::isnan(value)) {
+        out += "NaN";
+    } else if (std::isinf(value)) {
+        out += (value > 0) ? "Infinity" : "-Infinity";
+    } else {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*g", digits, value);
+        out += buf;
+    }
+}
+
+static void AppendInt32(const ParquetColumnInfo &column, int32_t value, string &out) {
+    switch (column.kind) {
+        case PARQUET_DATE:
+            if (AppendDate(value, out)) {
+                out += " BC";
+            }
+            break;
+        case PARQUET_DECIMAL:
+            AppendDecimal(value, column.scale, out);
+            break;
+        case PARQUET_TIME:
+            AppendTime(value, column.unitsPerSecond, out);
+            break;
+        case PARQUET_UINT32:
+            out += std::to_string((uint32_t)value);
+            break;
+        default:
+            out += std::to_string(value);
+    }
+}
+
+static void AppendInt64(const ParquetColumnInfo &column, int64_t value, string &out) {
+    switch (column.kind) {
+        case PARQUET_TIMESTAMP:
+            AppendTimestamp(value, column.unitsPerSecond, column.adjustedToUTC, out);
+            break;
+        case PARQUET_DECIMAL:
+            AppendDecimal(value, column.scale, out);
+            break;
+        case PARQUET_TIME:
+            AppendTime(value, column.unitsPerSecond, out);
+            break;
+        case PARQUET_UINT64:
+            out += std::to_string((uint64_t)value);
+            break;
+        default:
+            out += std::to_string(value);
+    }
+}
+
+static void AppendBytes(const ParquetColumnInfo &column, const uint8_t *data, uint64_t len,
+                        string &out) {
+    switch (column.kind) {
+        case PARQUET_STRING:
+            AppendEscaped((const char *)data, len, out);
+            break;
+        case PARQUET_DECIMAL:
+            AppendBinaryDecimal(data, len, column.scale, out);
+            break;
+        case PARQUET_UUID:
+            for (uint64_t i = 0; i < len; i++) {
+                if (i == 4 || i == 6 || i == 8 || i == 10) {
+                    out += '-';
+                }
+                AppendHex(data + i, 1, out);
+            }
+            break;
+        default:
+            // bytea hex format
+            AppendEscaped("\\x", 2, out);
+            AppendHex(data, len, out);
+    }
+}
+
+// Append the text of the PLAIN encoded value at 'p', and move past it.
+// Booleans are bit-packed, 'bit' counts the ones read.
+static void AppendPlainValue(const ParquetColumnInfo &column, const uint8_t *&p,
+                             const uint8_t *end, uint64_t &bit, string &out) {
+    uint64_t left = end - p;
+
+    switch (column.physicalType) {
+        case PT_BOOLEAN:
+            PARQUET_CHECK((bit >> 3) < left, "page has fewer values than expected");
+            out += ((p[bit >> 3] >> (bit & 7)) & 1) ? 't' : 'f';
+            bit++;
+            break;
+        case PT_INT32:
+            PARQUET_CHECK(left >= 4, "page has fewer values than expected");
+            AppendInt32(column, (int32_t)ReadLE32(p), out);
+            p += 4;
+            break;
+        case PT_INT64:
+            PARQUET_CHECK(left >= 8, "page has fewer values than expected");
+            AppendInt64(column, (int64_t)ReadLE64(p), out);
+            p += 8;
+            break;
+        case PT_INT96: {
+            PARQUET_CHECK(left >= 12, "page has fewer values than expected");
+            // nanoseconds of the day, then the julian day
+            int64_t nanos = (int64_t)ReadLE64(p);
+            int64_t days = (int64_t)ReadLE32(p + 8) - JULIAN_DAY_OF_EPOCH;
+            AppendTimestamp(days * 86400 * 1000000 + nanos / 1000, 1000000, false, out);
+            p += 12;
+            break;
+        }
+        case PT_FLOAT: {
+            PARQUET_CHECK(left >= 4, "page has fewer values than expected");
+            uint32_t bits = ReadLE32(p);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            AppendFloat(value, 9, out);
+            p += 4;
+            break;
+        }
+        case PT_DOUBLE: {
+            PARQUET_CHECK(left >= 8, "page has fewer values than expected");
+            uint64_t bits = ReadLE64(p);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            AppendFloat(value, 17, out);
+            p += 8;
+            break;
+        }
+        case PT_BYTE_ARRAY: {
+            PARQUET_CHECK(left >= 4, "page has fewer values than expected");
+            uint64_t len = ReadLE32(p);
+            PARQUET_CHECK(left - 4 >= len, "page has fewer values than expected");
+            AppendBytes(column, p + 4, len, out);
+            p += 4 + len;
+            break;
+        }
+        case PT_FIXED_LEN_BYTE_ARRAY:
+            PARQUET_CHECK(left >= (uint64_t)column.typeLength,
+                          "page has fewer values than expected");
+            AppendBytes(column, p, column.typeLength, out);
+            p += column.typeLength;
+            break;
+        default:
+            PARQUET_CHECK(false, "unknown type of column " + column.name);
+    }
+}
+
+// ParquetColumnReader converts the values of a column chunk to text, one
+// value at a time, decoding a page when the previous one is used up.
+class ParquetColumnReader {
+   public:
+    ParquetColumnReader(const ParquetColumnInfo &column, const ParquetColumnChunkInfo &chunk,
+                        S3VectorUInt8 &chunkData)
+        : column(column),
+          codec(chunk.codec),
+          pageValuesLeft(0),
+          encoding(ENC_PLAIN),
+          values(NULL),
+          valuesEnd(NULL),
+          valuesBit(0),
+          hasDictionary(false) {
+        S3_CHECK_OR_DIE(codec == CODEC_UNCOMPRESSED || codec == CODEC_SNAPPY || codec == CODEC_GZIP,
+                        S3RuntimeError,
+                        "unsupported compression codec " + std::to_string(codec) +
+                            " of parquet column " + column.name);
+        this->data.swap(chunkData);
+        this->p = this->data.data();
+        this->end = this->p + this->data.size();
+    }
+
+    // Append the text of the next value to 'out', or return false if it is
+    // NULL.
+    bool appendNext(string &out) {
+        while (pageValuesLeft == 0) {
+            readPage();
+        }
+        pageValuesLeft--;
+
+        if (column.optional && defLevels.next() == 0) {
+            return false;
+        }
+
+        switch (encoding) {
+            case ENC_PLAIN:
+                AppendPlainValue(column, values, valuesEnd, valuesBit, out);
+                break;
+            case ENC_RLE:
+                out += indices.next() ? 't' : 'f';
+                break;
+            default: {
+                uint32_t index = indices.next();
+                PARQUET_CHECK(index < dictionary.size(), "dictionary index out of range");
+                out += dictionary[index];
+            }
+        }
+
+        return true;
+    }
+
+   private:
+    const ParquetColumnInfo &column;
+    int32_t codec;
+
+    S3VectorUInt8 data;
+    const uint8_t *p;
+    const uint8_t *end;
+
+    vector<uint8_t> pageBuffer;  // of decompressed pages
+    int32_t pageValuesLeft;
+    RleBitPackedDecoder defLevels;
+
+    int32_t encoding;
+    const uint8_t *values;  // of PLAIN encoded pages
+    const uint8_t *valuesEnd;
+    uint64_t valuesBit;
+    RleBitPackedDecoder indices;  // of dictionary and RLE encoded pages
+
+    vector<string> dictionary;  // values formatted already
+    bool hasDictionary;
+
+    const uint8_t *decompress(const uint8_t *src, uint64_t srcLen, uint64_t dstLen) {
+        if (codec == CODEC_UNCOMPRESSED) {
+            PARQUET_CHECK(srcLen == dstLen, "page has unexpected length");
+            return src;
+        }
+
+        pageBuffer.resize(dstLen);
+        if (codec == CODEC_SNAPPY) {
+            SnappyRawDecompress(src, srcLen, pageBuffer.data(), dstLen);
+        } else {
+            GzipDecompress(src, srcLen, pageBuffer.data(), dstLen);
+        }
+        return pageBuffer.data();
+    }
+
+    void readDictionary(const uint8_t *page, uint64_t len, int32_t numValues) {
+        const uint8_t *q = page;
+        uint64_t bit = 0;
+
+        dictionary.clear();
+        dictionary.reserve(numValues);
+        for (int32_t i = 0; i < numValues; i++) {
+            dictionary.push_back(string());
+            AppendPlainValue(column, q, page + len, bit, dictionary.back());
+        }
+        hasDictionary = true;
+    }
+
+    void startValues(int32_t pageEncoding, const uint8_t *q, const uint8_t *qEnd) {
+        encoding = pageEncoding;
+
+        switch (encoding) {
+            case ENC_PLAIN:
+                values = q;
+                valuesEnd = qEnd;
+                valuesBit = 0;
+                break;
+            case ENC_PLAIN_DICTIONARY:
+            case ENC_RLE_DICTIONARY:
+                PARQUET_CHECK(hasDictionary, "dictionary page of column " + column.name +
+                                                 " is missing");
+                PARQUET_CHECK(q < qEnd, "page has fewer values than expected");
+                indices.init(q + 1, qEnd - q - 1, *q);
+                break;
+            case ENC_RLE:
+                S3_CHECK_OR_DIE(column.physicalType == PT_BOOLEAN, S3RuntimeError,
+                                "unsupported encoding of parquet column " + column.name);
+                PARQUET_CHECK(qEnd - q >= 4 && ReadLE32(q) <= (uint64_t)(qEnd - q - 4),
+                              "page has fewer values than expected");
+                indices.init(q + 4, ReadLE32(q), 1);
+                break;
+            default:
+                S3_DIE(S3RuntimeError, "unsupported encoding " + std::to_string(encoding) +
+                                           " of parquet column " + column.name);
+        }
+    }
+
+    void readPage() {
+        while (true) {
+            PARQUET_CHECK(p < end, "column " + column.name + " has fewer values than rows");
+
+            ThriftReader thrift(p, end - p);
+            ParquetPageHeader header;
+            ParsePageHeader(thrift, header);
+
+            p = thrift.position();
+            PARQUET_CHECK((uint64_t)header.compressedSize <= (uint64_t)(end - p),
+                          "page is beyond its column chunk");
+            const uint8_t *page = p;
+            p += header.compressedSize;
+
+            if (header.type == PAGE_DICTIONARY) {
+                const uint8_t *q =
+                    decompress(page, header.compressedSize, header.uncompressedSize);
+                readDictionary(q, header.uncompressedSize, header.numValues);
+            } else if (header.type == PAGE_DATA) {
+                const uint8_t *q =
+                    decompress(page, header.compressedSize, header.uncompressedSize);
+                const uint8_t *qEnd = q + header.uncompressedSize;
+
+                if (column.optional) {
+                    S3_CHECK_OR_DIE(header.defLevelEncoding == ENC_RLE, S3RuntimeError,
+                                    "unsupported definition level encoding of parquet column " +
+                                        column.name);
+                    PARQUET_CHECK(qEnd - q >= 4 && ReadLE32(q) <= (uint64_t)(qEnd - q - 4),
+                                  "page has fewer values than expected");
+                    defLevels.init(q + 4, ReadLE32(q), 1);
+                    q += 4 + ReadLE32(q);
+                }
+
+                startValues(header.encoding, q, qEnd);
+                pageValuesLeft = header.numValues;
+                return;
+            } else if (header.type == PAGE_DATA_V2) {
+                // levels are never compressed in version 2 pages
+                PARQUET_CHECK(header.repLevelsLength == 0 && header.defLevelsLength >= 0 &&
+                                  header.defLevelsLength <= header.compressedSize &&
+                                  header.defLevelsLength <= header.uncompressedSize,
+                              "invalid page header");
+                if (column.optional) {
+                    defLevels.init(page, header.defLevelsLength, 1);
+                }
+
+                const uint8_t *src = page + header.defLevelsLength;
+                uint64_t srcLen = header.compressedSize - header.defLevelsLength;
+                uint64_t dstLen = header.uncompressedSize - header.defLevelsLength;
+                const uint8_t *q = header.isCompressed ? decompress(src, srcLen, dstLen) : src;
+                PARQUET_CHECK(header.isCompressed || srcLen == dstLen,
+                              "page has unexpected length");
+
+                startValues(header.encoding, q, q + dstLen);
+                pageValuesLeft = header.numValues;
+                return;
+            }
+            // index pages are of no use here
+        }
+    }
+};
+
+ParquetReader::ParquetReader()
+    : s3Interface(NULL),
+      s3Url(""),
+      nextRowGroup(0),
+      skippedRowGroups(0),
+      rowsLeft(0),
+      rowsOffset(0) {
+}
+
+ParquetReader::~ParquetReader() {
+    this->close();
+}
+
+void ParquetReader::open(const S3Params &params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+    S3_CHECK_OR_DIE(isTextFormat, S3RuntimeError,
+                    "parquet files can only be read by TEXT format tables");
+    S3_CHECK_OR_DIE(!hasHeader, S3RuntimeError, "HEADER is not supported for parquet files");
+
+    this->s3Url = params.getS3Url();
+    this->nextRowGroup = 0;
+    this->skippedRowGroups = 0;
+    this->rowsLeft = 0;
+    this->rows.clear();
+    this->rowsOffset = 0;
+
+    this->readFileInfo(params.getKeySize());
+    this->selectColumns();
+
+    uint64_t numRead = this->projection.size() - std::count(this->projection.begin(),
+                                                             this->projection.end(),
+                                                             (uint64_t)PARQUET_NO_COLUMN);
+    S3DEBUG("Reading %" PRIu64 " of %zu columns, %zu row groups of parquet file %s", numRead,
+            this->fileInfo.columns.size(),
+            this->fileInfo.rowGroups.size(), this->s3Url.getFullUrlForCurl().c_str());
+}
+
+// Fetch the footer, and the metadata before it with the same request when it
+// is small enough.
+void ParquetReader::readFileInfo(uint64_t keySize) {
+    PARQUET_CHECK(keySize >= PARQUET_MAGIC_LEN + PARQUET_FOOTER_LEN, "file is too short");
+
+    uint64_t tailLen = std::min(keySize, (uint64_t)PARQUET_FOOTER_PREFETCH);
+    S3VectorUInt8 tail;
+    uint64_t readLen = this->s3Interface->fetchData(keySize - tailLen, tail, tailLen, this->s3Url);
+    S3_CHECK_OR_DIE(readLen == tailLen, S3PartialResponseError, tailLen, readLen);
+
+    const uint8_t *footer = tail.data() + tailLen - PARQUET_FOOTER_LEN;
+    PARQUET_CHECK(memcmp(footer + 4, PARQUET_MAGIC, PARQUET_MAGIC_LEN) == 0,
+                  "no magic at the end");
+
+    uint64_t metadataLen = ReadLE32(footer);
+    PARQUET_CHECK(metadataLen <= keySize - PARQUET_MAGIC_LEN - PARQUET_FOOTER_LEN,
+                  "metadata is longer than the file");
+
+    if (metadataLen <= tailLen - PARQUET_FOOTER_LEN) {
+        ParseParquetFileInfo(footer - metadataLen, metadataLen, this->fileInfo);
+        return;
+    }
+
+    S3VectorUInt8 metadata;
+    uint64_t metadataOffset = keySize - PARQUET_FOOTER_LEN - metadataLen;
+    readLen = this->s3Interface->fetchData(metadataOffset, metadata, metadataLen, this->s3Url);
+    S3_CHECK_OR_DIE(readLen == metadataLen, S3PartialResponseError, metadataLen, readLen);
+
+    ParseParquetFileInfo(metadata.data(), metadataLen, this->fileInfo);
+}
+
+void ParquetReader::selectColumns() {
+    const vector<ParquetColumnInfo> &columns = this->fileInfo.columns;
+
+    this->projection.clear();
+    if (columnNames.empty()) {
+        for (uint64_t i = 0; i < columns.size(); i++) {
+            this->projection.push_back(i);
+        }
+    }
+
+    for (uint64_t i = 0; i < columnNames.size(); i++) {
+        const string &name = columnNames[i];
+        uint64_t found = columns.size();
+
+        if (!columnReferenced.empty() && !columnReferenced[i]) {
+            this->projection.push_back(PARQUET_NO_COLUMN);
+            continue;
+        }
+
+        for (uint64_t j = 0; j < columns.size() && found == columns.size(); j++) {
+            if (columns[j].name == name) {
+                found = j;
+            }
+        }
+        // names of parquet columns are often mixed case, unlike the ones of tables
+        for (uint64_t j = 0; j < columns.size() && found == columns.size(); j++) {
+            if (strcasecmp(columns[j].name.c_str(), name.c_str()) == 0) {
+                found = j;
+            }
+        }
+
+        S3_CHECK_OR_DIE(found != columns.size(), S3RuntimeError,
+                        "column \"" + name + "\" does not exist in parquet file " +
+                            this->s3Url.getFullUrlForCurl());
+        this->projection.push_back(found);
+    }
+
+    for (uint64_t i = 0; i < this->projection.size(); i++) {
+        if (this->projection[i] == PARQUET_NO_COLUMN) {
+            continue;
+        }
+
+        const ParquetColumnInfo &column = columns[this->projection[i]];
+        S3_CHECK_OR_DIE(column.kind != PARQUET_UNSUPPORTED, S3RuntimeError,
+                        "nested or repeated parquet column \"" + column.name +
+                            "\" is not supported");
+    }
+}
+
+// Decode a min or max statistic of an integer column.
+static bool StatisticToInt64(const ParquetColumnInfo &column, const string &value,
+                             int64_t &result) {
+    const uint8_t *p = (const uint8_t *)value.data();
+
+    if (column.physicalType == PT_INT32 && value.size() == 4) {
+        result = (int32_t)ReadLE32(p);
+        return true;
+    }
+    if (column.physicalType == PT_INT64 && value.size() == 8) {
+        result = (int64_t)ReadLE64(p);
+        return true;
+    }
+    return false;
+}
+
+// Compare the value of a predicate with a min or max statistic of its
+// column. Return false when they cannot be compared.
+static bool ComparePredicate(const ColumnPredicate &predicate, const ParquetColumnInfo &column,
+                             const ParquetColumnChunkInfo &chunk, const string &value,
+                             int &result) {
+    switch (predicate.kind) {
+        case PREDICATE_INTEGER:
+        case PREDICATE_DATE: {
+            bool isDate = (predicate.kind == PREDICATE_DATE);
+            int64_t stat;
+
+            if ((isDate ? column.kind != PARQUET_DATE
+                        : column.kind != PARQUET_INT32 && column.kind != PARQUET_INT64) ||
+                !StatisticToInt64(column, value, stat)) {
+                return false;
+            }
+            result = (predicate.intValue < stat) ? -1 : (predicate.intValue > stat);
+            return true;
+        }
+        case PREDICATE_STRING:
+            // the deprecated statistics of strings are in signed byte order
+            if (column.kind != PARQUET_STRING || chunk.legacyMinMax) {
+                return false;
+            }
+            result = predicate.stringValue.compare(value);
+            return true;
+    }
+    return false;
+}
+
+// Return false when the statistics of the row group show that no row of it
+// passes columnPredicates.
+bool ParquetReader::rowGroupMayMatch(const ParquetRowGroupInfo &rowGroup) const {
+    for (const ColumnPredicate &predicate : columnPredicates) {
+        if (predicate.column >= this->projection.size() ||
+            this->projection[predicate.column] == PARQUET_NO_COLUMN) {
+            continue;
+        }
+
+        uint64_t leaf = this->projection[predicate.column];
+        const ParquetColumnInfo &column = this->fileInfo.columns[leaf];
+        const ParquetColumnChunkInfo &chunk = rowGroup.columns[leaf];
+
+        // a null passes no comparison
+        if (chunk.nullCount >= 0 && chunk.nullCount >= rowGroup.numRows) {
+            return false;
+        }
+
+        int cmpMin, cmpMax;
+        if (!chunk.hasMinMax ||
+            !ComparePredicate(predicate, column, chunk, chunk.minValue, cmpMin) ||
+            !ComparePredicate(predicate, column, chunk, chunk.maxValue, cmpMax)) {
+            continue;
+        }
+
+        bool mayMatch = true;
+        switch (predicate.op) {
+            case PREDICATE_LT:
+                mayMatch = cmpMin > 0;
+                break;
+            case PREDICATE_LE:
+                mayMatch = cmpMin >= 0;
+                break;
+            case PREDICATE_EQ:
+                mayMatch = cmpMin >= 0 && cmpMax <= 0;
+                break;
+            case PREDICATE_GE:
+                mayMatch = cmpMax <= 0;
+                break;
+            case PREDICATE_GT:
+                mayMatch = cmpMax < 0;
+                break;
+        }
+        if (!mayMatch) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Fetch the projected column chunks of the next row group with rows, that
+// is not ruled out by its statistics.
+bool ParquetReader::openNextRowGroup() {
+    this->columnReaders.clear();
+
+    while (this->nextRowGroup < this->fileInfo.rowGroups.size()) {
+        const ParquetRowGroupInfo &rowGroup = this->fileInfo.rowGroups[this->nextRowGroup++];
+        if (rowGroup.numRows <= 0) {
+            continue;
+        }
+
+        if (!this->rowGroupMayMatch(rowGroup)) {
+            this->skippedRowGroups++;
+            S3DEBUG("Skipped row group %" PRIu64 " of parquet file %s by its statistics",
+                    this->nextRowGroup - 1, this->s3Url.getFullUrlForCurl().c_str());
+            continue;
+        }
+
+        for (uint64_t i = 0; i < this->projection.size(); i++) {
+            if (this->projection[i] == PARQUET_NO_COLUMN) {
+                this->columnReaders.emplace_back(nullptr);
+                continue;
+            }
+
+            const ParquetColumnInfo &column = this->fileInfo.columns[this->projection[i]];
+            const ParquetColumnChunkInfo &chunk = rowGroup.columns[this->projection[i]];
+
+            S3_CHECK_OR_DIE(!chunk.external, S3RuntimeError,
+                            "parquet column chunks in other files are not supported");
+            PARQUET_CHECK(chunk.offset >= 0 && chunk.compressedSize > 0,
+                          "invalid column chunk of " + column.name);
+
+            S3VectorUInt8 chunkData;
+            uint64_t len = chunk.compressedSize;
+            uint64_t readLen =
+                this->s3Interface->fetchData(chunk.offset, chunkData, len, this->s3Url);
+            S3_CHECK_OR_DIE(readLen == len, S3PartialResponseError, len, readLen);
+
+            this->columnReaders.emplace_back(new ParquetColumnReader(column, chunk, chunkData));
+        }
+
+        this->rowsLeft = rowGroup.numRows;
+        return true;
+    }
+
+    return false;
+}
+
+// Format rows until the buffer is full or the file ends, return false at the
+// end of the file.
+bool ParquetReader::formatRows() {
+    this->rows.clear();
+    this->rowsOffset = 0;
+
+    while (this->rows.size() < PARQUET_ROWS_BUFFER_SIZE) {
+        if (this->rowsLeft == 0 && !this->openNextRowGroup()) {
+            break;
+        }
+
+        for (uint64_t i = 0; i < this->columnReaders.size(); i++) {
+            if (i > 0 && textDelimiter != '\0') {
+                this->rows += textDelimiter;
+            }
+            if (!this->columnReaders[i] || !this->columnReaders[i]->appendNext(this->rows)) {
+                this->rows += textNullString;
+            }
+        }
+        this->rows += eolString;
+        this->rowsLeft--;
+    }
+
+    return !this->rows.empty();
+}
+
+uint64_t ParquetReader::read(char *buf, uint64_t count) {
+    if (this->rowsOffset == this->rows.size() && !this->formatRows()) {
+        return 0;
+    }
+
+    uint64_t len = std::min(count, (uint64_t)(this->rows.size() - this->rowsOffset));
+    memcpy(buf, this->rows.data() + this->rowsOffset, len);
+    this->rowsOffset += len;
+
+    return len;
+}
+
+void ParquetReader::close() {
+    this->columnReaders.clear();
+    this->fileInfo = ParquetFileInfo();
+    this->projection.clear();
+    string().swap(this->rows);
+    this->rowsOffset = 0;
+    this->rowsLeft = 0;
+    this->nextRowGroup = 0;
+    this->skippedRowGroups = 0;
+}
@@ -1,24 +1,44 @@
 #include "s3bucket_reader.h"
 
-S3BucketReader::S3BucketReader() : Reader() {
-    this->keyIndex = 0;  // doesn't matter, be set in open()
+#include <queue>
+
+S3BucketReader::S3BucketReader() : Reader(), curRange(0, 0, 0, false) {
+    this->rangeIndex = 0;  // doesn't matter, be set in open()
+    this->rangeState = RangeDone;
+    this->lastChar = '\0';
 
     this->s3Interface = NULL;
     this->upstreamReader = NULL;
 
     this->needNewReader = true;
     this->isFirstFile = true;
+
+    this->listThreadRunning = false;
+    this->listDone = true;
+    this->listStopping = false;
+    pthread_mutex_init(&this->listMutex, NULL);
+    pthread_cond_init(&this->listCond, NULL);
 }
 
 S3BucketReader::~S3BucketReader() {
     this->close();
+
+    pthread_mutex_destroy(&this->listMutex);
+    pthread_cond_destroy(&this->listCond);
+}
+
+static void* ListBucketThreadFunc(void* data) {
+    MaskThreadSignals();
+
+    S3BucketReader* reader = static_cast<S3BucketReader*>(data);
+    reader->listRemainingPages();
+
+    return NULL;
 }
 
 void S3BucketReader::open(const S3Params& params) {
     this->params = params;
 
-    this->keyIndex = s3ext_segid;  // we may change it in unit tests
-
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface is NULL");
 
     S3Url& s3Url = this->params.getS3Url();
@@ -26,13 +46,227 @@ void S3BucketReader::open(const S3Params& params) {
     S3_CHECK_OR_DIE(s3Url.isValidUrl(), S3ConfigError, s3Url.getFullUrlForCurl() + " is not valid",
                     s3Url.getFullUrlForCurl());
 
-    this->keyList = this->s3Interface->listBucket(s3Url);
+    this->keyList = ListBucketResult();
+    this->listMarker.clear();
+    this->listException = NULL;
+    this->listStopping = false;
+
+    this->s3Interface->listBucketPage(s3Url, this->listMarker, this->keyList);
+
+    this->keyRanges.clear();
+    this->rangeIndex = 0;
+    this->segmentLoads.assign(this->isRoundRobin() ? 0 : s3ext_segnum, 0);
+    this->appendKeyRanges(0, this->splitKeys(this->keyList.contents, 0));
+
+    this->listDone = this->listMarker.empty();
+    if (!this->listDone) {
+        S3DEBUG("Listing the rest of %s in background", s3Url.getFullUrlForCurl().c_str());
+
+        pthread_create(&this->listThread, NULL, ListBucketThreadFunc, this);
+        this->listThreadRunning = true;
+    }
+}
+
+void S3BucketReader::listRemainingPages() {
+    const S3Url& s3Url = this->params.getS3Url();
+    string marker = this->listMarker;
+    uint64_t from = this->keyList.contents.size();
+
+    try {
+        while (!marker.empty()) {
+            if (S3QueryIsAbortInProgress()) {
+                S3_DIE(S3QueryAbort, "Listing thread is interrupted");
+            }
+
+            ListBucketResult page;
+            this->s3Interface->listBucketPage(s3Url, marker, page);
+
+            // Without the lock, splitting may check the compression of keys.
+            vector<KeyRange> pageRanges = this->splitKeys(page.contents, from);
+
+            UniqueLock lock(&this->listMutex);
+            if (this->listStopping) {
+                break;
+            }
+
+            this->keyList.contents.insert(this->keyList.contents.end(), page.contents.begin(),
+                                          page.contents.end());
+            this->appendKeyRanges(from, pageRanges);
+            from = this->keyList.contents.size();
+
+            pthread_cond_signal(&this->listCond);
+        }
+    } catch (...) {
+        UniqueLock lock(&this->listMutex);
+        this->listException = std::current_exception();
+    }
+
+    UniqueLock lock(&this->listMutex);
+    this->listDone = true;
+    pthread_cond_signal(&this->listCond);
+}
+
+void S3BucketReader::waitForListing() {
+    UniqueLock lock(&this->listMutex);
+    while (!this->listDone) {
+        pthread_cond_wait(&this->listCond, &this->listMutex);
+    }
+
+    if (this->listException != NULL) {
+        std::rethrow_exception(this->listException);
+    }
+}
+
+void S3BucketReader::stopListing() {
+    if (!this->listThreadRunning) {
+        return;
+    }
+
+    {
+        UniqueLock lock(&this->listMutex);
+        this->listStopping = true;
+    }
+
+    pthread_join(this->listThread, NULL);
+    this->listThreadRunning = false;
+}
+
+bool S3BucketReader::nextKeyRange(BucketContent& key) {
+    UniqueLock lock(&this->listMutex);
+    while (this->rangeIndex >= this->keyRanges.size() && !this->listDone) {
+        pthread_cond_wait(&this->listCond, &this->listMutex);
+    }
+
+    if (this->listException != NULL) {
+        std::rethrow_exception(this->listException);
+    }
+
+    if (this->rangeIndex >= this->keyRanges.size()) {
+        return false;
+    }
+
+    this->curRange = this->keyRanges[this->rangeIndex++];
+    this->curKey = this->keyList.contents[this->curRange.keyIndex];
+    key = this->curKey;
+    return true;
+}
+
+// Only uncompressed TEXT data can be split, at the line terminators. A header line
+// would have to be read by the segment reading the start of the key.
+bool S3BucketReader::isSplittable(BucketContent& key) {
+    if (!isTextFormat || hasHeader) {
+        return false;
+    }
+
+    S3Params keyParams = this->constructReaderParams(key);
+    return this->s3Interface->checkCompressionType(keyParams.getS3Url()) == S3_COMPRESSION_PLAIN;
+}
+
+bool S3BucketReader::isRoundRobin() {
+    return this->params.getSplitSize() == 0 || s3ext_segnum <= 1;
+}
+
+// Assign the keys from keyList.contents[from] on round-robin.
+void S3BucketReader::appendRoundRobinRanges(uint64_t from) {
+    vector<BucketContent>& keys = this->keyList.contents;
+
+    uint64_t i = from + (s3ext_segid + s3ext_segnum - from % s3ext_segnum) % s3ext_segnum;
+    for (; i < keys.size(); i += s3ext_segnum) {
+        this->keyRanges.emplace_back(i, 0, keys[i].getSize(), false);
+    }
+}
+
+// Decide which keys, or byte ranges of keys, this segment reads.
+//
+// By default every segment reads whole keys, assigned round-robin. When keys are
+// larger than both the configured split size and an even share of their page of
+// the listing, they are divided into byte ranges, and the keys and ranges are
+// assigned so that every segment reads about the same number of bytes. All
+// segments list the same pages and compute the same plan, page by page, without
+// talking to each other. So a segment starts reading the first page while the
+// next ones are listed.
+//
+// Split the keys of a page, keyList.contents[from] on once listed, into the
+// ranges to assign. There is nothing to split when keys are assigned round-robin.
+vector<KeyRange> S3BucketReader::splitKeys(const vector<BucketContent>& keys, uint64_t from) {
+    vector<KeyRange> pageRanges;
+    if (this->isRoundRobin()) {
+        return pageRanges;
+    }
+
+    uint64_t totalSize = 0;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        totalSize += keys[i].getSize();
+    }
+
+    uint64_t splitSize = this->params.getSplitSize();
+    uint64_t rangeSize = std::max(splitSize, (totalSize + s3ext_segnum - 1) / s3ext_segnum);
+
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        BucketContent key = keys[i];
+        uint64_t size = key.getSize();
+
+        if (size <= rangeSize || !this->isSplittable(key)) {
+            pageRanges.emplace_back(from + i, 0, size, false);
+            continue;
+        }
+
+        uint64_t numOfRanges = (size + rangeSize - 1) / rangeSize;
+        for (uint64_t j = 0; j < numOfRanges; j++) {
+            uint64_t start = size * j / numOfRanges;
+            uint64_t end = size * (j + 1) / numOfRanges;
+            pageRanges.emplace_back(from + i, start, end - start, true);
+        }
+    }
+
+    return pageRanges;
 }
 
-BucketContent& S3BucketReader::getNextKey() {
-    BucketContent& key = this->keyList.contents[this->keyIndex];
-    this->keyIndex += s3ext_segnum;
-    return key;
+// Add the share of this segment of a page, keyList.contents[from] on, to keyRanges.
+void S3BucketReader::appendKeyRanges(uint64_t from, const vector<KeyRange>& pageRanges) {
+    if (this->isRoundRobin()) {
+        this->appendRoundRobinRanges(from);
+        return;
+    }
+
+    // Largest first, each to the segment with the fewest bytes so far.
+    vector<uint64_t> order(pageRanges.size());
+    for (uint64_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&pageRanges](uint64_t a, uint64_t b) {
+        return pageRanges[a].length > pageRanges[b].length;
+    });
+
+    typedef std::pair<uint64_t, int32_t> SegmentLoad;
+    std::priority_queue<SegmentLoad, vector<SegmentLoad>, std::greater<SegmentLoad>> loads;
+    for (int32_t seg = 0; seg < s3ext_segnum; seg++) {
+        loads.push(SegmentLoad(this->segmentLoads[seg], seg));
+    }
+
+    vector<KeyRange> ranges;
+    for (uint64_t i = 0; i < order.size(); i++) {
+        SegmentLoad load = loads.top();
+        loads.pop();
+
+        const KeyRange& range = pageRanges[order[i]];
+        if (load.second == s3ext_segid) {
+            ranges.push_back(range);
+        }
+
+        load.first += range.length;
+        this->segmentLoads[load.second] = load.first;
+        loads.push(load);
+    }
+
+    // Read the parts of a key in order.
+    std::sort(ranges.begin(), ranges.end(), [](const KeyRange& a, const KeyRange& b) {
+        return a.keyIndex < b.keyIndex || (a.keyIndex == b.keyIndex && a.offset < b.offset);
+    });
+    this->keyRanges.insert(this->keyRanges.end(), ranges.begin(), ranges.end());
+
+    S3DEBUG("Segment %d reads %" PRIu64 " of %" PRIu64 " key ranges of the page", s3ext_segid,
+            (uint64_t)ranges.size(), (uint64_t)pageRanges.size());
 }
 
 S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
@@ -93,18 +327,108 @@ uint64_t S3BucketReader::readWithoutHeaderLine(char* buf, uint64_t count) {
     return remain;
 }
 
+uint64_t S3BucketReader::readRange(char* buf, uint64_t count) {
+    char eol = eolString[strlen(eolString) - 1];
+    uint64_t readCount = 0;
+    char* p = NULL;
+
+    while (true) {
+        switch (this->rangeState) {
+            case RangeSkipHead:
+                // The line going on at the start of the range is read by the previous one.
+                readCount = this->upstreamReader->read(buf, count);
+                if (readCount == 0) {
+                    this->rangeState = RangeDone;
+                    return 0;
+                }
+
+                p = (char*)memchr(buf, eol, readCount);
+                if (p == NULL) {
+                    continue;
+                }
+
+                p++;
+                readCount = buf + readCount - p;
+                memmove(buf, p, readCount);
+
+                this->lastChar = eol;
+                this->rangeState = RangeBody;
+                if (readCount == 0) {
+                    continue;
+                }
+
+                this->lastChar = buf[readCount - 1];
+                return readCount;
+
+            case RangeBody:
+                readCount = this->upstreamReader->read(buf, count);
+                if (readCount != 0) {
+                    this->lastChar = buf[readCount - 1];
+                    return readCount;
+                }
+
+                if (this->lastChar == eol ||
+                    this->curRange.offset + this->curRange.length >= this->curKey.getSize()) {
+                    this->rangeState = RangeDone;
+                    return 0;
+                }
+
+                // The last line ends past the range, read on in small chunks up to its end.
+                this->upstreamReader->close();
+                {
+                    S3Params tailParams = this->constructReaderParams(this->curKey);
+                    tailParams.setRange(this->curRange.offset + this->curRange.length, 0);
+                    tailParams.setChunkSize(
+                        std::min(tailParams.getChunkSize(), (uint64_t)S3_RANGE_TAIL_CHUNKSIZE));
+                    tailParams.setNumOfChunks(1);
+                    this->upstreamReader->open(tailParams);
+                }
+                this->rangeState = RangeTail;
+                continue;
+
+            case RangeTail:
+                readCount = this->upstreamReader->read(buf, count);
+                if (readCount == 0) {
+                    this->rangeState = RangeDone;
+                    return 0;
+                }
+
+                p = (char*)memchr(buf, eol, readCount);
+                if (p != NULL) {
+                    this->rangeState = RangeDone;
+                    return p - buf + 1;
+                }
+                return readCount;
+
+            case RangeDone:
+                return 0;
+        }
+    }
+}
+
 uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     S3_CHECK_OR_DIE(this->upstreamReader != NULL, S3RuntimeError, "upstreamReader is NULL");
     uint64_t readCount = 0;
     while (true) {
         if (this->needNewReader) {
-            if (this->keyIndex >= this->keyList.contents.size()) {
+            BucketContent key;
+            if (!this->nextKeyRange(key)) {
                 S3DEBUG("Read finished for segment: %d", s3ext_segid);
                 return 0;
             }
-            BucketContent& key = this->getNextKey();
 
-            this->upstreamReader->open(constructReaderParams(key));
+            S3Params readerParams = this->constructReaderParams(key);
+
+            if (this->curRange.split) {
+                // Start one byte early, to tell whether a line starts at the range.
+                uint64_t start = this->curRange.offset > 0 ? this->curRange.offset - 1 : 0;
+                readerParams.setRange(start, this->curRange.offset + this->curRange.length - start);
+
+                this->rangeState = this->curRange.offset > 0 ? RangeSkipHead : RangeBody;
+                this->lastChar = '\0';
+            }
+
+            this->upstreamReader->open(readerParams);
             this->needNewReader = false;
 
             // ignore header line if it is not the first file
@@ -116,7 +440,11 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
             }
         }
 
-        readCount = this->upstreamReader->read(buf, count);
+        if (this->curRange.split) {
+            readCount = this->readRange(buf, count);
+        } else {
+            readCount = this->upstreamReader->read(buf, count);
+        }
         if (readCount != 0) {
             return readCount;
         }
@@ -129,6 +457,8 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
 }
 
 void S3BucketReader::close() {
+    this->stopListing();
+
     if (this->upstreamReader != NULL) {
         this->upstreamReader->close();
         this->upstreamReader = NULL;
@@ -137,4 +467,6 @@ void S3BucketReader::close() {
     if (!this->keyList.contents.empty()) {
         this->keyList.contents.clear();
     }
+
+    this->keyRanges.clear();
 }
\ No newline at end of file
@@ -8,12 +8,20 @@ void S3CommonReader::open(const S3Params &params) {
     switch (compressionType) {
         case S3_COMPRESSION_DEFLATE:
         case S3_COMPRESSION_GZIP:
+        case S3_COMPRESSION_ZSTD:
+        case S3_COMPRESSION_SNAPPY:
+        case S3_COMPRESSION_LZ4:
             this->upstreamReader = &this->decompressReader;
             this->decompressReader.setReader(&this->keyReader);
+            this->decompressReader.setCompressionType(compressionType);
             break;
         case S3_COMPRESSION_PLAIN:
             this->upstreamReader = &this->keyReader;
             break;
+        case S3_COMPRESSION_PARQUET:
+            this->upstreamReader = &this->parquetReader;
+            this->parquetReader.setS3InterfaceService(s3InterfaceService);
+            break;
         default:
             S3_CHECK_OR_DIE(false, S3RuntimeError, "unknown file type");
     };
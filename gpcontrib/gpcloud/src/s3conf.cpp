@@ -107,6 +107,14 @@ S3Params InitConfig(const string& urlWithOptions) {
                                        8 * 1024 * 1024, 128 * 1024 * 1024);
     params.setChunkSize(chunkSize);
 
+    int64_t splitSize = s3Cfg.SafeScan("splitsize", configSection, 1024 * 1024 * 1024, 0,
+                                       (int64_t)1024 * 1024 * 1024 * 1024);
+    params.setSplitSize(splitSize);
+
+    int64_t objectSize = s3Cfg.SafeScan("objectsize", configSection, 0, 0,
+                                        (int64_t)5 * 1024 * 1024 * 1024 * 1024);
+    params.setObjectSize(objectSize);
+
     int64_t lowSpeedLimit = s3Cfg.SafeScan("low_speed_limit", configSection, 10240, 0, INT_MAX);
     params.setLowSpeedLimit(lowSpeedLimit);
 
@@ -119,6 +127,8 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setVerifyCert(s3Cfg.GetBool(configSection, "verifycert", "true"));
 
+    params.setKeepAlive(s3Cfg.GetBool(configSection, "keepalive", "true"));
+
     string sse_type = s3Cfg.Get(configSection, "server_side_encryption", "");
     if (sse_type == "sse-s3") {
         params.setSSEType(SSE_S3);
@@ -1,5 +1,7 @@
 #include "s3interface.h"
 
+#include "decompressor.h"
+
 // use destructor ~XMLContextHolder() to do the cleanup
 class XMLContextHolder {
    public:
@@ -294,47 +296,54 @@ ListBucketResult S3InterfaceService::listBucket(S3Url &s3Url) {
     ListBucketResult result;
 
     string marker = "";
-    string encodedPrefix = s3Url.getPrefix();
-    FindAndReplace(encodedPrefix, "/", "%2F");
     do {
-        // To get next set(up to 1000) keys in one iteration.
-        // S3 requires query parameters specified alphabetically.
+        this->listBucketPage(s3Url, marker, result);
+    } while (!marker.empty());
 
-        // marker and prefix are used as the values of query parameters here
-        // so URI encode their whole string, "/" also.
+    s3Url.setPrefix("");
 
-        // transfer /bucket/prefix to /bucket/?prefix=prefix because we need to "GET" a real thing
-        stringstream querySs;
-        if (!marker.empty()) {
-            querySs << "marker=" << UriEncode(marker);
-        }
+    return result;
+}
 
-        if (!encodedPrefix.empty()) {
-            querySs << (marker.empty() ? "prefix=" : "&prefix=") << encodedPrefix;
-        }
+// listBucketPage gets the next set (up to 1000) of keys after marker.
+void S3InterfaceService::listBucketPage(const S3Url &s3Url, string &marker,
+                                        ListBucketResult &result) {
+    string encodedPrefix = s3Url.getPrefix();
+    FindAndReplace(encodedPrefix, "/", "%2F");
 
-        s3Url.setPrefix("");
-        string queryStr = querySs.str();
+    // S3 requires query parameters specified alphabetically.
 
-        Response resp = getBucketResponse(s3Url, queryStr);
+    // marker and prefix are used as the values of query parameters here
+    // so URI encode their whole string, "/" also.
 
-        if (resp.getStatus() == RESPONSE_OK) {
-            xmlParserCtxtPtr xmlContext = getXMLContext(resp);
-            XMLContextHolder holder(xmlContext);
-            if (parseBucketXML(&result, xmlContext, marker)) {
-                continue;
-            }
-        } else if (resp.getStatus() == RESPONSE_ERROR) {
-            S3MessageParser s3msg(resp);
-            S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
-        } else {
-            S3_DIE(S3RuntimeError, "unexpected response status");
-        }
+    // transfer /bucket/prefix to /bucket/?prefix=prefix because we need to "GET" a real thing
+    stringstream querySs;
+    if (!marker.empty()) {
+        querySs << "marker=" << UriEncode(marker);
+    }
 
-        return result;
-    } while (!marker.empty());
+    if (!encodedPrefix.empty()) {
+        querySs << (marker.empty() ? "prefix=" : "&prefix=") << encodedPrefix;
+    }
 
-    return result;
+    S3Url bucketUrl(s3Url);
+    bucketUrl.setPrefix("");
+    string queryStr = querySs.str();
+
+    Response resp = getBucketResponse(bucketUrl, queryStr);
+
+    if (resp.getStatus() == RESPONSE_OK) {
+        xmlParserCtxtPtr xmlContext = getXMLContext(resp);
+        XMLContextHolder holder(xmlContext);
+        if (!parseBucketXML(&result, xmlContext, marker)) {
+            marker.clear();
+        }
+    } else if (resp.getStatus() == RESPONSE_ERROR) {
+        S3MessageParser s3msg(resp);
+        S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+    } else {
+        S3_DIE(S3RuntimeError, "unexpected response status");
+    }
 }
 
 uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
@@ -397,9 +406,11 @@ S3CompressionType S3InterfaceService::checkCompressionType(const S3Url &s3Url) {
         S3_CHECK_OR_DIE(responseData.size() == S3_MAGIC_BYTES_NUM, S3PartialResponseError,
                         S3_MAGIC_BYTES_NUM, responseData.size());
 
-        if ((responseData[0] == 0x1f) && (responseData[1] == 0x8b)) {
-            return S3_COMPRESSION_GZIP;
+        if (memcmp(responseData.data(), PARQUET_MAGIC, PARQUET_MAGIC_LEN) == 0) {
+            return S3_COMPRESSION_PARQUET;
         }
+
+        return DetectCompressionType(responseData.data(), responseData.size());
     } else if (resp.getStatus() == RESPONSE_ERROR) {
         S3MessageParser s3msg(resp);
         S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
@@ -189,7 +189,18 @@ void S3KeyReader::open(const S3Params& params) {
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
 
-    this->offsetMgr.setKeySize(params.getKeySize());
+    // A byte range of the key is read as if the key ended at the end of the range.
+    uint64_t keySize = params.getKeySize();
+    uint64_t rangeEnd = keySize;
+
+    this->rangeStart = std::min(params.getRangeOffset(), keySize);
+    if (params.getRangeLength() != 0) {
+        rangeEnd = std::min(this->rangeStart + params.getRangeLength(), keySize);
+    }
+    this->atKeyEnd = (rangeEnd == keySize);
+
+    this->offsetMgr.setKeySize(rangeEnd);
+    this->offsetMgr.setCurPos(this->rangeStart);
     this->offsetMgr.setChunkSize(params.getChunkSize());
 
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
@@ -211,13 +222,14 @@ void S3KeyReader::open(const S3Params& params) {
 }
 
 uint64_t S3KeyReader::read(char* buf, uint64_t count) {
-    uint64_t fileLen = this->offsetMgr.getKeySize();
+    uint64_t fileLen = this->offsetMgr.getKeySize() - this->rangeStart;
     uint64_t readLen = 0;
 
     do {
         // confirm there is no more available data, done with this file
         if (this->transferredKeyLen >= fileLen) {
-            if (!this->hasEol && !this->eolAppended) {
+            // only the real end of the key may need a line terminator
+            if (this->atKeyEnd && !this->hasEol && !this->eolAppended) {
                 uint64_t eolLen = strlen(eolString);
                 memcpy(buf, eolString, eolLen);
 
@@ -264,6 +276,8 @@ void S3KeyReader::reset() {
     this->sharedError = false;
     this->curReadingChunk = 0;
     this->transferredKeyLen = 0;
+    this->rangeStart = 0;
+    this->atKeyEnd = true;
 
     this->offsetMgr.reset();
 
@@ -1,12 +1,22 @@
 #include "s3key_writer.h"
 
+uint64_t S3_UPLOAD_MIN_PARTSIZE = 5 * 1024 * 1024;
+
+// S3 allows no more than 10000 parts, keep clear of it with full size parts.
+#define S3_UPLOAD_MAX_SMALL_PARTS 5000
+
 void S3KeyWriter::open(const S3Params& params) {
     this->params = params;
 
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
     S3_CHECK_OR_DIE(this->params.getChunkSize() > 0, S3RuntimeError, "chunkSize must not be zero");
 
-    buffer.reserve(this->params.getChunkSize());
+    // take the buffers from the chunks prepared by PrepareS3MemContext()
+    this->buffer = S3VectorUInt8(this->params.getMemoryContext());
+    this->buffer.reserve(this->params.getChunkSize());
+
+    this->partSize = std::min(S3_UPLOAD_MIN_PARTSIZE, this->params.getChunkSize());
+    this->partNumber = 0;
 
     this->uploadId = this->s3Interface->getUploadId(this->params.getS3Url());
     S3_CHECK_OR_DIE(!this->uploadId.empty(), S3RuntimeError, "Failed to get upload id");
@@ -27,13 +37,13 @@ uint64_t S3KeyWriter::write(const char* buf, uint64_t count) {
             std::rethrow_exception(sharedException);
         }
 
-        uint64_t bufferRemaining = this->params.getChunkSize() - this->buffer.size();
+        uint64_t bufferRemaining = this->partSize - this->buffer.size();
         uint64_t dataRemaining = count - offset;
         uint64_t dataToBuffer = bufferRemaining < dataRemaining ? bufferRemaining : dataRemaining;
 
         this->buffer.insert(this->buffer.end(), buf + offset, buf + offset + dataToBuffer);
 
-        if (this->buffer.size() == this->params.getChunkSize()) {
+        if (this->buffer.size() >= this->partSize) {
             this->flushBuffer();
         }
 
@@ -77,6 +87,9 @@ void S3KeyWriter::checkQueryCancelSignal() {
 }
 
 struct ThreadParams {
+    ThreadParams(const S3MemoryContext& context) : data(context) {
+    }
+
     S3KeyWriter* keyWriter;
     S3VectorUInt8 data;
     uint64_t currentNumber;
@@ -94,6 +107,9 @@ void* S3KeyWriter::UploadThreadFunc(void* data) {
         string etag = writer->s3Interface->uploadPartOfData(
             params->data, writer->params.getS3Url(), params->currentNumber, writer->uploadId);
 
+        // give the chunk back before the next part may take it
+        params->data.release();
+
         // when unique_lock destructs it will automatically unlock the mutex.
         UniqueLock threadLock(&writer->mutex);
 
@@ -107,6 +123,8 @@ void* S3KeyWriter::UploadThreadFunc(void* data) {
                 etag.c_str(), params->currentNumber);
     } catch (S3Exception& e) {
         S3ERROR("Upload thread error: %s", e.getMessage().c_str());
+        params->data.release();
+
         UniqueLock exceptLock(&writer->exceptionMutex);
         writer->sharedError = true;
         writer->sharedException = std::current_exception();
@@ -123,8 +141,10 @@ void* S3KeyWriter::UploadThreadFunc(void* data) {
 void S3KeyWriter::flushBuffer() {
     if (!this->buffer.empty()) {
         UniqueLock queueLock(&this->mutex);
+        bool waited = false;
         while (this->activeThreads >= this->params.getNumOfChunks()) {
             pthread_cond_wait(&this->cv, &this->mutex);
+            waited = true;
         }
 
         // Most time query is canceled during uploadPartOfData(). This is the first chance to cancel
@@ -134,7 +154,7 @@ void S3KeyWriter::flushBuffer() {
         this->activeThreads++;
 
         pthread_t writerThread;
-        ThreadParams* params = new ThreadParams();
+        ThreadParams* params = new ThreadParams(this->params.getMemoryContext());
         params->keyWriter = this;
         params->data.swap(this->buffer);
         params->currentNumber = ++this->partNumber;
@@ -142,6 +162,23 @@ void S3KeyWriter::flushBuffer() {
         threadList.emplace_back(writerThread);
 
         this->buffer.reserve(this->params.getChunkSize());
+
+        this->adaptPartSize(waited);
+    }
+}
+
+// Waiting for an upload thread means the parts are uploaded slower than they are
+// filled, larger parts then take fewer requests for the same data.
+void S3KeyWriter::adaptPartSize(bool waited) {
+    uint64_t chunkSize = this->params.getChunkSize();
+    if (this->partSize >= chunkSize) {
+        return;
+    }
+
+    if (waited || this->partNumber >= S3_UPLOAD_MAX_SMALL_PARTS) {
+        this->partSize = std::min(this->partSize * 2, chunkSize);
+        S3DEBUG("Part size of \"%s\" grows to %" PRIu64,
+                this->params.getS3Url().getFullUrlForCurl().c_str(), this->partSize);
     }
 }
 
@@ -1,12 +1,145 @@
 #include "s3restful_service.h"
 
+static string FormatConnectionStats(const ConnectionStats &stats) {
+    uint64_t reused =
+        stats.requests > stats.newConnections ? stats.requests - stats.newConnections : 0;
+
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "%" PRIu64 " requests, %" PRIu64 " new connections, %.1f%% connections reused",
+             stats.requests, stats.newConnections,
+             stats.requests == 0 ? 0.0 : reused * 100.0 / stats.requests);
+    return buf;
+}
+
+CURLHandlePool::CURLHandlePool() : share(NULL), users(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&this->shareLocks[i], NULL);
+    }
+}
+
+CURLHandlePool::~CURLHandlePool() {
+    this->cleanup();
+
+    pthread_mutex_destroy(&this->mutex);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&this->shareLocks[i]);
+    }
+}
+
+CURLHandlePool &CURLHandlePool::getInstance() {
+    static CURLHandlePool pool;
+    return pool;
+}
+
+void CURLHandlePool::lockShare(CURL *curl, curl_lock_data data, curl_lock_access access,
+                               void *userp) {
+    CURLHandlePool *pool = (CURLHandlePool *)userp;
+    pthread_mutex_lock(&pool->shareLocks[data]);
+}
+
+void CURLHandlePool::unlockShare(CURL *curl, curl_lock_data data, void *userp) {
+    CURLHandlePool *pool = (CURLHandlePool *)userp;
+    pthread_mutex_unlock(&pool->shareLocks[data]);
+}
+
+// Called by every S3RESTfulService when it is created.
+void CURLHandlePool::attach() {
+    UniqueLock lock(&this->mutex);
+    this->users++;
+}
+
+// Called by every S3RESTfulService when it is destroyed. The handles must be gone
+// before curl_global_cleanup() of the last one.
+void CURLHandlePool::detach() {
+    UniqueLock lock(&this->mutex);
+    if (this->users > 0 && --this->users == 0) {
+        if (this->stats.requests > 0) {
+            S3DEBUG("curl handle pool: %s", FormatConnectionStats(this->stats).c_str());
+        }
+        this->cleanup();
+    }
+}
+
+void CURLHandlePool::cleanup() {
+    for (uint64_t i = 0; i < this->idleHandles.size(); i++) {
+        curl_easy_cleanup(this->idleHandles[i]);
+    }
+    this->idleHandles.clear();
+
+    if (this->share != NULL) {
+        curl_share_cleanup(this->share);
+        this->share = NULL;
+    }
+}
+
+// Return the handle released last, whose connection is the least likely to have
+// been closed by the server, or a new one.
+CURL *CURLHandlePool::acquire() {
+    UniqueLock lock(&this->mutex);
+
+    if (!this->idleHandles.empty()) {
+        CURL *curl = this->idleHandles.back();
+        this->idleHandles.pop_back();
+        return curl;
+    }
+
+    if (this->share == NULL) {
+        this->share = curl_share_init();
+        curl_share_setopt(this->share, CURLSHOPT_LOCKFUNC, CURLHandlePool::lockShare);
+        curl_share_setopt(this->share, CURLSHOPT_UNLOCKFUNC, CURLHandlePool::unlockShare);
+        curl_share_setopt(this->share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    CURL *curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_SHARE, this->share);
+    return curl;
+}
+
+// Handles failed or not to be reused are closed along with their connections.
+void CURLHandlePool::release(CURL *curl, bool reusable) {
+    if (!reusable) {
+        curl_easy_cleanup(curl);
+        return;
+    }
+
+    // Forget the options of the request, but keep the connections.
+    curl_easy_reset(curl);
+
+    UniqueLock lock(&this->mutex);
+    this->idleHandles.push_back(curl);
+}
+
+void CURLHandlePool::countRequest(CURL *curl) {
+    long numConnects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &numConnects);
+
+    UniqueLock lock(&this->mutex);
+    this->stats.requests++;
+    this->stats.newConnections += numConnects;
+}
+
+ConnectionStats CURLHandlePool::getStats() {
+    UniqueLock lock(&this->mutex);
+    return this->stats;
+}
+
+string GetConnectionStatsSummary() {
+    return FormatConnectionStats(CURLHandlePool::getInstance().getStats());
+}
+
 S3RESTfulService::S3RESTfulService()
     : lowSpeedLimit(0),
       lowSpeedTime(0),
       proxy(""),
       debugCurl(false),
       verifyCert(true),
+      keepAlive(true),
       chunkBufferSize(64 * 1024) {
+    CURLHandlePool::getInstance().attach();
 }
 
 S3RESTfulService::S3RESTfulService(const string &proxy)
@@ -15,7 +148,9 @@ S3RESTfulService::S3RESTfulService(const string &proxy)
       proxy(proxy),
       debugCurl(false),
       verifyCert(true),
+      keepAlive(true),
       chunkBufferSize(64 * 1024) {
+    CURLHandlePool::getInstance().attach();
 }
 
 S3RESTfulService::S3RESTfulService(const S3Params &params)
@@ -29,10 +164,15 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
     this->debugCurl = params.isDebugCurl();
     this->chunkBufferSize = params.getChunkSize();
     this->verifyCert = params.isVerifyCert();
+    this->keepAlive = params.isKeepAlive();
     this->proxy = params.getProxy();
+
+    CURLHandlePool::getInstance().attach();
 }
 
 S3RESTfulService::~S3RESTfulService() {
+    CURLHandlePool::getInstance().detach();
+
     // This function is not thread safe, must NOT call it when any other
     // threads are running, that is, do NOT put it in threads.
     curl_global_cleanup();
@@ -96,15 +236,25 @@ static size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmem
 
 struct CURLWrapper {
     CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
-                uint64_t lowSpeedTime, bool debugCurl, string proxy) {
-        curl = curl_easy_init();
+                uint64_t lowSpeedTime, bool debugCurl, string proxy, bool keepAlive)
+        : reusable(false) {
+        curl = CURLHandlePool::getInstance().acquire();
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, lowSpeedTime);
 
+        if (keepAlive) {
+            curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x072f00
+            // HTTP/2 where the server offers it over TLS, HTTP/1.1 otherwise.
+            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#endif
+        } else {
+            curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        }
+
         if (debugCurl) {
             curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
         }
@@ -114,12 +264,15 @@ struct CURLWrapper {
         }
     }
     ~CURLWrapper() {
-        curl_easy_cleanup(curl);
+        CURLHandlePool::getInstance().release(curl, reusable);
     }
     CURL *curl;
+    bool reusable;  // set once the request is done, and the handle can serve another one
 };
 
-void S3RESTfulService::performCurl(CURL *curl, Response &response) {
+void S3RESTfulService::performCurl(CURLWrapper &wrapper, Response &response) {
+    CURL *curl = wrapper.curl;
+
     CURLcode res = curl_easy_perform(curl);
     if (res != CURLE_OK) {
         if (res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_COULDNT_RESOLVE_PROXY) {
@@ -135,6 +288,9 @@ void S3RESTfulService::performCurl(CURL *curl, Response &response) {
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
 
         response.FillResponse(responseCode);
+
+        CURLHandlePool::getInstance().countRequest(curl);
+        wrapper.reusable = this->keepAlive;
     }
 }
 
@@ -149,14 +305,14 @@ Response S3RESTfulService::get(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->keepAlive);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, RESTfulServiceWriteFuncCallback);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, this->verifyCert);
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
@@ -182,7 +338,7 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->keepAlive);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -198,7 +354,7 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
     curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)&response);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, RESTfulServiceHeadersWriteFuncCallback);
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     S3MessageParser s3msg(response);
     ResponseCode responseCode = response.getResponseCode();
@@ -225,7 +381,7 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->keepAlive);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -239,7 +395,7 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, RESTfulServiceReadFuncCallback);
     curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data.size());
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
@@ -270,14 +426,14 @@ ResponseCode S3RESTfulService::head(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->keepAlive);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
     curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, this->verifyCert);
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response.getResponseCode();
@@ -303,7 +459,7 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->keepAlive);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -317,7 +473,7 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, RESTfulServiceReadFuncCallback);
     curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data.size());
 
-    this->performCurl(curl, response);
+    this->performCurl(wrapper, response);
 
     if (response.getStatus() == RESPONSE_OK) {
 	return response;
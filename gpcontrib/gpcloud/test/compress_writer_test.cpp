@@ -210,3 +210,63 @@ TEST_F(CompressWriterTest, CompressCompressedData) {
 
     EXPECT_TRUE(memcmp(compressedData.data(), result.get(), compressedData.size()) == 0);
 }
+
+TEST_F(CompressWriterTest, CompressBlocksOnWorkerThreads) {
+    uint64_t chunkSize = S3_ZIP_COMPRESS_CHUNKSIZE;
+    S3_ZIP_COMPRESS_CHUNKSIZE = 1000;
+
+    S3Params params("s3://abc/def/");
+    params.setNumOfChunks(4);
+    compressWriter.open(params);
+
+    string input;
+    for (int i = 0; i < 5000; i++) {
+        input += std::to_string(i * 7919) + "|The quick brown fox jumps over the lazy dog\n";
+    }
+
+    // in pieces not aligned to the blocks
+    for (uint64_t offset = 0; offset < input.size(); offset += 777) {
+        uint64_t len = std::min((uint64_t)777, input.size() - offset);
+        EXPECT_EQ(len, compressWriter.write(input.data() + offset, len));
+    }
+    compressWriter.close();
+
+    S3_ZIP_COMPRESS_CHUNKSIZE = chunkSize;
+
+    // a single gzip member, with the right CRC-32 and length in its trailer
+    string result(input.size() + 1, '\0');
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    ASSERT_EQ(Z_OK, inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS));
+
+    zstream.next_in = (Byte *)writer.getRawData();
+    zstream.avail_in = writer.getDataSize();
+    zstream.next_out = (Byte *)&result[0];
+    zstream.avail_out = result.size();
+
+    EXPECT_EQ(Z_STREAM_END, inflate(&zstream, Z_FINISH));
+    EXPECT_EQ((uInt)0, zstream.avail_in);
+    EXPECT_EQ(input.size(), zstream.total_out);
+    inflateEnd(&zstream);
+
+    result.resize(input.size());
+    EXPECT_EQ(input, result);
+}
+
+TEST_F(CompressWriterTest, CompressNothing) {
+    compressWriter.close();
+
+    string result(16, '\0');
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    ASSERT_EQ(Z_OK, inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS));
+
+    zstream.next_in = (Byte *)writer.getRawData();
+    zstream.avail_in = writer.getDataSize();
+    zstream.next_out = (Byte *)&result[0];
+    zstream.avail_out = result.size();
+
+    EXPECT_EQ(Z_STREAM_END, inflate(&zstream, Z_FINISH));
+    EXPECT_EQ((uLong)0, zstream.total_out);
+    inflateEnd(&zstream);
+}
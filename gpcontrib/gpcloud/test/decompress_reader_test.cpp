@@ -311,3 +311,24 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+TEST_F(DecompressReaderTest, AbleToDecompressSnappyFramedStream) {
+    // stream identifier, then an uncompressed data chunk of "hello\n"
+    const uint8_t stream[] = {0xff, 0x06, 0x00, 0x00, 's',  'N',  'a',  'P', 'p', 'Y', 0x01, 0x0a,
+                              0x00, 0x00, 0x53, 0x55, 0xff, 0x53, 'h',  'e', 'l', 'l', 'o', '\n'};
+    decompressReader.close();
+    decompressReader.setCompressionType(S3_COMPRESSION_SNAPPY);
+    decompressReader.open(S3Params("s3://abc/def"));
+
+    S3_ZIP_DECOMPRESS_CHUNKSIZE = 4;
+    decompressReader.resizeDecompressReaderBuffer(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+    this->bufReader.setData(stream, sizeof(stream));
+
+    char buf[16];
+    string result;
+    uint64_t count;
+    while ((count = decompressReader.read(buf, sizeof(buf))) > 0) {
+        result.append(buf, count);
+    }
+    EXPECT_EQ("hello\n", result);
+}
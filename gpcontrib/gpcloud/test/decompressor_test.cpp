@@ -0,0 +1,250 @@
+#include "decompressor.cpp"
+#include "gtest/gtest.h"
+
+// Run data through a decompressor, a few bytes of input and output at a time.
+static string DecompressAll(Decompressor *decompressor, const string &data, uint64_t step) {
+    string result;
+    char buf[16];
+    const char *in = data.data();
+    uint64_t inLeft = data.size();
+
+    while (true) {
+        uint64_t inLen = std::min(step, inLeft);
+        uint64_t taken = inLen;
+        char *out = buf;
+        uint64_t outLen = std::min(step, (uint64_t)sizeof(buf));
+        uint64_t room = outLen;
+
+        decompressor->decompress(in, inLen, out, outLen);
+        taken -= inLen;
+        inLeft -= taken;
+        result.append(buf, room - outLen);
+
+        if (inLeft == 0 && taken == 0 && outLen == room) {
+            return result;
+        }
+    }
+}
+
+static string SnappyChunk(uint8_t type, const string &body) {
+    string chunk;
+    chunk += (char)type;
+    chunk += (char)(body.size() & 0xff);
+    chunk += (char)((body.size() >> 8) & 0xff);
+    chunk += (char)((body.size() >> 16) & 0xff);
+    return chunk + body;
+}
+
+static string SnappyDataChunk(uint8_t type, const string &data, const string &body) {
+    uint32_t crc = SnappyMaskedCrc32c((const uint8_t *)data.data(), data.size());
+    string checksum((const char *)&crc, sizeof(crc));  // little endian hosts only
+    return SnappyChunk(type, checksum + body);
+}
+
+// literal "abc", then a copy of 6 bytes at offset 3 overlapping itself
+static const uint8_t snappyBlock[] = {9, 2 << 2, 'a', 'b', 'c', (6 - 4) << 2 | 1, 3};
+
+TEST(Decompressor, DetectCompressionType) {
+    const uint8_t gzip[] = {0x1f, 0x8b, 0x08, 0x00};
+    const uint8_t zstd[] = {0x28, 0xb5, 0x2f, 0xfd};
+    const uint8_t snappy[] = {0xff, 0x06, 0x00, 0x00};
+    const uint8_t lz4[] = {0x04, 0x22, 0x4d, 0x18};
+    const uint8_t text[] = {'a', 'b', 'c', '\n'};
+
+    EXPECT_EQ(S3_COMPRESSION_GZIP, DetectCompressionType(gzip, sizeof(gzip)));
+    EXPECT_EQ(S3_COMPRESSION_ZSTD, DetectCompressionType(zstd, sizeof(zstd)));
+    EXPECT_EQ(S3_COMPRESSION_SNAPPY, DetectCompressionType(snappy, sizeof(snappy)));
+    EXPECT_EQ(S3_COMPRESSION_LZ4, DetectCompressionType(lz4, sizeof(lz4)));
+    EXPECT_EQ(S3_COMPRESSION_PLAIN, DetectCompressionType(text, sizeof(text)));
+    EXPECT_EQ(S3_COMPRESSION_PLAIN, DetectCompressionType(zstd, 3));
+}
+
+TEST(Decompressor, CreateDecompressor) {
+    std::unique_ptr<Decompressor> gzip(CreateDecompressor(S3_COMPRESSION_GZIP));
+    std::unique_ptr<Decompressor> snappy(CreateDecompressor(S3_COMPRESSION_SNAPPY));
+
+    EXPECT_TRUE(gzip != NULL);
+    EXPECT_TRUE(snappy != NULL);
+#ifdef USE_LZ4
+    std::unique_ptr<Decompressor> lz4(CreateDecompressor(S3_COMPRESSION_LZ4));
+    EXPECT_TRUE(lz4 != NULL);
+#else
+    EXPECT_TRUE(CreateDecompressor(S3_COMPRESSION_LZ4) == NULL);
+#endif
+    EXPECT_TRUE(CreateDecompressor(S3_COMPRESSION_PLAIN) == NULL);
+    EXPECT_STREQ("lz4", GetCompressionName(S3_COMPRESSION_LZ4));
+}
+
+TEST(Decompressor, ZlibMultipleGzipMembers) {
+    string data;
+    const char *members[] = {"first member\n", "second member\n"};
+
+    for (const char *member : members) {
+        z_stream zstream;
+        memset(&zstream, 0, sizeof(zstream));
+        ASSERT_EQ(Z_OK, deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16,
+                                     8, Z_DEFAULT_STRATEGY));
+
+        Byte buf[256];
+        zstream.next_in = (Byte *)member;
+        zstream.avail_in = strlen(member);
+        zstream.next_out = buf;
+        zstream.avail_out = sizeof(buf);
+        ASSERT_EQ(Z_STREAM_END, deflate(&zstream, Z_FINISH));
+        data.append((const char *)buf, sizeof(buf) - zstream.avail_out);
+        deflateEnd(&zstream);
+    }
+
+    ZlibDecompressor decompressor;
+    decompressor.init();
+    EXPECT_EQ("first member\nsecond member\n", DecompressAll(&decompressor, data, 5));
+    decompressor.end();
+}
+
+TEST(Decompressor, SnappyCrc32c) {
+    const char check[] = "123456789";
+    EXPECT_EQ(0xc78ab0e5, SnappyMaskedCrc32c((const uint8_t *)check, strlen(check)));
+}
+
+TEST(Decompressor, SnappyRawDecompress) {
+    uint8_t out[9];
+
+    SnappyRawDecompress(snappyBlock, sizeof(snappyBlock), out, sizeof(out));
+    EXPECT_EQ("abcabcabc", string((const char *)out, sizeof(out)));
+
+    EXPECT_THROW(SnappyRawDecompress(snappyBlock, sizeof(snappyBlock), out, 8), S3RuntimeError);
+}
+
+TEST(Decompressor, SnappyFramed) {
+    string data = SnappyChunk(0xff, "sNaPpY");
+    data += SnappyDataChunk(0x00, "abcabcabc",
+                            string((const char *)snappyBlock, sizeof(snappyBlock)));
+    data += SnappyChunk(0xfe, "padding");
+    data += SnappyDataChunk(0x01, "stored\n", "stored\n");
+
+    for (uint64_t step = 1; step <= 16; step++) {
+        SnappyDecompressor decompressor;
+        decompressor.init();
+        EXPECT_EQ("abcabcabcstored\n", DecompressAll(&decompressor, data, step));
+        decompressor.end();
+    }
+}
+
+TEST(Decompressor, SnappyFramedChecksumMismatch) {
+    string data = SnappyChunk(0xff, "sNaPpY");
+    data += SnappyDataChunk(0x01, "stored\n", "Stored\n");
+
+    SnappyDecompressor decompressor;
+    decompressor.init();
+    EXPECT_THROW(DecompressAll(&decompressor, data, 16), S3RuntimeError);
+}
+
+TEST(Decompressor, SnappyFramedReservedChunk) {
+    string data = SnappyChunk(0xff, "sNaPpY");
+    data += SnappyChunk(0x02, "unknown");
+
+    SnappyDecompressor decompressor;
+    decompressor.init();
+    EXPECT_THROW(DecompressAll(&decompressor, data, 16), S3RuntimeError);
+}
+
+#ifdef USE_ZSTD
+TEST(Decompressor, ZstdMultipleFrames) {
+    const uint8_t frames[] = {
+        0x28, 0xb5, 0x2f, 0xfd, 0x20, 0x0c, 0x61, 0x00, 0x00, 0x66, 0x69, 0x72, 0x73, 0x74, 0x20,
+        0x66, 0x72, 0x61, 0x6d, 0x65, 0x0a, 0x28, 0xb5, 0x2f, 0xfd, 0x20, 0x0d, 0x69, 0x00, 0x00,
+        0x73, 0x65, 0x63, 0x6f, 0x6e, 0x64, 0x20, 0x66, 0x72, 0x61, 0x6d, 0x65, 0x0a};
+
+    ZstdDecompressor decompressor;
+    decompressor.init();
+    EXPECT_EQ("first frame\nsecond frame\n",
+              DecompressAll(&decompressor, string((const char *)frames, sizeof(frames)), 7));
+    decompressor.end();
+}
+
+// Frames of "<i> frame\n" lines, some of them without a content size.
+static string ZstdFrames(int count, string &expected) {
+    string data;
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+
+    for (int i = 0; i < count; i++) {
+        string content;
+        for (int line = 0; line <= i; line++) {
+            content += std::to_string(i) + " frame\n";
+        }
+        expected += content;
+
+        ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, i % 5 != 3);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+
+        vector<char> frame(ZSTD_compressBound(content.size()));
+        size_t len =
+            ZSTD_compress2(cctx, frame.data(), frame.size(), content.data(), content.size());
+        EXPECT_FALSE(ZSTD_isError(len));
+        data.append(frame.data(), len);
+    }
+
+    ZSTD_freeCCtx(cctx);
+    return data;
+}
+
+TEST(Decompressor, ZstdParallelFrames) {
+    string expected;
+    string data = ZstdFrames(20, expected);
+
+    for (uint64_t threads : {1, 2, 4}) {
+        for (uint64_t step : {1, 7, 64, 4096}) {
+            ZstdDecompressor decompressor;
+            decompressor.setParallelism(threads);
+            decompressor.init();
+            EXPECT_EQ(expected, DecompressAll(&decompressor, data, step));
+            decompressor.end();
+        }
+    }
+}
+
+TEST(Decompressor, ZstdParallelCorruptFrame) {
+    string expected;
+    string data = ZstdFrames(3, expected);
+    data[data.size() - 4] ^= 0xff;
+
+    ZstdDecompressor decompressor;
+    decompressor.setParallelism(4);
+    decompressor.init();
+    EXPECT_THROW(DecompressAll(&decompressor, data, 4096), S3RuntimeError);
+}
+#endif
+
+#ifdef USE_LZ4
+TEST(Decompressor, Lz4MultipleFrames) {
+    const uint8_t frames[] = {
+        0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x0c, 0x00, 0x00, 0x80, 0x66, 0x69, 0x72, 0x73,
+        0x74, 0x20, 0x66, 0x72, 0x61, 0x6d, 0x65, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x94, 0xbc,
+        0xbd, 0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x0d, 0x00, 0x00, 0x80, 0x73, 0x65, 0x63,
+        0x6f, 0x6e, 0x64, 0x20, 0x66, 0x72, 0x61, 0x6d, 0x65, 0x0a, 0x00, 0x00, 0x00, 0x00, 0xe7,
+        0x98, 0xf4, 0xef};
+    string data((const char *)frames, sizeof(frames));
+
+    for (uint64_t step = 1; step <= 16; step++) {
+        Lz4Decompressor decompressor;
+        decompressor.init();
+        EXPECT_EQ("first frame\nsecond frame\n", DecompressAll(&decompressor, data, step));
+        decompressor.end();
+    }
+
+    data[data.size() - 1] ^= 0xff;
+    Lz4Decompressor decompressor;
+    decompressor.init();
+    EXPECT_THROW(DecompressAll(&decompressor, data, 16), S3RuntimeError);
+}
+#endif
+
+TEST(Decompressor, StatsSummary) {
+    DecompressStats &stats = GetDecompressStats(S3_COMPRESSION_SNAPPY);
+    stats.inBytes += 100;
+    stats.outBytes += 400;
+
+    EXPECT_NE(string::npos, GetDecompressStatsSummary().find("snappy: "));
+    EXPECT_EQ(string::npos, GetDecompressStatsSummary().find("lz4: "));
+}
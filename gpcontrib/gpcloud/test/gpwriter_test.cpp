@@ -120,3 +120,62 @@ TEST_F(GPWriterTest, ReGenerateKeyName) {
 
     // expect the restfulService->head() was called twice
 }
+
+TEST_F(GPWriterTest, RollToNewKeyAfterObjectSize) {
+    string url = "https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/dataset1/normal";
+
+    S3Params p = InitConfig(url + " config=data/s3test.conf");
+    p.setAutoCompress(false);
+    p.setObjectSize(10);
+
+    MockS3RESTfulService mockRESTfulService(p);
+    MockGPWriter gpwriter(p, &mockRESTfulService);
+    EXPECT_CALL(mockRESTfulService, head(_, _)).Times(2).WillRepeatedly(Return(404));
+
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<InitiateMultipartUploadResult"
+        " xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+        "<Bucket>example-bucket</Bucket>"
+        "<Key>example-object</Key>"
+        "<UploadId>VXBsb2FkIElEIGZvciA2aWWpbmcncyBteS1tb3ZpZS5tMnRzIHVwbG9hZA</UploadId>"
+        "</InitiateMultipartUploadResult>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+    Response response(RESPONSE_OK, raw);
+
+    // completing an upload posts a body, initiating one posts nothing
+    EXPECT_CALL(mockRESTfulService, post(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(Response(RESPONSE_OK)));
+    EXPECT_CALL(mockRESTfulService, post(_, _, vector<uint8_t>()))
+        .Times(2)
+        .WillRepeatedly(Return(response));
+
+    string etag = "ETag: \"abc\"\r\n";
+    Response putResponse(RESPONSE_OK);
+    putResponse.appendHeadersBuffer(&etag[0], etag.length());
+
+    vector<string> uploadedUrls;
+    EXPECT_CALL(mockRESTfulService, put(_, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const string &url, HTTPHeaders &, const S3VectorUInt8 &) {
+            uploadedUrls.push_back(url.substr(0, url.find('?')));
+            return putResponse;
+        }));
+
+    gpwriter.open(p);
+    string firstKey = gpwriter.getKeyUrlToUpload();
+
+    // the first row stays in the first key, even if it's over objectsize
+    EXPECT_EQ((uint64_t)11, gpwriter.write("0123456789\n", 11));
+    EXPECT_EQ(firstKey, gpwriter.getKeyUrlToUpload());
+
+    EXPECT_EQ((uint64_t)4, gpwriter.write("abc\n", 4));
+    EXPECT_NE(firstKey, gpwriter.getKeyUrlToUpload());
+
+    gpwriter.close();
+
+    ASSERT_EQ((uint64_t)2, uploadedUrls.size());
+    EXPECT_EQ(firstKey, uploadedUrls[0]);
+    EXPECT_EQ(gpwriter.getKeyUrlToUpload(), uploadedUrls[1]);
+}
@@ -0,0 +1,307 @@
+#include "parquet_reader.cpp"
+
+#include <fstream>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::_;
+using ::testing::AtLeast;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::Throw;
+
+// The files in data/ are written by pyarrow:
+//   parquet_types.parquet        snappy, dictionary encoded, version 1 pages
+//   parquet_types_plain.parquet  the same rows uncompressed, plain encoded
+//   parquet_gzip_v2.parquet      gzip, plain encoded, version 2 pages, 4 row groups
+//   parquet_nested.parquet       a struct and a list column
+class MockS3InterfaceForParquet : public MockS3Interface {
+   public:
+    void setFile(const string &path) {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    uint64_t mockFetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url) {
+        fetchedBytes += len;
+        data.assign(content.begin() + offset, content.begin() + offset + len);
+        return data.size();
+    }
+
+    string content;
+    uint64_t fetchedBytes = 0;
+};
+
+class ParquetReaderTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() {
+        isTextFormat = true;
+        hasHeader = false;
+        columnNames.clear();
+        columnReferenced.clear();
+        columnPredicates.clear();
+        reader.setS3InterfaceService(&mockS3Interface);
+
+        EXPECT_CALL(mockS3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(
+                Invoke(&mockS3Interface, &MockS3InterfaceForParquet::mockFetchData));
+    }
+
+    virtual void TearDown() {
+        reader.close();
+        isTextFormat = false;
+        columnNames.clear();
+        columnReferenced.clear();
+        columnPredicates.clear();
+    }
+
+    void openFile(const string &path) {
+        mockS3Interface.setFile(path);
+        ASSERT_FALSE(mockS3Interface.content.empty());
+
+        S3Params params("s3://bucket/file.parquet");
+        params.setKeySize(mockS3Interface.content.size());
+        reader.open(params);
+    }
+
+    // read with a small buffer to cross row boundaries
+    string readAll() {
+        string result;
+        char buf[7];
+        uint64_t len;
+        while ((len = reader.read(buf, sizeof(buf))) > 0) {
+            result.append(buf, len);
+        }
+        return result;
+    }
+
+    MockS3InterfaceForParquet mockS3Interface;
+    ParquetReader reader;
+};
+
+static const char *typesRows =
+    "t\t1\t10\t4294967295\t1.5\t0.10000000000000001\tplain\t\\\\x00ff\t12.34\t"
+    "-1234567890123456789012.34567\t2024-02-29\t2024-02-29 13:14:15.123456+00\t"
+    "2001-02-03 04:05:06.007000\t01:02:03.400000\ta\n"
+    "f\t-2\t\\N\t0\tNaN\t-2.25\ttab\\\there\t\\N\t-0.05\t\\N\t1969-12-31\t\\N\t\\N\t\\N\ta\n"
+    "\\N\t\\N\t-9223372036854775808\t1\t\\N\t1.0000000000000001e+300\tline\\nbreak\\\\\t\\\\x\t"
+    "\\N\t0.00001\t\\N\t1969-12-31 23:59:59+00\t\\N\t23:59:59\tb\n"
+    "t\t2147483647\t42\t\\N\t-Infinity\t\\N\t\\N\t\\\\x6162\t0.00\t1.00000\t0001-01-01\t"
+    "2000-01-01 00:00:00+00\t\\N\t00:00:00\ta\n";
+
+TEST_F(ParquetReaderTest, ReadAllTypesDictionary) {
+    openFile("data/parquet_types.parquet");
+
+    EXPECT_EQ(15, reader.getFileInfo().columns.size());
+    EXPECT_EQ(4, reader.getFileInfo().numRows);
+    EXPECT_EQ(typesRows, readAll());
+}
+
+TEST_F(ParquetReaderTest, ReadAllTypesPlain) {
+    openFile("data/parquet_types_plain.parquet");
+
+    EXPECT_EQ(typesRows, readAll());
+}
+
+TEST_F(ParquetReaderTest, ReadProjectedColumns) {
+    columnNames.push_back("camelname");
+    columnNames.push_back("i32");
+    openFile("data/parquet_types.parquet");
+
+    ASSERT_EQ(2, reader.getProjection().size());
+    EXPECT_EQ(14, reader.getProjection()[0]);
+    EXPECT_EQ(1, reader.getProjection()[1]);
+    EXPECT_EQ("a\t1\na\t-2\nb\t\\N\na\t2147483647\n", readAll());
+}
+
+TEST_F(ParquetReaderTest, ReadTextOptions) {
+    columnNames.push_back("s");
+    columnNames.push_back("b");
+    textDelimiter = '|';
+    textNullString = "NULL";
+    openFile("data/parquet_types.parquet");
+
+    string rows = readAll();
+    textDelimiter = '\t';
+    textNullString = "\\N";
+
+    EXPECT_EQ("plain|t\ntab\there|f\nline\\nbreak\\\\|NULL\nNULL|t\n", rows);
+}
+
+TEST_F(ParquetReaderTest, ReadGzipVersion2Pages) {
+    openFile("data/parquet_gzip_v2.parquet");
+
+    EXPECT_EQ(4, reader.getFileInfo().rowGroups.size());
+
+    string expected;
+    for (int i = 0; i < 1000; i++) {
+        expected += std::to_string(i) + "\t";
+        expected += (i % 3 == 0) ? "\\N" : "name" + std::to_string(i);
+        expected += (i % 2 == 0) ? "\tt\n" : "\tf\n";
+    }
+    EXPECT_EQ(expected, readAll());
+}
+
+TEST_F(ParquetReaderTest, FetchOnlyProjectedColumnChunks) {
+    columnNames.push_back("id");
+    openFile("data/parquet_gzip_v2.parquet");
+    readAll();
+
+    // the footer, then the 'id' chunk of each row group
+    uint64_t expected = std::min(mockS3Interface.content.size(), (size_t)PARQUET_FOOTER_PREFETCH);
+    for (const ParquetRowGroupInfo &rowGroup : reader.getFileInfo().rowGroups) {
+        expected += rowGroup.columns[0].compressedSize;
+    }
+    EXPECT_EQ(expected, mockS3Interface.fetchedBytes);
+}
+
+TEST_F(ParquetReaderTest, ReturnUnreferencedColumnsAsNulls) {
+    columnNames.push_back("id");
+    columnNames.push_back("name");
+    columnNames.push_back("flag");
+    columnReferenced.push_back(false);
+    columnReferenced.push_back(true);
+    columnReferenced.push_back(false);
+    openFile("data/parquet_gzip_v2.parquet");
+
+    ASSERT_EQ(3, reader.getProjection().size());
+    EXPECT_EQ(PARQUET_NO_COLUMN, reader.getProjection()[0]);
+    EXPECT_EQ(1, reader.getProjection()[1]);
+    EXPECT_EQ(PARQUET_NO_COLUMN, reader.getProjection()[2]);
+
+    string rows = readAll();
+    EXPECT_EQ("\\N\t\\N\t\\N\n\\N\tname1\t\\N\n", rows.substr(0, 21));
+
+    // the footer, then the 'name' chunk of each row group
+    uint64_t expected = std::min(mockS3Interface.content.size(), (size_t)PARQUET_FOOTER_PREFETCH);
+    for (const ParquetRowGroupInfo &rowGroup : reader.getFileInfo().rowGroups) {
+        expected += rowGroup.columns[1].compressedSize;
+    }
+    EXPECT_EQ(expected, mockS3Interface.fetchedBytes);
+}
+
+static ColumnPredicate MakePredicate(uint64_t column, ColumnPredicateOp op, int64_t value) {
+    ColumnPredicate predicate;
+    predicate.column = column;
+    predicate.op = op;
+    predicate.kind = PREDICATE_INTEGER;
+    predicate.intValue = value;
+    return predicate;
+}
+
+// The row groups of parquet_gzip_v2.parquet hold the ids 0-299, 300-599,
+// 600-899 and 900-999.
+TEST_F(ParquetReaderTest, SkipRowGroupsByStatistics) {
+    columnNames.push_back("id");
+    columnNames.push_back("name");
+    columnPredicates.push_back(MakePredicate(0, PREDICATE_GE, 600));
+    columnPredicates.push_back(MakePredicate(0, PREDICATE_LT, 900));
+    openFile("data/parquet_gzip_v2.parquet");
+
+    string rows = readAll();
+    EXPECT_EQ(3, reader.getSkippedRowGroups());
+    EXPECT_EQ(300, std::count(rows.begin(), rows.end(), '\n'));
+    EXPECT_EQ("600\t\\N\n601\tname601\n", rows.substr(0, 19));
+}
+
+TEST_F(ParquetReaderTest, SkipRowGroupsByStringStatistics) {
+    columnNames.push_back("id");
+    columnNames.push_back("name");
+    ColumnPredicate predicate;
+    predicate.column = 1;
+    predicate.op = PREDICATE_EQ;
+    predicate.kind = PREDICATE_STRING;
+    predicate.stringValue = "name5";
+    columnPredicates.push_back(predicate);
+    openFile("data/parquet_gzip_v2.parquet");
+
+    string rows = readAll();
+    EXPECT_EQ(2, reader.getSkippedRowGroups());
+    EXPECT_EQ(600, std::count(rows.begin(), rows.end(), '\n'));
+}
+
+TEST_F(ParquetReaderTest, KeepRowGroupsOfMismatchedPredicates) {
+    columnNames.push_back("id");
+    columnNames.push_back("name");
+    ColumnPredicate predicate = MakePredicate(1, PREDICATE_EQ, 5);  // 'name' is a string
+    columnPredicates.push_back(predicate);
+    openFile("data/parquet_gzip_v2.parquet");
+
+    readAll();
+    EXPECT_EQ(0, reader.getSkippedRowGroups());
+}
+
+TEST_F(ParquetReaderTest, ReadFlatColumnsOfNestedFile) {
+    columnNames.push_back("id");
+    openFile("data/parquet_nested.parquet");
+
+    EXPECT_EQ(4, reader.getFileInfo().columns.size());
+    EXPECT_EQ("point.x", reader.getFileInfo().columns[1].name);
+    EXPECT_EQ("1\n2\n", readAll());
+}
+
+TEST_F(ParquetReaderTest, NestedColumnIsNotSupported) {
+    columnNames.push_back("point.x");
+    EXPECT_THROW(openFile("data/parquet_nested.parquet"), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, MissingColumn) {
+    columnNames.push_back("nosuchcolumn");
+    EXPECT_THROW(openFile("data/parquet_types.parquet"), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, CsvFormatIsNotSupported) {
+    isTextFormat = false;
+    EXPECT_THROW(openFile("data/parquet_types.parquet"), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, CorruptFooter) {
+    mockS3Interface.setFile("data/parquet_types.parquet");
+    mockS3Interface.content.replace(mockS3Interface.content.size() - 8, 4, "\xff\xff\xff\x7f");
+
+    S3Params params("s3://bucket/file.parquet");
+    params.setKeySize(mockS3Interface.content.size());
+    EXPECT_THROW(reader.open(params), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, TruncatedMetadata) {
+    mockS3Interface.setFile("data/parquet_types.parquet");
+    string &content = mockS3Interface.content;
+    uint32_t metadataLen = ReadLE32((const uint8_t *)content.data() + content.size() - 8);
+
+    ParquetFileInfo fileInfo;
+    EXPECT_THROW(ParseParquetFileInfo(
+                     (const uint8_t *)content.data() + content.size() - 8 - metadataLen,
+                     metadataLen / 2, fileInfo),
+                 S3RuntimeError);
+}
+
+TEST(ParquetRleBitPacked, DecodeRuns) {
+    // a run of 3 fives, then 8 bit-packed values of 3 bits
+    const uint8_t data[] = {3 << 1, 5, 1 << 1 | 1, 0x88, 0xc6, 0xfa};
+    RleBitPackedDecoder decoder;
+    decoder.init(data, sizeof(data), 3);
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(5, decoder.next());
+    }
+    for (uint32_t i = 0; i < 8; i++) {
+        EXPECT_EQ(i, decoder.next());
+    }
+    EXPECT_THROW(decoder.next(), S3RuntimeError);
+}
+
+TEST(ParquetDecimal, AppendBinaryDecimal) {
+    const uint8_t minusOne[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    const uint8_t big[] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    string out;
+
+    AppendBinaryDecimal(minusOne, sizeof(minusOne), 3, out);
+    EXPECT_EQ("-0.001", out);
+
+    out.clear();
+    AppendBinaryDecimal(big, sizeof(big), 0, out);
+    EXPECT_EQ("18446744073709551616", out);
+}
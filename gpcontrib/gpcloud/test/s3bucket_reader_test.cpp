@@ -285,3 +285,344 @@ TEST_F(S3BucketReaderTest, ReadBucketFileWithHeaderAndFuzyMatch) {
     eolString[0] = '\n';
     eolString[1] = '\0';
 }
+
+// Upstream reader serving the requested byte range of keys, found by their size.
+class RangeReader : public Reader {
+   public:
+    void addKey(const string& content) {
+        keys[content.size()] = content;
+    }
+
+    void open(const S3Params& params) {
+        const string& content = keys[params.getKeySize()];
+        uint64_t length = params.getRangeLength();
+
+        if (length == 0) {
+            length = content.size() - params.getRangeOffset();
+        }
+        data = content.substr(params.getRangeOffset(), length);
+        pos = 0;
+        opened++;
+    }
+
+    uint64_t read(char* buf, uint64_t count) {
+        uint64_t len = std::min(count, (uint64_t)(data.size() - pos));
+        memcpy(buf, data.data() + pos, len);
+        pos += len;
+        return len;
+    }
+
+    void close() {
+    }
+
+    int opened = 0;
+
+   private:
+    map<uint64_t, string> keys;
+    string data;
+    uint64_t pos;
+};
+
+class S3BucketReaderSplitTest : public S3BucketReaderTest {
+   protected:
+    virtual void SetUp() {
+        S3BucketReaderTest::SetUp();
+        isTextFormat = true;
+    }
+
+    virtual void TearDown() {
+        isTextFormat = false;
+        S3BucketReaderTest::TearDown();
+    }
+
+    // Read the bucket as segment 'segid' of 'segnum'.
+    string readSegment(const ListBucketResult& result, RangeReader& rangeReader, int32_t segid,
+                       int32_t segnum) {
+        S3BucketReader reader;
+        S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+        params.setSplitSize(1);
+        params.setChunkSize(1024 * 1024);
+        params.setNumOfChunks(4);
+
+        s3ext_segid = segid;
+        s3ext_segnum = segnum;
+
+        reader.setS3InterfaceService(&s3Interface);
+        reader.open(params);
+        reader.setUpstreamReader(&rangeReader);
+
+        string out;
+        uint64_t len;
+        while ((len = reader.read(buf, sizeof(buf))) != 0) {
+            out.append(buf, len);
+        }
+        return out;
+    }
+
+    static vector<string> sortedLines(const string& data, const string& eol) {
+        vector<string> lines;
+        size_t start = 0;
+        size_t end;
+        while ((end = data.find(eol, start)) != string::npos) {
+            lines.push_back(data.substr(start, end - start));
+            start = end + eol.size();
+        }
+        EXPECT_EQ(data.size(), start);
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+
+    void checkSplitRead(const string& content, const string& eol, int32_t segnum) {
+        ListBucketResult result;
+        result.contents.emplace_back("big", content.size());
+
+        EXPECT_CALL(s3Interface, listBucket(_)).WillRepeatedly(Return(result));
+        EXPECT_CALL(s3Interface, checkCompressionType(_))
+            .WillRepeatedly(Return(S3_COMPRESSION_PLAIN));
+
+        RangeReader rangeReader;
+        rangeReader.addKey(content);
+
+        string all;
+        for (int32_t seg = 0; seg < segnum; seg++) {
+            all += readSegment(result, rangeReader, seg, segnum);
+        }
+
+        EXPECT_EQ(sortedLines(content, eol), sortedLines(all, eol));
+    }
+};
+
+TEST_F(S3BucketReaderSplitTest, SplitKeyIntoLineAlignedRanges) {
+    string content;
+    for (int i = 0; i < 500; i++) {
+        content += "row " + std::to_string(i) + string(i % 37, 'x') + "\n";
+    }
+
+    checkSplitRead(content, "\n", 1);
+    checkSplitRead(content, "\n", 3);
+    checkSplitRead(content, "\n", 16);
+}
+
+TEST_F(S3BucketReaderSplitTest, SplitKeyWithLinesLongerThanRanges) {
+    string content = "a\n" + string(3000, 'b') + "\n" + "c\n" + string(500, 'd') + "\n";
+
+    checkSplitRead(content, "\n", 8);
+    checkSplitRead(content, "\n", 64);
+}
+
+TEST_F(S3BucketReaderSplitTest, SplitKeyWithCRLF) {
+    eolString[0] = '\r';
+    eolString[1] = '\n';
+    eolString[2] = '\0';
+
+    string content;
+    for (int i = 0; i < 300; i++) {
+        content += "row " + std::to_string(i * 7919) + "\r\n";
+    }
+
+    checkSplitRead(content, "\r\n", 7);
+}
+
+TEST_F(S3BucketReaderSplitTest, BalanceBytesAcrossSegments) {
+    ListBucketResult result;
+    result.contents.emplace_back("big", 1000);
+    for (int i = 0; i < 10; i++) {
+        result.contents.emplace_back("small" + std::to_string(i), 10);
+    }
+
+    EXPECT_CALL(s3Interface, listBucket(_)).WillRepeatedly(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillRepeatedly(Return(S3_COMPRESSION_PLAIN));
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(1);
+
+    s3ext_segnum = 2;
+    for (int32_t seg = 0; seg < 2; seg++) {
+        S3BucketReader reader;
+        reader.setS3InterfaceService(&s3Interface);
+        s3ext_segid = seg;
+        reader.open(params);
+
+        uint64_t bytes = 0;
+        for (const KeyRange& range : reader.getKeyRanges()) {
+            bytes += range.length;
+        }
+        EXPECT_EQ((uint64_t)550, bytes);
+    }
+}
+
+TEST_F(S3BucketReaderSplitTest, DoNotSplitCompressedKeys) {
+    ListBucketResult result;
+    result.contents.emplace_back("big.gz", 1000);
+    result.contents.emplace_back("small", 10);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).WillRepeatedly(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillRepeatedly(Return(S3_COMPRESSION_GZIP));
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(1);
+
+    s3ext_segid = 0;
+    s3ext_segnum = 4;
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_FALSE(bucketReader->getKeyRanges()[0].split);
+    EXPECT_EQ((uint64_t)1000, bucketReader->getKeyRanges()[0].length);
+}
+
+TEST_F(S3BucketReaderSplitTest, DoNotSplitKeysWithHeader) {
+    hasHeader = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("big", 1000);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).WillRepeatedly(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).Times(0);
+
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(1);
+
+    s3ext_segid = 0;
+    s3ext_segnum = 4;
+    bucketReader->open(params);
+
+    ASSERT_EQ((uint64_t)1, bucketReader->getKeyRanges().size());
+    EXPECT_FALSE(bucketReader->getKeyRanges()[0].split);
+
+    hasHeader = false;
+}
+
+// Lists keys "key0", "key1", ... a few per page, and fails from failAt on.
+class MockS3InterfaceWithPages : public MockS3Interface {
+   public:
+    MockS3InterfaceWithPages(uint64_t numOfKeys, uint64_t pageSize, uint64_t failAt = UINT64_MAX)
+        : numOfKeys(numOfKeys), pageSize(pageSize), failAt(failAt) {
+    }
+
+    void listBucketPage(const S3Url& s3Url, string& marker, ListBucketResult& result) {
+        uint64_t start = marker.empty() ? 0 : std::stoull(marker);
+        if (start >= failAt) {
+            throw S3ConnectionError("listing failed");
+        }
+
+        uint64_t end = std::min(start + pageSize, numOfKeys);
+        for (uint64_t i = start; i < end; i++) {
+            result.contents.emplace_back("key" + std::to_string(i), i + 1);
+        }
+        marker = end < numOfKeys ? std::to_string(end) : "";
+    }
+
+   private:
+    uint64_t numOfKeys;
+    uint64_t pageSize;
+    uint64_t failAt;
+};
+
+class KeyRecordingReader : public Reader {
+   public:
+    void open(const S3Params& params) {
+        keys.push_back(params.getS3Url().getPrefix());
+    }
+    uint64_t read(char* buf, uint64_t count) {
+        return 0;
+    }
+    void close() {
+    }
+
+    vector<string> keys;
+};
+
+TEST_F(S3BucketReaderTest, ReadKeysWhileListingInBackground) {
+    MockS3InterfaceWithPages pagedInterface(10, 3);
+    KeyRecordingReader reader;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    s3ext_segid = 1;
+    s3ext_segnum = 2;
+
+    bucketReader->setS3InterfaceService(&pagedInterface);
+    bucketReader->setUpstreamReader(&reader);
+    bucketReader->open(params);
+
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    vector<string> expected = {"key1", "key3", "key5", "key7", "key9"};
+    EXPECT_EQ(expected, reader.keys);
+    EXPECT_EQ((uint64_t)10, bucketReader->getKeyList().contents.size());
+    bucketReader->close();
+}
+
+TEST_F(S3BucketReaderTest, ListingErrorIsThrownByRead) {
+    MockS3InterfaceWithPages pagedInterface(10, 3, 6);
+    KeyRecordingReader reader;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    bucketReader->setS3InterfaceService(&pagedInterface);
+    bucketReader->setUpstreamReader(&reader);
+    bucketReader->open(params);
+
+    EXPECT_THROW(bucketReader->read(buf, sizeof(buf)), S3ConnectionError);
+    bucketReader->close();
+}
+
+TEST_F(S3BucketReaderTest, SplitPagesWhileListingInBackground) {
+    MockS3InterfaceWithPages pagedInterface(10, 3);
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(1024);
+
+    // every key is smaller than the split size, each page is assigned in turn,
+    // the largest keys of a page first
+    vector<uint64_t> expectedBytes = {25, 30};
+    vector<uint64_t> readTimes(10, 0);
+
+    s3ext_segnum = 2;
+    for (int32_t seg = 0; seg < 2; seg++) {
+        S3BucketReader reader;
+        reader.setS3InterfaceService(&pagedInterface);
+        s3ext_segid = seg;
+        reader.open(params);
+
+        uint64_t bytes = 0;
+        for (const KeyRange& range : reader.getKeyRanges()) {
+            EXPECT_FALSE(range.split);
+            bytes += range.length;
+            readTimes[range.keyIndex]++;
+        }
+        EXPECT_EQ((uint64_t)10, reader.getKeyList().contents.size());
+        EXPECT_EQ(expectedBytes[seg], bytes);
+    }
+
+    EXPECT_EQ(vector<uint64_t>(10, 1), readTimes);
+}
+
+TEST_F(S3BucketReaderTest, ListingErrorIsThrownByReadWhenSplitting) {
+    MockS3InterfaceWithPages pagedInterface(10, 3, 3);
+    KeyRecordingReader reader;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(1024);
+
+    s3ext_segid = 0;
+    s3ext_segnum = 2;
+
+    bucketReader->setS3InterfaceService(&pagedInterface);
+    bucketReader->setUpstreamReader(&reader);
+    bucketReader->open(params);
+
+    // the keys of the first page are read before the error
+    EXPECT_THROW(bucketReader->read(buf, sizeof(buf)), S3ConnectionError);
+    vector<string> expected = {"key2"};
+    EXPECT_EQ(expected, reader.keys);
+    bucketReader->close();
+}
+
+TEST_F(S3BucketReaderTest, CloseWhileListingInBackground) {
+    MockS3InterfaceWithPages pagedInterface(100000, 1);
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    bucketReader->setS3InterfaceService(&pagedInterface);
+    bucketReader->open(params);
+    bucketReader->close();
+
+    EXPECT_EQ((uint64_t)0, bucketReader->getKeyRanges().size());
+}
@@ -61,6 +61,15 @@ TEST_F(S3CommonReaderTest, OpenPlain) {
     ASSERT_TRUE(NULL != dynamic_cast<S3KeyReader *>(this->upstreamReader));
 }
 
+TEST_F(S3CommonReaderTest, OpenLz4IsNotSupported) {
+    EXPECT_CALL(mockS3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_LZ4));
+    S3Params params("s3://abc/def");
+    params.setNumOfChunks(1);
+    params.setChunkSize(1024 * 1024 * 2);
+
+    EXPECT_THROW(this->open(params), S3RuntimeError);
+}
+
 TEST_F(S3CommonReaderTest, ReadGZip) {
     Byte compressionBuff[0x100];
     uLong compressedLen = sizeof(compressionBuff);
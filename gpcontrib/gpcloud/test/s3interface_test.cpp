@@ -248,6 +248,21 @@ TEST_F(S3InterfaceServiceTest, ListBucketWithBucketWith1001Keys) {
     EXPECT_EQ((uint64_t)1001, result.contents.size());
 }
 
+TEST_F(S3InterfaceServiceTest, ListBucketPageByPage) {
+    EXPECT_CALL(mockRESTfulService, get(_, _))
+        .WillOnce(Return(this->buildListBucketResponse(1000, true)))
+        .WillOnce(Return(this->buildListBucketResponse(1, false)));
+
+    string marker;
+    this->listBucketPage(this->params.getS3Url(), marker, result);
+    EXPECT_EQ((uint64_t)1000, result.contents.size());
+    EXPECT_FALSE(marker.empty());
+
+    this->listBucketPage(this->params.getS3Url(), marker, result);
+    EXPECT_EQ((uint64_t)1001, result.contents.size());
+    EXPECT_TRUE(marker.empty());
+}
+
 TEST_F(S3InterfaceServiceTest, ListBucketWithBucketWithMoreThan1000Keys) {
     EXPECT_CALL(mockRESTfulService, get(_, _))
         .WillOnce(Return(this->buildListBucketResponse(1000, true)))
@@ -414,6 +429,36 @@ TEST_F(S3InterfaceServiceTest, checkItsGzipCompressed) {
     EXPECT_EQ(S3_COMPRESSION_GZIP, this->checkCompressionType(s3Url));
 }
 
+TEST_F(S3InterfaceServiceTest, checkItsZstdCompressed) {
+    uint8_t magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    vector<uint8_t> raw(magic, magic + sizeof(magic));
+    Response response(RESPONSE_OK, raw);
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    S3Url s3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever.gz");
+    EXPECT_EQ(S3_COMPRESSION_ZSTD, this->checkCompressionType(s3Url));
+}
+
+TEST_F(S3InterfaceServiceTest, checkItsSnappyCompressed) {
+    uint8_t magic[] = {0xff, 0x06, 0x00, 0x00};
+    vector<uint8_t> raw(magic, magic + sizeof(magic));
+    Response response(RESPONSE_OK, raw);
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    S3Url s3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    EXPECT_EQ(S3_COMPRESSION_SNAPPY, this->checkCompressionType(s3Url));
+}
+
+TEST_F(S3InterfaceServiceTest, checkItsParquet) {
+    uint8_t magic[] = {'P', 'A', 'R', '1'};
+    vector<uint8_t> raw(magic, magic + sizeof(magic));
+    Response response(RESPONSE_OK, raw);
+    EXPECT_CALL(mockRESTfulService, get(_, _)).WillOnce(Return(response));
+
+    S3Url s3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    EXPECT_EQ(S3_COMPRESSION_PARQUET, this->checkCompressionType(s3Url));
+}
+
 TEST_F(S3InterfaceServiceTest, checkItsNotCompressed) {
     vector<uint8_t> raw;
     raw.resize(4);
@@ -12,8 +12,22 @@ using ::testing::Throw;
 
 bool hasHeader = false;
 
+bool isTextFormat = false;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+char textDelimiter = '\t';
+
+char textEscape = '\\';
+
+string textNullString = "\\N";
+
+vector<string> columnNames;
+
+vector<bool> columnReferenced;
+
+vector<ColumnPredicate> columnPredicates;
+
 string s3extErrorMessage;
 
 volatile bool QueryCancelPending = false;
@@ -370,6 +384,42 @@ TEST_F(S3KeyReaderTest, ReadWithSmallKeySize) {
     EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
 }
 
+TEST_F(S3KeyReaderTest, ReadRangeInTheMiddleOfKey) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(2);
+    params.setKeySize(1000);
+    params.setChunkSize(64);
+    params.setRange(100, 100);
+
+    EXPECT_CALL(s3Interface, fetchData(100, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(164, _, 36, _)).WillOnce(Invoke(MockFetchData(36, 64)));
+
+    this->open(params);
+
+    // no line terminator is appended at the end of the range
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)36, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeUpToEndOfKey) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(1);
+    params.setKeySize(1000);
+    params.setChunkSize(8192);
+    params.setRange(990, 0);
+
+    EXPECT_CALL(s3Interface, fetchData(990, _, 10, _)).WillOnce(Invoke(MockFetchData(10, 8192)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)10, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
 TEST_F(S3KeyReaderTest, ReadWithSmallChunk) {
     S3Params params("s3://abc/def");
 
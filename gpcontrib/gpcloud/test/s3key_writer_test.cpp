@@ -188,3 +188,42 @@ TEST_F(S3KeyWriterTest, TestWriteAbortInClosing) {
     EXPECT_THROW(this->close(), S3QueryAbort);
     QueryCancelPending = false;
 }
+
+TEST_F(S3KeyWriterTest, TestPartSizeGrowsWhenUploadIsSlow) {
+    uint64_t minPartSize = S3_UPLOAD_MIN_PARTSIZE;
+    S3_UPLOAD_MIN_PARTSIZE = 0x40;
+
+    testParams.setChunkSize(0x100);
+    testParams.setNumOfChunks(1);
+
+    char data[0x100];
+    vector<uint64_t> partSizes;
+    EXPECT_CALL(this->mockS3Interface, getUploadId(_)).WillOnce(Return("uploadid1"));
+    EXPECT_CALL(this->mockS3Interface, uploadPartOfData(_, _, _, "uploadid1"))
+        .WillRepeatedly(Invoke([&](S3VectorUInt8 &data, const S3Url &, uint64_t, const string &) {
+            partSizes.push_back(data.size());
+            usleep(20 * 1000);
+            return string("\"etag\"");
+        }));
+    EXPECT_CALL(this->mockS3Interface, completeMultiPart(_, _, _)).WillOnce(Return(true));
+
+    this->open(testParams);
+    EXPECT_EQ((uint64_t)0x40, this->getPartSize());
+
+    // the second part waits for the first one to be uploaded
+    ASSERT_EQ((uint64_t)0x80, this->write(data, 0x80));
+    EXPECT_EQ((uint64_t)0x80, this->getPartSize());
+
+    ASSERT_EQ((uint64_t)0x100, this->write(data, 0x100));
+    EXPECT_EQ((uint64_t)0x100, this->getPartSize());
+
+    this->close();
+    S3_UPLOAD_MIN_PARTSIZE = minPartSize;
+
+    // parts are uploaded one at a time, in order
+    ASSERT_EQ((uint64_t)4, partSizes.size());
+    EXPECT_EQ((uint64_t)0x40, partSizes[0]);
+    EXPECT_EQ((uint64_t)0x40, partSizes[1]);
+    EXPECT_EQ((uint64_t)0x80, partSizes[2]);
+    EXPECT_EQ((uint64_t)0x80, partSizes[3]);
+}
@@ -1,4 +1,14 @@
 #include "s3restful_service.cpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "gtest/gtest.h"
 
 TEST(S3RESTfulService, GetWithWrongHeader) {
@@ -338,3 +348,176 @@ TEST(S3RESTfulService, GetWithWrongProxyUrl) {
 
     EXPECT_THROW(service.get(url, headers), S3ResolveError);
 }
+
+// A local stand-in for S3: answers every request on a keep-alive HTTP/1.1 connection,
+// and counts the connections accepted.
+class LocalHTTPServer {
+   public:
+    LocalHTTPServer() : connections(0), requests(0) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listenFd, (struct sockaddr *)&addr, sizeof(addr));
+        listen(listenFd, 64);
+
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (struct sockaddr *)&addr, &len);
+        port = ntohs(addr.sin_port);
+
+        acceptThread = std::thread(&LocalHTTPServer::acceptLoop, this);
+    }
+
+    ~LocalHTTPServer() {
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptThread.join();
+
+        for (size_t i = 0; i < clientFds.size(); i++) {
+            shutdown(clientFds[i], SHUT_RDWR);
+        }
+        for (size_t i = 0; i < clientThreads.size(); i++) {
+            clientThreads[i].join();
+            close(clientFds[i]);
+        }
+    }
+
+    string getUrl() {
+        return "http://127.0.0.1:" + std::to_string(port) + "/bucket/key";
+    }
+
+    std::atomic<uint64_t> connections;
+    std::atomic<uint64_t> requests;
+
+   private:
+    void acceptLoop() {
+        while (true) {
+            int fd = accept(listenFd, NULL, NULL);
+            if (fd < 0) {
+                return;
+            }
+
+            connections++;
+            clientFds.push_back(fd);
+            clientThreads.push_back(std::thread(&LocalHTTPServer::serve, this, fd));
+        }
+    }
+
+    void serve(int fd) {
+        static const char reply[] = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\npong";
+        string pending;
+        char buf[4096];
+
+        while (true) {
+            ssize_t len = recv(fd, buf, sizeof(buf), 0);
+            if (len <= 0) {
+                return;
+            }
+            pending.append(buf, len);
+
+            size_t end;
+            while ((end = pending.find("\r\n\r\n")) != string::npos) {
+                pending.erase(0, end + 4);
+                requests++;
+                if (send(fd, reply, sizeof(reply) - 1, MSG_NOSIGNAL) < 0) {
+                    return;
+                }
+            }
+        }
+    }
+
+    int listenFd;
+    int port;
+    std::thread acceptThread;
+    vector<int> clientFds;
+    vector<std::thread> clientThreads;
+};
+
+static void GetFromLocalServer(S3RESTfulService &service, const string &url, int count) {
+    for (int i = 0; i < count; i++) {
+        HTTPHeaders headers;
+        Response resp = service.get(url, headers);
+        ASSERT_EQ(RESPONSE_OK, resp.getStatus());
+        ASSERT_EQ(4, resp.getRawData().size());
+    }
+}
+
+TEST(S3RESTfulServiceKeepAlive, ReuseConnectionAcrossRequests) {
+    LocalHTTPServer server;
+    S3RESTfulService service;
+    ConnectionStats before = CURLHandlePool::getInstance().getStats();
+
+    GetFromLocalServer(service, server.getUrl(), 50);
+
+    ConnectionStats after = CURLHandlePool::getInstance().getStats();
+    EXPECT_EQ(50, server.requests);
+    EXPECT_EQ(1, server.connections);
+    EXPECT_EQ(50, after.requests - before.requests);
+    EXPECT_EQ(1, after.newConnections - before.newConnections);
+}
+
+TEST(S3RESTfulServiceKeepAlive, NewConnectionPerRequestWithoutKeepAlive) {
+    LocalHTTPServer server;
+    S3Params params;
+    params.setKeepAlive(false);
+    S3RESTfulService service(params);
+
+    GetFromLocalServer(service, server.getUrl(), 10);
+
+    EXPECT_EQ(10, server.requests);
+    EXPECT_EQ(10, server.connections);
+}
+
+TEST(S3RESTfulServiceKeepAlive, PoolIsEmptiedWithLastService) {
+    LocalHTTPServer server;
+    {
+        S3RESTfulService service;
+        GetFromLocalServer(service, server.getUrl(), 1);
+    }
+
+    S3RESTfulService service;
+    GetFromLocalServer(service, server.getUrl(), 1);
+
+    EXPECT_EQ(2, server.connections);
+}
+
+// Chunk threads of one segment fetching small keys, with and without keep-alive.
+TEST(S3RESTfulServiceKeepAlive, LocalServerThroughput) {
+    const int threads = 4;
+    const int requestsPerThread = 250;
+
+    for (int keepAlive = 1; keepAlive >= 0; keepAlive--) {
+        LocalHTTPServer server;
+        S3Params params;
+        params.setKeepAlive(keepAlive);
+        S3RESTfulService service(params);
+
+        auto start = std::chrono::steady_clock::now();
+
+        vector<std::thread> workers;
+        for (int i = 0; i < threads; i++) {
+            workers.push_back(std::thread(GetFromLocalServer, std::ref(service),
+                                          server.getUrl(), requestsPerThread));
+        }
+        for (int i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t total = threads * requestsPerThread;
+        double reuseRate = 100.0 * (total - server.connections) / total;
+
+        printf("keepalive=%d: %.0f requests/s, %" PRIu64 " connections, %.1f%% reused\n",
+               keepAlive, total / elapsed.count(), (uint64_t)server.connections, reuseRate);
+
+        EXPECT_EQ(total, server.requests);
+        if (keepAlive) {
+            EXPECT_LE(server.connections, threads);
+        } else {
+            EXPECT_EQ(total, server.connections);
+        }
+    }
+}
@@ -245,6 +245,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	int64		prev_num_dead_tuples = 0;
 	int64		curr_heap_blks_scanned = 0;
 	int64		prev_heap_blks_scanned = 0;
+	int64		bytesCharged = 0;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationStorageIsAoCols(aorel));
@@ -323,7 +324,8 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		tupleCount++;
 		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOptimizedCompactionDelayPoint(scanDesc->totalBytesRead,
+												&bytesCharged);
 		}
 
 		/*
@@ -389,10 +391,12 @@ AOCSSegmentFileFullCompaction(Relation aorel,
  * insertion target. The segfiles listed in 'avoid_segnos' will not be used
  * for insertion.
  *
+ * Returns true if the segment file was compacted.
+ *
  * The caller is required to hold either an AccessExclusiveLock (vacuum full)
  * or a ShareLock on the relation.
  */
-void
+bool
 AOCSCompact(Relation aorel,
 			int compaction_segno,
 			int *insert_segno,
@@ -404,6 +408,7 @@ AOCSCompact(Relation aorel,
 	AOCSInsertDesc insertDesc = NULL;
 	AOCSFileSegInfo *fsinfo;
 	Snapshot	appendOnlyMetaDataSnapshot = RegisterSnapshot(GetCatalogSnapshot(InvalidOid));
+	bool		compacted = false;
 
 	Assert(RelationStorageIsAoCols(aorel));
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
@@ -437,6 +442,7 @@ AOCSCompact(Relation aorel,
 
 			insertDesc->skipModCountIncrement = true;
 			aocs_insert_finish(insertDesc, NULL);
+			compacted = true;
 		}
 		else
 		{
@@ -447,4 +453,6 @@ AOCSCompact(Relation aorel,
 	pfree(fsinfo);
 
 	UnregisterSnapshot(appendOnlyMetaDataSnapshot);
+
+	return compacted;
 }
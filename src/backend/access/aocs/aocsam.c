@@ -17,6 +17,7 @@
 
 #include "common/relpath.h"
 #include "access/amapi.h"
+#include "access/aocsbloom.h"
 #include "access/aocssegfiles.h"
 #include "access/aomd.h"
 #include "access/appendonlytid.h"
@@ -39,6 +40,7 @@
 #include "fmgr.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/gp_compress.h"
 #include "storage/procarray.h"
 #include "storage/smgr.h"
 #include "utils/datumstream.h"
@@ -98,6 +100,67 @@ open_datumstreamread_segfile(
 							  fileSegNo, segInfo->formatversion);
 }
 
+/*
+ * Read the next block of the first 'ncols' projected columns that need one,
+ * spreading the decompression of the blocks over the decompression worker
+ * pool.
+ *
+ * If 'all' is true, every column reads its next block, as right after the
+ * segment files were opened.  Returns false if a column has no more blocks.
+ */
+static bool
+aocs_read_blocks_in_parallel(AOCSScanDesc scan, AttrNumber ncols, bool all)
+{
+	DatumStreamRead **ds = scan->columnScanInfo.ds;
+	AttrNumber 		*proj_atts = scan->columnScanInfo.proj_atts;
+	AttrNumber 		num_proj_atts = scan->columnScanInfo.num_proj_atts;
+	int				ntasks = 0;
+	bool			eof = false;
+
+	if (scan->decompressTasks == NULL)
+	{
+		scan->decompressTasks = (GpDecompressTask *)
+			MemoryContextAlloc(scan->columnScanInfo.scanCtx,
+							   num_proj_atts * sizeof(GpDecompressTask));
+		scan->decompressAtts = (AttrNumber *)
+			MemoryContextAlloc(scan->columnScanInfo.scanCtx,
+							   num_proj_atts * sizeof(AttrNumber));
+	}
+
+	for (AttrNumber i = 0; i < ncols; i++)
+	{
+		AttrNumber	attno = proj_atts[i];
+		int			err;
+
+		if (!all && !datumstreamread_block_exhausted(ds[attno]))
+			continue;
+
+		err = datumstreamread_block_begin(ds[attno], scan->blockDirectory, attno,
+										  &scan->decompressTasks[ntasks]);
+		if (err < 0)
+			eof = true;
+		else if (err > 0)
+			scan->decompressAtts[ntasks++] = attno;
+		else
+			AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
+	}
+
+	if (ntasks == 0)
+		return !eof;
+
+	gp_decompress_pool_run(scan->decompressTasks, ntasks);
+
+	for (int i = 0; i < ntasks; i++)
+	{
+		AttrNumber	attno = scan->decompressAtts[i];
+
+		datumstreamread_block_finish(ds[attno], &scan->decompressTasks[i]);
+		AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
+	}
+
+	return !eof;
+}
+
 /*
  * Open all segment files associted with the datum stream.
  *
@@ -116,6 +179,7 @@ open_all_datumstreamread_segfiles(AOCSScanDesc scan, AOCSFileSegInfo *segInfo)
 	AttrNumber 		num_proj_atts = scan->columnScanInfo.num_proj_atts;
 	AppendOnlyBlockDirectory *blockDirectory = scan->blockDirectory;
 	char *basepath = relpathbackend(rel->rd_node, rel->rd_backend, MAIN_FORKNUM);
+	bool			parallel = (gp_aocs_decompress_workers > 0 && num_proj_atts > 1);
 
 	Assert(proj_atts);
 	for (AttrNumber i = 0; i < num_proj_atts; i++)
@@ -124,11 +188,16 @@ open_all_datumstreamread_segfiles(AOCSScanDesc scan, AOCSFileSegInfo *segInfo)
 
 		RelationOpenSmgr(rel);
 		open_datumstreamread_segfile(basepath, rel, segInfo, ds[attno], attno);
+		if (parallel)
+			continue;
 		datumstreamread_block(ds[attno], blockDirectory, attno);
 
 		AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
 	}
 
+	if (parallel)
+		(void) aocs_read_blocks_in_parallel(scan, num_proj_atts, true);
+
 	pfree(basepath);
 }
 
@@ -142,10 +211,13 @@ open_ds_write(Relation rel, DatumStreamWrite **ds, TupleDesc relationTupleDesc,
 	int			natts = RelationGetNumberOfAttributes(rel);
 	StdRdOptions **opts = RelationGetAttributeOptions(rel);
 	RelFileNodeBackend rnode;
+	Oid			blkdirrelid;
 
 	rnode.node = rel->rd_node;
 	rnode.backend = rel->rd_backend;
 
+	/* Bloom filters are kept in the block directory */
+	GetAppendOnlyEntryAuxOids(rel, NULL, &blkdirrelid, NULL, NULL, NULL);
 
 	/* open datum streams.  It will open segment file underneath */
 	for (int i = 0; i < natts; ++i)
@@ -190,6 +262,8 @@ open_ds_write(Relation rel, DatumStreamWrite **ds, TupleDesc relationTupleDesc,
 										&rnode,
 										rel->rd_smgr->smgr_ao);
 
+		if (opts[i]->bloomfilter_fpr > 0 && OidIsValid(blkdirrelid))
+			ds[i]->bloom = aocs_bloom_builder_create(attr, opts[i]->bloomfilter_fpr);
 	}
 }
 
@@ -434,6 +508,12 @@ open_next_scan_seg(AOCSScanDesc scan)
 
 				open_all_datumstreamread_segfiles(scan, curSegInfo);
 
+				if (scan->bloomScan && !scan->blockDirectory)
+					aocs_bloom_scan_load_segment(scan->bloomScan,
+												 scan->rs_base.rs_rd,
+												 scan->appendOnlyMetaDataSnapshot,
+												 curSegInfo->segno);
+
 				return scan->cur_seg;
 			}
 		}
@@ -666,6 +746,15 @@ aocs_endscan(AOCSScanDesc scan)
 	if (scan->total_seg != 0)
 		AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 
+	if (scan->bloomScan)
+		aocs_bloom_scan_end(scan->bloomScan);
+
+	if (scan->decompressTasks)
+	{
+		pfree(scan->decompressTasks);
+		pfree(scan->decompressAtts);
+	}
+
 	/* GPDB should backport this to upstream */
 	if (scan->rs_base.rs_flags & SO_TEMP_SNAPSHOT)
 		UnregisterSnapshot(scan->rs_base.rs_snapshot);
@@ -749,6 +838,92 @@ static void upgrade_datum_fetch(AOCSFetchDesc fetch, int attno, Datum values[],
 					   values, isnull, formatversion);
 }
 
+/*
+ * Position a column left behind by late materialization on row 'rowNum',
+ * ready for datumstreamread_get().
+ *
+ * Only the rows that passed the pushed down quals are fetched from such
+ * columns, so whole blocks without any of them are skipped without being
+ * read or decompressed.  Returns false if the segment file ends first.
+ */
+static bool
+aocs_fetch_lazy_column(AOCSScanDesc scan, AttrNumber attno, int64 rowNum)
+{
+	DatumStreamRead *ds = scan->columnScanInfo.ds[attno];
+	int			err;
+
+	Assert(rowNum > 0);
+	Assert(rowNum >= datumstreamread_next_rownum(ds) ||
+		   datumstreamread_block_exhausted(ds));
+
+	if (!datumstreamread_skip_to_row(ds, rowNum))
+		return false;
+
+	err = datumstreamread_advance(ds);
+	if (err == 0)
+	{
+		if (datumstreamread_block(ds, NULL, attno) < 0)
+			return false;
+
+		AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
+
+		err = datumstreamread_advance(ds);
+	}
+	Assert(err > 0);
+
+	return true;
+}
+
+/*
+ * Skip the blocks whose bloom filters rule out the scan's equality qual.
+ *
+ * Called between rows.  If the scan is about to read a row of a block of
+ * the bloom filtered column that holds none of the qual's values, move
+ * every projected column past that block, without reading the blocks in
+ * between.  The first projected column tells where the scan is: the
+ * columns left behind by late materialization, possibly including the
+ * bloom filtered one, only catch up when a row passes the quals.
+ *
+ * Returns false if that leaves nothing more to read in the segment file.
+ */
+static bool
+aocs_bloom_skip_blocks(AOCSScanDesc scan)
+{
+	DatumStreamRead *leadds;
+	int64		rowNum;
+	int64		target;
+
+	if (scan->columnScanInfo.ds[aocs_bloom_scan_attno(scan->bloomScan)] == NULL)
+		return true;			/* column not projected */
+
+	leadds = scan->columnScanInfo.ds[scan->columnScanInfo.proj_atts[0]];
+	rowNum = datumstreamread_next_rownum(leadds);
+	if (rowNum >= leadds->blockFirstRowNum + leadds->blockRowCount)
+	{
+		/* At the end of the block, see where the next one starts */
+		rowNum = datumstreamread_peek_first_row(leadds);
+		if (rowNum < 0)
+			return true;
+	}
+
+	target = aocs_bloom_scan_skip_to(scan->bloomScan, rowNum);
+	if (target == rowNum)
+		return true;
+
+	for (AttrNumber i = 0; i < scan->columnScanInfo.num_proj_atts; i++)
+	{
+		AttrNumber	attno = scan->columnScanInfo.proj_atts[i];
+
+		if (!datumstreamread_skip_to_row(scan->columnScanInfo.ds[attno], target))
+			return false;
+	}
+
+	/* Skipped rows count as processed, like the invisible ones */
+	scan->segrowsprocessed += target - rowNum;
+
+	return true;
+}
+
 bool
 aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 {
@@ -777,6 +952,7 @@ aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 	int			err = 0;
 	bool		isSnapshotAny = (scan->rs_base.rs_snapshot == SnapshotAny);
 	AttrNumber	natts;
+	AttrNumber	lazy_from;
 
 	Assert(ScanDirectionIsForward(direction));
 
@@ -815,30 +991,77 @@ ReadNext:
 		Assert(scan->cur_seg >= 0);
 		curseginfo = scan->seginfo[scan->cur_seg];
 
+		/*
+		 * Late materialization: the columns after the pushed down qual
+		 * columns are only read for the rows that pass the quals, see
+		 * aocs_fetch_lazy_column().  Blocks building the block directory
+		 * must all be read, though.  So must the blocks of segment files
+		 * from older versions, which may not record the first row number
+		 * that locates the rows.
+		 */
+		lazy_from = scan->columnScanInfo.num_proj_atts;
+		if (gp_enable_aocs_late_materialization &&
+			scan->aos_qual_col_num > 0 && !scan->blockDirectory &&
+			curseginfo->formatversion >= AOSegfileFormatVersion_GetLatest())
+			lazy_from = scan->aos_qual_col_num;
+
+		if (scan->bloomScan && !scan->blockDirectory &&
+			!aocs_bloom_skip_blocks(scan))
+		{
+			/* The rest of the segment can be skipped */
+			close_cur_scan_seg(scan);
+			err = -1;
+			goto ReadNext;
+		}
+
+		/* Decompress the blocks the columns need next together */
+		if (gp_aocs_decompress_workers > 0 && lazy_from > 1 &&
+			!aocs_read_blocks_in_parallel(scan, lazy_from, false))
+		{
+			close_cur_scan_seg(scan);
+			err = -1;
+			goto ReadNext;
+		}
+
 		/* Read from cur_seg */
 		visible_pass = predicate_pass = true;
 		for (AttrNumber i = 0; i < scan->columnScanInfo.num_proj_atts; i++)
 		{
 			AttrNumber	attno = scan->columnScanInfo.proj_atts[i];
 
-			err = datumstreamread_advance(scan->columnScanInfo.ds[attno]);
-			Assert(err >= 0);
-			if (err == 0)
+			if (i >= lazy_from)
 			{
-				err = datumstreamread_block(scan->columnScanInfo.ds[attno], scan->blockDirectory, attno);
-				if (err < 0)
+				if (!visible_pass || !predicate_pass)
+					break;		/* the lazy columns stay behind */
+
+				if (!aocs_fetch_lazy_column(scan, attno, rowNum))
 				{
-					/*
-					 * Ha, cannot read next block, we need to go to next seg
-					 */
 					close_cur_scan_seg(scan);
+					err = -1;
 					goto ReadNext;
 				}
-
-				AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
-
+			}
+			else
+			{
 				err = datumstreamread_advance(scan->columnScanInfo.ds[attno]);
-				Assert(err > 0);
+				Assert(err >= 0);
+				if (err == 0)
+				{
+					err = datumstreamread_block(scan->columnScanInfo.ds[attno], scan->blockDirectory, attno);
+					if (err < 0)
+					{
+						/*
+						 * Ha, cannot read next block, we need to go to next seg
+						 */
+						close_cur_scan_seg(scan);
+						goto ReadNext;
+					}
+
+					AOCSScanDesc_UpdateTotalBytesRead(scan, attno);
+
+					err = datumstreamread_advance(scan->columnScanInfo.ds[attno]);
+					Assert(err > 0);
+				}
 			}
 			if (!visible_pass || !predicate_pass)
 				continue; /* not break, need advance for other cols */
@@ -1061,79 +1284,89 @@ aocs_insert_init(Relation rel, int segno)
 }
 
 
-void
-aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+/*
+ * Append one value to the datum stream of column 'i', for row 'rowNum'.
+ *
+ * If 'task' is given and the value does not fit in the current block, the
+ * block is handed over for compression by the worker pool if possible: the
+ * task is filled in and false is returned, without appending the value.
+ * The caller must finish the block with datumstreamwrite_block_finish() and
+ * append the value again.
+ */
+static inline bool
+aocs_insert_column_value(AOCSInsertDesc idesc, int i, Datum datum, bool null,
+						 int64 rowNum, GpDecompressTask *task)
 {
-	Relation	rel = idesc->aoi_rel;
-	int			i;
-
-#ifdef FAULT_INJECTOR
-	FaultInjector_InjectFaultIfSet(
-								   "appendonly_insert",
-								   DDLNotSpecified,
-								   "",	/* databaseName */
-								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
-#endif
+	void	   *toFree1;
+	int			err = datumstreamwrite_put(idesc->ds[i], datum, null, &toFree1);
 
-	/* As usual, at this moment, we assume one col per vp */
-	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
+	if (toFree1 != NULL)
+	{
+		/*
+		 * Use the de-toasted and/or de-compressed as datum instead.
+		 */
+		datum = PointerGetDatum(toFree1);
+	}
+	if (err < 0)
 	{
-		void	   *toFree1;
-		Datum		datum = d[i];
-		int			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
+		int			itemCount = datumstreamwrite_nth(idesc->ds[i]);
+		void	   *toFree2;
 
-		if (toFree1 != NULL)
+		if (task && datumstreamwrite_block_begin(idesc->ds[i], task))
+		{
+			if (toFree1 != NULL)
+				pfree(toFree1);
+			return false;
+		}
+
+		/* write the block up to this one */
+		datumstreamwrite_block(idesc->ds[i], &idesc->blockDirectory, i, false);
+		if (itemCount > 0)
 		{
 			/*
-			 * Use the de-toasted and/or de-compressed as datum instead.
+			 * since we have written all up to the new tuple, the new
+			 * blockFirstRowNum is the inserted tuple's row number
 			 */
-			datum = PointerGetDatum(toFree1);
+			idesc->ds[i]->blockFirstRowNum = rowNum;
 		}
-		if (err < 0)
-		{
-			int			itemCount = datumstreamwrite_nth(idesc->ds[i]);
-			void	   *toFree2;
 
-			/* write the block up to this one */
-			datumstreamwrite_block(idesc->ds[i], &idesc->blockDirectory, i, false);
-			if (itemCount > 0)
-			{
-				/*
-				 * since we have written all up to the new tuple, the new
-				 * blockFirstRowNum is the inserted tuple's row number
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 1;
-			}
+		Assert(idesc->ds[i]->blockFirstRowNum == rowNum);
 
-			Assert(idesc->ds[i]->blockFirstRowNum == idesc->lastSequence + 1);
 
+		/* now write this new item to the new block */
+		err = datumstreamwrite_put(idesc->ds[i], datum, null, &toFree2);
+		Assert(toFree2 == NULL);
+		if (err < 0)
+		{
+			Assert(!null);
+			err = datumstreamwrite_lob(idesc->ds[i],
+									   datum,
+									   &idesc->blockDirectory,
+									   i,
+									   false);
+			Assert(err >= 0);
 
-			/* now write this new item to the new block */
-			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree2);
-			Assert(toFree2 == NULL);
-			if (err < 0)
-			{
-				Assert(!null[i]);
-				err = datumstreamwrite_lob(idesc->ds[i],
-										   datum,
-										   &idesc->blockDirectory,
-										   i,
-										   false);
-				Assert(err >= 0);
-
-				/*
-				 * A lob will live by itself in the block so this assignment
-				 * is for the block that contains tuples AFTER the one we are
-				 * inserting
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 2;
-			}
+			/*
+			 * A lob will live by itself in the block so this assignment
+			 * is for the block that contains tuples AFTER the one we are
+			 * inserting
+			 */
+			idesc->ds[i]->blockFirstRowNum = rowNum + 1;
 		}
-
-		if (toFree1 != NULL)
-			pfree(toFree1);
 	}
 
+	if (toFree1 != NULL)
+		pfree(toFree1);
+
+	return true;
+}
+
+/*
+ * Account for one more inserted row, and set its tid.
+ */
+static inline void
+aocs_insert_next_row(AOCSInsertDesc idesc, AOTupleId *aoTupleId)
+{
 	idesc->insertCount++;
 	idesc->lastSequence++;
 	idesc->range++;
@@ -1164,6 +1397,147 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 	}
 }
 
+void
+aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+{
+	Relation	rel = idesc->aoi_rel;
+	int			i;
+
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   "appendonly_insert",
+								   DDLNotSpecified,
+								   "",	/* databaseName */
+								   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
+#endif
+
+	/* As usual, at this moment, we assume one col per vp */
+	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
+		aocs_insert_column_value(idesc, i, d[i], null[i], idesc->lastSequence + 1,
+								 NULL);
+
+	aocs_insert_next_row(idesc, aoTupleId);
+}
+
+/*
+ * The rounds of aocs_insert_multi(), compressing full blocks with the
+ * worker pool.
+ */
+static void
+aocs_insert_multi_parallel(AOCSInsertDesc idesc, TupleTableSlot **slots,
+						   int ntuples)
+{
+	int			natts = RelationGetNumberOfAttributes(idesc->aoi_rel);
+	int64		firstRowNum = idesc->lastSequence + 1;
+	int		   *nextRow;
+
+	/* kept with the descriptor, the batch comes in a short-lived context */
+	if (idesc->compressTasks == NULL)
+	{
+		MemoryContext descCtx = GetMemoryChunkContext(idesc);
+
+		idesc->compressTasks = (GpDecompressTask *)
+			MemoryContextAlloc(descCtx, natts * sizeof(GpDecompressTask));
+		idesc->compressAtts = (int *)
+			MemoryContextAlloc(descCtx, natts * sizeof(int));
+	}
+	nextRow = (int *) palloc0(natts * sizeof(int));
+
+	for (;;)
+	{
+		int			ntasks = 0;
+
+		for (int i = 0; i < natts; ++i)
+		{
+			while (nextRow[i] < ntuples)
+			{
+				TupleTableSlot *slot = slots[nextRow[i]];
+
+				if (!aocs_insert_column_value(idesc, i,
+											  slot->tts_values[i],
+											  slot->tts_isnull[i],
+											  firstRowNum + nextRow[i],
+											  &idesc->compressTasks[ntasks]))
+				{
+					idesc->compressAtts[ntasks++] = i;
+					break;
+				}
+				nextRow[i]++;
+			}
+		}
+
+		if (ntasks == 0)
+			break;
+
+		gp_decompress_pool_run(idesc->compressTasks, ntasks);
+
+		for (int k = 0; k < ntasks; k++)
+		{
+			int			i = idesc->compressAtts[k];
+
+			datumstreamwrite_block_finish(idesc->ds[i], &idesc->blockDirectory,
+										  i, false, &idesc->compressTasks[k]);
+
+			/* the value that did not fit starts the next block */
+			idesc->ds[i]->blockFirstRowNum = firstRowNum + nextRow[i];
+		}
+	}
+
+	pfree(nextRow);
+}
+
+/*
+ * Insert a batch of rows, given as slots with all their attributes
+ * deformed.
+ *
+ * This does the same as calling aocs_insert_values() for each slot, but
+ * column by column: all the values of the batch are appended to the datum
+ * stream of one column before moving on to the next.  With wide tables
+ * that keeps the write state, compression and block directory entries of
+ * a single column hot in the caches, instead of cycling through all of
+ * them for every row.
+ *
+ * With gp_aocs_decompress_workers set, the columns are filled in rounds
+ * instead: every column takes values until its block is full, then the
+ * full blocks of all the columns are compressed at once by the worker
+ * pool, written out, and the next round continues where each column
+ * stopped.
+ */
+void
+aocs_insert_multi(AOCSInsertDesc idesc, TupleTableSlot **slots, int ntuples)
+{
+	Relation	rel = idesc->aoi_rel;
+	int			natts = RelationGetNumberOfAttributes(rel);
+	int64		firstRowNum = idesc->lastSequence + 1;
+
+#ifdef FAULT_INJECTOR
+	for (int j = 0; j < ntuples; j++)
+		FaultInjector_InjectFaultIfSet(
+									   "appendonly_insert",
+									   DDLNotSpecified,
+									   "",	/* databaseName */
+									   RelationGetRelationName(idesc->aoi_rel));	/* tableName */
+#endif
+
+	if (gp_aocs_decompress_workers > 0 && natts > 1)
+		aocs_insert_multi_parallel(idesc, slots, ntuples);
+	else
+	{
+		for (int i = 0; i < natts; ++i)
+		{
+			for (int j = 0; j < ntuples; j++)
+				aocs_insert_column_value(idesc, i,
+										 slots[j]->tts_values[i],
+										 slots[j]->tts_isnull[i],
+										 firstRowNum + j,
+										 NULL);
+		}
+	}
+
+	for (int j = 0; j < ntuples; j++)
+		aocs_insert_next_row(idesc, (AOTupleId *) &slots[j]->tts_tid);
+}
+
 static void
 aocs_insert_finish_guts(AOCSInsertDesc idesc)
 {
@@ -1184,6 +1558,12 @@ aocs_insert_finish_guts(AOCSInsertDesc idesc)
 
 	pfree(idesc->fsInfo);
 
+	if (idesc->compressTasks)
+	{
+		pfree(idesc->compressTasks);
+		pfree(idesc->compressAtts);
+	}
+
 	close_ds_write(idesc->ds, rel->rd_att->natts);
 }
 
@@ -2026,6 +2406,7 @@ aocs_addcol_init(Relation rel,
 	StringInfoData titleBuf;
 	bool        checksum;
 	RelFileNodeBackend rnode;
+	Oid			blkdirrelid;
 
 	rnode.node = rel->rd_node;
 	rnode.backend = rel->rd_backend;
@@ -2048,6 +2429,7 @@ aocs_addcol_init(Relation rel,
                                  NULL,
                                  &checksum,
                                  NULL);
+	GetAppendOnlyEntryAuxOids(rel, NULL, &blkdirrelid, NULL, NULL, NULL);
 
 	iattr = rel->rd_att->natts - num_newcols;
 
@@ -2071,6 +2453,10 @@ aocs_addcol_init(Relation rel,
 											   XLogIsNeeded() && RelationNeedsWAL(rel),
 											   &rnode,
 											   rel->rd_smgr->smgr_ao);
+
+		if (opts[iattr]->bloomfilter_fpr > 0 && OidIsValid(blkdirrelid))
+			desc->dsw[i]->bloom = aocs_bloom_builder_create(attr,
+															opts[iattr]->bloomfilter_fpr);
 	}
 	return desc;
 }
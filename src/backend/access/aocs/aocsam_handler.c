@@ -14,6 +14,7 @@
  */
 #include "postgres.h"
 
+#include "access/aocsbloom.h"
 #include "access/aomd.h"
 #include "access/appendonlywriter.h"
 #include "access/heapam.h"
@@ -607,6 +608,18 @@ extractcolumns_from_node(Node *expr, bool *cols, AttrNumber natts)
 	return  ecCtx.found;
 }
 
+/*
+ * EXPLAIN ANALYZE callback of the scan nodes using bloom filters.
+ */
+static void
+aoco_bloom_explain_end(PlanState *ps, StringInfo buf)
+{
+	AOCSScanDesc scan = (AOCSScanDesc) ((ScanState *) ps)->ss_currentScanDesc;
+
+	if (scan && scan->bloomScan)
+		aocs_bloom_scan_explain(scan->bloomScan, buf);
+}
+
 static TableScanDesc
 aoco_beginscan_extractcolumns(Relation rel, Snapshot snapshot, int nkeys, struct ScanKeyData *key,
 							  ParallelTableScanDesc parallel_scan,
@@ -643,6 +656,15 @@ aoco_beginscan_extractcolumns(Relation rel, Snapshot snapshot, int nkeys, struct
 	if (gp_enable_predicate_pushdown)
 		ps->qual = aocs_predicate_pushdown_prepare(aoscan, qual, ps->qual, ps->ps_ExprContext, ps);
 
+	if (gp_enable_aocs_bloom_filter)
+		aoscan->bloomScan = aocs_bloom_scan_prepare(rel, qual);
+
+	/* CDB: Offer the number of skipped blocks to EXPLAIN ANALYZE. */
+	if (aoscan->bloomScan && ps->instrument &&
+		(ps->state->es_instrument & INSTRUMENT_CDB) &&
+		ps->cdbexplainfun == NULL)
+		ps->cdbexplainfun = aoco_bloom_explain_end;
+
 	return (TableScanDesc)aoscan;
 }
 
@@ -1074,8 +1096,8 @@ aoco_tuple_complete_speculative(Relation relation, TupleTableSlot *slot,
  *	aoco_multi_insert	- insert multiple tuples into an ao relation
  *
  * This is like aoco_tuple_insert(), but inserts multiple tuples in one
- * operation. Typicaly used by COPY. This is preferrable than calling
- * aoco_tuple_insert() in a loop because ... WAL??
+ * operation. Typicaly used by COPY. The tuples are written column by
+ * column, see aocs_insert_multi().
  */
 static void
 aoco_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
@@ -1088,18 +1110,26 @@ aoco_multi_insert(Relation relation, TupleTableSlot **slots, int ntuples,
 	state = find_dml_state(RelationGetRelid(relation));
 
 	for (int i = 0; i < ntuples; i++)
-	{
 		slot_getallattrs(slots[i]);
+
+	for (int i = 0; i < ntuples;)
+	{
+		int			nbatch = ntuples - i;
+
 		/*
 		 * For bulk insert, we may switch insertDesc
 		 * on the fly. 
 		 */
-		if (state->insertMultiFiles && state->insertDesc->range == gp_appendonly_insert_files_tuples_range)
+		if (state->insertMultiFiles)
 		{
-			insertDesc = get_insert_descriptor(relation);
+			if (state->insertDesc->range == gp_appendonly_insert_files_tuples_range)
+				insertDesc = get_insert_descriptor(relation);
+			if (insertDesc->range < gp_appendonly_insert_files_tuples_range)
+				nbatch = Min(nbatch, gp_appendonly_insert_files_tuples_range - insertDesc->range);
 		}
 
-		aocs_insert_values(insertDesc, slots[i]->tts_values, slots[i]->tts_isnull, (AOTupleId *) &slots[i]->tts_tid);
+		aocs_insert_multi(insertDesc, &slots[i], nbatch);
+		i += nbatch;
 	}
 
 	pgstat_count_heap_insert(relation, ntuples);
@@ -0,0 +1,651 @@
+/*--------------------------------------------------------------------------
+ *
+ * aocsbloom.c
+ *	  Per-block bloom filters for append-optimized column oriented tables.
+ *
+ * Each block written for a column that has the bloomfilter_fpr storage
+ * option gets a bloom filter over the 64-bit extended hashes of its non-NULL
+ * values.  The filter is stored in the block directory relation, in a row
+ * with columngroup_no = AOBlkDirBloomColumnGroupNo(attno) keyed by the
+ * block's first row number, so it goes away together with the segment file
+ * when the segment is compacted or truncated.
+ *
+ * A sequential scan with an equality or IN-list qual against such a column
+ * probes the filters of each segment file once, and remembers the row ranges
+ * of the blocks that cannot contain any of the values.  Those ranges are
+ * then skipped in all projected columns, without reading or decompressing
+ * their blocks.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/access/aocs/aocsbloom.c
+ *
+ *--------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/aocsbloom.h"
+#include "access/genam.h"
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "access/table.h"
+#include "catalog/aoblkdir.h"
+#include "catalog/pg_appendonly.h"
+#include "catalog/pg_attribute_encoding.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/primnodes.h"
+#include "utils/array.h"
+#include "utils/fmgroids.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/typcache.h"
+
+/* Don't bother probing IN-lists longer than this */
+#define AOCS_BLOOM_MAX_PROBES	1024
+
+struct AOCSBloomBuilder
+{
+	double		fpr;
+	FmgrInfo	hashfn;
+	Oid			collation;
+
+	/* Hashes of the values put in the current block so far */
+	uint64	   *hashes;
+	int			nhashes;
+	int			maxhashes;
+	bool		overflow;
+};
+
+struct AOCSBloomScan
+{
+	AttrNumber	attno;			/* zero based */
+	uint64	   *probes;
+	int			nprobes;
+
+	/*
+	 * Row ranges [skipFirst, skipEnd) of the current segment file that hold
+	 * none of the probed values, in ascending order.
+	 */
+	int64	   *skipFirst;
+	int64	   *skipEnd;
+	int		   *skipBlocks;		/* number of blocks in each range */
+	int			nskip;
+	int			maxskip;
+	int			cursor;
+
+	/* For EXPLAIN ANALYZE, over all segment files */
+	int64		nblocks;		/* blocks with a filter */
+	int64		nskipped;		/* blocks skipped */
+};
+
+static int
+hash_cmp(const void *a, const void *b)
+{
+	uint64		ha = *(const uint64 *) a;
+	uint64		hb = *(const uint64 *) b;
+
+	if (ha < hb)
+		return -1;
+	if (ha > hb)
+		return 1;
+	return 0;
+}
+
+/*
+ * Sort the collected hashes and remove duplicates.
+ */
+static void
+builder_compact(AOCSBloomBuilder *builder)
+{
+	int			i;
+	int			n = 0;
+
+	if (builder->nhashes < 2)
+		return;
+
+	qsort(builder->hashes, builder->nhashes, sizeof(uint64), hash_cmp);
+	for (i = 0; i < builder->nhashes; i++)
+	{
+		if (n == 0 || builder->hashes[n - 1] != builder->hashes[i])
+			builder->hashes[n++] = builder->hashes[i];
+	}
+	builder->nhashes = n;
+}
+
+static inline uint32
+bloom_bit(uint64 hash, int i, uint32 nbits)
+{
+	uint32		h1 = (uint32) hash;
+	uint32		h2 = (uint32) (hash >> 32) | 1;
+
+	return (uint32) (((uint64) h1 + (uint64) i * h2) % nbits);
+}
+
+static bool
+bloom_may_contain(AOCSBloomFilter *filter, uint64 hash)
+{
+	for (int i = 0; i < filter->nhashes; i++)
+	{
+		uint32		bit = bloom_bit(hash, i, filter->nbits);
+
+		if ((filter->words[bit / 64] & (UINT64CONST(1) << (bit % 64))) == 0)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Set up a filter builder for a column.  Returns NULL if the column's type
+ * has no extended hash function, or if its collation is nondeterministic:
+ * equal values must hash equal for the filter to be usable.
+ */
+AOCSBloomBuilder *
+aocs_bloom_builder_create(Form_pg_attribute attr, double fpr)
+{
+	AOCSBloomBuilder *builder;
+	TypeCacheEntry *typentry;
+
+	Assert(fpr > 0);
+
+	typentry = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_EXTENDED_PROC_FINFO);
+	if (!OidIsValid(typentry->hash_extended_proc))
+		return NULL;
+	if (OidIsValid(attr->attcollation) &&
+		!get_collation_isdeterministic(attr->attcollation))
+		return NULL;
+
+	builder = palloc0(sizeof(AOCSBloomBuilder));
+	builder->fpr = fpr;
+	builder->collation = attr->attcollation;
+	fmgr_info_copy(&builder->hashfn, &typentry->hash_extended_proc_finfo,
+				   CurrentMemoryContext);
+	builder->maxhashes = 1024;
+	builder->hashes = palloc(builder->maxhashes * sizeof(uint64));
+
+	return builder;
+}
+
+void
+aocs_bloom_builder_add(AOCSBloomBuilder *builder, Datum value)
+{
+	if (builder->overflow)
+		return;
+
+	if (builder->nhashes == builder->maxhashes)
+	{
+		if (builder->maxhashes < 2 * AOCS_BLOOM_MAX_DISTINCT)
+		{
+			builder->maxhashes *= 2;
+			builder->hashes = repalloc(builder->hashes,
+									   builder->maxhashes * sizeof(uint64));
+		}
+		else
+		{
+			builder_compact(builder);
+			if (builder->nhashes > AOCS_BLOOM_MAX_DISTINCT)
+			{
+				/* Too many distinct values for a useful filter */
+				builder->overflow = true;
+				return;
+			}
+		}
+	}
+
+	builder->hashes[builder->nhashes++] =
+		DatumGetUInt64(FunctionCall2Coll(&builder->hashfn, builder->collation,
+										 value, Int64GetDatum(0)));
+}
+
+/*
+ * Build the filter of the block just written, and get ready for the next
+ * one.  Returns NULL if the block has too many distinct values.
+ */
+struct varlena *
+aocs_bloom_builder_finish(AOCSBloomBuilder *builder, int64 rowCount)
+{
+	AOCSBloomFilter *filter = NULL;
+
+	builder_compact(builder);
+
+	if (!builder->overflow && builder->nhashes <= AOCS_BLOOM_MAX_DISTINCT)
+	{
+		int			n = Max(builder->nhashes, 1);
+		double		bits;
+		uint32		nbits;
+		int			nhashes;
+		Size		len;
+
+		/* m = -n ln(p) / (ln 2)^2, k = m/n ln 2 */
+		bits = ceil(-n * log(builder->fpr) / (M_LN2 * M_LN2));
+		bits = Min(bits, AOCS_BLOOM_MAX_BYTES * 8);
+		nbits = TYPEALIGN(64, (uint32) Max(bits, 64));
+		nhashes = (int) rint((double) nbits / n * M_LN2);
+		nhashes = Max(Min(nhashes, 16), 1);
+
+		len = offsetof(AOCSBloomFilter, words) + nbits / 8;
+		filter = palloc0(len);
+		SET_VARSIZE(filter, len);
+		filter->version = AOCS_BLOOM_VERSION;
+		filter->rowCount = rowCount;
+		filter->nbits = nbits;
+		filter->nhashes = nhashes;
+
+		for (int i = 0; i < builder->nhashes; i++)
+		{
+			for (int j = 0; j < nhashes; j++)
+			{
+				uint32		bit = bloom_bit(builder->hashes[i], j, nbits);
+
+				filter->words[bit / 64] |= UINT64CONST(1) << (bit % 64);
+			}
+		}
+	}
+
+	builder->nhashes = 0;
+	builder->overflow = false;
+
+	return (struct varlena *) filter;
+}
+
+void
+aocs_bloom_builder_free(AOCSBloomBuilder *builder)
+{
+	pfree(builder->hashes);
+	pfree(builder);
+}
+
+/*
+ * Hash 'value' of type 'valtype' for probing a filter, with the extended
+ * hash function of the column's hash operator family.  Cross-type members
+ * of the family are required to hash equal values equally.
+ */
+static bool
+bloom_hash_probe(Oid opfamily, Oid valtype, Oid collation, Datum value,
+				 uint64 *hash)
+{
+	Oid			hashproc;
+
+	hashproc = get_opfamily_proc(opfamily, valtype, valtype, HASHEXTENDED_PROC);
+	if (!OidIsValid(hashproc))
+		return false;
+
+	*hash = DatumGetUInt64(OidFunctionCall2Coll(hashproc, collation, value,
+												Int64GetDatum(0)));
+	return true;
+}
+
+/*
+ * Is 'opno' the equality operator of the hash operator family used for the
+ * filters of column 'attr'?  Returns the family in *opfamily.
+ */
+static bool
+bloom_op_is_equality(Form_pg_attribute attr, Oid opno, Oid inputcollid,
+					 Oid *opfamily)
+{
+	TypeCacheEntry *typentry;
+
+	typentry = lookup_type_cache(attr->atttypid, TYPECACHE_HASH_OPFAMILY);
+	if (!OidIsValid(typentry->hash_opf))
+		return false;
+	if (get_op_opfamily_strategy(opno, typentry->hash_opf) != HTEqualStrategyNumber)
+		return false;
+	if (OidIsValid(inputcollid) && !get_collation_isdeterministic(inputcollid))
+		return false;
+
+	*opfamily = typentry->hash_opf;
+	return true;
+}
+
+static Var *
+bloom_strip_var(Node *node)
+{
+	while (node && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (node && IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+
+		if (!IS_SPECIAL_VARNO(var->varno) && var->varlevelsup == 0 &&
+			var->varattno > 0)
+			return var;
+	}
+	return NULL;
+}
+
+/*
+ * Try to turn one qual clause into probes against the filters of a column:
+ * "col = const", "const = col" or "col = ANY (const array)".
+ */
+static bool
+bloom_extract_clause(Relation rel, StdRdOptions **opts, Node *clause,
+					 AOCSBloomScan *bloomScan)
+{
+	Var		   *var = NULL;
+	Const	   *con = NULL;
+	Oid			opno;
+	Oid			inputcollid;
+	bool		isArray = false;
+	Form_pg_attribute attr;
+	Oid			opfamily;
+
+	if (IsA(clause, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) clause;
+		Node	   *left;
+		Node	   *right;
+
+		if (list_length(op->args) != 2)
+			return false;
+		left = linitial(op->args);
+		right = lsecond(op->args);
+
+		if ((var = bloom_strip_var(left)) != NULL && IsA(right, Const))
+			con = (Const *) right;
+		else if ((var = bloom_strip_var(right)) != NULL && IsA(left, Const))
+			con = (Const *) left;
+		else
+			return false;
+
+		opno = op->opno;
+		inputcollid = op->inputcollid;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+
+		if (!saop->useOr || list_length(saop->args) != 2)
+			return false;
+		var = bloom_strip_var(linitial(saop->args));
+		if (var == NULL || !IsA(lsecond(saop->args), Const))
+			return false;
+
+		con = (Const *) lsecond(saop->args);
+		opno = saop->opno;
+		inputcollid = saop->inputcollid;
+		isArray = true;
+	}
+	else
+		return false;
+
+	if (con->constisnull ||
+		var->varattno > RelationGetNumberOfAttributes(rel) ||
+		opts[var->varattno - 1] == NULL ||
+		opts[var->varattno - 1]->bloomfilter_fpr <= 0)
+		return false;
+
+	attr = TupleDescAttr(RelationGetDescr(rel), var->varattno - 1);
+	if (!bloom_op_is_equality(attr, opno, inputcollid, &opfamily))
+		return false;
+
+	if (isArray)
+	{
+		ArrayType  *arr = DatumGetArrayTypeP(con->constvalue);
+		Oid			elemtype = ARR_ELEMTYPE(arr);
+		int16		elmlen;
+		bool		elmbyval;
+		char		elmalign;
+		Datum	   *elems;
+		bool	   *nulls;
+		int			nelems;
+
+		get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+		deconstruct_array(arr, elemtype, elmlen, elmbyval, elmalign,
+						  &elems, &nulls, &nelems);
+		if (nelems > AOCS_BLOOM_MAX_PROBES)
+			return false;
+
+		bloomScan->probes = palloc(Max(nelems, 1) * sizeof(uint64));
+		for (int i = 0; i < nelems; i++)
+		{
+			/* NULL never compares equal */
+			if (nulls[i])
+				continue;
+			if (!bloom_hash_probe(opfamily, elemtype, inputcollid, elems[i],
+								  &bloomScan->probes[bloomScan->nprobes++]))
+				return false;
+		}
+	}
+	else
+	{
+		bloomScan->probes = palloc(sizeof(uint64));
+		if (!bloom_hash_probe(opfamily, con->consttype, inputcollid,
+							  con->constvalue, &bloomScan->probes[0]))
+			return false;
+		bloomScan->nprobes = 1;
+	}
+
+	bloomScan->attno = var->varattno - 1;
+	return true;
+}
+
+/*
+ * Look for a qual that the bloom filters of the relation can answer.
+ * 'qual' is the implicitly ANDed qual list of the scan.  Only the first
+ * usable clause is used.
+ *
+ * Returns NULL if there is none, or if the relation has no block directory
+ * to hold filters.
+ */
+AOCSBloomScan *
+aocs_bloom_scan_prepare(Relation rel, List *qual)
+{
+	Oid			blkdirrelid;
+	StdRdOptions **opts;
+	AOCSBloomScan *bloomScan;
+	List	   *clauses = NIL;
+	ListCell   *lc;
+	bool		found = false;
+
+	if (qual == NIL)
+		return NULL;
+
+	GetAppendOnlyEntryAuxOids(rel, NULL, &blkdirrelid, NULL, NULL, NULL);
+	if (!OidIsValid(blkdirrelid))
+		return NULL;
+
+	opts = RelationGetAttributeOptions(rel);
+	for (int i = 0; i < RelationGetNumberOfAttributes(rel); i++)
+	{
+		if (opts[i] && opts[i]->bloomfilter_fpr > 0)
+		{
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		return NULL;
+
+	/* Flatten top-level ANDs */
+	foreach(lc, qual)
+	{
+		Node	   *clause = (Node *) lfirst(lc);
+
+		if (is_andclause(clause))
+			clauses = list_concat(clauses, ((BoolExpr *) clause)->args);
+		else
+			clauses = lappend(clauses, clause);
+	}
+
+	bloomScan = palloc0(sizeof(AOCSBloomScan));
+	foreach(lc, clauses)
+	{
+		if (bloom_extract_clause(rel, opts, (Node *) lfirst(lc), bloomScan))
+			return bloomScan;
+
+		if (bloomScan->probes)
+			pfree(bloomScan->probes);
+		bloomScan->probes = NULL;
+		bloomScan->nprobes = 0;
+	}
+
+	pfree(bloomScan);
+	return NULL;
+}
+
+AttrNumber
+aocs_bloom_scan_attno(AOCSBloomScan *bloomScan)
+{
+	return bloomScan->attno;
+}
+
+static void
+bloom_scan_add_range(AOCSBloomScan *bloomScan, int64 firstRowNum, int64 endRowNum)
+{
+	/* Merge with the previous range if adjacent */
+	if (bloomScan->nskip > 0 &&
+		bloomScan->skipEnd[bloomScan->nskip - 1] == firstRowNum)
+	{
+		bloomScan->skipEnd[bloomScan->nskip - 1] = endRowNum;
+		bloomScan->skipBlocks[bloomScan->nskip - 1]++;
+		return;
+	}
+
+	if (bloomScan->nskip == bloomScan->maxskip)
+	{
+		bloomScan->maxskip = Max(bloomScan->maxskip * 2, 64);
+		if (bloomScan->skipFirst)
+		{
+			bloomScan->skipFirst = repalloc(bloomScan->skipFirst,
+											bloomScan->maxskip * sizeof(int64));
+			bloomScan->skipEnd = repalloc(bloomScan->skipEnd,
+										  bloomScan->maxskip * sizeof(int64));
+			bloomScan->skipBlocks = repalloc(bloomScan->skipBlocks,
+											 bloomScan->maxskip * sizeof(int));
+		}
+		else
+		{
+			bloomScan->skipFirst = palloc(bloomScan->maxskip * sizeof(int64));
+			bloomScan->skipEnd = palloc(bloomScan->maxskip * sizeof(int64));
+			bloomScan->skipBlocks = palloc(bloomScan->maxskip * sizeof(int));
+		}
+	}
+
+	bloomScan->skipFirst[bloomScan->nskip] = firstRowNum;
+	bloomScan->skipEnd[bloomScan->nskip] = endRowNum;
+	bloomScan->skipBlocks[bloomScan->nskip] = 1;
+	bloomScan->nskip++;
+}
+
+/*
+ * Probe the filters of all blocks of the column in segment file 'segno',
+ * and collect the row ranges that can be skipped.
+ */
+void
+aocs_bloom_scan_load_segment(AOCSBloomScan *bloomScan, Relation rel,
+							 Snapshot snapshot, int segno)
+{
+	Oid			blkdirrelid;
+	Oid			blkdiridxid;
+	Relation	blkdirRel;
+	Relation	blkdirIdx;
+	TupleDesc	tupdesc;
+	ScanKeyData scanKeys[2];
+	SysScanDesc scan;
+	HeapTuple	tuple;
+
+	bloomScan->nskip = 0;
+	bloomScan->cursor = 0;
+
+	GetAppendOnlyEntryAuxOids(rel, NULL, &blkdirrelid, &blkdiridxid, NULL, NULL);
+	Assert(OidIsValid(blkdirrelid) && OidIsValid(blkdiridxid));
+
+	blkdirRel = table_open(blkdirrelid, AccessShareLock);
+	blkdirIdx = index_open(blkdiridxid, AccessShareLock);
+	tupdesc = RelationGetDescr(blkdirRel);
+
+	ScanKeyInit(&scanKeys[0],
+				Anum_pg_aoblkdir_segno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(segno));
+	ScanKeyInit(&scanKeys[1],
+				Anum_pg_aoblkdir_columngroupno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(AOBlkDirBloomColumnGroupNo(bloomScan->attno)));
+
+	scan = systable_beginscan_ordered(blkdirRel, blkdirIdx, snapshot,
+									  2, scanKeys);
+	while ((tuple = systable_getnext_ordered(scan, ForwardScanDirection)) != NULL)
+	{
+		Datum		d;
+		bool		isnull;
+		int64		firstRowNum;
+		AOCSBloomFilter *filter;
+		bool		match = false;
+
+		d = heap_getattr(tuple, Anum_pg_aoblkdir_firstrownum, tupdesc, &isnull);
+		Assert(!isnull);
+		firstRowNum = DatumGetInt64(d);
+
+		d = heap_getattr(tuple, Anum_pg_aoblkdir_minipage, tupdesc, &isnull);
+		Assert(!isnull);
+
+		/* Copy, so that the 64-bit words are aligned */
+		filter = (AOCSBloomFilter *) PG_DETOAST_DATUM_COPY(d);
+		if (filter->version != AOCS_BLOOM_VERSION)
+			match = true;
+		for (int i = 0; i < bloomScan->nprobes && !match; i++)
+			match = bloom_may_contain(filter, bloomScan->probes[i]);
+
+		if (!match)
+			bloom_scan_add_range(bloomScan, firstRowNum,
+								 firstRowNum + filter->rowCount);
+		bloomScan->nblocks++;
+		pfree(filter);
+	}
+	systable_endscan_ordered(scan);
+
+	index_close(blkdirIdx, AccessShareLock);
+	table_close(blkdirRel, AccessShareLock);
+}
+
+/*
+ * Given the row number the scan is about to read, return the row number it
+ * can continue from.  Row numbers only grow within a segment file.
+ */
+int64
+aocs_bloom_scan_skip_to(AOCSBloomScan *bloomScan, int64 rowNum)
+{
+	while (bloomScan->cursor < bloomScan->nskip &&
+		   bloomScan->skipEnd[bloomScan->cursor] <= rowNum)
+		bloomScan->cursor++;
+
+	if (bloomScan->cursor < bloomScan->nskip &&
+		bloomScan->skipFirst[bloomScan->cursor] <= rowNum)
+	{
+		bloomScan->nskipped += bloomScan->skipBlocks[bloomScan->cursor];
+		return bloomScan->skipEnd[bloomScan->cursor];
+	}
+
+	return rowNum;
+}
+
+/*
+ * Report how many blocks the filters let the scan skip, for EXPLAIN ANALYZE.
+ */
+void
+aocs_bloom_scan_explain(AOCSBloomScan *bloomScan, StringInfo buf)
+{
+	appendStringInfo(buf, "Bloom filter skipped " INT64_FORMAT " of " INT64_FORMAT " blocks.",
+					 bloomScan->nskipped, bloomScan->nblocks);
+}
+
+void
+aocs_bloom_scan_end(AOCSBloomScan *bloomScan)
+{
+	if (bloomScan->probes)
+		pfree(bloomScan->probes);
+	if (bloomScan->skipFirst)
+	{
+		pfree(bloomScan->skipFirst);
+		pfree(bloomScan->skipEnd);
+		pfree(bloomScan->skipBlocks);
+	}
+	pfree(bloomScan);
+}
@@ -222,6 +222,7 @@ TruncateAOSegmentFile(File fd, Relation rel, int32 segFileNum, int64 offset, AOV
 		vacrelstats->nbytes_truncated += filesize_before - offset;
 		pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED,
 									 RelationGuessNumberOfBlocksFromSize(vacrelstats->nbytes_truncated));
+		AppendOptimizedReportBytesReclaimed(vacrelstats);
 	}
 
 	if (XLogIsNeeded() && RelationNeedsWAL(rel))
@@ -127,6 +127,8 @@ gp_aoblkdir(PG_FUNCTION_ARGS)
 	{
 		Datum	minipage;
 		bool	minipageNull;
+		Datum	columnGroupNo;
+		bool	columnGroupNoNull;
 
 		/* We need to fetch the next tuple from the blkdir relation */
 		if (!systable_getnext(context->scan))
@@ -139,8 +141,13 @@ gp_aoblkdir(PG_FUNCTION_ARGS)
 		/*
 		 * There should not really be any NULL values. We opt to report it
 		 * instead of ERRORing out.
+		 *
+		 * Rows holding AOCO bloom filters carry no minipage entries; they are
+		 * reported with NULL entry columns as well.
 		 */
-		context->currMinipageValid = !minipageNull;
+		columnGroupNo = slot_getattr(context->scan->slot, Anum_pg_aoblkdir_columngroupno, &columnGroupNoNull);
+		context->currMinipageValid = !minipageNull && !columnGroupNoNull &&
+			!AOBlkDirIsBloomColumnGroupNo(DatumGetInt32(columnGroupNo));
 		if (context->currMinipageValid)
 		{
 			/*
@@ -55,6 +55,7 @@
 #include "utils/relcache.h"
 #include "utils/guc.h"
 #include "utils/snapmgr.h"
+#include "utils/timestamp.h"
 #include "miscadmin.h"
 
 /* 
@@ -225,6 +226,51 @@ AppendOnlyCompaction_ShouldCompact(Relation aoRelation,
 	return result;
 }
 
+/*
+ * Vacuum delay point of the compaction loops.
+ *
+ * Append-optimized segment files are not read and written through shared
+ * buffers, so the cost based vacuum delay would never kick in by itself.
+ * Every heap-equivalent page read since the last call is charged as a page
+ * miss, plus a dirtied page for its copy in the insertion segment file (an
+ * upper bound, dead tuples are not copied).  '*bytesCharged' keeps track of
+ * what was charged already.
+ */
+void
+AppendOptimizedCompactionDelayPoint(int64 bytesRead, int64 *bytesCharged)
+{
+	int64		pages = (bytesRead - *bytesCharged) / BLCKSZ;
+
+	if (VacuumCostActive && pages > 0)
+	{
+		VacuumCostBalance += pages * (VacuumCostPageMiss + VacuumCostPageDirty);
+		*bytesCharged += pages * BLCKSZ;
+	}
+
+	vacuum_delay_point();
+}
+
+/*
+ * Report the bytes given back to the file system so far, and the rate at
+ * which they were since the VACUUM of the relation started.
+ */
+void
+AppendOptimizedReportBytesReclaimed(AOVacuumRelStats *vacrelstats)
+{
+	const int	progress_index[] = {
+		PROGRESS_VACUUM_AO_BYTES_RECLAIMED,
+		PROGRESS_VACUUM_AO_BYTES_RECLAIMED_RATE
+	};
+	int64		progress_val[2];
+	long		elapsed_ms;
+
+	elapsed_ms = TimestampDifferenceMilliseconds(vacrelstats->start_time,
+												 GetCurrentTimestamp());
+	progress_val[0] = vacrelstats->nbytes_truncated;
+	progress_val[1] = vacrelstats->nbytes_truncated * 1000 / Max(elapsed_ms, 1);
+	pgstat_progress_update_multi_param(2, progress_index, progress_val);
+}
+
 /*
  * AppendOnlySegmentFileTruncateToEOF()
  *
@@ -406,6 +452,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
     Oid         visimapidxid;
     Oid         blkdirrelid;
 	int64		heap_blks_scanned = 0;
+	int64		bytesCharged = 0;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationStorageIsAoRows(aorel));
@@ -506,7 +553,8 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		tupleCount++;
 		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			AppendOptimizedCompactionDelayPoint(scanDesc->totalBytesRead,
+												&bytesCharged);
 		}
 	}
 
@@ -802,10 +850,12 @@ AppendOptimizedTruncateToEOF(Relation aorel, AOVacuumRelStats *vacrelstats)
  * insertion target. The segfiles listed in 'avoid_segnos' will not be used
  * for insertion.
  *
+ * Returns true if the segment file was compacted.
+ *
  * The caller is required to hold either an AccessExclusiveLock (vacuum full)
  * or a ShareLock on the relation.
  */
-void
+bool
 AppendOnlyCompact(Relation aorel,
 				  int compaction_segno,
 				  int *insert_segno,
@@ -817,6 +867,7 @@ AppendOnlyCompact(Relation aorel,
 	AppendOnlyInsertDesc insertDesc = NULL;
 	FileSegInfo *fsinfo;
 	Snapshot	appendOnlyMetaDataSnapshot = RegisterSnapshot(GetCatalogSnapshot(InvalidOid));
+	bool		compacted = false;
 
 	Assert(RelationStorageIsAoRows(aorel));
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
@@ -849,6 +900,7 @@ AppendOnlyCompact(Relation aorel,
 
 			insertDesc->skipModCountIncrement = true;
 			appendonly_insert_finish(insertDesc, NULL);
+			compacted = true;
 		}
 		else
 		{
@@ -862,4 +914,6 @@ AppendOnlyCompact(Relation aorel,
 	pfree(fsinfo);
 
 	UnregisterSnapshot(appendOnlyMetaDataSnapshot);
+
+	return compacted;
 }
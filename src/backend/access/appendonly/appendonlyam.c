@@ -933,6 +933,14 @@ AOExecutorReadBlockBindingInit(AppendOnlyExecutorReadBlock *executorReadBlock,
 		oldContext = MemoryContextSwitchTo(executorReadBlock->memoryContext);
 		executorReadBlock->mt_bind = create_memtuple_binding(slot->tts_tupleDescriptor);
 		MemoryContextSwitchTo(oldContext);
+
+		if (executorReadBlock->jit_parent)
+		{
+			executorReadBlock->jit_deform =
+				jit_compile_memtuple_deform(executorReadBlock->jit_parent,
+											executorReadBlock->mt_bind);
+			executorReadBlock->jit_parent = NULL;
+		}
 	}
 }
 
@@ -976,7 +984,12 @@ AppendOnlyExecutorReadBlock_ProcessTuple(AppendOnlyExecutorReadBlock *executorRe
 			tuple = upgrade_tuple(executorReadBlock, tuple, executorReadBlock->mt_bind, formatVersion, &shouldFree);
 
 		ExecClearTuple(slot);
-		memtuple_deform(tuple, executorReadBlock->mt_bind, slot->tts_values, slot->tts_isnull);
+		if (executorReadBlock->jit_deform && !memtuple_get_islarge(tuple))
+			executorReadBlock->jit_deform(tuple,
+										  executorReadBlock->mt_bind->bind.null_saves_aligned,
+										  slot->tts_values, slot->tts_isnull);
+		else
+			memtuple_deform(tuple, executorReadBlock->mt_bind, slot->tts_values, slot->tts_isnull);
 		slot->tts_tid = fake_ctid;
 
 		if (shouldFree)
@@ -1680,6 +1693,7 @@ appendonly_beginscan_extractcolumns(Relation rel, Snapshot snapshot, int nkeys,
 {
 	AppendOnlyScanDesc aoscan;
 	aoscan = (AppendOnlyScanDesc) appendonly_beginscan(rel, snapshot, nkeys, key, parallel_scan, flags);
+	aoscan->executorReadBlock.jit_parent = ps;
 	if (gp_enable_predicate_pushdown)
 		ps->qual = appendonly_predicate_pushdown_prepare(aoscan, ps->qual, ps->ps_ExprContext);
 	return (TableScanDesc) aoscan;
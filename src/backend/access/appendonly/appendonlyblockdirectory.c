@@ -1014,6 +1014,67 @@ insert_new_entry(
 	return true;
 }
 
+/*
+ * AppendOnlyBlockDirectory_InsertBloomFilter
+ *
+ * Store the bloom filter of the AOCO block starting at firstRowNum of the
+ * given column. The row goes into the block directory relation right away;
+ * unlike minipages, filters are never updated later.
+ *
+ * If the block directory for the appendonly relation does not exist,
+ * this function simply returns.
+ */
+void
+AppendOnlyBlockDirectory_InsertBloomFilter(AppendOnlyBlockDirectory *blockDirectory,
+										   int columnGroupNo,
+										   int64 firstRowNum,
+										   struct varlena *filter)
+{
+	HeapTuple	tuple;
+	MemoryContext oldcxt;
+	Datum	   *values = blockDirectory->values;
+	bool	   *nulls = blockDirectory->nulls;
+	Relation	blkdirRel = blockDirectory->blkdirRel;
+
+	if (blkdirRel == NULL || blockDirectory->blkdirIdx == NULL)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(blockDirectory->memoryContext);
+
+	values[Anum_pg_aoblkdir_segno - 1] =
+		Int32GetDatum(blockDirectory->currentSegmentFileNum);
+	nulls[Anum_pg_aoblkdir_segno - 1] = false;
+
+	values[Anum_pg_aoblkdir_columngroupno - 1] =
+		Int32GetDatum(AOBlkDirBloomColumnGroupNo(columnGroupNo));
+	nulls[Anum_pg_aoblkdir_columngroupno - 1] = false;
+
+	values[Anum_pg_aoblkdir_firstrownum - 1] = Int64GetDatum(firstRowNum);
+	nulls[Anum_pg_aoblkdir_firstrownum - 1] = false;
+
+	values[Anum_pg_aoblkdir_minipage - 1] = PointerGetDatum(filter);
+	nulls[Anum_pg_aoblkdir_minipage - 1] = false;
+
+	tuple = heaptuple_form_to(RelationGetDescr(blkdirRel),
+							  values,
+							  nulls,
+							  NULL,
+							  NULL);
+
+	ereportif(Debug_appendonly_print_blockdirectory, LOG,
+			  (errmsg("Append-only block directory insert a bloom filter: "
+					  "(segno, columnGroupNo, firstRowNum) = "
+					  "(%d, %d, " INT64_FORMAT ")",
+					  blockDirectory->currentSegmentFileNum,
+					  columnGroupNo, firstRowNum)));
+
+	CatalogTupleInsertWithInfo(blkdirRel, tuple, blockDirectory->indinfo);
+
+	heap_freetuple(tuple);
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
 /*
  * AppendOnlyBlockDirectory_DeleteSegmentFile
  *
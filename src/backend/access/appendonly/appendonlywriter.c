@@ -79,6 +79,7 @@ typedef struct
 	int32		segno;
 	ItemPointerData ctid;
 	float8		tupcount;
+	float8		hideratio;		/* hidden/total tuples, compaction targets only */
 } candidate_segment;
 
 /*
@@ -107,6 +108,54 @@ compare_candidates(const void *a, const void *b)
 	}
 }
 
+/*
+ * Compare compaction candidates, dirtiest first.
+ */
+static int
+compare_compaction_candidates(const void *a, const void *b)
+{
+	candidate_segment *ca = (candidate_segment *) a;
+	candidate_segment *cb = (candidate_segment *) b;
+
+	if (ca->hideratio > cb->hideratio)
+		return -1;
+	else if (ca->hideratio < cb->hideratio)
+		return 1;
+	else
+		return compare_candidates(a, b);
+}
+
+/*
+ * Fill in the ratio of hidden tuples of each compaction candidate.
+ */
+static void
+compute_hide_ratios(Relation rel, candidate_segment *candidates,
+					int ncandidates, Snapshot snapshot)
+{
+	AppendOnlyVisimap visiMap;
+	Oid			visimaprelid;
+	Oid			visimapidxid;
+
+	GetAppendOnlyEntryAuxOids(rel,
+							  NULL, NULL, NULL,
+							  &visimaprelid, &visimapidxid);
+
+	AppendOnlyVisimap_Init(&visiMap,
+						   visimaprelid,
+						   visimapidxid,
+						   AccessShareLock,
+						   snapshot);
+	for (int i = 0; i < ncandidates; i++)
+	{
+		int64		hidden;
+
+		hidden = AppendOnlyVisimap_GetSegmentFileHiddenTupleCount(&visiMap,
+																  candidates[i].segno);
+		candidates[i].hideratio = hidden / candidates[i].tupcount;
+	}
+	AppendOnlyVisimap_Finish(&visiMap, AccessShareLock);
+}
+
 /*
  * Lock an existing segfile for writing.
  *
@@ -512,6 +561,7 @@ choose_segno_internal(Relation rel, List *avoid_segnos, choose_segno_mode mode)
 		candidates[ncandidates].segno = segno;
 		candidates[ncandidates].ctid = tuple->t_self;
 		candidates[ncandidates].tupcount = tupcount;
+		candidates[ncandidates].hideratio = 0;
 		ncandidates++;
 	}
 	systable_endscan(aoscan);
@@ -555,9 +605,20 @@ choose_segno_internal(Relation rel, List *avoid_segnos, choose_segno_mode mode)
 		 * Sort the candidates by tuple count, to prefer segment with fewest existing
 		 * tuples. (In particular, in COMPACTION_WRITE mode, this puts all empty
 		 * segfiles to the front).
+		 *
+		 * Compaction targets are instead taken dirtiest first, so that a VACUUM
+		 * that stops after gp_appendonly_compaction_max_segfiles segfiles
+		 * reclaims as much space as it can for the tuples it moves.
 		 */
-		qsort((void *) candidates, ncandidates, sizeof(candidate_segment),
-			  compare_candidates);
+		if (mode == CHOOSE_MODE_COMPACTION_TARGET && ncandidates > 1)
+		{
+			compute_hide_ratios(rel, candidates, ncandidates, snapshot);
+			qsort((void *) candidates, ncandidates, sizeof(candidate_segment),
+				  compare_compaction_candidates);
+		}
+		else
+			qsort((void *) candidates, ncandidates, sizeof(candidate_segment),
+				  compare_candidates);
 
 		for (i = 0; i < ncandidates; i++)
 		{
@@ -935,11 +935,82 @@ memtuple_copy(MemTuple mtup)
 	return dest;
 }
 
+/*
+ * Extract all the attributes of a memtuple in one pass.
+ *
+ * Fetching the attributes one by one with memtuple_getattr() sums up the
+ * space saved by the nulls of the whole null bitmap preceding each attribute,
+ * which is quadratic in the number of columns.  Instead, sum the saves of
+ * each complete bitmap byte once, so that locating an attribute only needs
+ * the partial byte it sits in.  Tuples without nulls skip all of that, every
+ * attribute is at its binding offset.
+ */
 static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
 {
-	int i;
-	for(i=0; i<pbind->tupdesc->natts; ++i)
-		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
+	TupleDesc	tupdesc = pbind->tupdesc;
+	int			natts = tupdesc->natts;
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	char	   *start = (char *) mtup;
+	int			i;
+
+	if (!memtuple_get_hasnull(mtup))
+	{
+		for (i = 0; i < natts; ++i)
+		{
+			MemTupleAttrBinding *attrbind = &colbind->bindings[i];
+			char	   *p = start + attrbind->offset;
+
+			if (attrbind->flag == MTB_ByRef || attrbind->flag == MTB_ByRef_CStr)
+				p = start + (attrbind->len == 2 ? *(uint16 *) p : *(uint32 *) p);
+
+			isnull[i] = false;
+			datum[i] = fetchatt(TupleDescAttr(tupdesc, i), p);
+		}
+	}
+	else
+	{
+		unsigned char *nullp = memtuple_get_nullp(mtup, pbind);
+		short	   *null_saves = (use_null_saves_aligned ? colbind->null_saves_aligned : colbind->null_saves);
+		int			nbytes = (natts + 7) >> 3;
+		int			byte_saves[(MaxTupleAttributeNumber + 7) / 8];
+		int			ns = 0;
+
+		Assert(null_saves);
+
+		start += pbind->null_bitmap_extra_size;
+
+		/* Space saved by the nulls of the bitmap bytes before each byte */
+		for (i = 0; i < nbytes; ++i)
+		{
+			byte_saves[i] = ns;
+			ns += compute_null_save_b(null_saves + i * 32, nullp[i]);
+		}
+
+		for (i = 0; i < natts; ++i)
+		{
+			MemTupleAttrBinding *attrbind = &colbind->bindings[i];
+			int			b = attrbind->null_byte;
+			char	   *p;
+
+			if (nullp[b] & attrbind->null_mask)
+			{
+				isnull[i] = true;
+				datum[i] = (Datum) 0;
+				continue;
+			}
+
+			ns = byte_saves[b] +
+				compute_null_save_b(null_saves + b * 32,
+									nullp[b] & (attrbind->null_mask - 1));
+			p = start + attrbind->offset - ns;
+
+			if (attrbind->flag == MTB_ByRef || attrbind->flag == MTB_ByRef_CStr)
+				p = start + (attrbind->len == 2 ? *(uint16 *) p : *(uint32 *) p);
+
+			isnull[i] = false;
+			datum[i] = fetchatt(TupleDescAttr(tupdesc, i), p);
+		}
+	}
 }
 
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
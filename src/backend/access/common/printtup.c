@@ -23,6 +23,10 @@
 #include "utils/memdebug.h"
 #include "utils/memutils.h"
 
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 
 static void printtup_startup(DestReceiver *self, int operation,
 							 TupleDesc typeinfo);
@@ -30,6 +34,16 @@ static bool printtup(TupleTableSlot *slot, DestReceiver *self);
 static void printtup_shutdown(DestReceiver *self);
 static void printtup_destroy(DestReceiver *self);
 
+/*
+ * A ColumnBatch message is sent once it holds this many rows, or this many
+ * bytes of values, whichever comes first.
+ */
+#define COLUMN_BATCH_MAX_ROWS	8192
+#define COLUMN_BATCH_MAX_BYTES	(1024 * 1024)
+
+/* zstd level for ColumnBatch messages, the fastest as they're sent at once */
+#define COLUMN_BATCH_COMPRESS_LEVEL 1
+
 /* ----------------------------------------------------------------
  *		printtup / debugtup support
  * ----------------------------------------------------------------
@@ -51,6 +65,18 @@ typedef struct
 	FmgrInfo	finfo;			/* Precomputed call info for output fn */
 } PrinttupAttrInfo;
 
+/*
+ * Rows collected for a ColumnBatch message.  The values of each column are
+ * appended to its own buffer, encoded as in a DataRow message, and the
+ * message carries the buffers one after the other.
+ */
+typedef struct
+{
+	int			nrows;			/* rows collected so far */
+	int			nbytes;			/* total length of the column buffers */
+	StringInfoData *columns;	/* one buffer per attribute */
+} PrinttupBatch;
+
 typedef struct
 {
 	DestReceiver pub;			/* publicly-known function pointers */
@@ -59,6 +85,7 @@ typedef struct
 	TupleDesc	attrinfo;		/* The attr info we are set up for */
 	int			nattrs;
 	PrinttupAttrInfo *myinfo;	/* Cached info about each attr */
+	PrinttupBatch *batch;		/* NULL unless sending ColumnBatch messages */
 	StringInfoData buf;			/* output buffer (*not* in tmpcontext) */
 	MemoryContext tmpcontext;	/* Memory context for per-row workspace */
 } DR_printtup;
@@ -87,6 +114,7 @@ printtup_create_DR(CommandDest dest)
 	self->attrinfo = NULL;
 	self->nattrs = 0;
 	self->myinfo = NULL;
+	self->batch = NULL;
 	self->buf.data = NULL;
 	self->tmpcontext = NULL;
 
@@ -129,6 +157,13 @@ printtup_startup(DestReceiver *self, int operation pg_attribute_unused(), TupleD
 												"printtup",
 												ALLOCSET_DEFAULT_SIZES);
 
+	/*
+	 * If the client asked for it at connection startup, send the tuples in
+	 * ColumnBatch messages instead of a DataRow message each.
+	 */
+	if (MyProcPort && MyProcPort->column_batches != PQ_COLUMN_BATCHES_OFF)
+		myState->batch = (PrinttupBatch *) palloc0(sizeof(PrinttupBatch));
+
 	/*
 	 * If we are supposed to emit row descriptions, then send the tuple
 	 * descriptor of the tuples.
@@ -243,6 +278,134 @@ SendRowDescriptionMessage(StringInfo buf, TupleDesc typeinfo,
 	pq_endmessage_reuse(buf);
 }
 
+/*
+ * Release the column buffers of the ColumnBatch being collected, if any
+ */
+static void
+printtup_free_batch_columns(DR_printtup *myState)
+{
+	PrinttupBatch *batch = myState->batch;
+	int			i;
+
+	if (batch == NULL || batch->columns == NULL)
+		return;
+
+	Assert(batch->nrows == 0);
+	for (i = 0; i < myState->nattrs; i++)
+		pfree(batch->columns[i].data);
+	pfree(batch->columns);
+	batch->columns = NULL;
+}
+
+/*
+ * Send the rows collected so far in a ColumnBatch ('b') message:
+ *
+ *	Int16	number of columns
+ *	Int32	number of rows
+ *	Byte1	compression of the payload, PQ_COLUMN_BATCH_xxx
+ *	Int32[]	uncompressed length of the values of each column
+ *	Byten	payload
+ *
+ * The payload holds the values of the first column for all the rows, then
+ * those of the second, and so on, each value encoded as in DataRow.  It is
+ * compressed if the client allowed it and that makes it smaller.
+ */
+static void
+printtup_send_batch(DR_printtup *myState)
+{
+	PrinttupBatch *batch = myState->batch;
+	StringInfo	buf = &myState->buf;
+	int			natts = myState->nattrs;
+	bool		compressed = false;
+	int			i;
+
+	if (batch == NULL || batch->nrows == 0)
+		return;
+
+	pq_beginmessage_reuse(buf, 'b');
+	pq_sendint16(buf, natts);
+	pq_sendint32(buf, batch->nrows);
+
+#ifdef USE_ZSTD
+	if (MyProcPort->column_batches == PQ_COLUMN_BATCHES_ZSTD && natts > 0)
+	{
+		static ZSTD_CCtx *cctx = NULL;
+		ZSTD_outBuffer out;
+		int			hdrlen = buf->len;
+		size_t		ret;
+
+		if (cctx == NULL)
+		{
+			cctx = ZSTD_createCCtx();
+			if (cctx == NULL)
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of memory"),
+						 errdetail("Failed to create ZSTD compression context.")));
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+								   COLUMN_BATCH_COMPRESS_LEVEL);
+		}
+		/* forget a batch that an error interrupted */
+		ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+		ZSTD_CCtx_setPledgedSrcSize(cctx, batch->nbytes);
+
+		pq_sendbyte(buf, PQ_COLUMN_BATCH_ZSTD);
+		for (i = 0; i < natts; i++)
+			pq_sendint32(buf, batch->columns[i].len);
+		enlargeStringInfo(buf, ZSTD_compressBound(batch->nbytes));
+		out.dst = buf->data + buf->len;
+		out.size = ZSTD_compressBound(batch->nbytes);
+		out.pos = 0;
+
+		for (i = 0; i <= natts; i++)
+		{
+			ZSTD_inBuffer in;
+			ZSTD_EndDirective mode = (i < natts) ? ZSTD_e_continue : ZSTD_e_end;
+
+			in.src = (i < natts) ? batch->columns[i].data : NULL;
+			in.size = (i < natts) ? batch->columns[i].len : 0;
+			in.pos = 0;
+			do
+			{
+				ret = ZSTD_compressStream2(cctx, &out, &in, mode);
+				if (ZSTD_isError(ret))
+					ereport(ERROR,
+							(errcode(ERRCODE_INTERNAL_ERROR),
+							 errmsg("could not compress column batch: %s",
+									ZSTD_getErrorName(ret))));
+			} while (mode == ZSTD_e_end ? ret != 0 : in.pos < in.size);
+		}
+
+		if (out.pos < batch->nbytes)
+		{
+			buf->len += out.pos;
+			compressed = true;
+		}
+		else
+		{
+			/* incompressible, send it as it is */
+			buf->len = hdrlen;
+		}
+	}
+#endif
+
+	if (!compressed)
+	{
+		pq_sendbyte(buf, PQ_COLUMN_BATCH_UNCOMPRESSED);
+		for (i = 0; i < natts; i++)
+			pq_sendint32(buf, batch->columns[i].len);
+		for (i = 0; i < natts; i++)
+			pq_sendbytes(buf, batch->columns[i].data, batch->columns[i].len);
+	}
+
+	pq_endmessage_reuse(buf);
+
+	for (i = 0; i < natts; i++)
+		resetStringInfo(&batch->columns[i]);
+	batch->nrows = 0;
+	batch->nbytes = 0;
+}
+
 /*
  * Get the lookup info that printtup() needs
  */
@@ -257,11 +420,21 @@ printtup_prepare_info(DR_printtup *myState, TupleDesc typeinfo, int numAttrs)
 		pfree(myState->myinfo);
 	myState->myinfo = NULL;
 
+	printtup_free_batch_columns(myState);
+
 	myState->attrinfo = typeinfo;
 	myState->nattrs = numAttrs;
 	if (numAttrs <= 0)
 		return;
 
+	if (myState->batch)
+	{
+		myState->batch->columns = (StringInfoData *)
+			palloc(numAttrs * sizeof(StringInfoData));
+		for (i = 0; i < numAttrs; i++)
+			initStringInfo(&myState->batch->columns[i]);
+	}
+
 	myState->myinfo = (PrinttupAttrInfo *)
 		palloc0(numAttrs * sizeof(PrinttupAttrInfo));
 
@@ -302,6 +475,7 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 {
 	TupleDesc	typeinfo = slot->tts_tupleDescriptor;
 	DR_printtup *myState = (DR_printtup *) self;
+	PrinttupBatch *batch = myState->batch;
 	MemoryContext oldcontext;
 	StringInfo	buf = &myState->buf;
 	int			natts = typeinfo->natts;
@@ -309,7 +483,11 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 
 	/* Set or update my derived attribute info, if needed */
 	if (myState->attrinfo != typeinfo || myState->nattrs != natts)
+	{
+		/* the rows collected so far have the old layout */
+		printtup_send_batch(myState);
 		printtup_prepare_info(myState, typeinfo, natts);
+	}
 
 	/* Make sure the tuple is fully deconstructed */
 	slot_getallattrs(slot);
@@ -318,11 +496,15 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 	oldcontext = MemoryContextSwitchTo(myState->tmpcontext);
 
 	/*
-	 * Prepare a DataRow message (note buffer is in per-row context)
+	 * Prepare a DataRow message (note buffer is in per-row context), unless
+	 * the values go to the column buffers of a batch
 	 */
-	pq_beginmessage_reuse(buf, 'D');
+	if (batch == NULL)
+	{
+		pq_beginmessage_reuse(buf, 'D');
 
-	pq_sendint16(buf, natts);
+		pq_sendint16(buf, natts);
+	}
 
 	/*
 	 * send the attributes of this tuple
@@ -333,6 +515,9 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 		bool 		isnull;
 		Datum		attr = slot_getattr(slot, i+1, &isnull);
 		Form_pg_attribute fatt = TupleDescAttr(typeinfo, i);
+
+		if (batch)
+			buf = &batch->columns[i];
 		
 		if (isnull)
 		{
@@ -583,12 +768,24 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 		}
 	}
 
-	pq_endmessage_reuse(buf);
+	if (batch == NULL)
+		pq_endmessage_reuse(buf);
+	else
+	{
+		batch->nrows++;
+		batch->nbytes = 0;
+		for (i = 0; i < natts; i++)
+			batch->nbytes += batch->columns[i].len;
+	}
 
 	/* Return to caller's context, and flush row's temporary memory */
 	MemoryContextSwitchTo(oldcontext);
 	MemoryContextReset(myState->tmpcontext);
 
+	if (batch && (batch->nrows >= COLUMN_BATCH_MAX_ROWS ||
+				  batch->nbytes >= COLUMN_BATCH_MAX_BYTES))
+		printtup_send_batch(myState);
+
 	return true;
 }
 
@@ -601,6 +798,13 @@ printtup_shutdown(DestReceiver *self)
 {
 	DR_printtup *myState = (DR_printtup *) self;
 
+	/* send the rows of the last batch */
+	printtup_send_batch(myState);
+	printtup_free_batch_columns(myState);
+	if (myState->batch)
+		pfree(myState->batch);
+	myState->batch = NULL;
+
 	if (myState->myinfo)
 		pfree(myState->myinfo);
 	myState->myinfo = NULL;
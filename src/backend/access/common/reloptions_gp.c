@@ -106,6 +106,16 @@ static relopt_int intRelOpts_gp[] =
 
 static relopt_real realRelOpts_gp[] =
 {
+	{
+		{
+			SOPT_BLOOMFILTER_FPR,
+			"AOCO column per-block bloom filter false positive rate",
+			RELOPT_KIND_APPENDOPTIMIZED,
+			ShareUpdateExclusiveLock	/* since it applies only to later
+										 * inserts */
+		},
+		AO_DEFAULT_BLOOMFILTER_FPR, AO_MIN_BLOOMFILTER_FPR, AO_MAX_BLOOMFILTER_FPR
+	},
 	/* list terminator */
 	{{NULL}}
 };
@@ -1957,7 +1967,20 @@ ao_amoptions(Datum reloptions, char relkind, bool validate)
 			return (bytea *) rdopts;
 		case RELKIND_RELATION:
 		case RELKIND_MATVIEW:
-			return default_reloptions(reloptions, validate, RELOPT_KIND_APPENDOPTIMIZED);
+			rdopts = (StdRdOptions *)
+				default_reloptions(reloptions, validate, RELOPT_KIND_APPENDOPTIMIZED);
+
+			/*
+			 * Bloom filters are built per column, so the false positive rate
+			 * can only be given in a column ENCODING clause.
+			 */
+			if (validate && rdopts != NULL &&
+				rdopts->bloomfilter_fpr != AO_DEFAULT_BLOOMFILTER_FPR)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("\"%s\" is a column specific option",
+								SOPT_BLOOMFILTER_FPR)));
+			return (bytea *) rdopts;
 		default:
 			Assert(false);
 			return NULL;
@@ -244,6 +244,29 @@ RelationGetAttributeOptions(Relation rel)
 	return opts;
 }
 
+/*
+ * Does any column of the table ask for per-block bloom filters?
+ */
+bool
+RelationHasBloomFilterColumns(Relation rel)
+{
+	StdRdOptions **opts = RelationGetAttributeOptions(rel);
+	int			natts = RelationGetNumberOfAttributes(rel);
+	bool		result = false;
+
+	for (int i = 0; i < natts; i++)
+	{
+		if (opts[i] == NULL)
+			continue;
+		if (opts[i]->bloomfilter_fpr > 0)
+			result = true;
+		pfree(opts[i]);
+	}
+	pfree(opts);
+
+	return result;
+}
+
 /*
  * Work horse underneath DefineRelation().
  *
@@ -1121,6 +1121,45 @@ AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead)
 	return content;
 }
 
+/*
+ * Get a pointer to the *small* compressed content, for the caller to
+ * decompress by itself.
+ *
+ * Like ~_GetBuffer, the pointer is into the read buffer and is valid until
+ * the next block is read.  The caller can still fall back to ~_Content for
+ * the same block.
+ */
+uint8 *
+AppendOnlyStorageRead_GetCompressedBuffer(AppendOnlyStorageRead *storageRead,
+										  int32 *compressedLen)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+
+	/*
+	 * Verify next block is a "small" compressed block.
+	 */
+	Assert(storageRead->current.headerKind == AoHeaderKind_SmallContent ||
+		   storageRead->current.headerKind == AoHeaderKind_NonBulkDenseContent ||
+		   storageRead->current.headerKind == AoHeaderKind_BulkDenseContent);
+	Assert(!storageRead->current.isLarge);
+	Assert(storageRead->current.isCompressed);
+
+	/*
+	 * Fetch pointers to content.
+	 */
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	*compressedLen = storageRead->current.compressedLen;
+
+	return content;
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
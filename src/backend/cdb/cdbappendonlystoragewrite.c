@@ -36,6 +36,12 @@
 #include "utils/faultinjector.h"
 #include "utils/guc.h"
 
+static void AppendOnlyStorageWrite_FinishBufferGuts(AppendOnlyStorageWrite *storageWrite,
+													int32 contentLen,
+													int executorBlockKind,
+													int rowCount,
+													int32 precompressedLen);
+
 
 /*----------------------------------------------------------------
  * Initialization
@@ -1013,12 +1019,21 @@ AppendOnlyStorageWrite_VerifyWriteBlock(AppendOnlyStorageWrite *storageWrite,
 #endif
 }
 
+/*
+ * Compress sourceData into the write buffer, after the header, and make
+ * the header.
+ *
+ * If 'precompressed' is true, the compressed data is already in place (see
+ * AppendOnlyStorageWrite_GetCompressBuffer) and *compressedLen is its
+ * length.
+ */
 static void
 AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 									  uint8 *sourceData,
 									  int32 sourceLen,
 									  int executorBlockKind,
 									  int itemCount,
+									  bool precompressed,
 									  int32 *compressedLen,
 									  int32 *bufferLen)
 {
@@ -1055,13 +1070,14 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 	 * Compress into the BufferedAppend buffer after the large header (and
 	 * optional checksum, etc.
 	 */
-	gp_trycompress(sourceData,
-					sourceLen,
-					dataBuffer,
-					dataBufferWithOverrrunLen,
-					compressedLen,
-					compressor,
-					storageWrite->compressionState);
+	if (!precompressed)
+		gp_trycompress(sourceData,
+						sourceLen,
+						dataBuffer,
+						dataBufferWithOverrrunLen,
+						compressedLen,
+						compressor,
+						storageWrite->compressionState);
 
 #ifdef FAULT_INJECTOR
 	/* Simulate that compression is not possible if the fault is set. */
@@ -1184,6 +1200,82 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 									int32 contentLen,
 									int executorBlockKind,
 									int rowCount)
+{
+	AppendOnlyStorageWrite_FinishBufferGuts(storageWrite,
+											contentLen,
+											executorBlockKind,
+											rowCount,
+											-1);
+}
+
+/*
+ * Get the place where the compressed content of the current buffer goes,
+ * so that it can be compressed without AppendOnlyStorageWrite_FinishBuffer,
+ * for example by a thread of the compression worker pool.
+ *
+ * Only valid after AppendOnlyStorageWrite_GetBuffer with compression
+ * configured.  *compressBufferLen is set to the room available.  Once the
+ * content is compressed, AppendOnlyStorageWrite_FinishCompressedBuffer
+ * finishes the buffer.
+ */
+uint8 *
+AppendOnlyStorageWrite_GetCompressBuffer(AppendOnlyStorageWrite *storageWrite,
+										 int32 *compressBufferLen)
+{
+	uint8	   *header;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(storageWrite->storageAttributes.compress);
+	Assert(storageWrite->currentCompleteHeaderLen > 0);
+
+	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (header == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("We do not expect files to be have a maximum length"),
+				 errcontext_appendonly_write_storage_block(storageWrite)));
+
+	*compressBufferLen = storageWrite->maxBufferWithCompressionOverrrunLen -
+		storageWrite->currentCompleteHeaderLen;
+
+	return &header[storageWrite->currentCompleteHeaderLen];
+}
+
+/*
+ * Like AppendOnlyStorageWrite_FinishBuffer, for content that was already
+ * compressed into the buffer from AppendOnlyStorageWrite_GetCompressBuffer.
+ *
+ * compressedLen	- byte length of the compressed data.  If it is not less
+ *					  than contentLen, the content is stored uncompressed.
+ */
+void
+AppendOnlyStorageWrite_FinishCompressedBuffer(AppendOnlyStorageWrite *storageWrite,
+											  int32 contentLen,
+											  int32 compressedLen,
+											  int executorBlockKind,
+											  int rowCount)
+{
+	Assert(storageWrite->storageAttributes.compress);
+	Assert(compressedLen >= 0);
+
+	AppendOnlyStorageWrite_FinishBufferGuts(storageWrite,
+											contentLen,
+											executorBlockKind,
+											rowCount,
+											compressedLen);
+}
+
+/*
+ * Workhorse of the above.  precompressedLen is -1 if the content still
+ * has to be compressed.
+ */
+static void
+AppendOnlyStorageWrite_FinishBufferGuts(AppendOnlyStorageWrite *storageWrite,
+										int32 contentLen,
+										int executorBlockKind,
+										int rowCount,
+										int32 precompressedLen)
 {
 	int64		headerOffsetInFile;
 	int32		bufferLen;
@@ -1311,13 +1403,14 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 	}
 	else
 	{
-		int32		compressedLen = 0;
+		int32		compressedLen = Max(precompressedLen, 0);
 
 		AppendOnlyStorageWrite_CompressAppend(storageWrite,
 											  storageWrite->uncompressedBuffer,
 											  contentLen,
 											  executorBlockKind,
 											  rowCount,
+											  precompressedLen >= 0,
 											  &compressedLen,
 											  &bufferLen);
 
@@ -1464,6 +1557,7 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 												  contentLen,
 												  executorBlockKind,
 												  rowCount,
+												  false,
 												  &compressedLen,
 												  &bufferLen);
 
@@ -1586,6 +1680,7 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 													  smallContentLen,
 													  executorBlockKind,
 													   /* rowCount */ 0,
+													  false,
 													  &compressedLen,
 													  &bufferLen);
 
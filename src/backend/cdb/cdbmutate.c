@@ -1003,6 +1003,7 @@ shareinput_mutator_xslice_2(Node *node, PlannerInfo *root, bool fPop)
 		{
 			Assert(!sisc->cross_slice);
 			sisc->cross_slice = true;
+			sisc->streaming = gp_shareinput_streaming;
 		}
 
 		sisc->producer_slice_id = pershare->producer_slice_id;
@@ -0,0 +1,255 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbplancache.c
+ *	  Cache of dispatched plans in the QEs.
+ *
+ * Dispatching a plan normally ships the whole serialized PlannedStmt to
+ * every QE, which then deserializes it again. For a prepared statement that
+ * is executed over and over, the plan is the same every time, and only the
+ * parameters (in the QueryDispatchDesc) change.
+ *
+ * So a QE keeps the last plans it received, keyed by an id the QD assigned
+ * to each of them. The QD remembers, in each SegmentDatabaseDescriptor,
+ * which plans that QE holds, and dispatches only the id to a QE that
+ * already has the plan. Both sides must agree on what is cached, so the QE
+ * never evicts a plan on its own: the cache is direct mapped, and a plan
+ * only replaces the one in its slot when the QD ships it in full.
+ *
+ * The QD keeps the serialized form of the last plan of each slot, and gives
+ * a plan the id of that slot's plan only if the bytes are the same. Ids are
+ * never reused in a session, so a cached plan is exactly what the QE would
+ * have deserialized anyway. On invalidation of catalog
+ * entries the plans may reference, and on abort, the QD forgets what all its
+ * QEs hold, and ships the plans in full again the next time they are used.
+ * The abort case covers a QE that failed before storing a plan it was sent;
+ * that includes the abort of a subtransaction, after which the QEs of the
+ * transaction are kept and used again.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/xact.h"
+#include "libpq-fe.h"
+#include "cdb/cdbconn.h"
+#include "cdb/cdbplancache.h"
+#include "cdb/cdbvars.h"
+#include "common/hashfn.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
+
+/* QE side: the cached plans */
+typedef struct CdbPlanCacheEntry
+{
+	uint64		planId;			/* 0 if the slot is empty */
+	MemoryContext context;		/* holds the plan */
+	PlannedStmt *plan;
+} CdbPlanCacheEntry;
+
+static CdbPlanCacheEntry planCache[CDB_PLAN_CACHE_SLOTS];
+
+/* QD side: the last plan given an id in each slot */
+typedef struct CdbPlanCacheKey
+{
+	uint64		planId;			/* 0 if the slot is empty */
+	char	   *splan;			/* serialized plan, as dispatched */
+	int			splan_len;
+	int			splan_len_uncompressed;
+} CdbPlanCacheKey;
+
+static CdbPlanCacheKey planCacheKeys[CDB_PLAN_CACHE_SLOTS];
+static uint64 planCacheLastSeq = 0;
+
+/*
+ * QD side: QEs whose descriptor was last updated in an older generation
+ * are known to hold nothing useful.
+ */
+static uint32 planCacheGeneration = 1;
+static bool planCacheCallbacksRegistered = false;
+
+static void
+cdbplancache_invalidate(void)
+{
+	planCacheGeneration++;
+	if (planCacheGeneration == 0)
+		planCacheGeneration = 1;
+}
+
+static void
+cdbplancache_relcache_callback(Datum arg, Oid relid)
+{
+	cdbplancache_invalidate();
+}
+
+static void
+cdbplancache_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	cdbplancache_invalidate();
+}
+
+static void
+cdbplancache_xact_callback(XactEvent event, void *arg)
+{
+	if (event == XACT_EVENT_ABORT)
+		cdbplancache_invalidate();
+}
+
+static void
+cdbplancache_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
+							  SubTransactionId parentSubid, void *arg)
+{
+	if (event == SUBXACT_EVENT_ABORT_SUB)
+		cdbplancache_invalidate();
+}
+
+/*
+ * Get the id of a serialized plan about to be dispatched.  The hash of the
+ * plan only picks its slot: the plan keeps the id of the slot's last plan if
+ * it is the same, byte for byte, and gets a new id otherwise.  The id of a
+ * plan is a multiple of CDB_PLAN_CACHE_SLOTS plus its slot, so it maps to the
+ * same slot in the QEs.
+ *
+ * Returns 0 if the plan should not be cached.
+ */
+uint64
+cdbplancache_plan_id(const char *splan, int splan_len,
+					 int splan_len_uncompressed)
+{
+	CdbPlanCacheKey *key;
+	uint32		slot;
+
+	if (!gp_enable_qe_plan_cache ||
+		splan_len_uncompressed > CDB_PLAN_CACHE_MAX_PLAN_SIZE)
+		return 0;
+
+	if (!planCacheCallbacksRegistered)
+	{
+		CacheRegisterRelcacheCallback(cdbplancache_relcache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PROCOID, cdbplancache_syscache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(TYPEOID, cdbplancache_syscache_callback, (Datum) 0);
+		RegisterXactCallback(cdbplancache_xact_callback, NULL);
+		RegisterSubXactCallback(cdbplancache_subxact_callback, NULL);
+		planCacheCallbacksRegistered = true;
+	}
+
+	slot = hash_bytes((const unsigned char *) splan, splan_len) %
+		CDB_PLAN_CACHE_SLOTS;
+	key = &planCacheKeys[slot];
+
+	if (key->planId != 0 &&
+		key->splan_len == splan_len &&
+		key->splan_len_uncompressed == splan_len_uncompressed &&
+		memcmp(key->splan, splan, splan_len) == 0)
+		return key->planId;
+
+	/* The slot's plan gets replaced */
+	key->planId = 0;
+	if (key->splan)
+	{
+		pfree(key->splan);
+		key->splan = NULL;
+	}
+	key->splan = MemoryContextAlloc(TopMemoryContext, splan_len);
+	memcpy(key->splan, splan, splan_len);
+	key->splan_len = splan_len;
+	key->splan_len_uncompressed = splan_len_uncompressed;
+
+	/* Never 0, which means "no cached plan" in the dispatch message */
+	key->planId = ++planCacheLastSeq * CDB_PLAN_CACHE_SLOTS + slot;
+
+	return key->planId;
+}
+
+/*
+ * Does the QE behind 'segdbDesc' hold the plan with the given id?
+ */
+bool
+cdbplancache_qe_has_plan(SegmentDatabaseDescriptor *segdbDesc, uint64 planId)
+{
+	Assert(planId != 0);
+
+	if (segdbDesc->cachedPlansGeneration != planCacheGeneration)
+		return false;
+
+	return segdbDesc->cachedPlans[planId % CDB_PLAN_CACHE_SLOTS] == planId;
+}
+
+/*
+ * Remember that the plan with the given id was shipped in full to the QE
+ * behind 'segdbDesc', which will keep it.
+ */
+void
+cdbplancache_qe_add_plan(SegmentDatabaseDescriptor *segdbDesc, uint64 planId)
+{
+	Assert(planId != 0);
+
+	if (segdbDesc->cachedPlansGeneration != planCacheGeneration)
+	{
+		cdbplancache_qe_reset(segdbDesc);
+		segdbDesc->cachedPlansGeneration = planCacheGeneration;
+	}
+
+	segdbDesc->cachedPlans[planId % CDB_PLAN_CACHE_SLOTS] = planId;
+}
+
+/*
+ * Forget all the plans held by the QE behind 'segdbDesc'. Called when
+ * connecting to a new QE.
+ */
+void
+cdbplancache_qe_reset(SegmentDatabaseDescriptor *segdbDesc)
+{
+	MemSet(segdbDesc->cachedPlans, 0, sizeof(segdbDesc->cachedPlans));
+	segdbDesc->cachedPlansGeneration = 0;
+}
+
+/*
+ * QE: keep a copy of a plan received in full, replacing whatever was in its
+ * slot.
+ */
+void
+cdbplancache_store(uint64 planId, PlannedStmt *plan)
+{
+	CdbPlanCacheEntry *entry = &planCache[planId % CDB_PLAN_CACHE_SLOTS];
+	MemoryContext oldcontext;
+
+	Assert(planId != 0);
+
+	if (entry->context == NULL)
+		entry->context = AllocSetContextCreate(TopMemoryContext,
+											   "QE plan cache entry",
+											   ALLOCSET_SMALL_SIZES);
+	else
+		MemoryContextReset(entry->context);
+	entry->planId = 0;
+	entry->plan = NULL;
+
+	oldcontext = MemoryContextSwitchTo(entry->context);
+	entry->plan = copyObject(plan);
+	MemoryContextSwitchTo(oldcontext);
+
+	entry->planId = planId;
+}
+
+/*
+ * QE: get a copy of a cached plan, in the current memory context.
+ *
+ * Returns NULL if the plan is not cached, which means that the QD and the
+ * QE disagree on the contents of the cache.
+ */
+PlannedStmt *
+cdbplancache_fetch(uint64 planId)
+{
+	CdbPlanCacheEntry *entry = &planCache[planId % CDB_PLAN_CACHE_SLOTS];
+
+	if (entry->planId != planId)
+		return NULL;
+
+	return copyObject(entry->plan);
+}
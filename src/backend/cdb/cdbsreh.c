@@ -385,6 +385,31 @@ ErrorIfRejectLimitReached(CdbSreh *cdbsreh)
 	}
 }
 
+/*
+ * Reports error if the rows rejected by all the segments together reached
+ * the reject limit.  Each QE only checks its own share of the input, which
+ * is not enough when the QD spread the lines over the segments without
+ * looking at them (see CopyFromThroughStage()).
+ */
+void
+ErrorIfTotalRejectLimitReached(CdbSreh *cdbsreh, uint64 total_rejected,
+							   uint64 total_processed)
+{
+	bool		reached = false;
+
+	if (cdbsreh->is_limit_in_rows)
+		reached = (total_rejected >= cdbsreh->rejectlimit);
+	else if (total_processed > gp_reject_percent_threshold)
+		reached = ((total_rejected * 100) / total_processed >= cdbsreh->rejectlimit);
+
+	if (reached)
+		ereport(ERROR,
+				(errcode(ERRCODE_T_R_GP_REJECT_LIMIT_REACHED),
+				 errmsg("segment reject limit reached, aborting operation"),
+				 errdetail("The segments rejected " UINT64_FORMAT " of " UINT64_FORMAT " input rows in total.",
+						   total_rejected, total_processed)));
+}
+
 /*
  * Return true if the first bad rows exceed the hard limit.  We assume the
  * input is not well configured or similar case.  Stop the work regardless of
@@ -273,6 +273,7 @@ bool		gp_enable_runtime_filter = false;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
+bool		gp_hashjoin_role_reversal = true;
 
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
@@ -295,6 +296,9 @@ int			gp_segworker_relative_priority = PRIO_MAX;
 /* Max size of dispatched plans; 0 if no limit */
 int			gp_max_plan_size = 0;
 
+/* Let QEs cache dispatched plans, and dispatch only their hash */
+bool		gp_enable_qe_plan_cache = true;
+
 /* Disable setting of tuple hints while reading */
 bool		gp_disable_tuple_hints = false;
 
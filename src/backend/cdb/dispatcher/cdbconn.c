@@ -281,6 +281,9 @@ cdbconn_doConnectStart(SegmentDatabaseDescriptor *segdbDesc,
 	Assert(nkeywords < MAX_KEYWORDS);
 
 	segdbDesc->conn = PQconnectStartParams(keywords, values, false);
+
+	/* A new QE has no cached plans */
+	cdbplancache_qe_reset(segdbDesc);
 	return;
 }
 
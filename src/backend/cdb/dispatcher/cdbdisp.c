@@ -330,6 +330,9 @@ cdbdisp_makeDispatcherState(bool isExtendedQuery)
 	handle->dispatcherState->largestGangSize = 0;
 	handle->dispatcherState->rootGangSize = 0;
 	handle->dispatcherState->destroyIdleReaderGang = false;
+	handle->dispatcherState->planId = 0;
+	handle->dispatcherState->cachedPlanQueryText = NULL;
+	handle->dispatcherState->cachedPlanQueryTextLen = 0;
 
 	return handle->dispatcherState;
 }
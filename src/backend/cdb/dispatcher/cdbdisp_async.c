@@ -39,6 +39,7 @@
 #include "cdb/cdbfts.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdbvars.h"
+#include "cdb/cdbplancache.h"
 #include "cdb/cdbpq.h"
 #include "miscadmin.h"
 #include "commands/sequence.h"
@@ -330,7 +331,15 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 		}
 		pParms->dispatchResultPtrArray[pParms->dispatchCount++] = qeResult;
 
-		dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
+		/* Send only the plan id to the QEs that have the plan cached */
+		if (ds->planId != 0 && cdbplancache_qe_has_plan(segdbDesc, ds->planId))
+			dispatchCommand(qeResult, ds->cachedPlanQueryText, ds->cachedPlanQueryTextLen);
+		else
+		{
+			dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
+			if (ds->planId != 0)
+				cdbplancache_qe_add_plan(segdbDesc, ds->planId);
+		}
 	}
 }
 
@@ -24,6 +24,7 @@
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbmutate.h"
+#include "cdb/cdbplancache.h"
 #include "cdb/cdbsrlz.h"
 #include "cdb/tupleremap.h"
 #include "catalog/namespace.h" /* for GetTempNamespaceState() */
@@ -87,6 +88,12 @@ typedef struct DispatchCommandQueryParms
 	char	   *serializedQueryDispatchDesc;
 	int			serializedQueryDispatchDesclen;
 
+	/*
+	 * Id of the plan in the QEs' plan cache, or 0 if the plan is
+	 * not to be cached. Sent with or instead of serializedPlantree.
+	 */
+	uint64		planId;
+
 	/*
 	 * Additional information.
 	 */
@@ -669,6 +676,8 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->serializedPlantreelen = splan_len;
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
 	pQueryParms->serializedQueryDispatchDesclen = sddesc_len;
+	pQueryParms->planId = cdbplancache_plan_id(splan, splan_len,
+											   splan_len_uncompressed);
 
 	/*
 	 * Serialize a version of our snapshot, and generate our transction
@@ -861,6 +870,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	int			command_len;
 	const char *plantree = pQueryParms->serializedPlantree;
 	int			plantree_len = pQueryParms->serializedPlantreelen;
+	uint64		planId = pQueryParms->planId;
 	const char *sddesc = pQueryParms->serializedQueryDispatchDesc;
 	int			sddesc_len = pQueryParms->serializedQueryDispatchDesclen;
 	const char *dtxContextInfo = pQueryParms->serializedDtxContextInfo;
@@ -888,7 +898,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	oldContext = MemoryContextSwitchTo(DispatcherContext);
 
 	/*
-	 * If plantree is set then the query string is not so
+	 * If plantree is set (or cached) then the query string is not so
 	 * important, dispatch a truncated version to increase the performance.
 	 *
 	 * Here we only need to determine the truncated size, the actual work is
@@ -898,7 +908,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	 * character.
 	 */
 	command_len = strlen(command) + 1;
-	if (plantree && command_len > QUERY_STRING_TRUNCATE_SIZE)
+	if ((plantree || planId != 0) && command_len > QUERY_STRING_TRUNCATE_SIZE)
 		command_len = pg_mbcliplen(command, command_len,
 								   QUERY_STRING_TRUNCATE_SIZE-1) + 1;
 
@@ -915,6 +925,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 		sizeof(n32) * 2 /* currentStatementStartTimestamp */ +
 		sizeof(command_len) +
 		sizeof(plantree_len) +
+		sizeof(n32) * 2 /* planId */ +
 		sizeof(sddesc_len) +
 		sizeof(dtxContextInfo_len) +
 		dtxContextInfo_len +
@@ -976,6 +987,14 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	memcpy(pos, &tmp, sizeof(plantree_len));
 	pos += sizeof(plantree_len);
 
+	/* planId, high order half first */
+	n32 = htonl((uint32) (planId >> 32));
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+	n32 = htonl((uint32) planId);
+	memcpy(pos, &n32, sizeof(n32));
+	pos += sizeof(n32);
+
 	tmp = htonl(sddesc_len);
 	memcpy(pos, &tmp, sizeof(tmp));
 	pos += sizeof(tmp);
@@ -1105,6 +1124,20 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	pQueryParms = cdbdisp_buildPlanQueryParms(queryDesc, planRequiresTxn);
 	queryText = buildGpQueryString(pQueryParms, &queryTextLength);
 
+	/*
+	 * If the plan can be cached in the QEs, also build the message for the
+	 * QEs that already hold it: the same, without the plan itself.
+	 */
+	if (pQueryParms->planId != 0)
+	{
+		pQueryParms->serializedPlantree = NULL;
+		pQueryParms->serializedPlantreelen = 0;
+
+		ds->planId = pQueryParms->planId;
+		ds->cachedPlanQueryText = buildGpQueryString(pQueryParms,
+													 &ds->cachedPlanQueryTextLen);
+	}
+
 	/*
 	 * Allocate result array with enough slots for QEs of primary gangs.
 	 */
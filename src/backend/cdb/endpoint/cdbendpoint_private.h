@@ -53,4 +53,14 @@ extern void endpoint_token_str2arr(const char *tokenStr, int8 *token);
 extern void endpoint_token_arr2str(const int8 *token, char *tokenStr);
 extern char *state_enum_to_string(EndpointState state);
 
+/* Arrow IPC stream encoding in "cdbendpointarrow.c" */
+typedef struct ArrowBuilder ArrowBuilder;
+
+extern ArrowBuilder *arrow_builder_create(TupleDesc tupdesc);
+extern void arrow_builder_free(ArrowBuilder *builder);
+extern bool arrow_builder_append(ArrowBuilder *builder, TupleTableSlot *slot);
+extern bytea *arrow_schema_message(ArrowBuilder *builder);
+extern bytea *arrow_batch_message(ArrowBuilder *builder);
+extern bytea *arrow_eos_message(void);
+
 #endif							/* CDBENDPOINTINTERNAL_H */
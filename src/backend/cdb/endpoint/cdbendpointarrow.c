@@ -0,0 +1,904 @@
+/*-------------------------------------------------------------------------
+ * cdbendpointarrow.c
+ *
+ * Encode the results of a RETRIEVE statement in the Apache Arrow IPC
+ * streaming format, for RETRIEVE ... WITH (FORMAT arrow).
+ *
+ * An Arrow stream is a sequence of encapsulated messages. Each one is a
+ * Flatbuffers encoded Message, followed by a body holding the column
+ * buffers. The first message carries the Schema, every following one a
+ * RecordBatch of rows, and the stream ends with an end-of-stream marker.
+ * Every message is returned to the client as a bytea row of the RETRIEVE
+ * result, so a client that concatenates the rows, fetched in binary format,
+ * has a stream that any Arrow reader can open. The column buffers are laid
+ * out the way Arrow keeps them in memory, so the reader can use them in
+ * place instead of parsing text values row by row.
+ *
+ * There is no dependency on the Arrow or Flatbuffers libraries: the few
+ * Flatbuffers tables Arrow needs are built by hand here. See Message.fbs and
+ * Schema.fbs in the Arrow sources for their definitions.
+ *
+ * Copyright (c) 2020-Present VMware, Inc. or its affiliates
+ *
+ * IDENTIFICATION
+ *		src/backend/cdb/endpoint/cdbendpointarrow.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/detoast.h"
+#include "catalog/pg_type.h"
+#include "common/int.h"
+#include "datatype/timestamp.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
+#include "utils/date.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/timestamp.h"
+#include "cdbendpoint_private.h"
+
+/*
+ * A batch is sent once it holds this many rows, or this many bytes of
+ * values, whichever comes first.
+ */
+#define ARROW_BATCH_MAX_ROWS		65536
+#define ARROW_BATCH_MAX_BYTES		(8 * 1024 * 1024)
+
+/* Every message and body buffer is padded to a multiple of this */
+#define ARROW_ALIGN					8
+
+#define ARROW_CONTINUATION			0xFFFFFFFF
+
+/* Message.fbs: MetadataVersion and the MessageHeader union */
+#define ARROW_METADATA_V5			4
+#define ARROW_HEADER_SCHEMA			1
+#define ARROW_HEADER_RECORDBATCH	3
+
+/* Schema.fbs: the Type union */
+#define ARROW_TYPE_INT				2
+#define ARROW_TYPE_FLOATINGPOINT	3
+#define ARROW_TYPE_BINARY			4
+#define ARROW_TYPE_UTF8				5
+#define ARROW_TYPE_BOOL				6
+#define ARROW_TYPE_DATE				8
+#define ARROW_TYPE_TIME				9
+#define ARROW_TYPE_TIMESTAMP		10
+
+/* Schema.fbs: Precision, DateUnit, TimeUnit and Endianness */
+#define ARROW_PRECISION_SINGLE		1
+#define ARROW_PRECISION_DOUBLE		2
+#define ARROW_DATEUNIT_DAY			0
+#define ARROW_TIMEUNIT_MICROSECOND	2
+#ifdef WORDS_BIGENDIAN
+#define ARROW_ENDIANNESS			1
+#else
+#define ARROW_ENDIANNESS			0
+#endif
+
+/* Days and microseconds between the Unix epoch and the Postgres epoch */
+#define ARROW_EPOCH_DAYS	(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE)
+#define ARROW_EPOCH_USECS	(ARROW_EPOCH_DAYS * USECS_PER_DAY)
+
+/* The most fields of the tables built here, that of Field */
+#define FB_MAX_FIELDS				6
+
+/*
+ * A field of a Flatbuffers table. A size of 0 leaves the field out, the
+ * others are the size of the scalar, or 4 for an offset to be set with
+ * fb_set_offset() once the object it points to has been written.
+ */
+typedef struct FbField
+{
+	int			size;
+	int64		value;
+} FbField;
+
+/* A column of the batch being built */
+typedef struct ArrowColumn
+{
+	Oid			typid;			/* base type of the attribute */
+	int			arrowtype;		/* ARROW_TYPE_* */
+	int			bitwidth;		/* bits per value of fixed-width types */
+	bool		useoutput;		/* Utf8 made by the type output function */
+	FmgrInfo	outfunc;
+
+	int64		nullcount;
+	StringInfoData validity;	/* one bit per row, set if not null */
+	StringInfoData offsets;		/* Binary and Utf8 only, int32 per row + 1 */
+	StringInfoData values;
+} ArrowColumn;
+
+struct ArrowBuilder
+{
+	TupleDesc	tupdesc;
+	ArrowColumn *columns;
+	int64		nrows;			/* rows in the current batch */
+	Size		nbytes;			/* bytes of values in the current batch */
+	bool		toutf8;			/* is the server encoding other than UTF8? */
+	MemoryContext context;		/* holds the builder and its buffers */
+	MemoryContext rowcontext;	/* reset after every row */
+};
+
+static void fb_pad(StringInfo buf, int align);
+static void fb_store(StringInfo buf, int pos, uint64 value, int size);
+static void fb_append(StringInfo buf, uint64 value, int size);
+static int	fb_table(StringInfo buf, int nfields, const FbField *fields, int *fieldpos);
+static void fb_set_offset(StringInfo buf, int fieldpos, int target);
+static int	fb_vector(StringInfo buf, int nelems, int elemsize);
+static int	fb_string(StringInfo buf, const char *str, int len);
+static int	arrow_message_table(StringInfo meta, int headertype, int *bodylengthpos);
+static int	arrow_type_table(StringInfo meta, ArrowColumn *col);
+static bytea *arrow_begin_message(StringInfo msg, StringInfo meta);
+static bytea *arrow_end_message(StringInfo msg);
+static void arrow_reset_column(ArrowColumn *col);
+static void arrow_append_bit(StringInfo buf, int64 row, bool value);
+static void arrow_append_value(ArrowBuilder *builder, ArrowColumn *col,
+							   Datum value, bool isnull);
+static void arrow_append_bytes(ArrowBuilder *builder, ArrowColumn *col,
+							   const char *data, int len);
+static Size arrow_append_buffer(StringInfo body, StringInfo buffer);
+
+/*
+ * arrow_builder_create - Create a builder for the rows of the given
+ * descriptor, in a memory context of its own under TopMemoryContext, so
+ * that a stream can go on over several RETRIEVE statements.
+ */
+ArrowBuilder *
+arrow_builder_create(TupleDesc tupdesc)
+{
+	MemoryContext context;
+	MemoryContext oldcontext;
+	ArrowBuilder *builder;
+	int			i;
+
+	context = AllocSetContextCreate(TopMemoryContext,
+									"Arrow batch builder",
+									ALLOCSET_DEFAULT_SIZES);
+	oldcontext = MemoryContextSwitchTo(context);
+
+	builder = palloc0(sizeof(ArrowBuilder));
+	builder->tupdesc = CreateTupleDescCopy(tupdesc);
+	builder->columns = palloc0(tupdesc->natts * sizeof(ArrowColumn));
+	builder->toutf8 = (GetDatabaseEncoding() != PG_UTF8);
+	builder->context = context;
+	builder->rowcontext = AllocSetContextCreate(context,
+												"Arrow batch builder row",
+												ALLOCSET_DEFAULT_SIZES);
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		ArrowColumn *col = &builder->columns[i];
+		Oid			typoutput;
+		bool		typisvarlena;
+
+		col->typid = getBaseType(TupleDescAttr(tupdesc, i)->atttypid);
+
+		switch (col->typid)
+		{
+			case BOOLOID:
+				col->arrowtype = ARROW_TYPE_BOOL;
+				break;
+			case INT2OID:
+				col->arrowtype = ARROW_TYPE_INT;
+				col->bitwidth = 16;
+				break;
+			case INT4OID:
+				col->arrowtype = ARROW_TYPE_INT;
+				col->bitwidth = 32;
+				break;
+			case INT8OID:
+				col->arrowtype = ARROW_TYPE_INT;
+				col->bitwidth = 64;
+				break;
+			case FLOAT4OID:
+				col->arrowtype = ARROW_TYPE_FLOATINGPOINT;
+				col->bitwidth = 32;
+				break;
+			case FLOAT8OID:
+				col->arrowtype = ARROW_TYPE_FLOATINGPOINT;
+				col->bitwidth = 64;
+				break;
+			case DATEOID:
+				col->arrowtype = ARROW_TYPE_DATE;
+				col->bitwidth = 32;
+				break;
+			case TIMEOID:
+				col->arrowtype = ARROW_TYPE_TIME;
+				col->bitwidth = 64;
+				break;
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				col->arrowtype = ARROW_TYPE_TIMESTAMP;
+				col->bitwidth = 64;
+				break;
+			case BYTEAOID:
+				col->arrowtype = ARROW_TYPE_BINARY;
+				break;
+			case TEXTOID:
+			case VARCHAROID:
+			case BPCHAROID:
+				col->arrowtype = ARROW_TYPE_UTF8;
+				break;
+			default:
+				/* everything else is sent as its text representation */
+				col->arrowtype = ARROW_TYPE_UTF8;
+				col->useoutput = true;
+				getTypeOutputInfo(col->typid, &typoutput, &typisvarlena);
+				fmgr_info(typoutput, &col->outfunc);
+				break;
+		}
+
+		initStringInfo(&col->validity);
+		initStringInfo(&col->values);
+		if (col->arrowtype == ARROW_TYPE_BINARY ||
+			col->arrowtype == ARROW_TYPE_UTF8)
+			initStringInfo(&col->offsets);
+		arrow_reset_column(col);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return builder;
+}
+
+/*
+ * arrow_builder_free - Release a builder and all of its buffers.
+ */
+void
+arrow_builder_free(ArrowBuilder *builder)
+{
+	MemoryContextDelete(builder->context);
+}
+
+/*
+ * arrow_schema_message - Build the Schema message, the first of the stream.
+ */
+bytea *
+arrow_schema_message(ArrowBuilder *builder)
+{
+	TupleDesc	tupdesc = builder->tupdesc;
+	StringInfoData meta;
+	StringInfoData msg;
+	FbField		fields[FB_MAX_FIELDS];
+	int			fieldpos[FB_MAX_FIELDS];
+	int			headerpos;
+	int			schemapos;
+	int			vectorpos;
+	int			i;
+
+	initStringInfo(&meta);
+	headerpos = arrow_message_table(&meta, ARROW_HEADER_SCHEMA, NULL);
+
+	/* Schema: endianness, fields */
+	memset(fields, 0, sizeof(fields));
+	fields[0] = (FbField) {2, ARROW_ENDIANNESS};
+	fields[1] = (FbField) {4, 0};
+	schemapos = fb_table(&meta, 2, fields, fieldpos);
+	fb_set_offset(&meta, headerpos, schemapos);
+
+	vectorpos = fb_vector(&meta, tupdesc->natts, 4);
+	fb_set_offset(&meta, fieldpos[1], vectorpos);
+
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		ArrowColumn *col = &builder->columns[i];
+		const char *name = NameStr(TupleDescAttr(tupdesc, i)->attname);
+		int			namelen = strlen(name);
+		int			pos;
+
+		/* Field: name, nullable, type_type, type, dictionary, children */
+		memset(fields, 0, sizeof(fields));
+		fields[0] = (FbField) {4, 0};
+		fields[1] = (FbField) {1, true};
+		fields[2] = (FbField) {1, col->arrowtype};
+		fields[3] = (FbField) {4, 0};
+		fields[5] = (FbField) {4, 0};
+		pos = fb_table(&meta, 6, fields, fieldpos);
+		fb_set_offset(&meta, vectorpos + 4 + i * 4, pos);
+
+		if (builder->toutf8)
+		{
+			name = pg_server_to_any(name, namelen, PG_UTF8);
+			namelen = strlen(name);
+		}
+		fb_set_offset(&meta, fieldpos[0], fb_string(&meta, name, namelen));
+		fb_set_offset(&meta, fieldpos[3], arrow_type_table(&meta, col));
+		/* no children, but readers insist on the vector */
+		fb_set_offset(&meta, fieldpos[5], fb_vector(&meta, 0, 4));
+	}
+
+	arrow_begin_message(&msg, &meta);
+	pfree(meta.data);
+
+	return arrow_end_message(&msg);
+}
+
+/*
+ * arrow_builder_append - Add the row in the slot to the current batch.
+ *
+ * Returns true once the batch is full, the caller is then expected to send
+ * it with arrow_batch_message().
+ */
+bool
+arrow_builder_append(ArrowBuilder *builder, TupleTableSlot *slot)
+{
+	MemoryContext oldcontext;
+	int			i;
+
+	slot_getallattrs(slot);
+
+	oldcontext = MemoryContextSwitchTo(builder->rowcontext);
+
+	for (i = 0; i < builder->tupdesc->natts; i++)
+	{
+		ArrowColumn *col = &builder->columns[i];
+		bool		isnull = slot->tts_isnull[i];
+
+		arrow_append_bit(&col->validity, builder->nrows, !isnull);
+		if (isnull)
+			col->nullcount++;
+		arrow_append_value(builder, col, slot->tts_values[i], isnull);
+	}
+	builder->nrows++;
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(builder->rowcontext);
+
+	return builder->nrows >= ARROW_BATCH_MAX_ROWS ||
+		builder->nbytes >= ARROW_BATCH_MAX_BYTES;
+}
+
+/*
+ * arrow_batch_message - Build a RecordBatch message of the rows added since
+ * the last one, and start a new batch.
+ *
+ * Returns NULL if there are no rows to send.
+ */
+bytea *
+arrow_batch_message(ArrowBuilder *builder)
+{
+	int			natts = builder->tupdesc->natts;
+	StringInfoData meta;
+	StringInfoData body;
+	StringInfoData msg;
+	FbField		fields[3];
+	int			fieldpos[3];
+	int			headerpos;
+	int			bodylengthpos;
+	int			batchpos;
+	int			nodespos;
+	int			bufferspos;
+	int			nbuffers;
+	Size		offset;
+	int			i;
+	int			j;
+
+	if (builder->nrows == 0)
+		return NULL;
+
+	/* Buffers: validity, offsets for Binary and Utf8, values */
+	nbuffers = 0;
+	for (i = 0; i < natts; i++)
+		nbuffers += (builder->columns[i].offsets.data != NULL) ? 3 : 2;
+
+	/* The body goes after the metadata, and its length is part of it */
+	initStringInfo(&body);
+	initStringInfo(&meta);
+	headerpos = arrow_message_table(&meta, ARROW_HEADER_RECORDBATCH,
+									&bodylengthpos);
+
+	/* RecordBatch: length, nodes, buffers */
+	fields[0] = (FbField) {8, builder->nrows};
+	fields[1] = (FbField) {4, 0};
+	fields[2] = (FbField) {4, 0};
+	batchpos = fb_table(&meta, 3, fields, fieldpos);
+	fb_set_offset(&meta, headerpos, batchpos);
+
+	/* FieldNode structs: length, null_count */
+	nodespos = fb_vector(&meta, natts, 16);
+	fb_set_offset(&meta, fieldpos[1], nodespos);
+	for (i = 0; i < natts; i++)
+	{
+		fb_store(&meta, nodespos + 4 + i * 16, builder->nrows, 8);
+		fb_store(&meta, nodespos + 4 + i * 16 + 8,
+				 builder->columns[i].nullcount, 8);
+	}
+
+	/* Buffer structs: offset, length */
+	bufferspos = fb_vector(&meta, nbuffers, 16);
+	fb_set_offset(&meta, fieldpos[2], bufferspos);
+	offset = 0;
+	j = 0;
+	for (i = 0; i < natts; i++)
+	{
+		ArrowColumn *col = &builder->columns[i];
+		StringInfo	buffers[3];
+		int			nbuf = 0;
+		int			k;
+
+		/* the validity bitmap may be left out if there are no nulls */
+		if (col->nullcount > 0)
+			buffers[nbuf++] = &col->validity;
+		else
+			buffers[nbuf++] = NULL;
+		if (col->offsets.data != NULL)
+			buffers[nbuf++] = &col->offsets;
+		buffers[nbuf++] = &col->values;
+
+		for (k = 0; k < nbuf; k++, j++)
+		{
+			Size		len = 0;
+
+			if (buffers[k] != NULL)
+				len = arrow_append_buffer(&body, buffers[k]);
+			fb_store(&meta, bufferspos + 4 + j * 16, offset, 8);
+			fb_store(&meta, bufferspos + 4 + j * 16 + 8, len, 8);
+			offset += TYPEALIGN(ARROW_ALIGN, len);
+		}
+	}
+	Assert(offset == body.len);
+
+	/* now that the body is known, fill in its length in the Message */
+	fb_store(&meta, bodylengthpos, body.len, 8);
+
+	arrow_begin_message(&msg, &meta);
+	appendBinaryStringInfo(&msg, body.data, body.len);
+	pfree(meta.data);
+	pfree(body.data);
+
+	/* start the next batch */
+	for (i = 0; i < natts; i++)
+		arrow_reset_column(&builder->columns[i]);
+	builder->nrows = 0;
+	builder->nbytes = 0;
+
+	return arrow_end_message(&msg);
+}
+
+/*
+ * arrow_eos_message - Build the end-of-stream marker, the last message of a
+ * stream.
+ */
+bytea *
+arrow_eos_message(void)
+{
+	StringInfoData msg;
+
+	initStringInfo(&msg);
+	appendStringInfoSpaces(&msg, VARHDRSZ);
+	fb_append(&msg, ARROW_CONTINUATION, 4);
+	fb_append(&msg, 0, 4);
+
+	return arrow_end_message(&msg);
+}
+
+/*
+ * Pad the buffer with zeros to a multiple of 'align'.
+ */
+static void
+fb_pad(StringInfo buf, int align)
+{
+	while (buf->len % align != 0)
+		appendStringInfoChar(buf, '\0');
+}
+
+/*
+ * Store a little-endian scalar at the given position of the buffer, the
+ * byte order of all Flatbuffers scalars.
+ */
+static void
+fb_store(StringInfo buf, int pos, uint64 value, int size)
+{
+	int			i;
+
+	Assert(pos + size <= buf->len);
+	for (i = 0; i < size; i++)
+	{
+		buf->data[pos + i] = (char) (value & 0xFF);
+		value >>= 8;
+	}
+}
+
+static void
+fb_append(StringInfo buf, uint64 value, int size)
+{
+	appendStringInfoSpaces(buf, size);
+	fb_store(buf, buf->len - size, value, size);
+}
+
+/*
+ * Write a table with its vtable, and return the position of the table.
+ *
+ * The buffer is written front to back, unlike the Flatbuffers builders do:
+ * the vtable goes right before its table, and the objects the table points
+ * to are written after it by the caller. The position of each field is
+ * returned in 'fieldpos', for fb_set_offset().
+ */
+static int
+fb_table(StringInfo buf, int nfields, const FbField *fields, int *fieldpos)
+{
+	uint16		fieldoff[FB_MAX_FIELDS] = {0};
+	int			tablesize = 4;	/* the soffset to the vtable */
+	int			align = 4;
+	int			vtablepos;
+	int			tablepos;
+	int			size;
+	int			i;
+
+	Assert(nfields <= FB_MAX_FIELDS);
+
+	/* lay out the fields the widest first, so that they are all aligned */
+	for (i = 0; i < nfields; i++)
+	{
+		if (fields[i].size == 8)
+		{
+			align = 8;
+			tablesize = 8;
+		}
+	}
+	for (size = 8; size >= 1; size /= 2)
+	{
+		for (i = 0; i < nfields; i++)
+		{
+			if (fields[i].size != size)
+				continue;
+			fieldoff[i] = tablesize;
+			tablesize += size;
+		}
+	}
+
+	/* the vtable: its size, the size of the table, the field offsets */
+	fb_pad(buf, 2);
+	vtablepos = buf->len;
+	fb_append(buf, 4 + 2 * nfields, 2);
+	fb_append(buf, tablesize, 2);
+	for (i = 0; i < nfields; i++)
+		fb_append(buf, fieldoff[i], 2);
+
+	fb_pad(buf, align);
+	tablepos = buf->len;
+	appendStringInfoSpaces(buf, tablesize);
+	memset(buf->data + tablepos, 0, tablesize);
+	fb_store(buf, tablepos, (uint32) (tablepos - vtablepos), 4);
+
+	for (i = 0; i < nfields; i++)
+	{
+		if (fields[i].size == 0)
+			continue;
+		fieldpos[i] = tablepos + fieldoff[i];
+		fb_store(buf, fieldpos[i], fields[i].value, fields[i].size);
+	}
+
+	return tablepos;
+}
+
+/*
+ * Point the offset field at 'fieldpos' to the object at 'target', which
+ * must come after it.
+ */
+static void
+fb_set_offset(StringInfo buf, int fieldpos, int target)
+{
+	Assert(target > fieldpos);
+	fb_store(buf, fieldpos, target - fieldpos, 4);
+}
+
+/*
+ * Write a vector of 'nelems' zeroed elements, and return its position. The
+ * elements start 4 bytes after that, past the length.
+ */
+static int
+fb_vector(StringInfo buf, int nelems, int elemsize)
+{
+	int			align = Max(elemsize, 4);
+	int			pos;
+
+	while ((buf->len + 4) % align != 0)
+		appendStringInfoChar(buf, '\0');
+	pos = buf->len;
+	fb_append(buf, nelems, 4);
+	appendStringInfoSpaces(buf, nelems * elemsize);
+	memset(buf->data + pos + 4, 0, nelems * elemsize);
+
+	return pos;
+}
+
+/*
+ * Write a string, and return its position.
+ */
+static int
+fb_string(StringInfo buf, const char *str, int len)
+{
+	int			pos;
+
+	fb_pad(buf, 4);
+	pos = buf->len;
+	fb_append(buf, len, 4);
+	appendBinaryStringInfo(buf, str, len);
+	appendStringInfoChar(buf, '\0');
+
+	return pos;
+}
+
+/*
+ * Start the Flatbuffers metadata of a message with the root offset and the
+ * Message table, and return the position of its header offset. The length
+ * of the body is left 0, its position is returned in 'bodylengthpos' for
+ * messages that have one.
+ */
+static int
+arrow_message_table(StringInfo meta, int headertype, int *bodylengthpos)
+{
+	FbField		fields[4];
+	int			fieldpos[4];
+	int			pos;
+
+	Assert(meta->len == 0);
+	fb_append(meta, 0, 4);
+
+	/* Message: version, header_type, header, bodyLength */
+	fields[0] = (FbField) {2, ARROW_METADATA_V5};
+	fields[1] = (FbField) {1, headertype};
+	fields[2] = (FbField) {4, 0};
+	fields[3] = (FbField) {8, 0};
+	pos = fb_table(meta, 4, fields, fieldpos);
+	fb_set_offset(meta, 0, pos);
+	if (bodylengthpos)
+		*bodylengthpos = fieldpos[3];
+
+	return fieldpos[2];
+}
+
+/*
+ * Write the table of the Type union member that describes the column, and
+ * return its position.
+ */
+static int
+arrow_type_table(StringInfo meta, ArrowColumn *col)
+{
+	FbField		fields[2];
+	int			fieldpos[2];
+	int			pos;
+
+	memset(fields, 0, sizeof(fields));
+	switch (col->arrowtype)
+	{
+		case ARROW_TYPE_INT:
+			/* Int: bitWidth, is_signed */
+			fields[0] = (FbField) {4, col->bitwidth};
+			fields[1] = (FbField) {1, true};
+			return fb_table(meta, 2, fields, fieldpos);
+
+		case ARROW_TYPE_FLOATINGPOINT:
+			/* FloatingPoint: precision */
+			fields[0] = (FbField) {2, col->bitwidth == 32 ?
+				ARROW_PRECISION_SINGLE : ARROW_PRECISION_DOUBLE};
+			return fb_table(meta, 1, fields, fieldpos);
+
+		case ARROW_TYPE_DATE:
+			/* Date: unit */
+			fields[0] = (FbField) {2, ARROW_DATEUNIT_DAY};
+			return fb_table(meta, 1, fields, fieldpos);
+
+		case ARROW_TYPE_TIME:
+			/* Time: unit, bitWidth */
+			fields[0] = (FbField) {2, ARROW_TIMEUNIT_MICROSECOND};
+			fields[1] = (FbField) {4, col->bitwidth};
+			return fb_table(meta, 2, fields, fieldpos);
+
+		case ARROW_TYPE_TIMESTAMP:
+			/* Timestamp: unit, timezone, the values of timestamptz are UTC */
+			fields[0] = (FbField) {2, ARROW_TIMEUNIT_MICROSECOND};
+			if (col->typid == TIMESTAMPTZOID)
+				fields[1] = (FbField) {4, 0};
+			pos = fb_table(meta, 2, fields, fieldpos);
+			if (col->typid == TIMESTAMPTZOID)
+				fb_set_offset(meta, fieldpos[1], fb_string(meta, "UTC", 3));
+			return pos;
+
+		default:
+			/* Bool, Binary and Utf8 have no fields */
+			return fb_table(meta, 0, fields, fieldpos);
+	}
+}
+
+/*
+ * Start a message in 'msg', a bytea with the continuation marker, the
+ * length of the metadata and the metadata, padded so that the body that
+ * follows is aligned.
+ */
+static bytea *
+arrow_begin_message(StringInfo msg, StringInfo meta)
+{
+	int			metalen = TYPEALIGN(ARROW_ALIGN, meta->len);
+
+	initStringInfo(msg);
+	appendStringInfoSpaces(msg, VARHDRSZ);
+	fb_append(msg, ARROW_CONTINUATION, 4);
+	fb_append(msg, metalen, 4);
+	appendBinaryStringInfo(msg, meta->data, meta->len);
+	appendStringInfoSpaces(msg, metalen - meta->len);
+	memset(msg->data + msg->len - (metalen - meta->len), 0, metalen - meta->len);
+
+	return (bytea *) msg->data;
+}
+
+/*
+ * Finish a message started with arrow_begin_message().
+ */
+static bytea *
+arrow_end_message(StringInfo msg)
+{
+	bytea	   *result = (bytea *) msg->data;
+
+	Assert((msg->len - VARHDRSZ) % ARROW_ALIGN == 0);
+	SET_VARSIZE(result, msg->len);
+
+	return result;
+}
+
+/*
+ * Empty the buffers of a column, for a new batch.
+ */
+static void
+arrow_reset_column(ArrowColumn *col)
+{
+	col->nullcount = 0;
+	resetStringInfo(&col->validity);
+	resetStringInfo(&col->values);
+	if (col->offsets.data != NULL)
+	{
+		int32		start = 0;
+
+		resetStringInfo(&col->offsets);
+		appendBinaryStringInfo(&col->offsets, (char *) &start, sizeof(int32));
+	}
+}
+
+/*
+ * Append a bit to a bitmap of the current batch, the bits of a byte are
+ * used from the least significant one.
+ */
+static void
+arrow_append_bit(StringInfo buf, int64 row, bool value)
+{
+	if (row % 8 == 0)
+		appendStringInfoChar(buf, '\0');
+	if (value)
+		buf->data[buf->len - 1] |= (1 << (row % 8));
+}
+
+/*
+ * Append a value to the buffers of a column. A null takes the place of a
+ * zero in fixed-width columns, and no bytes in Binary and Utf8 columns.
+ */
+static void
+arrow_append_value(ArrowBuilder *builder, ArrowColumn *col, Datum value,
+				   bool isnull)
+{
+	StringInfo	values = &col->values;
+	int16		i16;
+	int32		i32;
+	int64		i64;
+	float4		f4;
+	float8		f8;
+
+	if (isnull)
+	{
+		if (col->arrowtype == ARROW_TYPE_BINARY ||
+			col->arrowtype == ARROW_TYPE_UTF8)
+			arrow_append_bytes(builder, col, NULL, 0);
+		else if (col->arrowtype == ARROW_TYPE_BOOL)
+			arrow_append_bit(values, builder->nrows, false);
+		else
+		{
+			appendStringInfoSpaces(values, col->bitwidth / 8);
+			memset(values->data + values->len - col->bitwidth / 8, 0,
+				   col->bitwidth / 8);
+		}
+		return;
+	}
+
+	switch (col->typid)
+	{
+		case BOOLOID:
+			arrow_append_bit(values, builder->nrows, DatumGetBool(value));
+			break;
+		case INT2OID:
+			i16 = DatumGetInt16(value);
+			appendBinaryStringInfo(values, (char *) &i16, sizeof(int16));
+			break;
+		case INT4OID:
+			i32 = DatumGetInt32(value);
+			appendBinaryStringInfo(values, (char *) &i32, sizeof(int32));
+			break;
+		case INT8OID:
+			i64 = DatumGetInt64(value);
+			appendBinaryStringInfo(values, (char *) &i64, sizeof(int64));
+			break;
+		case FLOAT4OID:
+			f4 = DatumGetFloat4(value);
+			appendBinaryStringInfo(values, (char *) &f4, sizeof(float4));
+			break;
+		case FLOAT8OID:
+			f8 = DatumGetFloat8(value);
+			appendBinaryStringInfo(values, (char *) &f8, sizeof(float8));
+			break;
+		case DATEOID:
+			i32 = DatumGetDateADT(value);
+			/* -infinity and infinity stay at the ends of the range */
+			if (!DATE_NOT_FINITE(i32))
+				i32 += ARROW_EPOCH_DAYS;
+			appendBinaryStringInfo(values, (char *) &i32, sizeof(int32));
+			break;
+		case TIMEOID:
+			i64 = DatumGetTimeADT(value);
+			appendBinaryStringInfo(values, (char *) &i64, sizeof(int64));
+			break;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			i64 = DatumGetTimestamp(value);
+			/* The last 30 years of the range don't fit after the shift */
+			if (!TIMESTAMP_NOT_FINITE(i64) &&
+				pg_add_s64_overflow(i64, ARROW_EPOCH_USECS, &i64))
+				ereport(ERROR,
+						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+						 errmsg("timestamp out of range")));
+			appendBinaryStringInfo(values, (char *) &i64, sizeof(int64));
+			break;
+		default:
+			if (col->useoutput)
+			{
+				char	   *str = OutputFunctionCall(&col->outfunc, value);
+
+				arrow_append_bytes(builder, col, str, strlen(str));
+			}
+			else
+			{
+				struct varlena *v = pg_detoast_datum_packed((struct varlena *) DatumGetPointer(value));
+
+				arrow_append_bytes(builder, col, VARDATA_ANY(v), VARSIZE_ANY_EXHDR(v));
+			}
+			break;
+	}
+}
+
+/*
+ * Append a value to a Binary or Utf8 column, and the offset of its end.
+ */
+static void
+arrow_append_bytes(ArrowBuilder *builder, ArrowColumn *col,
+				   const char *data, int len)
+{
+	int32		end;
+
+	if (len > 0 && builder->toutf8 && col->arrowtype == ARROW_TYPE_UTF8)
+	{
+		data = pg_server_to_any(data, len, PG_UTF8);
+		len = strlen(data);
+	}
+
+	if (len > 0)
+		appendBinaryStringInfo(&col->values, data, len);
+	end = col->values.len;
+	appendBinaryStringInfo(&col->offsets, (char *) &end, sizeof(int32));
+	builder->nbytes += len;
+}
+
+/*
+ * Append a column buffer to the body of a RecordBatch, padded, and return
+ * its length without the padding.
+ */
+static Size
+arrow_append_buffer(StringInfo body, StringInfo buffer)
+{
+	appendBinaryStringInfo(body, buffer->data, buffer->len);
+	fb_pad(body, ARROW_ALIGN);
+
+	return buffer->len;
+}
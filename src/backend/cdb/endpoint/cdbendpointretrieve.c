@@ -33,6 +33,8 @@
 
 #include "access/session.h"
 #include "access/xact.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
 #include "common/hashfn.h"
 #include "storage/ipc.h"
 #include "utils/backend_cancel.h"
@@ -86,6 +88,18 @@ typedef struct RetrieveExecEntry
 	TupleQueueReader *tqReader;
 	/* Track retrieve state */
 	enum RetrieveState retrieveState;
+
+	/*
+	 * Set if the endpoint is retrieved WITH (FORMAT arrow), by the first
+	 * RETRIEVE statement. The builder is freed once the end-of-stream marker
+	 * has been sent.
+	 */
+	bool		arrow;
+	ArrowBuilder *arrowBuilder;
+	/* tuple slot used for the messages of the Arrow stream */
+	TupleTableSlot *arrowTs;
+	/* has the Schema message been sent? */
+	bool		arrowStarted;
 }			RetrieveExecEntry;
 
 /*
@@ -119,11 +133,15 @@ static RetrieveControl RetrieveCtl =
 
 static void init_retrieve_exec_entry(RetrieveExecEntry * entry);
 static Endpoint *get_endpoint_from_retrieve_exec_entry(RetrieveExecEntry *entry, bool noError);
-static void start_retrieve(const char *endpointName);
+static bool retrieve_in_arrow_format(const RetrieveStmt *stmt);
+static void start_retrieve(const char *endpointName, bool arrow);
 static void validate_retrieve_endpoint(Endpoint *endpointDesc, const char *endpointName);
 static void finish_retrieve(bool resetPID);
 static void attach_receiver_mq(dsm_handle dsmHandle);
 static void detach_receiver_mq(RetrieveExecEntry *entry);
+static void init_retrieve_arrow(RetrieveExecEntry *entry);
+static void send_arrow_message(RetrieveExecEntry *entry, DestReceiver *dest,
+							   bytea *msg);
 static void notify_sender(bool finished);
 static void retrieve_cancel_action(RetrieveExecEntry *entry, char *msg);
 static void retrieve_exit_callback(int code, Datum arg);
@@ -164,13 +182,18 @@ AuthEndpoint(Oid userID, const char *tokenStr)
  * GetRetrieveStmtTupleDesc - Gets TupleDesc for the given retrieve statement.
  *
  * This function calls start_retrieve() to initialize related data structure
- * and returns the tuple descriptor.
+ * and returns the tuple descriptor. In the Arrow format that is a single
+ * bytea column, for the messages of the stream.
  */
 TupleDesc
 GetRetrieveStmtTupleDesc(const RetrieveStmt * stmt)
 {
-	start_retrieve(stmt->endpoint_name);
+	bool		arrow = retrieve_in_arrow_format(stmt);
+
+	start_retrieve(stmt->endpoint_name, arrow);
 
+	if (arrow)
+		return RetrieveCtl.current_entry->arrowTs->tts_tupleDescriptor;
 	return RetrieveCtl.current_entry->retrieveTs->tts_tupleDescriptor;
 }
 
@@ -181,14 +204,20 @@ GetRetrieveStmtTupleDesc(const RetrieveStmt * stmt)
  * attached endpoint in this retrieve session. If the endpoint can be found,
  * then read from the message queue to feed the active portal's tuplestore. And
  * mark the endpoint as detached before returning.
+ *
+ * In the Arrow format, the tuples are packed into RecordBatch messages. The
+ * first RETRIEVE statement starts the stream with the Schema message, every
+ * one sends the batch it has started, full or not, and the one that reads the
+ * last tuple ends the stream. The count is that of tuples, not messages.
  */
 void
 ExecRetrieveStmt(const RetrieveStmt *stmt, DestReceiver *dest)
 {
 	TupleTableSlot *result = NULL;
+	RetrieveExecEntry *entry = RetrieveCtl.current_entry;
 	int64		retrieveCount = 0;
 
-	if (RetrieveCtl.current_entry == NULL)
+	if (entry == NULL)
 		ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR),
 						errmsg("endpoint %s is not attached",
 							   stmt->endpoint_name)));
@@ -201,20 +230,43 @@ ExecRetrieveStmt(const RetrieveStmt *stmt, DestReceiver *dest)
 							   retrieveCount)));
 
 	Assert(dest->mydest == DestTuplestore);
-	Assert(RetrieveCtl.current_entry->retrieveState > RETRIEVE_STATE_INIT);
+	Assert(entry->retrieveState > RETRIEVE_STATE_INIT);
 
-	if (RetrieveCtl.current_entry->retrieveState < RETRIEVE_STATE_FINISHED)
+	if (entry->retrieveState < RETRIEVE_STATE_FINISHED)
 	{
+		if (entry->arrow && !entry->arrowStarted)
+		{
+			send_arrow_message(entry, dest,
+							   arrow_schema_message(entry->arrowBuilder));
+			entry->arrowStarted = true;
+		}
+
 		while (stmt->is_all || retrieveCount > 0)
 		{
 			result = retrieve_next_tuple();
 			if (!result)
 				break;
 
-			(*dest->receiveSlot) (result, dest);
+			if (!entry->arrow)
+				(*dest->receiveSlot) (result, dest);
+			else if (arrow_builder_append(entry->arrowBuilder, result))
+				send_arrow_message(entry, dest,
+								   arrow_batch_message(entry->arrowBuilder));
 			if (!stmt->is_all)
 				retrieveCount--;
 		}
+
+		if (entry->arrow)
+		{
+			send_arrow_message(entry, dest,
+							   arrow_batch_message(entry->arrowBuilder));
+			if (entry->retrieveState == RETRIEVE_STATE_FINISHED)
+			{
+				send_arrow_message(entry, dest, arrow_eos_message());
+				arrow_builder_free(entry->arrowBuilder);
+				entry->arrowBuilder = NULL;
+			}
+		}
 	}
 	else
 	{
@@ -235,6 +287,10 @@ init_retrieve_exec_entry(RetrieveExecEntry * entry)
 	entry->mqHandle = NULL;
 	entry->retrieveTs = NULL;
 	entry->retrieveState = RETRIEVE_STATE_INIT;
+	entry->arrow = false;
+	entry->arrowBuilder = NULL;
+	entry->arrowTs = NULL;
+	entry->arrowStarted = false;
 }
 
 /*
@@ -278,6 +334,47 @@ get_endpoint_from_retrieve_exec_entry(RetrieveExecEntry * entry, bool noError)
 	return entry->endpoint;
 }
 
+/*
+ * retrieve_in_arrow_format - Check the options of a RETRIEVE statement, and
+ * return true if it asks for the Arrow format.
+ */
+static bool
+retrieve_in_arrow_format(const RetrieveStmt *stmt)
+{
+	bool		arrow = false;
+	bool		formatSpecified = false;
+	ListCell   *lc;
+
+	foreach(lc, stmt->options)
+	{
+		DefElem    *defel = lfirst_node(DefElem, lc);
+
+		if (strcmp(defel->defname, "format") == 0)
+		{
+			char	   *fmt = defGetString(defel);
+
+			if (formatSpecified)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options")));
+			formatSpecified = true;
+
+			if (strcmp(fmt, "arrow") == 0)
+				arrow = true;
+			else if (strcmp(fmt, "row") != 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("RETRIEVE format \"%s\" not recognized", fmt)));
+		}
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_SYNTAX_ERROR),
+					 errmsg("option \"%s\" not recognized", defel->defname)));
+	}
+
+	return arrow;
+}
+
 /*
  * Initialize a hashtable, its key is the endpoint's name, its value is
  * RetrieveExecEntry
@@ -311,7 +408,7 @@ void InitRetrieveCtl(void)
  * be called 2 times.
  */
 static void
-start_retrieve(const char *endpointName)
+start_retrieve(const char *endpointName, bool arrow)
 {
 	HTAB	   *entryHTB = RetrieveCtl.RetrieveExecEntryHTB;
 	RetrieveExecEntry *entry = NULL;
@@ -322,6 +419,14 @@ start_retrieve(const char *endpointName)
 
 	entry = hash_search(entryHTB, endpointName, HASH_FIND, &found);
 
+	/* The first RETRIEVE statement decides the format of the endpoint */
+	if (found && entry->arrow != arrow)
+		ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						errmsg("endpoint %s is retrieved in %s format",
+							   endpointName, entry->arrow ? "arrow" : "row"),
+						errhint("Use the same format for all the RETRIEVE "
+								"statements of an endpoint.")));
+
 	LWLockAcquire(ParallelCursorEndpointLock, LW_EXCLUSIVE);
 
 	if (found)
@@ -356,7 +461,11 @@ start_retrieve(const char *endpointName)
 	RetrieveCtl.current_entry = entry;
 
 	if (!found)
+	{
 		attach_receiver_mq(handle);
+		if (arrow)
+			init_retrieve_arrow(entry);
+	}
 
 	if (CurrentSession->segment != NULL &&
 		dsm_segment_handle(CurrentSession->segment) != endpoint->sessionDsmHandle)
@@ -502,6 +611,50 @@ detach_receiver_mq(RetrieveExecEntry * entry)
 	entry->mqSeg = NULL;
 }
 
+/*
+ * Set up an entry for the Arrow format, after attach_receiver_mq() has set
+ * the descriptor of the tuples.
+ */
+static void
+init_retrieve_arrow(RetrieveExecEntry *entry)
+{
+	MemoryContext oldcontext;
+	TupleDesc	td;
+
+	entry->arrow = true;
+	entry->arrowBuilder =
+		arrow_builder_create(entry->retrieveTs->tts_tupleDescriptor);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	td = CreateTemplateTupleDesc(1);
+	TupleDescInitEntry(td, (AttrNumber) 1, "arrow", BYTEAOID, -1, 0);
+	entry->arrowTs = MakeTupleTableSlot(td, &TTSOpsVirtual);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Send a message of the Arrow stream as a row, and free it. Nothing is sent
+ * for a NULL message, as arrow_batch_message() returns when there are no
+ * tuples for a batch.
+ */
+static void
+send_arrow_message(RetrieveExecEntry *entry, DestReceiver *dest, bytea *msg)
+{
+	TupleTableSlot *slot = entry->arrowTs;
+
+	if (msg == NULL)
+		return;
+
+	ExecClearTuple(slot);
+	slot->tts_values[0] = PointerGetDatum(msg);
+	slot->tts_isnull[0] = false;
+	ExecStoreVirtualTuple(slot);
+	(*dest->receiveSlot) (slot, dest);
+	ExecClearTuple(slot);
+
+	pfree(msg);
+}
+
 /*
  * Notify the sender to stop waiting on the ackDone latch.
  *
@@ -633,6 +786,8 @@ finish_retrieve(bool resetPID)
 		LWLockRelease(ParallelCursorEndpointLock);
 		elogif(gp_log_endpoints, LOG, "the Endpoint entry %s has already been cleaned, \
 			   remove from RetrieveCtl.RetrieveExecEntryHTB hash table", entry->endpointName);
+		if (entry->arrowBuilder)
+			arrow_builder_free(entry->arrowBuilder);
 		hash_search(RetrieveCtl.RetrieveExecEntryHTB, entry->endpointName, HASH_REMOVE, NULL);
 		RetrieveCtl.current_entry = NULL;
 		return;
@@ -932,6 +932,10 @@ make_new_heap_with_colname(Oid OIDOldHeap, Oid NewTableSpace, Oid NewAccessMetho
 		ReleaseSysCache(tuple);
 	}
 
+	/* Keep the block directory that holds the bloom filters, if any */
+	if (NewAccessMethod == AO_COLUMN_TABLE_AM_OID && !createAoBlockDirectory)
+		createAoBlockDirectory = RelationHasBloomFilterColumns(OldHeap);
+
 	if (IsAccessMethodAO(NewAccessMethod))
 		NewRelationCreateAOAuxTables(OIDNewHeap, createAoBlockDirectory);
 
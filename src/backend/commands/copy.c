@@ -51,6 +51,7 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/rls.h"
+#include "utils/ruleutils.h"
 #include "utils/snapmgr.h"
 
 #include "access/external.h"
@@ -68,6 +69,7 @@
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbvars.h"
 #include "commands/copyto_internal.h"
+#include "executor/spi.h"
 #include "commands/queue.h"
 #include "nodes/makefuncs.h"
 #include "postmaster/autostats.h"
@@ -78,6 +80,9 @@
 /* non-export function prototypes */
 static uint64 CopyDispatchOnSegment(const CopyStmt *stmt);
 static uint64 CopyToQueryOnSegment(CopyToState cstate);
+static bool CopyFromThroughStageAllowed(ParseState *pstate, Relation rel,
+										Node *whereClause, List *options);
+static uint64 CopyFromThroughStage(const CopyStmt *stmt, Relation rel);
 
 /* Low-level communications functions */
 static List *parse_joined_option_list(char *str, char *delimiter);
@@ -87,6 +92,10 @@ volatile CopyToState glob_cstate = NULL;
 /* GPDB_91_MERGE_FIXME: passing through a global variable like this is ugly */
 CopyStmt *glob_copystmt = NULL;
 
+/* table whose stage is being loaded, see CopyFromThroughStage() */
+static Oid	copy_stage_target = InvalidOid;
+static int	copy_stage_count = 0;
+
 /*
  *	 DoCopy executes the SQL COPY statement
  *
@@ -367,7 +376,11 @@ DoCopy(ParseState *pstate, const CopyStmt *stmt,
 		rel = NULL;
 	}
 
-	if (is_from)
+	if (is_from && CopyFromThroughStageAllowed(pstate, rel, whereClause, options))
+	{
+		*processed = CopyFromThroughStage(stmt, rel);
+	}
+	else if (is_from)
 	{
 		CopyFromState cstate;
 
@@ -417,6 +430,13 @@ DoCopy(ParseState *pstate, const CopyStmt *stmt,
 										  log_to_file);
 			if (rel)
 				cstate->cdbsreh->relid = RelationGetRelid(rel);
+
+			/* rows rejected by a stage are logged for the table it loads */
+			if (OidIsValid(cstate->opts.stage_for))
+			{
+				cstate->cdbsreh->relid = cstate->opts.stage_for;
+				cstate->cdbsreh->relname = get_rel_name(cstate->opts.stage_for);
+			}
 		}
 		else
 		{
@@ -527,8 +547,11 @@ DoCopy(ParseState *pstate, const CopyStmt *stmt,
 	if (rel != NULL)
 		table_close(rel, (is_from ? NoLock : AccessShareLock));
 
-	/* Issue automatic ANALYZE if conditions are satisfied (MPP-4082). */
-	if (Gp_role == GP_ROLE_DISPATCH && is_from)
+	/*
+	 * Issue automatic ANALYZE if conditions are satisfied (MPP-4082).  A
+	 * stage is dropped right away, only the table it loads is analyzed.
+	 */
+	if (Gp_role == GP_ROLE_DISPATCH && is_from && !OidIsValid(copy_stage_target))
 	{
 		bool inFunction = already_under_executor_run() || utility_nested();
 		auto_stats(AUTOSTATS_CMDTYPE_COPY, relid, *processed, inFunction);
@@ -823,6 +846,17 @@ ProcessCopyOptions(ParseState *pstate,
 								 parser_errposition(pstate, defel->location)));
 			opts_out->tags = defGetString(defel);
 		}
+		else if (strcmp(defel->defname, "stage_for") == 0 &&
+				 (Gp_role == GP_ROLE_EXECUTE || OidIsValid(copy_stage_target)))
+		{
+			/* internal option, see CopyFromThroughStage() */
+			if (OidIsValid(opts_out->stage_for))
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options"),
+						 parser_errposition(pstate, defel->location)));
+			opts_out->stage_for = atooid(defGetString(defel));
+		}
 		else if (!rel_is_external_table(rel_oid))
 			ereport(ERROR,
 					(errcode(ERRCODE_SYNTAX_ERROR),
@@ -1188,6 +1222,164 @@ CopyDispatchOnSegment(const CopyStmt *stmt)
 	return processed;
 }
 
+/*
+ * Can the segments parse the input of this COPY FROM, and route the rows
+ * among themselves?  See CopyFromThroughStage().
+ */
+static bool
+CopyFromThroughStageAllowed(ParseState *pstate, Relation rel,
+							Node *whereClause, List *options)
+{
+	CopyFormatOptions opts = {0};
+
+	if (!gp_copy_parse_on_segments || Gp_role != GP_ROLE_DISPATCH ||
+		OidIsValid(copy_stage_target))
+		return false;
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_PARTITIONED_TABLE)
+		return false;
+
+	/* INSERT would apply the rules that COPY ignores */
+	if (rel->rd_rules != NULL)
+		return false;
+
+	/* only a hash distribution needs the rows to be routed */
+	if (!GpPolicyIsHashPartitioned(rel->rd_cdbpolicy))
+		return false;
+
+	if (whereClause != NULL ||
+		CopyGetAttnums(RelationGetDescr(rel), rel, NIL) == NIL)
+		return false;
+
+	ProcessCopyOptions(pstate, &opts, true, options, RelationGetRelid(rel));
+
+	return !opts.binary && !opts.on_segment && !opts.freeze &&
+		!opts.skip_foreign_partitions;
+}
+
+/*
+ * Run a statement of CopyFromThroughStage() through SPI.
+ */
+static uint64
+ExecuteCopyStageQuery(const char *query, int expected)
+{
+	uint64		processed;
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+	if (SPI_execute(query, false, 0) != expected)
+		elog(ERROR, "SPI_exec failed: %s", query);
+	processed = SPI_processed;
+	if (SPI_finish() != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed");
+
+	return processed;
+}
+
+/*
+ * COPY FROM with gp_copy_parse_on_segments: the QD neither parses the rows
+ * nor computes their segments.
+ *
+ * The input is copied into a randomly distributed temporary stage holding
+ * the columns being copied, so the QD only cuts it into lines and deals them
+ * out to the segments in chunks.  The segments parse the lines, rejecting
+ * the bad ones, and an INSERT ... SELECT from the stage then hashes the rows
+ * and moves them from segment to segment.  The QEs of a COPY cannot send
+ * rows to each other, only the motions of a plan can.
+ */
+static uint64
+CopyFromThroughStage(const CopyStmt *stmt, Relation rel)
+{
+	TupleDesc	tupDesc = RelationGetDescr(rel);
+	List	   *attnums = CopyGetAttnums(tupDesc, rel, stmt->attlist);
+	char	   *stagename;
+	CopyStmt   *stageStmt;
+	ParseState *stagePstate;
+	StringInfoData columns;
+	StringInfoData coldefs;
+	StringInfoData query;
+	uint64		staged;
+	uint64		processed;
+	ListCell   *lc;
+
+	/* check read-only transaction and parallel mode */
+	if (XactReadOnly && !rel->rd_islocaltemp)
+		PreventCommandIfReadOnly("COPY FROM");
+
+	stagename = psprintf("gp_copy_stage_%u_%d", RelationGetRelid(rel),
+						 copy_stage_count++);
+
+	initStringInfo(&columns);
+	initStringInfo(&coldefs);
+	foreach(lc, attnums)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupDesc, lfirst_int(lc) - 1);
+		const char *attname = quote_identifier(NameStr(attr->attname));
+
+		if (columns.len > 0)
+		{
+			appendStringInfoString(&columns, ", ");
+			appendStringInfoString(&coldefs, ", ");
+		}
+		appendStringInfoString(&columns, attname);
+		appendStringInfo(&coldefs, "%s %s", attname,
+						 format_type_extended(attr->atttypid, attr->atttypmod,
+											  FORMAT_TYPE_TYPEMOD_GIVEN |
+											  FORMAT_TYPE_FORCE_QUALIFY));
+		if (OidIsValid(attr->attcollation))
+			appendStringInfo(&coldefs, " COLLATE %s",
+							 generate_collation_name(attr->attcollation));
+	}
+
+	initStringInfo(&query);
+	appendStringInfo(&query,
+					 "CREATE TEMP TABLE %s (%s) DISTRIBUTED RANDOMLY",
+					 quote_identifier(stagename), coldefs.data);
+	ExecuteCopyStageQuery(query.data, SPI_OK_UTILITY);
+
+	/*
+	 * Copy into the stage with the same source and options.  Rejected rows
+	 * are logged for the target, and the reject limit is checked over all
+	 * the segments once they are done, see CopyFrom().
+	 */
+	stageStmt = copyObject((CopyStmt *) stmt);
+	stageStmt->relation = makeRangeVar("pg_temp", stagename, -1);
+	stageStmt->attlist = NIL;
+	stageStmt->options = lappend(stageStmt->options,
+								 makeDefElem("stage_for",
+											 (Node *) makeString(psprintf("%u", RelationGetRelid(rel))),
+											 -1));
+
+	stagePstate = make_parsestate(NULL);
+	copy_stage_target = RelationGetRelid(rel);
+	PG_TRY();
+	{
+		DoCopy(stagePstate, stageStmt, -1, 0, &staged);
+	}
+	PG_FINALLY();
+	{
+		copy_stage_target = InvalidOid;
+	}
+	PG_END_TRY();
+	free_parsestate(stagePstate);
+
+	/* OVERRIDING SYSTEM VALUE, as COPY sets identity columns too */
+	resetStringInfo(&query);
+	appendStringInfo(&query,
+					 "INSERT INTO %s (%s) OVERRIDING SYSTEM VALUE SELECT %s FROM pg_temp.%s",
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+												RelationGetRelationName(rel)),
+					 columns.data, columns.data, quote_identifier(stagename));
+	processed = ExecuteCopyStageQuery(query.data, SPI_OK_INSERT);
+
+	resetStringInfo(&query);
+	appendStringInfo(&query, "DROP TABLE pg_temp.%s", quote_identifier(stagename));
+	ExecuteCopyStageQuery(query.data, SPI_OK_UTILITY);
+
+	return processed;
+}
+
 /*
  * Modify the filename in cstate->filename, and cstate->cdbsreh if any,
  * for COPY ON SEGMENT.
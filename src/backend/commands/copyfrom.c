@@ -183,6 +183,14 @@ typedef struct
 */
 #define SizeOfCopyFromDispatchError (offsetof(copy_from_dispatch_error, line_len) + sizeof(uint32))
 
+/*
+ * The QD collects the frames for each QE into chunks of about this size,
+ * and sends a chunk in one CopyData message. The QEs read the frames as a
+ * stream, so they don't care how the frames are split into messages, but
+ * one message per row costs both sides a lot more than the rows do.
+ */
+#define COPY_DISPATCH_CHUNK_SIZE	(32 * 1024)
+
 /* Low-level communications functions */
 static void
 SendCopyFromForwardedTuple(CopyFromState cstate,
@@ -198,6 +206,9 @@ SendCopyFromForwardedTuple(CopyFromState cstate,
 						   bool is_directory_table);
 static void SendCopyFromForwardedHeader(CopyFromState cstate, CdbCopy *cdbCopy);
 static void SendCopyFromForwardedError(CopyFromState cstate, CdbCopy *cdbCopy, char *errmsg);
+static void SendCopyFromDispatchData(CopyFromState cstate, CdbCopy *cdbCopy,
+									 int target_seg, const char *data, int len);
+static void FlushCopyFromDispatchChunks(CopyFromState cstate, CdbCopy *cdbCopy);
 
 static bool NextCopyFromDispatch(CopyFromState cstate, ExprContext *econtext,
 								 Datum *values, bool *nulls);
@@ -1976,6 +1987,9 @@ CopyFrom(CopyFromState cstate)
 		 */
 		cdbCopy = makeCdbCopyFrom(cstate);
 
+		/* collect the rows for each segment into chunks */
+		cstate->dispatch_chunks = palloc0(cdbCopy->total_segs * sizeof(StringInfo));
+
 		/*
 		 * Dispatch the COPY command.
 		 *
@@ -2279,8 +2293,14 @@ CopyFrom(CopyFromState cstate)
 		 */
 		if (cstate->dispatch_mode == COPY_DISPATCH)
 		{
-			/* In QD, compute the target segment to send this row to. */
-			target_seg = GetTargetSeg(distData, myslot);
+			/*
+			 * In QD, compute the target segment to send this row to. The
+			 * rows of a stage fill the chunk of one QE after the other.
+			 */
+			if (OidIsValid(cstate->opts.stage_for))
+				target_seg = cstate->stage_seg;
+			else
+				target_seg = GetTargetSeg(distData, myslot);
 			bool send_to_all = distData &&
 							   GpPolicyIsReplicated(distData->policy);
 
@@ -2476,6 +2496,8 @@ CopyFrom(CopyFromState cstate)
 		int64		total_completed_from_qes;
 		int64		total_rejected_from_qes;
 
+		FlushCopyFromDispatchChunks(cstate, cdbCopy);
+
 		cdbCopyEnd(cdbCopy,
 				   &total_completed_from_qes,
 				   &total_rejected_from_qes);
@@ -2514,6 +2536,15 @@ CopyFrom(CopyFromState cstate)
 			total_rejected = total_rejected_from_qd + total_rejected_from_qes;
 
 			ReportSrehResults(cstate->cdbsreh, total_rejected);
+
+			/*
+			 * When loading the stage of another table, the lines were dealt
+			 * out to the segments regardless of their content, so the limit
+			 * holds for all the segments together.
+			 */
+			if (OidIsValid(cstate->opts.stage_for))
+				ErrorIfTotalRejectLimitReached(cstate->cdbsreh, total_rejected,
+											   processed + total_rejected);
 		}
 	}
 	/* In dispatcher, we have the report for rejected count. We should have it in singlenode too. */
@@ -4036,9 +4067,12 @@ SendCopyFromForwardedTuple(CopyFromState cstate,
 	frame->delim_seen_at_end = cstate->stopped_processing_at_delim;
 
 	if (toAll)
-		cdbCopySendDataToAll(cdbCopy, msgbuf->data, msgbuf->len);
+	{
+		for (i = 0; i < cdbCopy->total_segs; i++)
+			SendCopyFromDispatchData(cstate, cdbCopy, i, msgbuf->data, msgbuf->len);
+	}
 	else
-		cdbCopySendData(cdbCopy, target_seg, msgbuf->data, msgbuf->len);
+		SendCopyFromDispatchData(cstate, cdbCopy, target_seg, msgbuf->data, msgbuf->len);
 }
 
 static void
@@ -4084,7 +4118,69 @@ SendCopyFromForwardedError(CopyFromState cstate, CdbCopy *cdbCopy, char *errorms
 
 	target_seg = (cstate->lastsegid++ % cdbCopy->total_segs);
 
-	cdbCopySendData(cdbCopy, target_seg, msgbuf->data, msgbuf->len);
+	SendCopyFromDispatchData(cstate, cdbCopy, target_seg, msgbuf->data, msgbuf->len);
+}
+
+/*
+ * Send a frame to a QE. If the COPY collects chunks, the frame is added to
+ * the segment's chunk, which is sent once it is big enough.
+ */
+static void
+SendCopyFromDispatchData(CopyFromState cstate, CdbCopy *cdbCopy,
+						 int target_seg, const char *data, int len)
+{
+	StringInfo	chunk;
+
+	if (cstate->dispatch_chunks == NULL)
+	{
+		cdbCopySendData(cdbCopy, target_seg, data, len);
+		return;
+	}
+
+	Assert(target_seg >= 0 && target_seg < cdbCopy->total_segs);
+
+	chunk = cstate->dispatch_chunks[target_seg];
+	if (chunk == NULL)
+	{
+		chunk = makeStringInfo();
+		enlargeStringInfo(chunk, COPY_DISPATCH_CHUNK_SIZE);
+		cstate->dispatch_chunks[target_seg] = chunk;
+	}
+
+	APPEND_MSGBUF(chunk, data, len);
+
+	if (chunk->len >= COPY_DISPATCH_CHUNK_SIZE)
+	{
+		cdbCopySendData(cdbCopy, target_seg, chunk->data, chunk->len);
+		chunk->len = 0;
+
+		if (OidIsValid(cstate->opts.stage_for) && target_seg == cstate->stage_seg)
+			cstate->stage_seg = (target_seg + 1) % cdbCopy->total_segs;
+	}
+}
+
+/*
+ * Send the partial chunks to the QEs. This must be done before ending the
+ * COPY on the QEs, so that they see, and count, all the rows and errors.
+ */
+static void
+FlushCopyFromDispatchChunks(CopyFromState cstate, CdbCopy *cdbCopy)
+{
+	int			i;
+
+	if (cstate->dispatch_chunks == NULL)
+		return;
+
+	for (i = 0; i < cdbCopy->total_segs; i++)
+	{
+		StringInfo	chunk = cstate->dispatch_chunks[i];
+
+		if (chunk != NULL && chunk->len > 0)
+		{
+			cdbCopySendData(cdbCopy, i, chunk->data, chunk->len);
+			chunk->len = 0;
+		}
+	}
 }
 
 static void
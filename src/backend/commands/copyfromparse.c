@@ -72,6 +72,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/pg_bswap.h"
+#include "port/pg_lfind.h"
 #include "utils/elog.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -855,6 +856,10 @@ CopyReadLineText(CopyFromState cstate)
 	char		quotec = '\0';
 	char		escapec = '\0';
 
+	/* the characters the loop below has to look at, see pg_lfind8_any() */
+	char		special[PG_LFIND8_MAX_KEYS] = {'\n', '\r', '\\'};
+	int			nspecial = 3;
+
 	if (cstate->opts.csv_mode)
 	{
 		quotec = cstate->opts.quote[0];
@@ -862,6 +867,10 @@ CopyReadLineText(CopyFromState cstate)
 		/* ignore special escape processing if it's the same as quotec */
 		if (quotec == escapec)
 			escapec = '\0';
+
+		special[nspecial++] = quotec;
+		if (escapec != '\0')
+			special[nspecial++] = escapec;
 	}
 
 	/*
@@ -892,6 +901,7 @@ CopyReadLineText(CopyFromState cstate)
 	for (;;)
 	{
 		int			prev_raw_ptr;
+		int			skip;
 		char		c;
 
 		/*
@@ -927,6 +937,24 @@ CopyReadLineText(CopyFromState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip over the run of ordinary characters in front of us, a vector
+		 * at a time.  They are only part of the line, so all that is needed
+		 * is the state that looking at them one by one would have left.
+		 */
+		skip = pg_lfind8_any(copy_input_buf + input_buf_ptr,
+							 copy_input_buf + copy_buf_len,
+							 special, nspecial) -
+			(copy_input_buf + input_buf_ptr);
+		if (skip > 0)
+		{
+			input_buf_ptr += skip;
+			first_char_in_line = false;
+			last_was_esc = false;
+			if (input_buf_ptr >= copy_buf_len)
+				continue;
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = input_buf_ptr;
 		c = copy_input_buf[input_buf_ptr++];
@@ -1283,6 +1311,30 @@ GetDecimalFromHex(char hex)
 		return tolower((unsigned char) hex) - 'a' + 10;
 }
 
+/*
+ * CopyPlainRun - transfer the run of characters at *cur_ptr that needs no
+ * de-escaping, up to the first of the 'nspecial' characters in 'special' or
+ * the end of the line, to *output_ptr.  Both pointers are advanced.
+ *
+ * Most fields contain no escapes at all, so this copies them whole.
+ */
+static inline void
+CopyPlainRun(char **cur_ptr, char *line_end_ptr, char **output_ptr,
+			 const char *special, int nspecial)
+{
+	char	   *run_end = line_end_ptr;
+	int			len;
+
+	if (nspecial > 0)
+		run_end = (char *) pg_lfind8_any(*cur_ptr, line_end_ptr,
+										 special, nspecial);
+
+	len = run_end - *cur_ptr;
+	memcpy(*output_ptr, *cur_ptr, len);
+	*output_ptr += len;
+	*cur_ptr = run_end;
+}
+
 /*
  * Parse the current line into separate attributes (fields),
  * performing de-escaping as needed.
@@ -1312,6 +1364,8 @@ CopyReadAttributesText(CopyFromState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	char		special[2];
+	int			nspecial = 0;
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -1326,6 +1380,12 @@ CopyReadAttributesText(CopyFromState cstate, int stop_processing_at_field)
 		return 0;
 	}
 
+	/* the characters that end a run of plain data, see CopyPlainRun() */
+	if (!delim_off)
+		special[nspecial++] = delimc;
+	if (!cstate->escape_off)
+		special[nspecial++] = escapec;
+
 	resetStringInfo(&cstate->attribute_buf);
 
 	/*
@@ -1389,6 +1449,9 @@ CopyReadAttributesText(CopyFromState cstate, int stop_processing_at_field)
 		{
 			char		c;
 
+			CopyPlainRun(&cur_ptr, line_end_ptr, &output_ptr,
+						 special, nspecial);
+
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
 				break;
@@ -1561,6 +1624,8 @@ CopyReadAttributesCSV(CopyFromState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	char		unquoted_special[2] = {quotec, delimc};
+	char		quoted_special[2] = {quotec, escapec};
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -1637,6 +1702,9 @@ CopyReadAttributesCSV(CopyFromState cstate, int stop_processing_at_field)
 			/* Not in quote */
 			for (;;)
 			{
+				CopyPlainRun(&cur_ptr, line_end_ptr, &output_ptr,
+							 unquoted_special, delim_off ? 1 : 2);
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -1660,6 +1728,9 @@ CopyReadAttributesCSV(CopyFromState cstate, int stop_processing_at_field)
 			/* In quote */
 			for (;;)
 			{
+				CopyPlainRun(&cur_ptr, line_end_ptr, &output_ptr,
+							 quoted_special, 2);
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
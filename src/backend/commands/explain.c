@@ -2516,6 +2516,11 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			/* GPDB: how many of those the batch qual removed */
+			if (es->verbose && IsA(planstate, SeqScanState) &&
+				((SeqScanState *) planstate)->batchqual)
+				show_instrumentation_count("Rows Removed by Batch Filter", 2,
+										   planstate, es);
 			break;
 		case T_Gather:
 			{
@@ -4477,8 +4482,11 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 								 usage->local_blks_written > 0);
 		bool		has_temp = (usage->temp_blks_read > 0 ||
 								usage->temp_blks_written > 0);
+		bool		has_temp_timing = (!INSTR_TIME_IS_ZERO(usage->temp_blk_read_time) ||
+									   !INSTR_TIME_IS_ZERO(usage->temp_blk_write_time));
 		bool		has_timing = (!INSTR_TIME_IS_ZERO(usage->blk_read_time) ||
-								  !INSTR_TIME_IS_ZERO(usage->blk_write_time));
+								  !INSTR_TIME_IS_ZERO(usage->blk_write_time) ||
+								  has_temp_timing);
 		bool		show_planning = (planning && (has_shared ||
 												  has_local || has_temp || has_timing));
 
@@ -4544,6 +4552,15 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 			appendStringInfoChar(es->str, '\n');
 		}
 
+		/* GPDB: workfiles written with gp_workfile_compression */
+		if (usage->temp_bytes_raw > 0)
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str, "Temp Compression: %lld kB to %lld kB\n",
+							 (long long) ((usage->temp_bytes_raw + 1023) / 1024),
+							 (long long) ((usage->temp_bytes_compressed + 1023) / 1024));
+		}
+
 		/* As above, show only positive counter values. */
 		if (has_timing)
 		{
@@ -4555,6 +4572,19 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 			if (!INSTR_TIME_IS_ZERO(usage->blk_write_time))
 				appendStringInfo(es->str, " write=%0.3f",
 								 INSTR_TIME_GET_MILLISEC(usage->blk_write_time));
+			if (has_temp_timing)
+			{
+				if (!INSTR_TIME_IS_ZERO(usage->blk_read_time) ||
+					!INSTR_TIME_IS_ZERO(usage->blk_write_time))
+					appendStringInfoChar(es->str, ',');
+				appendStringInfoString(es->str, " temp");
+				if (!INSTR_TIME_IS_ZERO(usage->temp_blk_read_time))
+					appendStringInfo(es->str, " read=%0.3f",
+									 INSTR_TIME_GET_MILLISEC(usage->temp_blk_read_time));
+				if (!INSTR_TIME_IS_ZERO(usage->temp_blk_write_time))
+					appendStringInfo(es->str, " write=%0.3f",
+									 INSTR_TIME_GET_MILLISEC(usage->temp_blk_write_time));
+			}
 			appendStringInfoChar(es->str, '\n');
 		}
 
@@ -4591,6 +4621,19 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 			ExplainPropertyFloat("I/O Write Time", "ms",
 								 INSTR_TIME_GET_MILLISEC(usage->blk_write_time),
 								 3, es);
+			ExplainPropertyFloat("Temp I/O Read Time", "ms",
+								 INSTR_TIME_GET_MILLISEC(usage->temp_blk_read_time),
+								 3, es);
+			ExplainPropertyFloat("Temp I/O Write Time", "ms",
+								 INSTR_TIME_GET_MILLISEC(usage->temp_blk_write_time),
+								 3, es);
+		}
+		if (usage->temp_bytes_raw > 0)
+		{
+			ExplainPropertyInteger("Temp Raw Bytes", "bytes",
+								   usage->temp_bytes_raw, es);
+			ExplainPropertyInteger("Temp Compressed Bytes", "bytes",
+								   usage->temp_bytes_compressed, es);
 		}
 	}
 }
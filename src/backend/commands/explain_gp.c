@@ -71,6 +71,7 @@ typedef struct CdbExplain_StatInst
 	int			enotes;			/* Offset to end of node's extra text */
 	int 		nworkers_launched; /* Number of workers launched for this node */
 	WalUsage	walusage;		/* add WAL usage */
+	BufferUsage bufusage;		/* add buffer usage */
 } CdbExplain_StatInst;
 
 
@@ -891,6 +892,7 @@ cdbexplain_collectStatsFromNode(PlanState *planstate, CdbExplain_SendStatCtx *ct
 	si->firststart = instr->firststart;
 	si->numPartScanned = instr->numPartScanned;
         memcpy(&si->walusage, &instr->walusage, sizeof(WalUsage));
+	memcpy(&si->bufusage, &instr->bufusage, sizeof(BufferUsage));
 
 	if (IsA(planstate, SortState))
 	{
@@ -1287,6 +1289,21 @@ cdbexplain_depositStatsToNode(PlanState *planstate, CdbExplain_RecvStatCtx *ctx)
 			walusage->wal_records += rsi->walusage.wal_records;
 		}
 	}
+	if (planstate->instrument && planstate->instrument->need_bufusage &&
+		ctx->dispatchResults != NULL)
+	{
+		/*
+		 * Likewise for buffer usage, which includes the workfile I/O of the
+		 * node on the segments.  The stats of a slice that ran in the QD
+		 * were collected from this very node, don't add them to it again.
+		 */
+		for (imsgptr = 0; imsgptr < ctx->nmsgptr; imsgptr++)
+		{
+			rsh = ctx->msgptrs[imsgptr];
+			rsi = &rsh->inst[ctx->iStatInst];
+			BufferUsageAdd(&planstate->instrument->bufusage, &rsi->bufusage);
+		}
+	}
 }								/* cdbexplain_depositStatsToNode */
 
 
@@ -128,6 +128,7 @@
 #include "access/appendonly_compaction.h"
 #include "access/bitmap_private.h"
 #include "access/external.h"
+#include "catalog/aoblkdir.h"
 #include "catalog/aocatalog.h"
 #include "catalog/gp_matview_aux.h"
 #include "catalog/oid_dispatch.h"
@@ -1361,6 +1362,14 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId,
 	 */
 	CommandCounterIncrement();
 
+	/*
+	 * Bloom filters of AOCO blocks live in the block directory, so create it
+	 * right away if any column asks for them.
+	 */
+	if (RelationStorageIsAoCols(rel) && !stmt->buildAoBlkdir &&
+		RelationHasBloomFilterColumns(rel))
+		AlterTableCreateAoBlkdirTable(relationId);
+
 	/* Process and store partition bound, if any. */
 	if (stmt->partbound)
 	{
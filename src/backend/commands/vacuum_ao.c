@@ -142,6 +142,7 @@
 #include "utils/relcache.h"
 #include "utils/lsyscache.h"
 #include "utils/pg_rusage.h"
+#include "utils/timestamp.h"
 #include "cdb/cdbappendonlyblockdirectory.h"
 
 
@@ -328,6 +329,7 @@ ao_vacuum_rel_compact(Relation onerel, VacuumParams *params, BufferAccessStrateg
 	char	   *relname;
 	int			elevel;
 	int			options = params->options;
+	bool		compacted;
 
 	/*
 	 * This should run in a distributed transaction. But also allow utility
@@ -365,6 +367,12 @@ ao_vacuum_rel_compact(Relation onerel, VacuumParams *params, BufferAccessStrateg
 	 * multiple transactions. The problem with that is that the updates to
 	 * pg_aoseg needs to happen in a distributed transaction (Problem 3), so
 	 * we would need to coordinate the transactions from the QD.
+	 *
+	 * To bound that, gp_appendonly_compaction_max_segfiles can limit the
+	 * number of segfiles compacted by one VACUUM. The segfiles are taken
+	 * dirtiest first, and the remaining ones are left for the next VACUUM,
+	 * so a large table can be compacted incrementally, and an interrupted
+	 * VACUUM only loses the work of its own batch.
 	 */
 	insert_segno = -1;
 	while ((compaction_segno = ChooseSegnoForCompaction(onerel, compacted_and_inserted_segments)) != -1)
@@ -382,21 +390,21 @@ ao_vacuum_rel_compact(Relation onerel, VacuumParams *params, BufferAccessStrateg
 			elog(LOG, "compacting segno %d of %s", compaction_segno, relname);
 
 		if (RelationIsAoRows(onerel))
-			AppendOnlyCompact(onerel,
-							  compaction_segno,
-							  &insert_segno,
-							  (options & VACOPT_FULL) != 0,
-							  compacted_segments,
-							  vacrelstats);
+			compacted = AppendOnlyCompact(onerel,
+										  compaction_segno,
+										  &insert_segno,
+										  (options & VACOPT_FULL) != 0,
+										  compacted_segments,
+										  vacrelstats);
 		else
 		{
 			Assert(RelationIsAoCols(onerel));
-			AOCSCompact(onerel,
-						compaction_segno,
-						&insert_segno,
-						(options & VACOPT_FULL) != 0,
-						compacted_segments,
-						vacrelstats);
+			compacted = AOCSCompact(onerel,
+									compaction_segno,
+									&insert_segno,
+									(options & VACOPT_FULL) != 0,
+									compacted_segments,
+									vacrelstats);
 		}
 
 		if (insert_segno != -1)
@@ -408,6 +416,15 @@ ao_vacuum_rel_compact(Relation onerel, VacuumParams *params, BufferAccessStrateg
 		 * that we can update the insertion target pg_aoseg row again.
 		 */
 		CommandCounterIncrement();
+
+		if (compacted &&
+			++vacrelstats->num_compacted == gp_appendonly_compaction_max_segfiles)
+		{
+			ereport(elevel,
+					(errmsg("stopping compaction of \"%s\" after %d segment files",
+							relname, vacrelstats->num_compacted)));
+			break;
+		}
 	}
 
 	SIMPLE_FAULT_INJECTOR("vacuum_ao_after_compact");
@@ -421,6 +438,7 @@ init_vacrelstats()
 
 	old_context = MemoryContextSwitchTo(TopMemoryContext);
 	vacrelstats = (AOVacuumRelStats *) palloc0(sizeof(AOVacuumRelStats));
+	vacrelstats->start_time = GetCurrentTimestamp();
 	MemoryContextSwitchTo(old_context);
 
 	return vacrelstats;
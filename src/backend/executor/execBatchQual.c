@@ -0,0 +1,370 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchQual.c
+ *	  Evaluation of simple scan quals over a batch of tuples at a time.
+ *
+ * Most scan quals in a warehouse are comparisons of a column with a
+ * constant, on integer, date, timestamp or float8 columns.  ExecQual()
+ * evaluates them one tuple at a time: a few interpreter steps and an fmgr
+ * call of the comparison function for every row.  Here, a scan collects
+ * BATCH_QUAL_SIZE tuples, and each such comparison is applied to all of
+ * them in one tight loop over an array of Datums, with the comparison done
+ * inline.  The loops narrow a selection vector of the tuples that passed
+ * so far, so later comparisons only look at the survivors.
+ *
+ * ExecInitBatchQual() picks the clauses of an implicitly ANDed qual that
+ * can be handled this way; the others are returned for the caller to
+ * evaluate with ExecQual() on the tuples that pass the batch, as before.
+ * Only strict comparison operators are handled, so a NULL column value
+ * just fails the clause, same as in the regular evaluation.
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatchQual.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "executor/execBatchQual.h"
+#include "nodes/primnodes.h"
+#include "utils/fmgroids.h"
+#include "utils/float.h"
+
+/* Representation of an operand of a supported comparison */
+typedef enum BatchQualKind
+{
+	BQ_INT32,					/* int4, date */
+	BQ_INT64,					/* int8, timestamp, timestamptz */
+	BQ_FLOAT4,
+	BQ_FLOAT8
+} BatchQualKind;
+
+typedef enum BatchQualCmp
+{
+	BQ_EQ,
+	BQ_NE,
+	BQ_LT,
+	BQ_LE,
+	BQ_GT,
+	BQ_GE,
+	BQ_NUM_CMPS
+} BatchQualCmp;
+
+typedef struct BatchQualOperator
+{
+	Oid			funcid;
+	BatchQualKind left;
+	BatchQualKind right;
+	BatchQualCmp cmp;
+} BatchQualOperator;
+
+#define BQ_OPERATOR_FAMILY(prefix, left, right) \
+	{F_##prefix##EQ, left, right, BQ_EQ}, \
+	{F_##prefix##NE, left, right, BQ_NE}, \
+	{F_##prefix##LT, left, right, BQ_LT}, \
+	{F_##prefix##LE, left, right, BQ_LE}, \
+	{F_##prefix##GT, left, right, BQ_GT}, \
+	{F_##prefix##GE, left, right, BQ_GE}
+
+static const BatchQualOperator batch_qual_operators[] = {
+	BQ_OPERATOR_FAMILY(INT4, BQ_INT32, BQ_INT32),
+	BQ_OPERATOR_FAMILY(INT8, BQ_INT64, BQ_INT64),
+	BQ_OPERATOR_FAMILY(INT48, BQ_INT32, BQ_INT64),
+	BQ_OPERATOR_FAMILY(INT84, BQ_INT64, BQ_INT32),
+	BQ_OPERATOR_FAMILY(DATE_, BQ_INT32, BQ_INT32),
+	BQ_OPERATOR_FAMILY(TIMESTAMP_, BQ_INT64, BQ_INT64),
+	BQ_OPERATOR_FAMILY(TIMESTAMPTZ_, BQ_INT64, BQ_INT64),
+	BQ_OPERATOR_FAMILY(FLOAT8, BQ_FLOAT8, BQ_FLOAT8),
+	BQ_OPERATOR_FAMILY(FLOAT84, BQ_FLOAT8, BQ_FLOAT4),
+	BQ_OPERATOR_FAMILY(FLOAT48, BQ_FLOAT4, BQ_FLOAT8)
+};
+
+typedef struct BatchQualClause BatchQualClause;
+
+/*
+ * A kernel filters the 'n' tuples of the selection vector 'sel', whose
+ * column values are in values[] and isnull[], and returns how many passed.
+ * The passing ones are moved to the front of 'sel', in order.
+ */
+typedef int (*BatchQualKernel) (const Datum *values, const bool *isnull,
+								int n, const BatchQualClause *clause,
+								int *sel);
+
+struct BatchQualClause
+{
+	AttrNumber	attno;			/* column compared */
+	BatchQualKernel kernel;
+	int64		ival;			/* the constant, for integer columns */
+	float8		fval;			/* the constant, for float8 columns */
+};
+
+struct BatchQual
+{
+	int			nclauses;
+	BatchQualClause *clauses;
+	AttrNumber	maxattno;		/* highest column any clause needs */
+
+	/* Column values of the selected tuples, gathered for the kernels */
+	Datum		values[BATCH_QUAL_SIZE];
+	bool		isnull[BATCH_QUAL_SIZE];
+};
+
+#define BQ_CMP_EQ(a, b)		((a) == (b))
+#define BQ_CMP_NE(a, b)		((a) != (b))
+#define BQ_CMP_LT(a, b)		((a) < (b))
+#define BQ_CMP_LE(a, b)		((a) <= (b))
+#define BQ_CMP_GT(a, b)		((a) > (b))
+#define BQ_CMP_GE(a, b)		((a) >= (b))
+
+/* float8 comparisons must order NaNs like float8_cmp_internal() does */
+#define BQ_FCMP_EQ(a, b)	float8_eq(a, b)
+#define BQ_FCMP_NE(a, b)	float8_ne(a, b)
+#define BQ_FCMP_LT(a, b)	float8_lt(a, b)
+#define BQ_FCMP_LE(a, b)	float8_le(a, b)
+#define BQ_FCMP_GT(a, b)	float8_gt(a, b)
+#define BQ_FCMP_GE(a, b)	float8_ge(a, b)
+
+/*
+ * The loops are branch free, so that the compiler can keep them tight (and
+ * vectorize them, where it is able to).
+ */
+#define BQ_KERNEL(name, ctype, getvalue, constfield, compare) \
+static int \
+name(const Datum *values, const bool *isnull, int n, \
+	 const BatchQualClause *clause, int *sel) \
+{ \
+	ctype		c = (ctype) clause->constfield; \
+	int			nout = 0; \
+\
+	for (int i = 0; i < n; i++) \
+	{ \
+		ctype		v = (ctype) getvalue(values[i]); \
+\
+		sel[nout] = sel[i]; \
+		nout += (!isnull[i] & compare(v, c)); \
+	} \
+	return nout; \
+}
+
+#define BQ_KERNELS(kind, ctype, getvalue, constfield, prefix) \
+	BQ_KERNEL(bq_##kind##_eq, ctype, getvalue, constfield, prefix##EQ) \
+	BQ_KERNEL(bq_##kind##_ne, ctype, getvalue, constfield, prefix##NE) \
+	BQ_KERNEL(bq_##kind##_lt, ctype, getvalue, constfield, prefix##LT) \
+	BQ_KERNEL(bq_##kind##_le, ctype, getvalue, constfield, prefix##LE) \
+	BQ_KERNEL(bq_##kind##_gt, ctype, getvalue, constfield, prefix##GT) \
+	BQ_KERNEL(bq_##kind##_ge, ctype, getvalue, constfield, prefix##GE)
+
+BQ_KERNELS(int32, int64, DatumGetInt32, ival, BQ_CMP_)
+#ifdef USE_FLOAT8_BYVAL
+BQ_KERNELS(int64, int64, DatumGetInt64, ival, BQ_CMP_)
+BQ_KERNELS(float8, float8, DatumGetFloat8, fval, BQ_FCMP_)
+#endif
+
+static const BatchQualKernel bq_int32_kernels[BQ_NUM_CMPS] = {
+	bq_int32_eq, bq_int32_ne, bq_int32_lt, bq_int32_le, bq_int32_gt, bq_int32_ge
+};
+
+#ifdef USE_FLOAT8_BYVAL
+static const BatchQualKernel bq_int64_kernels[BQ_NUM_CMPS] = {
+	bq_int64_eq, bq_int64_ne, bq_int64_lt, bq_int64_le, bq_int64_gt, bq_int64_ge
+};
+
+static const BatchQualKernel bq_float8_kernels[BQ_NUM_CMPS] = {
+	bq_float8_eq, bq_float8_ne, bq_float8_lt, bq_float8_le, bq_float8_gt, bq_float8_ge
+};
+#endif
+
+/* The comparison to use when the operands are swapped */
+static const BatchQualCmp bq_commuted[BQ_NUM_CMPS] = {
+	BQ_EQ, BQ_NE, BQ_GT, BQ_GE, BQ_LT, BQ_LE
+};
+
+static const BatchQualOperator *
+batch_qual_lookup_operator(Oid funcid)
+{
+	for (int i = 0; i < lengthof(batch_qual_operators); i++)
+	{
+		if (batch_qual_operators[i].funcid == funcid)
+			return &batch_qual_operators[i];
+	}
+	return NULL;
+}
+
+/*
+ * Can 'clause' be evaluated by a kernel?  If so, fill in 'bqc'.
+ */
+static bool
+batch_qual_clause(Expr *clause, BatchQualClause *bqc)
+{
+	OpExpr	   *opexpr;
+	const BatchQualOperator *oper;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *con;
+	BatchQualKind colkind;
+	BatchQualKind constkind;
+	BatchQualCmp cmp;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (list_length(opexpr->args) != 2)
+		return false;
+
+	oper = batch_qual_lookup_operator(opexpr->opfuncid);
+	if (oper == NULL)
+		return false;
+
+	left = linitial(opexpr->args);
+	right = lsecond(opexpr->args);
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		con = (Const *) right;
+		colkind = oper->left;
+		constkind = oper->right;
+		cmp = oper->cmp;
+	}
+	else if (IsA(left, Const) && IsA(right, Var))
+	{
+		var = (Var *) right;
+		con = (Const *) left;
+		colkind = oper->right;
+		constkind = oper->left;
+		cmp = bq_commuted[oper->cmp];
+	}
+	else
+		return false;
+
+	if (IS_SPECIAL_VARNO(var->varno) || var->varlevelsup != 0 ||
+		var->varattno <= 0)
+		return false;
+
+	/* The operators are strict, leave the rare NULL constant to ExecQual */
+	if (con->constisnull)
+		return false;
+
+	bqc->attno = var->varattno;
+	switch (colkind)
+	{
+		case BQ_INT32:
+			bqc->kernel = bq_int32_kernels[cmp];
+			break;
+#ifdef USE_FLOAT8_BYVAL
+		case BQ_INT64:
+			bqc->kernel = bq_int64_kernels[cmp];
+			break;
+		case BQ_FLOAT8:
+			bqc->kernel = bq_float8_kernels[cmp];
+			break;
+#endif
+		default:
+			return false;
+	}
+
+	switch (constkind)
+	{
+		case BQ_INT32:
+			bqc->ival = DatumGetInt32(con->constvalue);
+			break;
+		case BQ_INT64:
+			bqc->ival = DatumGetInt64(con->constvalue);
+			break;
+		case BQ_FLOAT4:
+			bqc->fval = (float8) DatumGetFloat4(con->constvalue);
+			break;
+		case BQ_FLOAT8:
+			bqc->fval = DatumGetFloat8(con->constvalue);
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * ExecInitBatchQual
+ *
+ * Prepare to evaluate the clauses of the implicitly ANDed 'qual' that the
+ * kernels can handle over batches of scan tuples.  Returns NULL if there
+ * are none.  The other clauses are returned in '*residual'.
+ *
+ * The Vars of 'qual' must refer to the tuples that will be passed to
+ * ExecBatchQual(), as they do in the qual of a scan node.
+ */
+BatchQual *
+ExecInitBatchQual(List *qual, List **residual)
+{
+	BatchQual  *bq;
+	ListCell   *lc;
+
+	bq = palloc(sizeof(BatchQual));
+	bq->nclauses = 0;
+	bq->clauses = palloc(list_length(qual) * sizeof(BatchQualClause));
+	bq->maxattno = 0;
+
+	*residual = NIL;
+	foreach(lc, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+		BatchQualClause *bqc = &bq->clauses[bq->nclauses];
+
+		if (batch_qual_clause(clause, bqc))
+		{
+			bq->maxattno = Max(bq->maxattno, bqc->attno);
+			bq->nclauses++;
+		}
+		else
+			*residual = lappend(*residual, clause);
+	}
+
+	if (bq->nclauses == 0)
+	{
+		pfree(bq->clauses);
+		pfree(bq);
+		*residual = qual;
+		return NULL;
+	}
+
+	return bq;
+}
+
+/*
+ * ExecBatchQual
+ *
+ * Evaluate the batch qual on 'nslots' tuples, at most BATCH_QUAL_SIZE.
+ * The indexes of the slots that pass are stored in 'sel', in order, and
+ * their number is returned.
+ */
+int
+ExecBatchQual(BatchQual *bq, TupleTableSlot **slots, int nslots, int *sel)
+{
+	int			nsel = nslots;
+
+	Assert(nslots <= BATCH_QUAL_SIZE);
+
+	for (int i = 0; i < nslots; i++)
+	{
+		slot_getsomeattrs(slots[i], bq->maxattno);
+		sel[i] = i;
+	}
+
+	for (int c = 0; c < bq->nclauses && nsel > 0; c++)
+	{
+		BatchQualClause *clause = &bq->clauses[c];
+		int			attoff = clause->attno - 1;
+
+		for (int i = 0; i < nsel; i++)
+		{
+			TupleTableSlot *slot = slots[sel[i]];
+
+			bq->values[i] = slot->tts_values[attoff];
+			bq->isnull[i] = slot->tts_isnull[attoff];
+		}
+
+		nsel = clause->kernel(bq->values, bq->isnull, nsel, clause, sel);
+	}
+
+	return nsel;
+}
@@ -169,7 +169,8 @@ initNextTableToScan(DynamicSeqScanState *node)
 	}
 
 	node->seqScanState = ExecInitSeqScanForPartition(&plan->seqscan, estate,
-													 currentRelation);
+													 currentRelation,
+													 &node->batchslots);
 	return true;
 }
 
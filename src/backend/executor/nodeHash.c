@@ -2658,6 +2658,12 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
                              "  Skipped %d empty batches.",
                              hashtable->nbatch - stats->nonemptybatches);
     }
+
+    /* Report batches built from the outer side, see nodeHashjoin.c */
+    if (stats->reversedbatches > 0)
+        appendStringInfo(buf,
+                         "  Built %d batches from the outer side.",
+                         stats->reversedbatches);
 }                               /* ExecHashTableExplainEnd */
 
 
@@ -134,6 +134,8 @@
 #define HJ_FILL_OUTER_TUPLE		4
 #define HJ_FILL_INNER_TUPLES	5
 #define HJ_NEED_NEW_BATCH		6
+#define HJ_NEED_NEW_INNER		7	/* role-reversed batches only */
+#define HJ_SCAN_OUTER_BUCKET	8	/* role-reversed batches only */
 
 /* Returns true if doing null-fill on outer relation */
 #define HJ_FILL_OUTER(hjstate)	((hjstate)->hj_NullInnerTupleSlot != NULL)
@@ -160,6 +162,11 @@ static bool isNotDistinctJoin(List *qualList);
 static void ReleaseHashTable(HashJoinState *node);
 static void SpillCurrentBatch(HashJoinState *node);
 static bool ExecHashJoinReloadHashTable(HashJoinState *hjstate);
+static bool ExecHashJoinReverseBatch(HashJoinState *hjstate);
+static TupleTableSlot *ExecHashJoinInnerGetTuple(HashJoinState *hjstate,
+												 uint32 *hashvalue);
+static bool ExecScanHashBucketReversed(HashJoinState *hjstate,
+									   ExprContext *econtext);
 static void ExecEagerFreeHashJoin(HashJoinState *node);
 extern bool Test_print_prefetch_joinqual;
 
@@ -188,6 +195,7 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 	ExprContext *econtext;
 	HashJoinTable hashtable;
 	TupleTableSlot *outerTupleSlot;
+	TupleTableSlot *innerTupleSlot;
 	uint32		hashvalue;
 	int			batchno;
 	ParallelHashJoinState *parallel_state;
@@ -701,7 +709,80 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					if (!ExecHashJoinNewBatch(node))
 						return NULL;	/* end of parallel-oblivious join */
 				}
-				node->hj_JoinState = HJ_NEED_NEW_OUTER;
+				if (node->hj_BatchReversed)
+					node->hj_JoinState = HJ_NEED_NEW_INNER;
+				else
+					node->hj_JoinState = HJ_NEED_NEW_OUTER;
+				break;
+
+			case HJ_NEED_NEW_INNER:
+
+				/*
+				 * The hash table of this batch holds the outer tuples, probe
+				 * it with the next tuple of the inner batch file.
+				 */
+				innerTupleSlot = ExecHashJoinInnerGetTuple(node, &hashvalue);
+				if (TupIsNull(innerTupleSlot))
+				{
+					node->hj_JoinState = HJ_NEED_NEW_BATCH;
+					continue;
+				}
+
+				econtext->ecxt_innertuple = innerTupleSlot;
+				node->hj_CurHashValue = hashvalue;
+				ExecHashGetBucketAndBatch(hashtable, hashvalue,
+										  &node->hj_CurBucketNo, &batchno);
+				node->hj_CurTuple = NULL;
+
+				/*
+				 * The tuple might belong to a later batch, if nbatch was
+				 * increased after it was written.
+				 */
+				if (batchno != hashtable->curbatch)
+				{
+					bool		shouldFree;
+					MinimalTuple mintuple = ExecFetchSlotMinimalTuple(innerTupleSlot,
+																	  &shouldFree);
+
+					Assert(batchno > hashtable->curbatch);
+					ExecHashJoinSaveTuple(&node->js.ps, mintuple,
+										  hashvalue,
+										  hashtable,
+										  &hashtable->innerBatchFile[batchno],
+										  hashtable->bfCxt);
+
+					if (shouldFree)
+						heap_free_minimal_tuple(mintuple);
+
+					continue;
+				}
+
+				node->hj_JoinState = HJ_SCAN_OUTER_BUCKET;
+
+				/* FALL THRU */
+
+			case HJ_SCAN_OUTER_BUCKET:
+
+				/*
+				 * Scan the selected hash bucket for outer tuples matching the
+				 * current inner tuple.  Only inner joins are reversed, so
+				 * there is no match state to keep, and no fill to do.
+				 */
+				if (!ExecScanHashBucketReversed(node, econtext))
+				{
+					node->hj_JoinState = HJ_NEED_NEW_INNER;
+					continue;
+				}
+
+				if (joinqual == NULL || ExecQual(joinqual, econtext))
+				{
+					if (otherqual == NULL || ExecQual(otherqual, econtext))
+						return ExecProject(node->js.ps.ps_ProjInfo);
+					else
+						InstrCountFiltered2(node, 1);
+				}
+				else
+					InstrCountFiltered1(node, 1);
 				break;
 
 			default:
@@ -986,6 +1067,7 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
+	hjstate->hj_BatchReversed = false;
 	hjstate->worker_id = -1;
 
 	/* Setup the relationship of HashJoin, Hash and RuntimeFilter node. */
@@ -1254,11 +1336,20 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	{
 		/*
 		 * We no longer need the previous outer batch file; close it right
-		 * away to free disk space.
+		 * away to free disk space.  For a role-reversed batch, it is the
+		 * inner batch file that we have been reading.
 		 */
 		if (hashtable->outerBatchFile[curbatch])
 			BufFileClose(hashtable->outerBatchFile[curbatch]);
 		hashtable->outerBatchFile[curbatch] = NULL;
+
+		if (hjstate->hj_BatchReversed)
+		{
+			if (hashtable->innerBatchFile[curbatch])
+				BufFileClose(hashtable->innerBatchFile[curbatch]);
+			hashtable->innerBatchFile[curbatch] = NULL;
+			hjstate->hj_BatchReversed = false;
+		}
 	}
 	else						/* we just finished the first batch */
 	{
@@ -1375,6 +1466,9 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	if (curbatch >= nbatch)
 		return false;			/* no more batches */
 
+	if (ExecHashJoinReverseBatch(hjstate))
+		return true;
+
 	if (!ExecHashJoinReloadHashTable(hjstate))
 	{
 		/* We no longer continue as we couldn't load the batch */
@@ -1738,6 +1832,7 @@ ExecReScanHashJoin(HashJoinState *node)
 
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
+	node->hj_BatchReversed = false;
 
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
@@ -1953,6 +2048,201 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 	return true;
 }
 
+/*
+ * ExecHashJoinReverseBatch
+ *		Build the hash table of the current batch from its outer side, if
+ *		that is the better choice.
+ *
+ * When the inner side was underestimated, or one of its batches could not
+ * be split because of skew, a later inner batch can be much larger than
+ * the matching outer batch, or even than the memory we have.  Loading the
+ * inner batch would then split it into yet more batches, or overrun the
+ * memory.  For an inner join, building the hash table from the outer batch
+ * and probing it with the inner tuples gives the same result, so we do that
+ * instead when the outer batch is less than half the size of the inner one
+ * and fits in memory.
+ *
+ * Returns true if the hash table was built from the outer batch.  The inner
+ * batch file is then rewound, to be read by ExecHashJoinInnerGetTuple().
+ */
+static bool
+ExecHashJoinReverseBatch(HashJoinState *hjstate)
+{
+	HashState  *hashState = (HashState *) innerPlanState(hjstate);
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			curbatch = hashtable->curbatch;
+	BufFile    *innerFile = hashtable->innerBatchFile[curbatch];
+	BufFile    *outerFile = hashtable->outerBatchFile[curbatch];
+	TupleTableSlot *slot;
+	uint32		hashvalue;
+	int64		innerSize;
+	int64		outerSize;
+	bool		growEnabled;
+
+	/*
+	 * Only inner joins, as the outer tuples carry no match flags and nothing
+	 * tracks which inner tuples found a match.  A rescannable join must keep
+	 * its inner batches as they are.
+	 */
+	if (!gp_hashjoin_role_reversal ||
+		hjstate->js.jointype != JOIN_INNER ||
+		hjstate->reuse_hashtable ||
+		innerFile == NULL || outerFile == NULL)
+		return false;
+
+	/*
+	 * Leave half of the memory for the hash table overhead and the buckets,
+	 * as the outer batch cannot be split if it turns out to be too big.
+	 * Compare the sizes of the tuples as written, BufFileSize() would give
+	 * the compressed size and miss what is still buffered.
+	 */
+	innerSize = BufFileBytesWritten(innerFile);
+	outerSize = BufFileBytesWritten(outerFile);
+	if (outerSize > hashtable->spaceAllowed / 2 ||
+		outerSize * 2 >= innerSize)
+		return false;
+
+	elog(gp_workfile_caching_loglevel,
+		 "HashJoin building batch %d from the outer side, inner " INT64_FORMAT " bytes, outer " INT64_FORMAT " bytes",
+		 curbatch, innerSize, outerSize);
+
+	ExecHashTableReset(hashState, hashtable);
+
+	if (BufFileSeek(outerFile, 0, 0L, SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file")));
+
+	/* The outer tuples must all stay in memory, don't add batches */
+	growEnabled = hashtable->growEnabled;
+	hashtable->growEnabled = false;
+
+	while ((slot = ExecHashJoinGetSavedTuple(hjstate, outerFile, &hashvalue,
+											 hjstate->hj_OuterTupleSlot)) != NULL)
+	{
+		int			bucketno;
+		int			batchno;
+
+		if (QueryFinishPending)
+			break;
+
+		/*
+		 * A tuple that belongs to a later batch, because nbatch was increased
+		 * after it was written, goes to that batch's outer file.
+		 */
+		ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+		if (batchno != curbatch)
+		{
+			bool		shouldFree;
+			MinimalTuple mintuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+			Assert(batchno > curbatch);
+			ExecHashJoinSaveTuple(&hjstate->js.ps, mintuple,
+								  hashvalue,
+								  hashtable,
+								  &hashtable->outerBatchFile[batchno],
+								  hashtable->bfCxt);
+			if (shouldFree)
+				heap_free_minimal_tuple(mintuple);
+			continue;
+		}
+
+		(void) ExecHashTableInsert(hashState, hashtable, slot, hashvalue);
+	}
+
+	hashtable->growEnabled = growEnabled;
+
+	BufFileClose(outerFile);
+	hashtable->outerBatchFile[curbatch] = NULL;
+
+	if (BufFileSeek(innerFile, 0, 0L, SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file")));
+
+	/* The inner file is complete on disk once rewound */
+	if (hjstate->js.ps.instrument && hjstate->js.ps.instrument->need_cdb)
+	{
+		Assert(hashtable->stats);
+		hashtable->stats->batchstats[curbatch].innerfilesize =
+			BufFileSize(innerFile);
+		hashtable->stats->reversedbatches++;
+	}
+
+	hjstate->hj_BatchReversed = true;
+
+	return true;
+}
+
+/*
+ * ExecHashJoinInnerGetTuple
+ *		get the next inner tuple of a role-reversed batch
+ *
+ * Returns NULL at the end of the batch.  On success, *hashvalue is set to
+ * the tuple's hash value.
+ */
+static TupleTableSlot *
+ExecHashJoinInnerGetTuple(HashJoinState *hjstate, uint32 *hashvalue)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	BufFile    *file = hashtable->innerBatchFile[hashtable->curbatch];
+
+	Assert(hjstate->hj_BatchReversed);
+
+	if (file == NULL || QueryFinishPending)
+		return NULL;
+
+	return ExecHashJoinGetSavedTuple(hjstate, file, hashvalue,
+									 hjstate->hj_HashTupleSlot);
+}
+
+/*
+ * ExecScanHashBucketReversed
+ *		scan a bucket of a role-reversed batch for matches to the current
+ *		inner tuple
+ *
+ * Like ExecScanHashBucket(), with the sides swapped: the current inner
+ * tuple must be stored in econtext->ecxt_innertuple, and on success the
+ * matching outer tuple is stored into econtext->ecxt_outertuple, using
+ * hjstate->hj_OuterTupleSlot.  The hash clauses refer to each side
+ * explicitly, so they work the same either way.
+ */
+static bool
+ExecScanHashBucketReversed(HashJoinState *hjstate, ExprContext *econtext)
+{
+	ExprState  *hjclauses = hjstate->hashqualclauses;
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
+	uint32		hashvalue = hjstate->hj_CurHashValue;
+
+	if (hashTuple != NULL)
+		hashTuple = hashTuple->next.unshared;
+	else
+		hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+
+	while (hashTuple != NULL)
+	{
+		if (hashTuple->hashvalue == hashvalue)
+		{
+			/* the outer slot need not be a minimal tuple slot */
+			ExecForceStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+									   hjstate->hj_OuterTupleSlot,
+									   false);	/* do not pfree */
+			econtext->ecxt_outertuple = hjstate->hj_OuterTupleSlot;
+
+			if (ExecQualAndReset(hjclauses, econtext))
+			{
+				hjstate->hj_CurTuple = hashTuple;
+				return true;
+			}
+		}
+
+		hashTuple = hashTuple->next.unshared;
+	}
+
+	return false;
+}
+
 void
 ExecShutdownHashJoin(HashJoinState *node)
 {
@@ -31,6 +31,7 @@
 #include "access/relscan.h"
 #include "access/session.h"
 #include "access/tableam.h"
+#include "executor/execBatchQual.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
 #include "utils/rel.h"
@@ -40,8 +41,13 @@
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbvars.h"
+#include "utils/guc.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static TupleTableSlot *SeqNextBatch(SeqScanState *node);
+static void ExecSeqScanClearBatch(SeqScanState *node);
+static TupleTableSlot **ExecSeqScanBatchSlots(EState *estate, Relation rel,
+											  List **batchslots);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -91,6 +97,57 @@ SeqNext(SeqScanState *node)
 	return NULL;
 }
 
+/* ----------------------------------------------------------------
+ *		SeqNextBatch
+ *
+ *		Like SeqNext, but reads BATCH_QUAL_SIZE tuples at a time, and
+ *		returns only those that pass the batch qual.  ExecScan() then
+ *		checks the rest of the qual on them, as usual.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+SeqNextBatch(SeqScanState *node)
+{
+	while (node->batchpos >= node->nbatchsel)
+	{
+		int			ntuples;
+
+		if (node->batchdone)
+			return NULL;
+
+		for (ntuples = 0; ntuples < BATCH_QUAL_SIZE; ntuples++)
+		{
+			TupleTableSlot *slot = SeqNext(node);
+
+			if (slot == NULL)
+			{
+				/* don't ask the table AM again, it could start over */
+				node->batchdone = true;
+				break;
+			}
+
+			/*
+			 * For heap tables, this only takes another pin on the buffer.
+			 * The copy doesn't keep the identity of the row, which tableoid,
+			 * ctid and a DELETE or UPDATE above the scan need.
+			 */
+			ExecCopySlot(node->batchslots[ntuples], slot);
+			node->batchslots[ntuples]->tts_tableOid = slot->tts_tableOid;
+			node->batchslots[ntuples]->tts_tid = slot->tts_tid;
+		}
+
+		node->nbatchsel = ExecBatchQual(node->batchqual, node->batchslots,
+										ntuples, node->batchsel);
+		node->batchpos = 0;
+
+		/* nfiltered2 tells EXPLAIN how many of those the batch removed */
+		InstrCountFiltered1(node, ntuples - node->nbatchsel);
+		InstrCountFiltered2(node, ntuples - node->nbatchsel);
+	}
+
+	return node->batchslots[node->batchsel[node->batchpos++]];
+}
+
 /*
  * SeqRecheck -- access method routine to recheck a tuple in EvalPlanQual
  */
@@ -123,6 +180,16 @@ ExecSeqScan(PlanState *pstate)
 					(ExecScanRecheckMtd) SeqRecheck);
 }
 
+static TupleTableSlot *
+ExecSeqScanBatch(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+
+	return ExecScan(&node->ss,
+					(ExecScanAccessMtd) SeqNextBatch,
+					(ExecScanRecheckMtd) SeqRecheck);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSeqScan
  * ----------------------------------------------------------------
@@ -138,14 +205,20 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	 */
 	currentRelation = ExecOpenScanRelation(estate, node->scanrelid, eflags);
 
-	return ExecInitSeqScanForPartition(node, estate, currentRelation);
+	return ExecInitSeqScanForPartition(node, estate, currentRelation, NULL);
 }
 
+/*
+ * Like ExecInitSeqScan, but for a relation the caller has opened.  A
+ * DynamicSeqScan calls this for each partition, and passes 'batchslots' to
+ * share the slots of the batches between them, see ExecSeqScanBatchSlots().
+ */
 SeqScanState *
 ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
-							Relation currentRelation)
+							Relation currentRelation, List **batchslots)
 {
 	SeqScanState *scanstate;
+	List	   *qual = node->plan.qual;
 
 	/*
 	 * Once upon a time it was possible to have an outerPlan of a SeqScan, but
@@ -185,15 +258,110 @@ ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
 	ExecInitResultTypeTL(&scanstate->ss.ps);
 	ExecAssignScanProjectionInfo(&scanstate->ss);
 
+	/*
+	 * GPDB: evaluate the simple comparisons of the qual over batches of
+	 * tuples.  Not for scans that may run backwards or recheck tuples for
+	 * EvalPlanQual, which both expect to see one tuple at a time.  Column
+	 * oriented tables with predicate pushdown are left alone too: their scan
+	 * evaluates the single column clauses before reading the other columns,
+	 * which saves more than batching the comparisons would.
+	 */
+	if (gp_enable_batch_qual && qual != NIL &&
+		estate->es_epq_active == NULL &&
+		(estate->es_top_eflags & EXEC_FLAG_BACKWARD) == 0 &&
+		!(RelationIsAoCols(currentRelation) && gp_enable_predicate_pushdown))
+	{
+		List	   *residual;
+
+		scanstate->batchqual = ExecInitBatchQual(qual, &residual);
+		if (scanstate->batchqual)
+		{
+			qual = residual;
+			scanstate->batchslots = ExecSeqScanBatchSlots(estate,
+														  currentRelation,
+														  batchslots);
+			scanstate->batchsel = palloc(BATCH_QUAL_SIZE * sizeof(int));
+			scanstate->ss.ps.ExecProcNode = ExecSeqScanBatch;
+		}
+	}
+
 	/*
 	 * initialize child expressions
 	 */
 	scanstate->ss.ps.qual =
-		ExecInitQual(node->plan.qual, (PlanState *) scanstate);
+		ExecInitQual(qual, (PlanState *) scanstate);
 
 	return scanstate;
 }
 
+/*
+ * Get the slots to collect the batches of 'rel' in.
+ *
+ * Every slot goes into the executor's tuple table, and stays there until
+ * the end of the query.  So a DynamicSeqScan must not create another set
+ * for each partition: it passes the list of the sets created for the
+ * partitions it scanned so far, and a set with the slot type of 'rel' is
+ * reused, after switching it to the tuple descriptor of 'rel'.
+ */
+static TupleTableSlot **
+ExecSeqScanBatchSlots(EState *estate, Relation rel, List **batchslots)
+{
+	const TupleTableSlotOps *ops = table_slot_callbacks(rel);
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	TupleTableSlot **slots;
+	ListCell   *lc;
+
+	if (batchslots == NULL)
+	{
+		slots = palloc(BATCH_QUAL_SIZE * sizeof(TupleTableSlot *));
+		for (int i = 0; i < BATCH_QUAL_SIZE; i++)
+			slots[i] = ExecInitExtraTupleSlot(estate, tupdesc, ops);
+		return slots;
+	}
+
+	foreach(lc, *batchslots)
+	{
+		slots = (TupleTableSlot **) lfirst(lc);
+
+		if (slots[0]->tts_ops == ops)
+		{
+			for (int i = 0; i < BATCH_QUAL_SIZE; i++)
+			{
+				if (slots[i]->tts_tupleDescriptor != tupdesc)
+					ExecSetSlotDescriptor(slots[i], tupdesc);
+			}
+			return slots;
+		}
+	}
+
+	/* the descriptor changes between partitions, so don't fix it */
+	slots = palloc(BATCH_QUAL_SIZE * sizeof(TupleTableSlot *));
+	for (int i = 0; i < BATCH_QUAL_SIZE; i++)
+	{
+		slots[i] = ExecInitExtraTupleSlot(estate, NULL, ops);
+		ExecSetSlotDescriptor(slots[i], tupdesc);
+	}
+	*batchslots = lappend(*batchslots, slots);
+
+	return slots;
+}
+
+/*
+ * Forget the current batch, and release the buffer pins it holds.
+ */
+static void
+ExecSeqScanClearBatch(SeqScanState *node)
+{
+	if (node->batchqual == NULL)
+		return;
+
+	for (int i = 0; i < BATCH_QUAL_SIZE; i++)
+		ExecClearTuple(node->batchslots[i]);
+	node->nbatchsel = 0;
+	node->batchpos = 0;
+	node->batchdone = false;
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndSeqScan
  *
@@ -221,6 +389,7 @@ ExecEndSeqScan(SeqScanState *node)
 	if (node->ss.ps.ps_ResultTupleSlot)
 		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	ExecSeqScanClearBatch(node);
 
 	/*
 	 * close heap scan
@@ -251,6 +420,8 @@ ExecReScanSeqScan(SeqScanState *node)
 		table_rescan(scan,		/* scan desc */
 					 NULL);		/* new scan keys */
 
+	ExecSeqScanClearBatch(node);
+
 	ExecScanReScan((ScanState *) node);
 }
 
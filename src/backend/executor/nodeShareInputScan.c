@@ -43,6 +43,28 @@
  * the producer when they're done reading it. The producer slice keeps the
  * underlying tuplestore open, until all the consumers have finished.
  *
+ * Streaming cross-slice shares
+ * ----------------------------
+ *
+ * Waiting for the whole input to be materialized leaves the consumers idle
+ * while the producer runs, which hurts when the shared input is large. When
+ * the plan asks for streaming (see gp_shareinput_streaming), the producer
+ * writes its input as a series of chunk files in the shared fileset
+ * instead of one tuplestore. Each chunk is advertised in shared memory
+ * ('nchunks') as soon as it is complete, and the consumers read the chunks
+ * in order while the producer is still writing the next ones. The first
+ * chunks are small, so that the consumers can start early, and they grow
+ * up to SHAREINPUT_STREAM_MAX_CHUNK. 'ready' then means that the last
+ * chunk has been published.
+ *
+ * The producer never waits for the consumers while writing: some of them
+ * may be in its own slice, and cannot run before it returns. The chunk
+ * files are the buffer between the slices, and chunks written recently are
+ * normally still in the OS cache when the consumers read them. Every
+ * scanner, including the ones in the producer slice, keeps its own read
+ * position in a 'shareinput_stream_reader'. The producer deletes the chunks
+ * once all the consumers are done, like it ends the tuplestore otherwise.
+ *
  *
  * Portions Copyright (c) 2007-2008, Greenplum inc
  * Portions Copyright (c) 2012-Present VMware, Inc. or its affiliates.
@@ -59,10 +81,12 @@
 
 #include "access/xact.h"
 #include "cdb/cdbvars.h"
+#include "commands/tablespace.h"
 #include "executor/executor.h"
 #include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/buffile.h"
 #include "storage/condition_variable.h"
 #include "storage/lwlock.h"
 #include "storage/shmem.h"
@@ -71,6 +95,7 @@
 #include "utils/memutils.h"
 #include "utils/resowner.h"
 #include "utils/tuplestore.h"
+#include "utils/workfile_mgr.h"
 #include "port/atomics.h"
 
 /*
@@ -105,11 +130,13 @@ typedef struct shareinput_Xslice_state
 	int			refcount;		/* reference count of this entry */
 	pg_atomic_uint32	ready;	/* is the input fully materialized and ready to be read? */
 	pg_atomic_uint32	ndone;	/* # of consumers that have finished the scan */
+	pg_atomic_uint32	nchunks;	/* # of chunks published, if streaming */
 
 	/*
 	 * ready_done_cv is used for signaling when the scan becomes "ready", and
 	 * when it becomes "done". The producer wakes up everyone waiting on this
-	 * condition variable when it sets ready = true. Also, when the last
+	 * condition variable when it sets ready = true, and when it publishes a
+	 * chunk of a streaming share. Also, when the last
 	 * consumer finishes the scan (ndone reaches nconsumers), it wakes up the
 	 * producer using this same condition variable.
 	 */
@@ -180,8 +207,28 @@ typedef struct shareinput_local_state
 
 	/* Tuplestore that holds the result */
 	Tuplestorestate *ts_state;
+
+	/* Chunk files written by the producer of a streaming share */
+	BufFile   **chunks;
+	int			nchunks;
+	workfile_set *work_set;
 } shareinput_local_state;
 
+/*
+ * Size of the chunks of a streaming share. The first chunk is small so that
+ * the consumers can start soon, and each following one is twice as large,
+ * up to the maximum.
+ */
+#define SHAREINPUT_STREAM_FIRST_CHUNK	(256 * 1024)
+#define SHAREINPUT_STREAM_MAX_CHUNK		(64 * 1024 * 1024)
+
+/* Read position of a scanner in a streaming share */
+typedef struct shareinput_stream_reader
+{
+	int			chunkno;		/* chunk being read, or the next to open */
+	BufFile    *file;			/* open chunk, or NULL */
+} shareinput_stream_reader;
+
 static shareinput_Xslice_reference *get_shareinput_reference(int share_id);
 static void release_shareinput_reference(shareinput_Xslice_reference *ref, bool reader_squelching);
 static void shareinput_release_callback(ResourceReleasePhase phase,
@@ -193,6 +240,14 @@ static void shareinput_writer_notifyready(shareinput_Xslice_reference *ref);
 static void shareinput_reader_waitready(shareinput_Xslice_reference *ref);
 static void shareinput_reader_notifydone(shareinput_Xslice_reference *ref, int nconsumers);
 static void shareinput_writer_waitdone(shareinput_Xslice_reference *ref, int nconsumers);
+static void shareinput_writer_notifychunk(shareinput_Xslice_reference *ref, int nchunks);
+static bool shareinput_reader_waitchunk(shareinput_Xslice_reference *ref, int chunkno);
+
+static void shareinput_create_chunkname(char *p, int size, int share_id, int chunkno);
+static void shareinput_stream_write(ShareInputScanState *node);
+static bool shareinput_stream_gettupleslot(ShareInputScanState *node, TupleTableSlot *slot);
+static void shareinput_stream_close_reader(ShareInputScanState *node);
+static void shareinput_stream_drop(shareinput_local_state *local_state, int share_id);
 
 static void ExecShareInputScanExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
@@ -222,6 +277,30 @@ init_tuplestore_state(ShareInputScanState *node)
 			elog(ERROR, "cannot execute ShareInputScan that was not initialized");
 	}
 
+	if (sisc->streaming)
+	{
+		Assert(sisc->cross_slice);
+
+		/*
+		 * The producer writes out its whole input right away, publishing it
+		 * chunk by chunk. Consumers don't wait for anything here, they wait
+		 * for each chunk as they get to it.
+		 */
+		if (!local_state->ready)
+		{
+			if (currentSliceId == sisc->producer_slice_id)
+			{
+				shareinput_stream_write(node);
+				shareinput_writer_notifyready(node->ref);
+			}
+			local_state->ready = true;
+		}
+
+		node->stream = palloc0(sizeof(shareinput_stream_reader));
+		node->isready = true;
+		return;
+	}
+
 	if (!local_state->ready)
 	{
 		if (currentSliceId == sisc->producer_slice_id || estate->es_plannedstmt->numSlices == 1)
@@ -380,6 +459,19 @@ ExecShareInputScan(PlanState *pstate)
 
 	Assert(!node->local_state->closed);
 
+	if (sisc->streaming)
+	{
+		if (!forward)
+			elog(ERROR, "backward scan is not supported by a streaming ShareInputScan");
+
+		if (!shareinput_stream_gettupleslot(node, slot))
+			return NULL;
+
+		SIMPLE_FAULT_INJECTOR("execshare_input_next");
+
+		return slot;
+	}
+
 	tuplestore_select_read_pointer(node->ts_state, node->ts_pos);
 	while(1)
 	{
@@ -420,6 +512,7 @@ ExecInitShareInputScan(ShareInputScan *node, EState *estate, int eflags)
 
 	sisstate->ts_state = NULL;
 	sisstate->ts_pos = -1;
+	sisstate->stream = NULL;
 
 	/*
 	 * init child node.
@@ -553,6 +646,8 @@ ExecEndShareInputScan(ShareInputScanState *node)
 	/* clean up tuple table */
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 
+	shareinput_stream_close_reader(node);
+
 	if (node->ref)
 	{
 		if (sisc->this_slice_id == currentSliceId || estate->es_plannedstmt->numSlices == 1)
@@ -567,6 +662,9 @@ ExecEndShareInputScan(ShareInputScanState *node)
 				if (!local_state->ready)
 					init_tuplestore_state(node);
 				shareinput_writer_waitdone(node->ref, sisc->nconsumers);
+
+				if (sisc->streaming)
+					shareinput_stream_drop(local_state, sisc->share_id);
 			}
 			else
 			{
@@ -607,6 +705,14 @@ ExecReScanShareInputScan(ShareInputScanState *node)
 		init_tuplestore_state(node);
 
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	if (node->stream)
+	{
+		shareinput_stream_close_reader(node);
+		node->stream->chunkno = 0;
+		return;
+	}
+
 	Assert(node->ts_pos != -1);
 
 	tuplestore_select_read_pointer(node->ts_state, node->ts_pos);
@@ -664,6 +770,8 @@ ExecSquelchShareInputScan(ShareInputScanState *node, bool force)
 			/* We are a consumer. Let the producer know that we're done. */
 			Assert(!local_state->closed);
 
+			shareinput_stream_close_reader(node);
+
 			local_state->ndone++;
 
 			if (local_state->ndone == local_state->nsharers)
@@ -837,6 +945,7 @@ get_shareinput_reference(int share_id)
 		xslice_state->refcount = 0;
 		pg_atomic_init_u32(&xslice_state->ready, 0);
 		pg_atomic_init_u32(&xslice_state->ndone, 0);
+		pg_atomic_init_u32(&xslice_state->nchunks, 0);
 
 		ConditionVariableInit(&xslice_state->ready_done_cv);
 		elog((Debug_shareinput_xslice ? LOG : DEBUG1), "SISC (shareid=%d, slice=%d): initialized xslice state",
@@ -1062,3 +1171,271 @@ shareinput_writer_waitdone(shareinput_Xslice_reference *ref, int nconsumers)
 
 	/* it's all done now */
 }
+
+/*
+ * shareinput_writer_notifychunk
+ *
+ *  Called by the writer (producer) of a streaming share, once the first
+ *  'nchunks' chunks are written and can be read by the readers (consumers).
+ */
+static void
+shareinput_writer_notifychunk(shareinput_Xslice_reference *ref, int nchunks)
+{
+	shareinput_Xslice_state *state = ref->xslice_state;
+
+	/* the chunk must be on disk before anyone can see it */
+	pg_write_barrier();
+	pg_atomic_write_u32(&state->nchunks, nchunks);
+
+	ConditionVariableBroadcast(&state->ready_done_cv);
+}
+
+/*
+ * shareinput_reader_waitchunk
+ *
+ *  Called by the reader (consumer) of a streaming share to wait until chunk
+ *  'chunkno' is published. Returns false if the writer finished without
+ *  writing that chunk, i.e. the reader has seen all the tuples.
+ *
+ *  This is a blocking operation.
+ */
+static bool
+shareinput_reader_waitchunk(shareinput_Xslice_reference *ref, int chunkno)
+{
+	shareinput_Xslice_state *state = ref->xslice_state;
+	bool		found;
+
+	for (;;)
+	{
+		/*
+		 * Check 'ready' first: the writer sets it after publishing the last
+		 * chunk, so if it is set, 'nchunks' is final.
+		 */
+		uint32		ready = pg_atomic_read_u32(&state->ready);
+
+		pg_read_barrier();
+		if (pg_atomic_read_u32(&state->nchunks) > (uint32) chunkno)
+		{
+			found = true;
+			break;
+		}
+		if (ready)
+		{
+			found = false;
+			break;
+		}
+
+		elog((Debug_shareinput_xslice ? LOG : DEBUG1), "SISC READER (shareid=%d, slice=%d): Waiting for chunk %d",
+			 ref->share_id, currentSliceId, chunkno);
+
+		ConditionVariableSleep(&state->ready_done_cv, WAIT_EVENT_SHAREINPUT_SCAN);
+	}
+	ConditionVariableCancelSleep();
+
+	return found;
+}
+
+
+/*************************************************************************
+ * Streaming cross-slice shares.
+ **************************************************************************/
+
+/*
+ * shareinput_create_chunkname() constructs the name of a chunk file of a
+ * streaming share.
+ */
+static void
+shareinput_create_chunkname(char *p, int size, int share_id, int chunkno)
+{
+	char		prefix[100];
+
+	shareinput_create_bufname_prefix(prefix, sizeof(prefix), share_id);
+	snprintf(p, size, "%s_chunk%d", prefix, chunkno);
+}
+
+/*
+ * shareinput_stream_write
+ *
+ *  Run the shared child node to completion, writing its tuples to chunk
+ *  files and publishing every chunk as soon as it is complete.
+ *
+ *  The chunks are kept open until the share is dropped, so that the space
+ *  they use stays accounted to the workfile set.
+ */
+static void
+shareinput_stream_write(ShareInputScanState *node)
+{
+	ShareInputScan *sisc = (ShareInputScan *) node->ss.ps.plan;
+	shareinput_local_state *local_state = node->local_state;
+	SharedFileSet *fileset = get_shareinput_fileset();
+	BufFile    *file = NULL;
+	Size		chunk_size = SHAREINPUT_STREAM_FIRST_CHUNK;
+	Size		written = 0;
+	int			maxchunks = 8;
+	char		name[MAXPGPATH];
+
+	elog((Debug_shareinput_xslice ? LOG : DEBUG1), "SISC WRITER (shareid=%d, slice=%d): streaming input to consumers",
+		 sisc->share_id, currentSliceId);
+
+	shareinput_create_bufname_prefix(name, sizeof(name), sisc->share_id);
+	local_state->work_set = workfile_mgr_create_set("SharedTupleStream", name, true /* hold pin */);
+	local_state->chunks = palloc(maxchunks * sizeof(BufFile *));
+	local_state->nchunks = 0;
+
+	PrepareTempTablespaces();
+
+	for (;;)
+	{
+		TupleTableSlot *outerslot;
+		MinimalTuple tuple;
+		bool		shouldFree;
+
+		outerslot = ExecProcNode(local_state->childState);
+		if (TupIsNull(outerslot))
+			break;
+
+		if (file == NULL)
+		{
+			if (local_state->nchunks == maxchunks)
+			{
+				maxchunks *= 2;
+				local_state->chunks = repalloc(local_state->chunks,
+											   maxchunks * sizeof(BufFile *));
+			}
+			shareinput_create_chunkname(name, sizeof(name), sisc->share_id,
+										local_state->nchunks);
+			file = BufFileCreateShared(fileset, name, local_state->work_set);
+			local_state->chunks[local_state->nchunks] = file;
+		}
+
+		tuple = ExecFetchSlotMinimalTuple(outerslot, &shouldFree);
+		BufFileWrite(file, tuple, tuple->t_len);
+		written += tuple->t_len;
+		if (shouldFree)
+			pfree(tuple);
+
+		if (written >= chunk_size)
+		{
+			BufFileExportShared(file);
+			file = NULL;
+			shareinput_writer_notifychunk(node->ref, ++local_state->nchunks);
+
+			written = 0;
+			chunk_size = Min(chunk_size * 2, SHAREINPUT_STREAM_MAX_CHUNK);
+		}
+	}
+
+	/* publish the last, partial chunk */
+	if (file != NULL)
+	{
+		BufFileExportShared(file);
+		shareinput_writer_notifychunk(node->ref, ++local_state->nchunks);
+	}
+
+	elog((Debug_shareinput_xslice ? LOG : DEBUG1), "SISC WRITER (shareid=%d, slice=%d): wrote %d chunks",
+		 sisc->share_id, currentSliceId, local_state->nchunks);
+}
+
+/*
+ * shareinput_stream_gettupleslot
+ *
+ *  Fetch the next tuple of a streaming share into 'slot', waiting for the
+ *  producer if it has not been written yet. Returns false at the end.
+ */
+static bool
+shareinput_stream_gettupleslot(ShareInputScanState *node, TupleTableSlot *slot)
+{
+	ShareInputScan *sisc = (ShareInputScan *) node->ss.ps.plan;
+	shareinput_stream_reader *reader = node->stream;
+
+	for (;;)
+	{
+		MinimalTuple tuple;
+		uint32		len;
+		size_t		nread;
+
+		if (reader->file == NULL)
+		{
+			char		name[MAXPGPATH];
+
+			if (!shareinput_reader_waitchunk(node->ref, reader->chunkno))
+			{
+				ExecClearTuple(slot);
+				return false;
+			}
+
+			shareinput_create_chunkname(name, sizeof(name), sisc->share_id,
+										reader->chunkno);
+			reader->file = BufFileOpenShared(get_shareinput_fileset(), name, O_RDONLY);
+		}
+
+		/* a MinimalTuple starts with its length */
+		nread = BufFileRead(reader->file, &len, sizeof(len));
+		if (nread == 0)
+		{
+			/* end of this chunk, move on to the next one */
+			shareinput_stream_close_reader(node);
+			reader->chunkno++;
+			continue;
+		}
+		if (nread != sizeof(len))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from shared scan temporary file: read only %zu of %zu bytes",
+							nread, sizeof(len))));
+
+		tuple = (MinimalTuple) palloc(len);
+		tuple->t_len = len;
+		nread = BufFileRead(reader->file, (char *) tuple + sizeof(len),
+							len - sizeof(len));
+		if (nread != len - sizeof(len))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from shared scan temporary file: read only %zu of %zu bytes",
+							nread, len - sizeof(len))));
+
+		ExecStoreMinimalTuple(tuple, slot, true);
+		return true;
+	}
+}
+
+/*
+ * Close the chunk this scanner is reading, if any.
+ */
+static void
+shareinput_stream_close_reader(ShareInputScanState *node)
+{
+	if (node->stream && node->stream->file)
+	{
+		BufFileClose(node->stream->file);
+		node->stream->file = NULL;
+	}
+}
+
+/*
+ * shareinput_stream_drop
+ *
+ *  Called by the producer of a streaming share once all the consumers are
+ *  done, to remove the chunk files.
+ */
+static void
+shareinput_stream_drop(shareinput_local_state *local_state, int share_id)
+{
+	SharedFileSet *fileset;
+	char		name[MAXPGPATH];
+
+	if (local_state->work_set == NULL)
+		return;
+
+	fileset = get_shareinput_fileset();
+	for (int i = 0; i < local_state->nchunks; i++)
+	{
+		BufFileClose(local_state->chunks[i]);
+		shareinput_create_chunkname(name, sizeof(name), share_id, i);
+		BufFileDeleteShared(fileset, name);
+	}
+	local_state->nchunks = 0;
+
+	workfile_mgr_close_set(local_state->work_set);
+	local_state->work_set = NULL;
+}
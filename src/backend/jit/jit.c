@@ -179,6 +179,31 @@ jit_compile_expr(struct ExprState *state)
 	return false;
 }
 
+/*
+ * Ask provider to JIT compile deforming the memtuples of binding 'pbind',
+ * for a scan of an append-optimized row table under 'parent'.
+ *
+ * Returns the function, or NULL if not successful.
+ */
+MemTupleDeformFunc
+jit_compile_memtuple_deform(struct PlanState *parent,
+							struct MemTupleBinding *pbind)
+{
+	/* if no jitting should be performed at all */
+	if (!(parent->state->es_jit_flags & PGJIT_PERFORM))
+		return NULL;
+
+	/* or if deforming isn't JITed */
+	if (!(parent->state->es_jit_flags & PGJIT_DEFORM))
+		return NULL;
+
+	/* this also takes !jit_enabled into account */
+	if (provider_init() && provider.compile_memtuple_deform)
+		return provider.compile_memtuple_deform(parent, pbind);
+
+	return NULL;
+}
+
 /* Aggregate JIT instrumentation information */
 void
 InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
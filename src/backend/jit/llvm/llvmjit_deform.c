@@ -21,10 +21,13 @@
 #include <llvm-c/Core.h>
 
 #include "access/htup_details.h"
+#include "access/memtup.h"
 #include "access/tupdesc_details.h"
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "nodes/execnodes.h"
+#include "portability/instr_time.h"
 
 
 /*
@@ -754,3 +757,328 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+/*
+ * GPDB: deforming memtuples, the tuple format of append-optimized row tables.
+ *
+ * Unlike in a heap tuple, the position of every attribute in a memtuple is
+ * fixed by its binding, see memtuple.c.  Without nulls, an attribute is at
+ * its binding offset.  With nulls, the space the nulls physically preceding
+ * it saved is subtracted; that is looked up per byte of the null bitmap in
+ * the binding's null_saves table, which the caller passes in.  Varlena
+ * attributes hold the offset of their data.
+ */
+
+/*
+ * Space saved by the nulls in 'v_byte', byte 'byteno' of the null bitmap.
+ */
+static LLVMValueRef
+memtuple_null_save_b(LLVMBuilderRef b, LLVMValueRef v_null_saves, int byteno,
+					 LLVMValueRef v_byte)
+{
+	LLVMValueRef v_low;
+	LLVMValueRef v_high;
+
+	v_low = LLVMBuildZExt(b, LLVMBuildAnd(b, v_byte, l_int8_const(0xF), ""),
+						  LLVMInt32Type(), "");
+	v_low = LLVMBuildAdd(b, v_low, l_int32_const(byteno * 32), "");
+	v_low = LLVMBuildSExt(b, l_load_gep1(b, v_null_saves, v_low, "save_low"),
+						  LLVMInt32Type(), "");
+
+	v_high = LLVMBuildZExt(b, LLVMBuildLShr(b, v_byte, l_int8_const(4), ""),
+						   LLVMInt32Type(), "");
+	v_high = LLVMBuildAdd(b, v_high, l_int32_const(byteno * 32 + 16), "");
+	v_high = LLVMBuildSExt(b, l_load_gep1(b, v_null_saves, v_high, "save_high"),
+						   LLVMInt32Type(), "");
+
+	return LLVMBuildAdd(b, v_low, v_high, "");
+}
+
+/*
+ * Store attribute 'attnum', which is at offset 'v_off' from 'v_start'.
+ */
+static void
+memtuple_deform_att(LLVMBuilderRef b, Form_pg_attribute att,
+					MemTupleAttrBinding *bind, int attnum,
+					LLVMValueRef v_start, LLVMValueRef v_off,
+					LLVMValueRef v_values, LLVMValueRef v_nulls)
+{
+	LLVMValueRef l_attno = l_int32_const(attnum);
+	LLVMValueRef v_attdatap;
+	LLVMValueRef v_resultp;
+
+	v_attdatap = LLVMBuildGEP(b, v_start, &v_off, 1, "");
+
+	if (bind->flag == MTB_ByRef || bind->flag == MTB_ByRef_CStr)
+	{
+		LLVMValueRef v_dataoff;
+
+		/* regular, not large, tuples use 2 byte offsets */
+		Assert(bind->len == 2);
+		v_dataoff = LLVMBuildPointerCast(b, v_attdatap,
+										 l_ptr(LLVMInt16Type()), "");
+		v_dataoff = LLVMBuildLoad(b, v_dataoff, "dataoff");
+		v_dataoff = LLVMBuildZExt(b, v_dataoff, LLVMInt32Type(), "");
+		v_attdatap = LLVMBuildGEP(b, v_start, &v_dataoff, 1, "");
+	}
+
+	v_resultp = LLVMBuildGEP(b, v_values, &l_attno, 1, "");
+
+	/* store null-byte (false) */
+	LLVMBuildStore(b, l_int8_const(0),
+				   LLVMBuildGEP(b, v_nulls, &l_attno, 1, ""));
+
+	/* store datum, like slot_compile_deform() */
+	if (att->attbyval)
+	{
+		LLVMValueRef v_tmp_loaddata;
+		LLVMTypeRef vartypep =
+		LLVMPointerType(LLVMIntType(att->attlen * 8), 0);
+
+		v_tmp_loaddata =
+			LLVMBuildPointerCast(b, v_attdatap, vartypep, "");
+		v_tmp_loaddata = LLVMBuildLoad(b, v_tmp_loaddata, "attr_byval");
+		v_tmp_loaddata = LLVMBuildZExt(b, v_tmp_loaddata, TypeSizeT, "");
+
+		LLVMBuildStore(b, v_tmp_loaddata, v_resultp);
+	}
+	else
+	{
+		LLVMValueRef v_tmp_loaddata;
+
+		/* store pointer */
+		v_tmp_loaddata =
+			LLVMBuildPtrToInt(b,
+							  v_attdatap,
+							  TypeSizeT,
+							  "attr_ptr");
+		LLVMBuildStore(b, v_tmp_loaddata, v_resultp);
+	}
+}
+
+/*
+ * Create a function that deforms all attributes of a memtuple of binding
+ * 'pbind', with the signature of MemTupleDeformFunc.  Returns its name.
+ *
+ * Only the binding of regular tuples is compiled in, the caller has to use
+ * memtuple_deform() for large ones.
+ */
+static char *
+memtuple_compile_deform(LLVMJitContext *context, MemTupleBinding *pbind)
+{
+	TupleDesc	desc = pbind->tupdesc;
+	MemTupleBindingCols *colbind = &pbind->bind;
+	int			natts = desc->natts;
+	int			nbytes = (natts + 7) >> 3;
+	char	   *funcname;
+
+	LLVMModuleRef mod;
+	LLVMBuilderRef b;
+
+	LLVMTypeRef deform_sig;
+	LLVMValueRef v_deform_fn;
+
+	LLVMBasicBlockRef b_entry;
+	LLVMBasicBlockRef b_nonulls;
+	LLVMBasicBlockRef b_nulls;
+
+	LLVMValueRef v_tuplep;
+	LLVMValueRef v_null_saves;
+	LLVMValueRef v_values;
+	LLVMValueRef v_nulls;
+	LLVMValueRef v_mtlen;
+	LLVMValueRef v_hasnulls;
+	LLVMValueRef v_start;
+	LLVMValueRef *v_nullbytes;
+	LLVMValueRef *v_bytesaves;
+
+	int			attnum;
+	int			byteno;
+
+	mod = llvm_mutable_module(context);
+
+	funcname = llvm_expand_funcname(context, "deform_memtuple");
+
+	/* Create the signature and function */
+	{
+		LLVMTypeRef param_types[4];
+
+		param_types[0] = l_ptr(LLVMInt8Type());
+		param_types[1] = l_ptr(LLVMInt16Type());
+		param_types[2] = l_ptr(TypeSizeT);
+		param_types[3] = l_ptr(TypeStorageBool);
+
+		deform_sig = LLVMFunctionType(LLVMVoidType(), param_types,
+									  lengthof(param_types), 0);
+	}
+	v_deform_fn = LLVMAddFunction(mod, funcname, deform_sig);
+	LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+	LLVMSetVisibility(v_deform_fn, LLVMDefaultVisibility);
+	llvm_copy_attributes(AttributeTemplate, v_deform_fn);
+
+	b_entry = LLVMAppendBasicBlock(v_deform_fn, "entry");
+	b_nonulls = LLVMAppendBasicBlock(v_deform_fn, "nonulls");
+	b_nulls = LLVMAppendBasicBlock(v_deform_fn, "nulls");
+
+	b = LLVMCreateBuilder();
+
+	LLVMPositionBuilderAtEnd(b, b_entry);
+
+	v_tuplep = LLVMGetParam(v_deform_fn, 0);
+	v_null_saves = LLVMGetParam(v_deform_fn, 1);
+	v_values = LLVMGetParam(v_deform_fn, 2);
+	v_nulls = LLVMGetParam(v_deform_fn, 3);
+
+	/* PRIVATE_mt_len & MEMTUP_HASNULL */
+	v_mtlen = LLVMBuildLoad(b,
+							LLVMBuildPointerCast(b, v_tuplep,
+												 l_ptr(LLVMInt32Type()), ""),
+							"mt_len");
+	v_hasnulls =
+		LLVMBuildICmp(b, LLVMIntNE,
+					  LLVMBuildAnd(b, v_mtlen,
+								   l_int32_const(MEMTUP_HASNULL), ""),
+					  l_int32_const(0),
+					  "hasnulls");
+	LLVMBuildCondBr(b, v_hasnulls, b_nulls, b_nonulls);
+
+	/* Without nulls, every attribute is at its binding offset */
+	LLVMPositionBuilderAtEnd(b, b_nonulls);
+	for (attnum = 0; attnum < natts; attnum++)
+	{
+		MemTupleAttrBinding *bind = &colbind->bindings[attnum];
+
+		memtuple_deform_att(b, TupleDescAttr(desc, attnum), bind, attnum,
+							v_tuplep, l_int32_const(bind->offset),
+							v_values, v_nulls);
+	}
+	LLVMBuildRetVoid(b);
+
+	/*
+	 * With nulls, the attributes start after the extra null bitmap bytes.
+	 * Sum up the saves of each complete bitmap byte first, so that locating
+	 * an attribute only needs the part of the byte it sits in.
+	 */
+	LLVMPositionBuilderAtEnd(b, b_nulls);
+
+	{
+		LLVMValueRef v_extra = l_int32_const(pbind->null_bitmap_extra_size);
+
+		v_start = LLVMBuildGEP(b, v_tuplep, &v_extra, 1, "start");
+	}
+
+	v_nullbytes = palloc(sizeof(LLVMValueRef) * nbytes);
+	v_bytesaves = palloc(sizeof(LLVMValueRef) * nbytes);
+	for (byteno = 0; byteno < nbytes; byteno++)
+	{
+		v_nullbytes[byteno] =
+			l_load_gep1(b, v_tuplep,
+						l_int32_const(offsetof(MemTupleData, PRIVATE_mt_bits) + byteno),
+						"nullbyte");
+		if (byteno == 0)
+			v_bytesaves[byteno] = l_int32_const(0);
+		else
+			v_bytesaves[byteno] =
+				LLVMBuildAdd(b, v_bytesaves[byteno - 1],
+							 memtuple_null_save_b(b, v_null_saves, byteno - 1,
+												  v_nullbytes[byteno - 1]),
+							 "bytesave");
+	}
+
+	for (attnum = 0; attnum < natts; attnum++)
+	{
+		MemTupleAttrBinding *bind = &colbind->bindings[attnum];
+		LLVMValueRef l_attno = l_int32_const(attnum);
+		LLVMValueRef v_nullbyte = v_nullbytes[bind->null_byte];
+		LLVMValueRef v_attisnull;
+		LLVMValueRef v_ns;
+		LLVMValueRef v_off;
+		LLVMBasicBlockRef b_ifnull;
+		LLVMBasicBlockRef b_ifnotnull;
+		LLVMBasicBlockRef b_next;
+
+		b_ifnull = l_bb_append_v(v_deform_fn, "block.attr.%d.attisnull", attnum);
+		b_ifnotnull = l_bb_append_v(v_deform_fn, "block.attr.%d.store", attnum);
+		b_next = l_bb_append_v(v_deform_fn, "block.attr.%d.next", attnum);
+
+		v_attisnull =
+			LLVMBuildICmp(b, LLVMIntNE,
+						  LLVMBuildAnd(b, v_nullbyte,
+									   l_int8_const(bind->null_mask), ""),
+						  l_int8_const(0),
+						  "attisnull");
+		LLVMBuildCondBr(b, v_attisnull, b_ifnull, b_ifnotnull);
+
+		LLVMPositionBuilderAtEnd(b, b_ifnull);
+		LLVMBuildStore(b,
+					   l_int8_const(1),
+					   LLVMBuildGEP(b, v_nulls, &l_attno, 1, ""));
+		LLVMBuildStore(b,
+					   l_sizet_const(0),
+					   LLVMBuildGEP(b, v_values, &l_attno, 1, ""));
+		LLVMBuildBr(b, b_next);
+
+		LLVMPositionBuilderAtEnd(b, b_ifnotnull);
+		v_ns = memtuple_null_save_b(b, v_null_saves, bind->null_byte,
+									LLVMBuildAnd(b, v_nullbyte,
+												 l_int8_const(bind->null_mask - 1),
+												 ""));
+		v_ns = LLVMBuildAdd(b, v_bytesaves[bind->null_byte], v_ns, "");
+		v_off = LLVMBuildSub(b, l_int32_const(bind->offset), v_ns, "off");
+		memtuple_deform_att(b, TupleDescAttr(desc, attnum), bind, attnum,
+							v_start, v_off, v_values, v_nulls);
+		LLVMBuildBr(b, b_next);
+
+		LLVMPositionBuilderAtEnd(b, b_next);
+	}
+	LLVMBuildRetVoid(b);
+
+	LLVMDisposeBuilder(b);
+
+	pfree(v_nullbytes);
+	pfree(v_bytesaves);
+
+	return funcname;
+}
+
+/*
+ * Compile deforming the memtuples of binding 'pbind' for a scan under
+ * 'parent', see memtuple_deform().  Unlike expressions, the function is
+ * emitted right away; this is called for the first tuple of the scan, by
+ * which time all expressions of the plan have been generated, so they get
+ * emitted together.
+ */
+MemTupleDeformFunc
+llvm_compile_memtuple_deform(PlanState *parent, MemTupleBinding *pbind)
+{
+	LLVMJitContext *context;
+	MemTupleDeformFunc func;
+	char	   *funcname;
+	instr_time	starttime;
+	instr_time	endtime;
+
+	llvm_enter_fatal_on_oom();
+
+	/* get or create JIT context */
+	if (parent->state->es_jit)
+		context = (LLVMJitContext *) parent->state->es_jit;
+	else
+	{
+		context = llvm_create_context(parent->state->es_jit_flags);
+		parent->state->es_jit = &context->base;
+	}
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	funcname = memtuple_compile_deform(context, pbind);
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.generation_counter,
+						  endtime, starttime);
+
+	func = (MemTupleDeformFunc) llvm_get_function(context, funcname);
+
+	llvm_leave_fatal_on_oom();
+
+	return func;
+}
@@ -1262,6 +1262,7 @@ _copyShareInputScan(const ShareInputScan *from)
 	COPY_SCALAR_FIELD(this_slice_id);
 	COPY_SCALAR_FIELD(nconsumers);
 	COPY_SCALAR_FIELD(discard_output);
+	COPY_SCALAR_FIELD(streaming);
 
 	return newnode;
 }
@@ -4401,6 +4402,7 @@ _copyRetrieveStmt(const RetrieveStmt *from)
 	COPY_STRING_FIELD(endpoint_name);
 	COPY_SCALAR_FIELD(count);
 	COPY_SCALAR_FIELD(is_all);
+	COPY_NODE_FIELD(options);
 
 	return newnode;
 }
@@ -608,6 +608,7 @@ static void check_expressions_in_partition_key(PartitionSpec *spec, core_yyscan_
 %type <defelt>	copy_generic_opt_elem
 %type <list>	copy_generic_opt_list copy_generic_opt_arg_list
 %type <list>	copy_options
+%type <list>	opt_retrieve_options
 
 %type <typnam>	Typename SimpleTypename ConstTypename
 				GenericType Numeric opt_float
@@ -15246,23 +15247,30 @@ SelectStmt: select_no_parens			%prec UMINUS
 		;
 
 RetrieveStmt:
-			RETRIEVE SignedIconst FROM ENDPOINT name
+			RETRIEVE SignedIconst FROM ENDPOINT name opt_retrieve_options
 				{
 					RetrieveStmt *n = makeNode(RetrieveStmt);
 					n->endpoint_name = $5;
 					n->count = $2;
+					n->options = $6;
 					$$ = (Node *)n;
 				}
-			| RETRIEVE ALL FROM ENDPOINT name
+			| RETRIEVE ALL FROM ENDPOINT name opt_retrieve_options
 				{
 					RetrieveStmt *n = makeNode(RetrieveStmt);
 					n->endpoint_name = $5;
 					n->count = -1;
 					n->is_all = true;
+					n->options = $6;
 					$$ = (Node *)n;
 				}
 		;
 
+opt_retrieve_options:
+			WITH '(' copy_generic_opt_list ')'		{ $$ = $3; }
+			| /*EMPTY*/								{ $$ = NIL; }
+		;
+
 select_with_parens:
 			'(' select_no_parens ')'				{ $$ = $2; }
 			| '(' select_with_parens ')'			{ $$ = $2; }
@@ -2562,12 +2562,27 @@ retry1:
 									valptr),
 							 errhint("Valid values are: \"false\", 0, \"true\", 1, \"database\".")));
 			}
+			else if (strcmp(nameptr, PQ_COLUMN_BATCHES_OPTION) == 0)
+			{
+				bool		on;
+
+				if (strcmp(valptr, "zstd") == 0)
+					port->column_batches = PQ_COLUMN_BATCHES_ZSTD;
+				else if (parse_bool(valptr, &on))
+					port->column_batches = on ? PQ_COLUMN_BATCHES_ON : PQ_COLUMN_BATCHES_OFF;
+				else
+					ereport(FATAL,
+							(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+							 errmsg("invalid value for parameter \"%s\": \"%s\"",
+									PQ_COLUMN_BATCHES_OPTION,
+									valptr),
+							 errhint("Valid values are: \"off\", \"on\", \"zstd\".")));
+			}
 			else if (strncmp(nameptr, "_pq_.", 5) == 0)
 			{
 				/*
-				 * Any option beginning with _pq_. is reserved for use as a
-				 * protocol-level option, but at present no such options are
-				 * defined.
+				 * Any other option beginning with _pq_. is reserved for use
+				 * as a protocol-level option, but is not defined yet.
 				 */
 				unrecognized_protocol_options =
 					lappend(unrecognized_protocol_options, pstrdup(nameptr));
@@ -70,6 +70,12 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000 
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * How far ahead of a sequential reader we ask the kernel to read, see
+ * BufFileReadAhead().
+ */
+#define BUFFILE_READAHEAD_SIZE	(1024 * 1024)
+
 /* To align upstream's structure, minimize the code differences */
 typedef union FakeAlignedBlock
 {
@@ -142,6 +148,19 @@ struct BufFile
 		BFS_COMPRESSED_READING
 	} state;
 
+	/*
+	 * Kernel readahead window.  readaheadFile is the component file we last
+	 * loaded from (or -1), readaheadNext the offset the next load is expected
+	 * at if the file is being read sequentially, and readaheadEnd the offset
+	 * up to which we have already asked the kernel to prefetch.
+	 */
+	int			readaheadFile;
+	off_t		readaheadNext;
+	off_t		readaheadEnd;
+
+	/* Bytes passed to BufFileWrite(), before any compression */
+	int64		bytesWritten;
+
 	/* ZStandard compression support */
 #ifdef USE_ZSTD
 	zstd_context *zstd_context;	/* ZStandard library handles. */
@@ -161,6 +180,7 @@ static BufFile *makeBufFileCommon(int nfiles);
 static BufFile *makeBufFile(File firstfile, const char *operation_name);
 static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
+static void BufFileReadAhead(BufFile *file, int fileno, off_t offset);
 static void BufFileDumpBuffer(BufFile *file);
 static void BufFileFlush(BufFile *file);
 static File MakeNewSharedSegment(BufFile *file, int segment);
@@ -187,6 +207,8 @@ makeBufFileCommon(int nfiles)
 	file->pos = 0;
 	file->nbytes = 0;
 	file->buffer.data = palloc(BLCKSZ);
+	file->readaheadFile = -1;
+	file->bytesWritten = 0;
 
 	return file;
 }
@@ -599,6 +621,8 @@ static void
 BufFileLoadBuffer(BufFile *file)
 {
 	File		thisfile;
+	instr_time	io_start,
+				io_time;
 
 	/*
 	 * Advance to next component file if necessary and possible.
@@ -610,6 +634,11 @@ BufFileLoadBuffer(BufFile *file)
 		file->curOffset = 0L;
 	}
 
+	BufFileReadAhead(file, file->curFile, file->curOffset);
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
 	/*
 	 * Read whatever we can get, up to a full bufferload.
 	 */
@@ -628,12 +657,65 @@ BufFileLoadBuffer(BufFile *file)
 						FilePathName(thisfile))));
 	}
 
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		INSTR_TIME_ADD(pgBufferUsage.temp_blk_read_time, io_time);
+	}
+
 	/* we choose not to advance curOffset here */
 
 	if (file->nbytes > 0)
 		pgBufferUsage.temp_blks_read++;
 }
 
+/*
+ * BufFileReadAhead
+ *
+ * Called before loading from 'offset' of component file 'fileno'.  If the
+ * file is being read front to back, ask the kernel to start reading the
+ * next BUFFILE_READAHEAD_SIZE bytes, so that the following loads find them
+ * in the page cache instead of each waiting for the disk in turn.  The
+ * window is topped up when the reader is half way through it.
+ *
+ * Sequential and compressed files are always read that way.  A random
+ * access file is only read ahead once it was loaded from two adjacent
+ * places in a row, which is the common case for spilled batches and
+ * tuplestores, but not for the scattered blocks of a logical tape set.
+ */
+static void
+BufFileReadAhead(BufFile *file, int fileno, off_t offset)
+{
+#ifdef USE_PREFETCH
+	bool		sequential;
+
+	sequential = (file->state != BFS_RANDOM_ACCESS ||
+				  (fileno == file->readaheadFile &&
+				   offset == file->readaheadNext));
+
+	if (fileno != file->readaheadFile || offset < file->readaheadNext ||
+		offset > file->readaheadEnd)
+	{
+		/* Moved elsewhere, whatever we prefetched so far is of no use */
+		file->readaheadFile = fileno;
+		file->readaheadEnd = offset;
+	}
+	file->readaheadNext = offset + BLCKSZ;
+
+	if (sequential &&
+		offset + BUFFILE_READAHEAD_SIZE / 2 >= file->readaheadEnd)
+	{
+		off_t		start = Max(offset, file->readaheadEnd);
+		off_t		end = offset + BUFFILE_READAHEAD_SIZE;
+
+		(void) FilePrefetch(file->files[fileno], start, (int) (end - start),
+							WAIT_EVENT_BUFFILE_READ);
+		file->readaheadEnd = end;
+	}
+#endif							/* USE_PREFETCH */
+}
+
 /*
  * BufFileDumpBuffer
  *
@@ -647,6 +729,8 @@ BufFileDumpBuffer(BufFile *file)
 	int			wpos = 0;
 	int			bytestowrite;
 	File		thisfile;
+	instr_time	io_start,
+				io_time;
 
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
@@ -676,6 +760,9 @@ BufFileDumpBuffer(BufFile *file)
 		if ((off_t) bytestowrite > availbytes)
 			bytestowrite = (int) availbytes;
 
+		if (track_io_timing)
+			INSTR_TIME_SET_CURRENT(io_start);
+
 		thisfile = file->files[file->curFile];
 		bytestowrite = FileWrite(thisfile,
 								 file->buffer.data + wpos,
@@ -687,6 +774,14 @@ BufFileDumpBuffer(BufFile *file)
 					(errcode_for_file_access(),
 					 errmsg("could not write to file \"%s\": %m",
 							FilePathName(thisfile))));
+
+		if (track_io_timing)
+		{
+			INSTR_TIME_SET_CURRENT(io_time);
+			INSTR_TIME_SUBTRACT(io_time, io_start);
+			INSTR_TIME_ADD(pgBufferUsage.temp_blk_write_time, io_time);
+		}
+
 		file->curOffset += bytestowrite;
 		wpos += bytestowrite;
 
@@ -829,6 +924,8 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 
 	SIMPLE_FAULT_INJECTOR("workfile_write_failure");
 
+	file->bytesWritten += size;
+
 	switch (file->state)
 	{
 		case BFS_RANDOM_ACCESS:
@@ -1114,6 +1211,18 @@ BufFileSize(BufFile *file)
 		lastFileSize;
 }
 
+/*
+ * Return the number of bytes written to the BufFile, before compression.
+ *
+ * Unlike BufFileSize(), this includes the data not flushed to disk yet.  It
+ * is the size of the file's contents for a sequential BufFile.
+ */
+int64
+BufFileBytesWritten(BufFile *file)
+{
+	return file->bytesWritten;
+}
+
 /*
  * Append the contents of source file (managed within shared fileset) to
  * end of target file (managed within same shared fileset).
@@ -1326,6 +1435,44 @@ BufFileStartCompression(BufFile *file)
 	file->state = BFS_COMPRESSED_WRITING;
 }
 
+/*
+ * Write a chunk of compressed data at the given offset of the file, and
+ * account for it like BufFileDumpBuffer() does for a block.
+ */
+static int
+BufFileWriteCompressed(BufFile *file, const void *buffer, size_t nbytes,
+					   off_t offset)
+{
+	instr_time	io_start,
+				io_time;
+	int			wrote;
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+
+	wrote = FileWrite(file->files[0], (char *) buffer, nbytes, offset, WAIT_EVENT_BUFFILE_WRITE);
+	if (wrote != nbytes)
+		elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) nbytes);
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_SUBTRACT(io_time, io_start);
+		INSTR_TIME_ADD(pgBufferUsage.temp_blk_write_time, io_time);
+	}
+
+	/*
+	 * The chunks are appended one after the other, count the blocks they
+	 * reach into for the first time.  That adds up to the size of the
+	 * compressed file in blocks, like the uncompressed file is counted.
+	 */
+	if (wrote > 0)
+		pgBufferUsage.temp_blks_written +=
+			(offset + wrote + BLCKSZ - 1) / BLCKSZ - (offset + BLCKSZ - 1) / BLCKSZ;
+
+	return wrote;
+}
+
 static void
 BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 {
@@ -1357,13 +1504,15 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 		{
 			int			wrote;
 
-			wrote = FileWrite(file->files[0], output.dst, output.pos, file->curOffset + file->pos + pos, WAIT_EVENT_BUFFILE_WRITE);
-			if (wrote != output.pos)
-				elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
+			wrote = BufFileWriteCompressed(file, output.dst, output.pos,
+										   file->curOffset + file->pos + pos);
 			pos += wrote;
 		}
 	}
 	file->curOffset += pos;
+
+	pgBufferUsage.temp_bytes_raw += nbytes;
+	pgBufferUsage.temp_bytes_compressed += pos;
 }
 
 /*
@@ -1388,12 +1537,13 @@ BufFileEndCompression(BufFile *file)
 		if (ZSTD_isError(ret))
 			elog(ERROR, "%s", ZSTD_getErrorName(ret));
 
-		wrote = FileWrite(file->files[0], output.dst, output.pos, file->curOffset + file->pos + pos, WAIT_EVENT_BUFFILE_WRITE);
-		if (wrote != output.pos)
-			elog(ERROR, "could not write %d bytes to compressed temporary file: %m", (int) output.pos);
+		wrote = BufFileWriteCompressed(file, output.dst, output.pos,
+									   file->curOffset + file->pos + pos);
 		pos += wrote;
 	} while (ret > 0);
 
+	pgBufferUsage.temp_bytes_compressed += pos;
+
 	ZSTD_freeCCtx(file->zstd_context->cctx);
 	file->zstd_context->cctx = NULL;
 
@@ -1440,13 +1590,31 @@ BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 		/* No more compressed input? Load some. */
 		if (file->compressed_buffer.pos == file->compressed_buffer.size)
 		{
+			off_t		offset = file->curOffset + file->pos + pos;
+			instr_time	io_start,
+						io_time;
 			int			nb;
 
-			nb = FileRead(file->files[0], (char *) file->compressed_buffer.src, BLCKSZ, file->curOffset + file->pos + pos, WAIT_EVENT_BUFFILE_READ);
+			BufFileReadAhead(file, 0, offset);
+
+			if (track_io_timing)
+				INSTR_TIME_SET_CURRENT(io_start);
+
+			nb = FileRead(file->files[0], (char *) file->compressed_buffer.src, BLCKSZ, offset, WAIT_EVENT_BUFFILE_READ);
 			if (nb < 0)
 			{
 				elog(ERROR, "could not read from temporary file: %m");
 			}
+
+			if (track_io_timing)
+			{
+				INSTR_TIME_SET_CURRENT(io_time);
+				INSTR_TIME_SUBTRACT(io_time, io_start);
+				INSTR_TIME_ADD(pgBufferUsage.temp_blk_read_time, io_time);
+			}
+			if (nb > 0)
+				pgBufferUsage.temp_blks_read++;
+
 			pos += nb;
 			file->compressed_buffer.size = nb;
 			file->compressed_buffer.pos = 0;
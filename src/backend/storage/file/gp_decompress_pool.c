@@ -0,0 +1,514 @@
+/*-------------------------------------------------------------------------
+ *
+ * gp_decompress_pool.c
+ *	  Pool of threads that decompress append-optimized blocks in parallel.
+ *
+ * A scan of a column oriented table reads one block of every projected
+ * column at a time, and decompressing them one after the other keeps a
+ * single core busy while the host usually has many more.  The scan can
+ * instead collect the compressed blocks it needs next, and hand them all to
+ * gp_decompress_pool_run(), which spreads them over gp_aocs_decompress_workers
+ * threads plus the calling backend.
+ *
+ * The worker threads must not touch anything that is not thread safe in the
+ * backend: no palloc, no elog, no catalog access, and no signal handling.
+ * They only call the compression libraries directly, on buffers that the
+ * caller allocated and keeps alive until gp_decompress_pool_run() returns.
+ * Failures are only flagged in the task; the caller decompresses such a
+ * block again the regular way, which raises the usual error.
+ *
+ * Only compression types whose library is linked into the server can be
+ * handled this way (zstd and zlib); other blocks are decompressed by the
+ * caller as before.
+ *
+ * The same threads also compress blocks, for a multi-insert into a column
+ * oriented table that filled the blocks of several columns at once.  A
+ * compression task that fails is compressed again by the caller.
+ *
+ * Memory: the threads are started on first use and kept for the lifetime of
+ * the backend.  Their stacks and decompression contexts are accounted in
+ * the vmem tracker up front; if the reservation fails the pool is not
+ * started and everything is decompressed by the backend itself.  The
+ * larger compression contexts are reserved when the first compression
+ * tasks arrive; without that reservation the backend compresses alone.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/storage/file/gp_decompress_pool.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <limits.h>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#include "storage/gp_compress.h"
+#include "storage/ipc.h"
+#include "utils/guc.h"
+#include "utils/vmem_tracker.h"
+
+/* Stack size of a worker thread, they only run the decompressors */
+#define DECOMPRESS_WORKER_STACK_SIZE	(256 * 1024)
+
+/*
+ * Memory accounted for each worker: its stack plus the decompression state
+ * of zstd (a ZSTD_DCtx is about 160kB) or zlib (about 40kB).
+ */
+#define DECOMPRESS_WORKER_VMEM	(DECOMPRESS_WORKER_STACK_SIZE + 256 * 1024)
+
+/*
+ * Memory accounted for each worker once it compresses: a deflate stream
+ * takes about 270kB, and a zstd compression context for a block of at most
+ * 2MB stays below this up to COMPRESS_MAX_ZSTD_LEVEL.  Higher zstd levels
+ * need much larger match tables, those blocks are left to the caller.
+ */
+#define COMPRESS_WORKER_VMEM	(8 * 1024 * 1024)
+#define COMPRESS_MAX_ZSTD_LEVEL	5
+
+/* Compression library state of one thread, created on first use */
+typedef struct DecompressState
+{
+	void	   *dctx;			/* ZSTD_DCtx */
+	void	   *cctx;			/* ZSTD_CCtx */
+} DecompressState;
+
+typedef struct DecompressPool
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t work_cv;		/* signalled when tasks are posted */
+	pthread_cond_t done_cv;		/* signalled when the last task is done */
+
+	/* The batch being processed, protected by mutex */
+	GpDecompressTask *tasks;
+	int			ntasks;
+	int			next;			/* next task to hand out */
+	int			pending;		/* tasks not finished yet */
+	bool		shutdown;
+
+	int			nworkers;		/* number of running threads */
+	int			failed;			/* setting the pool could not be started for */
+	pthread_t  *threads;
+	int64		reserved;		/* bytes reserved in the vmem tracker */
+	bool		compress_reserved;	/* reserved includes compression */
+} DecompressPool;
+
+static DecompressPool pool;
+static bool pool_initialized = false;
+static bool pool_exit_registered = false;
+
+/* Library state of the backend itself, it also runs tasks */
+static DecompressState backend_state = {NULL, NULL};
+
+static void *decompress_worker_main(void *arg);
+static bool decompress_pool_start(int nworkers);
+static void decompress_pool_stop(void);
+static void decompress_pool_exit(int code, Datum arg);
+
+/*
+ * Which decompressor of the pool handles the given compression type?
+ *
+ * Returns GP_DECOMPRESS_NONE if blocks of that type must be decompressed by
+ * the caller.
+ */
+GpDecompressKind
+gp_decompress_pool_kind(const char *compresstype)
+{
+	if (compresstype == NULL)
+		return GP_DECOMPRESS_NONE;
+#ifdef USE_ZSTD
+	if (pg_strcasecmp(compresstype, "zstd") == 0)
+		return GP_DECOMPRESS_ZSTD;
+#endif
+#ifdef HAVE_LIBZ
+	if (pg_strcasecmp(compresstype, "zlib") == 0)
+		return GP_DECOMPRESS_ZLIB;
+#endif
+	return GP_DECOMPRESS_NONE;
+}
+
+/*
+ * Which compressor of the pool handles the given compression type and
+ * level?
+ *
+ * Returns GP_DECOMPRESS_NONE if blocks of that type must be compressed by
+ * the caller.
+ */
+GpDecompressKind
+gp_compress_pool_kind(const char *compresstype, int level)
+{
+	GpDecompressKind kind = gp_decompress_pool_kind(compresstype);
+
+	if (kind == GP_DECOMPRESS_ZSTD && level > COMPRESS_MAX_ZSTD_LEVEL)
+		return GP_DECOMPRESS_NONE;
+	return kind;
+}
+
+/*
+ * Compress one task.  A block that does not get smaller is reported as
+ * compressed to its full length, which the caller stores uncompressed,
+ * like the compression functions of pg_compression do.
+ */
+static void
+compress_task(GpDecompressTask *task, DecompressState *state)
+{
+	switch (task->kind)
+	{
+#ifdef USE_ZSTD
+		case GP_DECOMPRESS_ZSTD:
+			{
+				size_t		len;
+
+				if (state->cctx == NULL)
+					state->cctx = ZSTD_createCCtx();
+				if (state->cctx == NULL)
+					break;
+
+				len = ZSTD_compressCCtx((ZSTD_CCtx *) state->cctx,
+										task->compressed,
+										task->compressedLen,
+										task->uncompressed,
+										task->uncompressedLen,
+										task->level);
+				if (!ZSTD_isError(len))
+				{
+					task->compressedLen = (int32) len;
+					task->ok = true;
+				}
+				break;
+			}
+#endif
+#ifdef HAVE_LIBZ
+		case GP_DECOMPRESS_ZLIB:
+			{
+				uLongf		len = task->compressedLen;
+				int			rc;
+
+				rc = compress2(task->compressed, &len,
+							   task->uncompressed, task->uncompressedLen,
+							   task->level);
+				if (rc == Z_OK)
+					task->compressedLen = (int32) len;
+				else if (rc == Z_BUF_ERROR)
+					task->compressedLen = task->uncompressedLen;
+				task->ok = (rc == Z_OK || rc == Z_BUF_ERROR);
+				break;
+			}
+#endif
+		default:
+			break;
+	}
+}
+
+/*
+ * Run one task.  Called by the workers and by the backend, so this must not
+ * do anything but call the compression library.
+ */
+static void
+decompress_task(GpDecompressTask *task, DecompressState *state)
+{
+	task->ok = false;
+
+	if (task->compress)
+	{
+		compress_task(task, state);
+		return;
+	}
+
+	switch (task->kind)
+	{
+#ifdef USE_ZSTD
+		case GP_DECOMPRESS_ZSTD:
+			{
+				size_t		len;
+
+				if (state->dctx == NULL)
+					state->dctx = ZSTD_createDCtx();
+				if (state->dctx == NULL)
+					break;
+
+				len = ZSTD_decompressDCtx((ZSTD_DCtx *) state->dctx,
+										  task->uncompressed,
+										  task->uncompressedLen,
+										  task->compressed,
+										  task->compressedLen);
+				task->ok = (!ZSTD_isError(len) && len == task->uncompressedLen);
+				break;
+			}
+#endif
+#ifdef HAVE_LIBZ
+		case GP_DECOMPRESS_ZLIB:
+			{
+				uLongf		len = task->uncompressedLen;
+				int			rc;
+
+				rc = uncompress(task->uncompressed, &len,
+								task->compressed, task->compressedLen);
+				task->ok = (rc == Z_OK && len == task->uncompressedLen);
+				break;
+			}
+#endif
+		default:
+			break;
+	}
+}
+
+static void
+decompress_state_free(DecompressState *state)
+{
+#ifdef USE_ZSTD
+	if (state->dctx)
+		ZSTD_freeDCtx((ZSTD_DCtx *) state->dctx);
+	if (state->cctx)
+		ZSTD_freeCCtx((ZSTD_CCtx *) state->cctx);
+#endif
+	state->dctx = NULL;
+	state->cctx = NULL;
+}
+
+static void *
+decompress_worker_main(void *arg)
+{
+	DecompressState state = {NULL, NULL};
+
+	pthread_mutex_lock(&pool.mutex);
+	for (;;)
+	{
+		GpDecompressTask *task;
+
+		while (!pool.shutdown && pool.next >= pool.ntasks)
+			pthread_cond_wait(&pool.work_cv, &pool.mutex);
+		if (pool.shutdown)
+			break;
+
+		task = &pool.tasks[pool.next++];
+		pthread_mutex_unlock(&pool.mutex);
+
+		decompress_task(task, &state);
+
+		pthread_mutex_lock(&pool.mutex);
+		if (--pool.pending == 0)
+			pthread_cond_signal(&pool.done_cv);
+	}
+	pthread_mutex_unlock(&pool.mutex);
+
+	decompress_state_free(&state);
+
+	return NULL;
+}
+
+/*
+ * Start 'nworkers' threads.  Returns false, with no thread running, if the
+ * memory for them cannot be reserved or the threads cannot be created.
+ */
+static bool
+decompress_pool_start(int nworkers)
+{
+	pthread_attr_t attr;
+	sigset_t	sigs;
+	sigset_t	oldsigs;
+	int64		reserve = (int64) nworkers * DECOMPRESS_WORKER_VMEM;
+
+	Assert(pool.nworkers == 0);
+
+	if (VmemTracker_ReserveVmem(reserve) != MemoryAllocation_Success)
+	{
+		elog(DEBUG1, "not enough memory for %d decompression workers", nworkers);
+		return false;
+	}
+	pool.reserved = reserve;
+	pool.compress_reserved = false;
+
+	if (!pool_initialized)
+	{
+		pthread_mutex_init(&pool.mutex, NULL);
+		pthread_cond_init(&pool.work_cv, NULL);
+		pthread_cond_init(&pool.done_cv, NULL);
+		pool_initialized = true;
+	}
+	if (!pool_exit_registered)
+	{
+		on_proc_exit(decompress_pool_exit, 0);
+		pool_exit_registered = true;
+	}
+
+	pool.tasks = NULL;
+	pool.ntasks = 0;
+	pool.next = 0;
+	pool.pending = 0;
+	pool.shutdown = false;
+	pool.threads = MemoryContextAlloc(TopMemoryContext,
+									  nworkers * sizeof(pthread_t));
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, Max(PTHREAD_STACK_MIN,
+										 DECOMPRESS_WORKER_STACK_SIZE));
+
+	/* The workers must never run our signal handlers */
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, &oldsigs);
+
+	while (pool.nworkers < nworkers)
+	{
+		int			err;
+
+		err = pthread_create(&pool.threads[pool.nworkers], &attr,
+							 decompress_worker_main, NULL);
+		if (err != 0)
+		{
+			pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+			pthread_attr_destroy(&attr);
+			decompress_pool_stop();
+			ereport(LOG,
+					(errmsg("could not create decompression worker thread"),
+					 errdetail("pthread_create() failed with err %d", err)));
+			return false;
+		}
+		pool.nworkers++;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+	pthread_attr_destroy(&attr);
+
+	return true;
+}
+
+static void
+decompress_pool_stop(void)
+{
+	if (pool.threads)
+	{
+		pthread_mutex_lock(&pool.mutex);
+		pool.shutdown = true;
+		pthread_cond_broadcast(&pool.work_cv);
+		pthread_mutex_unlock(&pool.mutex);
+
+		for (int i = 0; i < pool.nworkers; i++)
+			pthread_join(pool.threads[i], NULL);
+
+		pfree(pool.threads);
+		pool.threads = NULL;
+	}
+	pool.nworkers = 0;
+
+	if (pool.reserved > 0)
+	{
+		VmemTracker_ReleaseVmem(pool.reserved);
+		pool.reserved = 0;
+	}
+	pool.compress_reserved = false;
+}
+
+static void
+decompress_pool_exit(int code, Datum arg)
+{
+	decompress_pool_stop();
+
+	decompress_state_free(&backend_state);
+}
+
+/*
+ * Make sure the memory of compressing workers is accounted for.  Returns
+ * false if it cannot be reserved.
+ */
+static bool
+compress_pool_reserve(void)
+{
+	int64		reserve = (int64) pool.nworkers * COMPRESS_WORKER_VMEM;
+
+	if (pool.compress_reserved)
+		return true;
+
+	if (VmemTracker_ReserveVmem(reserve) != MemoryAllocation_Success)
+	{
+		elog(DEBUG1, "not enough memory for %d compression workers",
+			 pool.nworkers);
+		return false;
+	}
+	pool.reserved += reserve;
+	pool.compress_reserved = true;
+
+	return true;
+}
+
+/*
+ * Decompress, or compress, all the given tasks, using the worker threads
+ * if gp_aocs_decompress_workers asks for them, and return once all are
+ * done.
+ *
+ * A batch holds either only decompression or only compression tasks.
+ * Each task's 'ok' tells whether it succeeded.  Nothing here reports
+ * errors or can be interrupted, so the caller's buffers are never left in
+ * use by a worker.
+ */
+void
+gp_decompress_pool_run(GpDecompressTask *tasks, int ntasks)
+{
+	bool		use_workers;
+
+	/*
+	 * Adjust the pool to the setting, between batches.  A size the pool
+	 * could not be started for is not retried until the setting changes.
+	 */
+	if (gp_aocs_decompress_workers == 0)
+	{
+		if (pool.nworkers > 0)
+			decompress_pool_stop();
+		pool.failed = 0;
+	}
+	else if (pool.nworkers != gp_aocs_decompress_workers &&
+			 pool.failed != gp_aocs_decompress_workers)
+	{
+		decompress_pool_stop();
+		pool.failed = 0;
+		if (!decompress_pool_start(gp_aocs_decompress_workers))
+			pool.failed = gp_aocs_decompress_workers;
+	}
+
+	use_workers = (pool.nworkers > 0 && ntasks >= 2);
+	if (use_workers && tasks[0].compress)
+		use_workers = compress_pool_reserve();
+
+	if (!use_workers)
+	{
+		for (int i = 0; i < ntasks; i++)
+			decompress_task(&tasks[i], &backend_state);
+	}
+	else
+	{
+		pthread_mutex_lock(&pool.mutex);
+		pool.tasks = tasks;
+		pool.ntasks = ntasks;
+		pool.next = 0;
+		pool.pending = ntasks;
+		pthread_cond_broadcast(&pool.work_cv);
+
+		/* Lend a hand */
+		while (pool.next < pool.ntasks)
+		{
+			GpDecompressTask *task = &pool.tasks[pool.next++];
+
+			pthread_mutex_unlock(&pool.mutex);
+			decompress_task(task, &backend_state);
+			pthread_mutex_lock(&pool.mutex);
+			pool.pending--;
+		}
+
+		while (pool.pending > 0)
+			pthread_cond_wait(&pool.done_cv, &pool.mutex);
+
+		pool.tasks = NULL;
+		pool.ntasks = 0;
+		pool.next = 0;
+		pthread_mutex_unlock(&pool.mutex);
+	}
+}
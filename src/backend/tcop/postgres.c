@@ -92,6 +92,7 @@
 
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
+#include "cdb/cdbplancache.h"
 #include "cdb/cdbsrlz.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbdtxcontextinfo.h"
@@ -1101,6 +1102,9 @@ pg_plan_queries(List *querytrees, const char *query_string, int cursorOptions,
  *
  * query_string -- optional query text (C string).
  * serializedPlantree[len] -- PlannedStmt node, or (NULL,0) if query provided.
+ * planId -- key of the plan in the QE plan cache, or 0. If set, the plan
+ *			   is taken from the cache when serializedPlantree is not provided,
+ *			   or stored in it otherwise.
  * serializedQueryDispatchDesc[len] -- QueryDispatchDesc node, or (NULL,0) if query provided.
  *
  * Caller may supply either a Query (representing utility command) or
@@ -1109,6 +1113,7 @@ pg_plan_queries(List *querytrees, const char *query_string, int cursorOptions,
 static void
 exec_mpp_query(const char *query_string,
 			   const char * serializedPlantree, int serializedPlantreelen,
+			   uint64 planId,
 			   const char * serializedQueryDispatchDesc, int serializedQueryDispatchDesclen)
 {
 	CommandDest dest = whereToSendOutput;
@@ -1177,7 +1182,16 @@ exec_mpp_query(const char *query_string,
 		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
 			elog(ERROR, "MPPEXEC: receive invalid planned statement");
+
+		if (planId != 0)
+			cdbplancache_store(planId, plan);
     }
+	else if (planId != 0)
+	{
+		plan = cdbplancache_fetch(planId);
+		if (!plan)
+			elog(ERROR, "MPPEXEC: planned statement " UINT64_FORMAT " is not cached", planId);
+	}
 
 	/*
      * Deserialize the extra execution information (a QueryDispatchDesc node), if there is one.
@@ -5636,6 +5650,7 @@ PostgresMain(int argc, char *argv[],
 					int query_string_len = 0;
 					int serializedDtxContextInfolen = 0;
 					int serializedPlantreelen = 0;
+					uint64 planId = 0;
 					int serializedQueryDispatchDesclen = 0;
 					int resgroupInfoLen = 0;
 					TimestampTz statementStart;
@@ -5671,6 +5686,7 @@ PostgresMain(int argc, char *argv[],
 					statementStart = pq_getmsgint64(&input_message);
 					query_string_len = pq_getmsgint(&input_message, 4);
 					serializedPlantreelen = pq_getmsgint(&input_message, 4);
+					planId = (uint64) pq_getmsgint64(&input_message);
 					serializedQueryDispatchDesclen = pq_getmsgint(&input_message, 4);
 					serializedDtxContextInfolen = pq_getmsgint(&input_message, 4);
 
@@ -5754,7 +5770,7 @@ PostgresMain(int argc, char *argv[],
 					if (cuid > 0)
 						SetUserIdAndContext(cuid, false); /* Set current userid */
 
-					if (serializedPlantreelen==0)
+					if (serializedPlantreelen==0 && planId == 0)
 					{
 						if (strncmp(query_string, "BEGIN", 5) == 0)
 						{
@@ -5789,6 +5805,7 @@ PostgresMain(int argc, char *argv[],
 					else
 						exec_mpp_query(query_string,
 									   serializedPlantree, serializedPlantreelen,
+									   planId,
 									   serializedQueryDispatchDesc, serializedQueryDispatchDesclen);
 
 					SetUserIdAndSecContext(GetOuterUserId(), 0);
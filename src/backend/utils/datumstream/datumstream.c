@@ -20,6 +20,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include "access/aocsbloom.h"
 #include "access/detoast.h"
 #include "access/heaptoast.h"
 #include "access/tupmacs.h"
@@ -31,6 +32,7 @@
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
 #include "crypto/bufenc.h"
+#include "storage/gp_compress.h"
 #include "utils/datumstream.h"
 #include "utils/guc.h"
 #include "catalog/pg_compression.h"
@@ -305,7 +307,15 @@ datumstreamwrite_put(
 					 bool null,
 					 void **toFree)
 {
-	return DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+	int			result;
+
+	result = DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+
+	/* Only values that made it into the current block go into its filter */
+	if (result >= 0 && !null && acc->bloom != NULL)
+		aocs_bloom_builder_add(acc->bloom, d);
+
+	return result;
 }
 
 int
@@ -769,6 +779,12 @@ destroy_datumstreamwrite(DatumStreamWrite * ds)
 
 	AppendOnlyStorageWrite_FinishSession(&ds->ao_write);
 
+	if (ds->bloom)
+	{
+		aocs_bloom_builder_free(ds->bloom);
+		ds->bloom = NULL;
+	}
+
 	if (ds->title)
 	{
 		pfree(ds->title);
@@ -850,6 +866,7 @@ datumstreamread_open_file(DatumStreamRead * ds, char *fn, int64 eof, int64 eofUn
 
 	AppendOnlyStorageRead_OpenFile(&ds->ao_read, fn, version, ds->eof);
 
+	ds->haveNextBlockInfo = false;
 	ds->need_close_file = true;
 }
 
@@ -876,15 +893,19 @@ datumstreamread_close_file(DatumStreamRead * ds)
 {
 	AppendOnlyStorageRead_CloseFile(&ds->ao_read);
 
+	ds->haveNextBlockInfo = false;
 	ds->need_close_file = false;
 }
 
+/*
+ * Generate the content of the current block into the buffer of the storage
+ * layer.  Returns the length of the content, and sets *rowCount.
+ */
 static int64
-datumstreamwrite_block_orig(DatumStreamWrite * acc)
+datumstreamwrite_block_content(DatumStreamWrite * acc, int32 *rowCount)
 {
-	int64		writesz = 0;
 	uint8	   *buffer = NULL;
-	int32		rowCount;
+	AoHeaderKind aoHeaderKind;
 
 	/*
 	 * Set the BlockFirstRowNum. Need to set this before
@@ -893,72 +914,102 @@ datumstreamwrite_block_orig(DatumStreamWrite * acc)
 	AppendOnlyStorageWrite_SetFirstRowNum(&acc->ao_write,
 										  acc->blockFirstRowNum);
 
-	rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
-	Assert(rowCount <= MAXDATUM_PER_AOCS_ORIG_BLOCK);
+	*rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
 
-	buffer = AppendOnlyStorageWrite_GetBuffer(
-											  &acc->ao_write,
-											  AoHeaderKind_SmallContent);
-
-	writesz = DatumStreamBlockWrite_Block(
-										  &acc->blockWrite,
-										  buffer,
-										  &acc->ao_write.relFileNode.node);
+	switch (acc->datumStreamVersion)
+	{
+		case DatumStreamVersion_Original:
+			Assert(*rowCount <= MAXDATUM_PER_AOCS_ORIG_BLOCK);
+			aoHeaderKind = AoHeaderKind_SmallContent;
+			break;
 
-	acc->ao_write.logicalBlockStartOffset =
-		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
+		case DatumStreamVersion_Dense:
+		case DatumStreamVersion_Dense_Enhanced:
+			if (*rowCount <= AOSmallContentHeader_MaxRowCount)
+			{
+				aoHeaderKind = AoHeaderKind_SmallContent;
+			}
+			else if (acc->ao_attr.compress)
+			{
+				aoHeaderKind = AoHeaderKind_BulkDenseContent;
+			}
+			else
+			{
+				aoHeaderKind = AoHeaderKind_NonBulkDenseContent;
+			}
+			break;
 
-	/* Write it out */
-	AppendOnlyStorageWrite_FinishBuffer(
-										&acc->ao_write,
-										(int32) writesz,
-										AOCSBK_BLOCK,
-										rowCount);
+		default:
+			elog(ERROR, "Unexpected datum stream version %d",
+				 acc->datumStreamVersion);
+			return 0;
+			/* Never reaches here. */
+	}
 
-	/* Set up our write block information */
-	DatumStreamBlockWrite_GetReady(&acc->blockWrite);
+	buffer = AppendOnlyStorageWrite_GetBuffer(
+											  &acc->ao_write,
+											  aoHeaderKind);
 
-	return writesz;
+	return DatumStreamBlockWrite_Block(
+									   &acc->blockWrite,
+									   buffer,
+									   &acc->ao_write.relFileNode.node);
 }
 
-static int64
-datumstreamwrite_block_dense(DatumStreamWrite * acc)
+/*
+ * Record the block just written in the block directory, along with its
+ * bloom filter if the column has one.
+ */
+static void
+datumstreamwrite_block_directory(DatumStreamWrite *acc,
+								 AppendOnlyBlockDirectory *blockDirectory,
+								 int columnGroupNo,
+								 int itemCount,
+								 bool addColAction)
 {
-	int64		writesz = 0;
-	uint8	   *buffer = NULL;
-	int32		rowCount;
-	AoHeaderKind aoHeaderKind;
-
-	/*
-	 * Set the BlockFirstRowNum. Need to set this before
-	 * calling AppendOnlyStorageWrite_GetBuffer.
-	 */
-	AppendOnlyStorageWrite_SetFirstRowNum(&acc->ao_write,
-										  acc->blockFirstRowNum);
-
-	rowCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+	/* Insert an entry to the block directory */
+	AppendOnlyBlockDirectory_InsertEntry(
+		blockDirectory,
+		columnGroupNo,
+		acc->blockFirstRowNum,
+		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
+		itemCount,
+		addColAction);
 
-	if (rowCount <= AOSmallContentHeader_MaxRowCount)
+	/* And the bloom filter of the block's values, if the column wants one */
+	if (acc->bloom)
 	{
-		aoHeaderKind = AoHeaderKind_SmallContent;
-	}
-	else if (acc->ao_attr.compress)
-	{
-		aoHeaderKind = AoHeaderKind_BulkDenseContent;
+		struct varlena *filter;
+
+		filter = aocs_bloom_builder_finish(acc->bloom, itemCount);
+		if (filter)
+		{
+			AppendOnlyBlockDirectory_InsertBloomFilter(blockDirectory,
+													   columnGroupNo,
+													   acc->blockFirstRowNum,
+													   filter);
+			pfree(filter);
+		}
 	}
-	else
+}
+
+int64
+datumstreamwrite_block(DatumStreamWrite *acc,
+					   AppendOnlyBlockDirectory *blockDirectory,
+					   int columnGroupNo,
+					   bool addColAction)
+{
+	int64 writesz;
+	int32 rowCount;
+	int itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+
+	/* Nothing to write, this is just no op */
+	if (itemCount == 0)
 	{
-		aoHeaderKind = AoHeaderKind_NonBulkDenseContent;
+		return 0;
 	}
 
-	buffer = AppendOnlyStorageWrite_GetBuffer(
-											  &acc->ao_write,
-											  aoHeaderKind);
-
-	writesz = DatumStreamBlockWrite_Block(
-										  &acc->blockWrite,
-										  buffer,
-										  &acc->ao_write.relFileNode.node);
+	writesz = datumstreamwrite_block_content(acc, &rowCount);
 
 	acc->ao_write.logicalBlockStartOffset =
 		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
@@ -973,52 +1024,89 @@ datumstreamwrite_block_dense(DatumStreamWrite * acc)
 	/* Set up our write block information */
 	DatumStreamBlockWrite_GetReady(&acc->blockWrite);
 
+	datumstreamwrite_block_directory(acc, blockDirectory, columnGroupNo,
+									 itemCount, addColAction);
+
 	return writesz;
 }
 
+/*
+ * Like datumstreamwrite_block(), but leaves the compression of the block to
+ * the caller, so that the compression worker pool can do it.
+ *
+ * Returns false, having done nothing, if the pool cannot compress blocks of
+ * this column; datumstreamwrite_block() must be used then.  Otherwise the
+ * content of the block is generated, 'task' is filled in, and once the task
+ * has been run by gp_decompress_pool_run(), datumstreamwrite_block_finish()
+ * must be called before anything else is done with the stream.
+ */
+bool
+datumstreamwrite_block_begin(DatumStreamWrite *acc, GpDecompressTask *task)
+{
+	GpDecompressKind kind;
+	int32		rowCount;
+
+	if (DatumStreamBlockWrite_Nth(&acc->blockWrite) == 0 ||
+		!acc->ao_attr.compress)
+		return false;
+
+	kind = gp_compress_pool_kind(acc->ao_attr.compressType,
+								 acc->ao_attr.compressLevel);
+	if (kind == GP_DECOMPRESS_NONE)
+		return false;
+
+	task->kind = kind;
+	task->compress = true;
+	task->level = Max(acc->ao_attr.compressLevel, 1);
+	task->uncompressedLen = (int32) datumstreamwrite_block_content(acc, &rowCount);
+	task->uncompressed = acc->ao_write.uncompressedBuffer;
+	task->compressed = AppendOnlyStorageWrite_GetCompressBuffer(&acc->ao_write,
+																&task->compressedLen);
+	task->ok = false;
+
+	return true;
+}
+
+/*
+ * Complete the write of a block started by datumstreamwrite_block_begin().
+ */
 int64
-datumstreamwrite_block(DatumStreamWrite *acc,
-					   AppendOnlyBlockDirectory *blockDirectory,
-					   int columnGroupNo,
-					   bool addColAction)
+datumstreamwrite_block_finish(DatumStreamWrite *acc,
+							  AppendOnlyBlockDirectory *blockDirectory,
+							  int columnGroupNo,
+							  bool addColAction,
+							  GpDecompressTask *task)
 {
-	int64 writesz;
-	int itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
+	int			itemCount = DatumStreamBlockWrite_Nth(&acc->blockWrite);
 
-	/* Nothing to write, this is just no op */
-	if (itemCount == 0)
-	{
-		return 0;
-	}
+	Assert(task->uncompressed == acc->ao_write.uncompressedBuffer);
 
-	switch (acc->datumStreamVersion)
-	{
-		case DatumStreamVersion_Original:
-			writesz = datumstreamwrite_block_orig(acc);
-			break;
+	acc->ao_write.logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&(acc->ao_write.bufferedAppend));
 
-		case DatumStreamVersion_Dense:
-		case DatumStreamVersion_Dense_Enhanced:
-			writesz = datumstreamwrite_block_dense(acc);
-			break;
+	/*
+	 * If the worker could not compress the block, compress it the regular
+	 * way, which also reports any error.
+	 */
+	if (task->ok)
+		AppendOnlyStorageWrite_FinishCompressedBuffer(&acc->ao_write,
+													  task->uncompressedLen,
+													  task->compressedLen,
+													  AOCSBK_BLOCK,
+													  itemCount);
+	else
+		AppendOnlyStorageWrite_FinishBuffer(&acc->ao_write,
+											task->uncompressedLen,
+											AOCSBK_BLOCK,
+											itemCount);
 
-		default:
-			elog(ERROR, "Unexpected datum stream version %d",
-				 acc->datumStreamVersion);
-			return 0;
-			/* Never reaches here. */
-	}
+	/* Set up our write block information */
+	DatumStreamBlockWrite_GetReady(&acc->blockWrite);
 
-	/* Insert an entry to the block directory */
-	AppendOnlyBlockDirectory_InsertEntry(
-		blockDirectory,
-		columnGroupNo,
-		acc->blockFirstRowNum,
-		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
-		itemCount,
-		addColAction);
+	datumstreamwrite_block_directory(acc, blockDirectory, columnGroupNo,
+									 itemCount, addColAction);
 
-	return writesz;
+	return task->uncompressedLen;
 }
 
 static void
@@ -1235,6 +1323,33 @@ datumstreamread_block_get_ready(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Make sure large_object_buffer can hold the decompressed content of the
+ * current block.
+ */
+static void
+datumstreamread_decompress_buffer(DatumStreamRead * acc)
+{
+	if (acc->large_object_buffer_size < acc->getBlockInfo.contentLen)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(acc->memctxt);
+
+		if (acc->large_object_buffer)
+		{
+			pfree(acc->large_object_buffer);
+			acc->large_object_buffer = NULL;
+
+			SIMPLE_FAULT_INJECTOR("malloc_failure");
+		}
+
+		acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
+		acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
+		MemoryContextSwitchTo(oldCtxt);
+	}
+}
+
 void
 datumstreamread_block_content(DatumStreamRead * acc)
 {
@@ -1257,24 +1372,7 @@ datumstreamread_block_content(DatumStreamRead * acc)
 		if (acc->getBlockInfo.isCompressed)
 		{
 			/* Compressed, need to decompress to our own buffer.  */
-			if (acc->large_object_buffer_size < acc->getBlockInfo.contentLen)
-			{
-				MemoryContext oldCtxt;
-
-				oldCtxt = MemoryContextSwitchTo(acc->memctxt);
-
-				if (acc->large_object_buffer)
-				{
-					pfree(acc->large_object_buffer);
-					acc->large_object_buffer = NULL;
-
-					SIMPLE_FAULT_INJECTOR("malloc_failure");
-				}
-
-				acc->large_object_buffer_size = acc->getBlockInfo.contentLen;
-				acc->large_object_buffer = palloc(acc->getBlockInfo.contentLen);
-				MemoryContextSwitchTo(oldCtxt);
-			}
+			datumstreamread_decompress_buffer(acc);
 
 			AppendOnlyStorageRead_Content(
 										  &acc->ao_read,
@@ -1359,10 +1457,13 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
-int
-datumstreamread_block(DatumStreamRead * acc,
-					  AppendOnlyBlockDirectory *blockDirectory,
-					  int colGroupNo)
+/*
+ * Read the header of the next block, and position the stream at it.
+ *
+ * Returns false at the end of the segment file.
+ */
+static bool
+datumstreamread_next_block_info(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1370,15 +1471,22 @@ datumstreamread_block(DatumStreamRead * acc,
 
 	acc->blockFirstRowNum += acc->blockRowCount;
 
-	readOK = AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
-												&acc->getBlockInfo.contentLen,
-											&acc->getBlockInfo.execBlockKind,
-												&acc->getBlockInfo.firstRow,
-												&acc->getBlockInfo.rowCnt,
-												&acc->getBlockInfo.isLarge,
-											&acc->getBlockInfo.isCompressed);
+	if (acc->haveNextBlockInfo)
+	{
+		/* The header was already read by datumstreamread_peek_first_row() */
+		acc->haveNextBlockInfo = false;
+		readOK = true;
+	}
+	else
+		readOK = AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
+													&acc->getBlockInfo.contentLen,
+													&acc->getBlockInfo.execBlockKind,
+													&acc->getBlockInfo.firstRow,
+													&acc->getBlockInfo.rowCnt,
+													&acc->getBlockInfo.isLarge,
+													&acc->getBlockInfo.isCompressed);
 	if (!readOK)
-		return -1;
+		return false;
 
 	if (Debug_appendonly_print_datumstream)
 		elog(LOG,
@@ -1420,6 +1528,17 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
+	return true;
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc,
+					  AppendOnlyBlockDirectory *blockDirectory,
+					  int colGroupNo)
+{
+	if (!datumstreamread_next_block_info(acc))
+		return -1;
+
 	datumstreamread_block_content(acc);
 
 	if (blockDirectory)
@@ -1435,6 +1554,84 @@ datumstreamread_block(DatumStreamRead * acc,
 	return 0;
 }
 
+/*
+ * Like datumstreamread_block(), but leaves the decompression of the block
+ * to the caller when the decompression worker pool can do it.
+ *
+ * In that case 'task' is filled in and 1 is returned; once the task has
+ * been run by gp_decompress_pool_run(), datumstreamread_block_finish() must
+ * be called before anything else is done with the stream.  Otherwise the
+ * block is read completely and 0 is returned.  -1 means end of file.
+ */
+int
+datumstreamread_block_begin(DatumStreamRead * acc,
+							AppendOnlyBlockDirectory *blockDirectory,
+							int colGroupNo,
+							GpDecompressTask *task)
+{
+	GpDecompressKind kind;
+
+	if (!datumstreamread_next_block_info(acc))
+		return -1;
+
+	if (blockDirectory)
+	{
+		AppendOnlyBlockDirectory_InsertEntry(blockDirectory,
+											 colGroupNo,
+											 acc->blockFirstRowNum,
+											 acc->blockFileOffset,
+											 acc->blockRowCount,
+											 false);
+	}
+
+	kind = gp_decompress_pool_kind(acc->ao_attr.compressType);
+	if (kind == GP_DECOMPRESS_NONE ||
+		acc->getBlockInfo.execBlockKind != AOCSBK_BLOCK ||
+		acc->getBlockInfo.isLarge ||
+		!acc->getBlockInfo.isCompressed)
+	{
+		datumstreamread_block_content(acc);
+		return 0;
+	}
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+
+	datumstreamread_decompress_buffer(acc);
+
+	task->kind = kind;
+	task->compress = false;
+	task->compressed = AppendOnlyStorageRead_GetCompressedBuffer(&acc->ao_read,
+																 &task->compressedLen);
+	task->uncompressed = (uint8 *) acc->large_object_buffer;
+	task->uncompressedLen = acc->getBlockInfo.contentLen;
+	task->ok = false;
+
+	return 1;
+}
+
+/*
+ * Complete the read of a block started by datumstreamread_block_begin().
+ */
+void
+datumstreamread_block_finish(DatumStreamRead * acc, GpDecompressTask *task)
+{
+	Assert(task->uncompressed == (uint8 *) acc->large_object_buffer);
+
+	/*
+	 * If the worker could not decompress the block, do it again the
+	 * regular way, which reports the problem.
+	 */
+	if (!task->ok)
+		AppendOnlyStorageRead_Content(&acc->ao_read,
+									  (uint8 *) acc->large_object_buffer,
+									  acc->getBlockInfo.contentLen);
+
+	acc->buffer_beginp = acc->large_object_buffer;
+
+	datumstreamread_block_get_ready(acc);
+}
+
 void
 datumstreamread_rewind_block(DatumStreamRead * datumStream)
 {
@@ -1662,6 +1859,94 @@ datumstreamread_find_block(DatumStreamRead * datumStream,
 	return true;
 }
 
+/*
+ * Return the first row number of the block following the current one,
+ * reading only its header.  The content is read later by
+ * datumstreamread_block() or skipped by datumstreamread_skip_to_row().
+ *
+ * Returns -1 at the end of the segment file, or if the block doesn't record
+ * its first row number (pre-4.0 blocks).
+ */
+int64
+datumstreamread_peek_first_row(DatumStreamRead * acc)
+{
+	if (!acc->haveNextBlockInfo)
+	{
+		if (!AppendOnlyStorageRead_GetBlockInfo(&acc->ao_read,
+												&acc->getBlockInfo.contentLen,
+												&acc->getBlockInfo.execBlockKind,
+												&acc->getBlockInfo.firstRow,
+												&acc->getBlockInfo.rowCnt,
+												&acc->getBlockInfo.isLarge,
+												&acc->getBlockInfo.isCompressed))
+			return -1;
+		acc->haveNextBlockInfo = true;
+	}
+
+	return acc->getBlockInfo.firstRow;
+}
+
+/*
+ * Position the stream so that the next datumstreamread_advance() returns
+ * row 'rowNum'.  'rowNum' must not be behind the current position.
+ *
+ * Blocks that end before 'rowNum' are skipped without reading or
+ * decompressing their content.  Returns false if the segment file ends
+ * before 'rowNum'.
+ */
+bool
+datumstreamread_skip_to_row(DatumStreamRead * acc, int64 rowNum)
+{
+	Assert(rowNum >= datumstreamread_next_rownum(acc) || acc->haveNextBlockInfo);
+
+	/* Still inside the current block? */
+	if (!acc->haveNextBlockInfo &&
+		rowNum < acc->blockFirstRowNum + acc->blockRowCount)
+	{
+		if (rowNum > datumstreamread_next_rownum(acc))
+			datumstreamread_find(acc, rowNum - acc->blockFirstRowNum - 1);
+		return true;
+	}
+
+	/* The current block is left behind */
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+
+	while (true)
+	{
+		int64		firstRow = datumstreamread_peek_first_row(acc);
+
+		if (!acc->haveNextBlockInfo)
+			return false;
+
+		if (firstRow >= 0 && rowNum >= firstRow + acc->getBlockInfo.rowCnt)
+		{
+			acc->blockFirstRowNum = firstRow;
+			acc->blockFileOffset = acc->ao_read.current.headerOffsetInFile;
+			acc->blockRowCount = acc->getBlockInfo.rowCnt;
+
+			AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+			acc->haveNextBlockInfo = false;
+			continue;
+		}
+
+		/*
+		 * This block holds the row, or we can't tell without reading it.
+		 */
+		if (datumstreamread_block(acc, NULL, 0) < 0)
+			return false;
+
+		if (rowNum < acc->blockFirstRowNum + acc->blockRowCount)
+		{
+			datumstreamread_find(acc, rowNum - acc->blockFirstRowNum - 1);
+			return true;
+		}
+
+		DatumStreamBlockRead_Reset(&acc->blockRead);
+		acc->largeObjectState = DatumStreamLargeObjectState_None;
+	}
+}
+
 /*
  * Ensures that the stream's datum_upgrade_buffer is at least len bytes long.
  * Returns a pointer to the (possibly newly allocated) upgrade buffer space. If
@@ -19,6 +19,7 @@
 #include <postgres.h>
 #include <commands/copy.h>
 #include <fstream/fstream.h>
+#include <port/pg_lfind.h>
 #include <assert.h>
 #include <glob.h>
 #include <stdio.h>
@@ -180,6 +181,19 @@ scan_csv_records_crlf(char *p, char* q, int one, fstream_t* fs)
 
 	while (p < q)
 	{
+		/* skip to the next character that can change the state */
+		if (!last_was_esc)
+		{
+			char	keys[2] = {qc, in_quote ? xc : '\n'};
+			char   *next = (char *) pg_lfind8_any(p, q, keys, 2);
+
+			if (next == q)
+				break;
+			if (next > p)
+				ch = next[-1];
+			p = next;
+		}
+
 		lastch = ch;
 		ch = *p++;
 
@@ -220,7 +234,19 @@ scan_csv_records_cr_or_lf(char *p, char *q, int one, fstream_t *fs, int nc)
 
 	while (p < q)
 	{
-		int ch = *p++;
+		int ch;
+
+		/* skip to the next character that can change the state */
+		if (!last_was_esc)
+		{
+			char	keys[2] = {qc, in_quote ? xc : nc};
+
+			p = (char *) pg_lfind8_any(p, q, keys, 2);
+			if (p == q)
+				break;
+		}
+
+		ch = *p++;
 
 		if (in_quote)
 		{
@@ -927,7 +953,7 @@ int fstream_read(fstream_t *fs,
 			 */
 			if (fs->options.is_csv)
 			{
-				/* CSV: go slow, scan byte-by-byte for record boundary */
+				/* CSV: track the quotes to find the record boundary */
 				p = scan_csv_records(dest, (char*)dest + size, 0, fs);
 			}
 			else
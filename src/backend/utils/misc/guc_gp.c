@@ -155,6 +155,7 @@ int			gp_appendonly_insert_files = 0;
 int			gp_appendonly_insert_files_tuples_range = 0;
 int			gp_random_insert_segments = 0;
 int 		gp_appendonly_compaction_segfile_limit = 0;
+int			gp_appendonly_compaction_max_segfiles = 0;
 bool		gp_heap_require_relhasoids_match = true;
 bool		gp_local_distributed_cache_stats = false;
 bool		debug_xlog_record_read = false;
@@ -279,6 +280,7 @@ bool		gp_enable_agg_pushdown = false;
 bool		gp_dynamic_partition_pruning = true;
 bool		gp_log_dynamic_partition_pruning = false;
 bool		gp_cte_sharing = false;
+bool		gp_shareinput_streaming = false;
 bool		gp_enable_relsize_collection = false;
 bool		gp_recursive_cte = true;
 bool		gp_eager_two_phase_agg = false;
@@ -442,6 +444,7 @@ bool		gp_reject_internal_tcp_conn = true;
 
 /* copy */
 bool		gp_enable_segment_copy_checking = true;
+bool		gp_copy_parse_on_segments = false;
 /*
  * Default storage options GUC.  Value is comma-separated name=value
  * pairs.  E.g. "blocksize=32768,compresstype=none,checksum=true"
@@ -458,6 +461,10 @@ bool		gp_enable_global_deadlock_detector = false;
 
 bool gp_enable_predicate_pushdown;
 int  gp_predicate_pushdown_sample_rows;
+bool gp_enable_aocs_bloom_filter = true;
+bool gp_enable_aocs_late_materialization = true;
+int  gp_aocs_decompress_workers = 0;
+bool gp_enable_batch_qual = true;
 
 bool        enable_offload_entry_to_qe = false;
 bool 		enable_answer_query_using_materialized_views = false;
@@ -674,6 +681,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_hashjoin_role_reversal", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Allows a spilled batch of an inner hash join to be built from the outer side."),
+			gettext_noop("Used when the inner batch does not fit in memory but the outer batch does.")
+		},
+		&gp_hashjoin_role_reversal,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_direct_dispatch", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable dispatch for single-row-insert targeted mirror-pairs."),
@@ -683,6 +699,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_qe_plan_cache", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Enable caching of dispatched plans in the segments."),
+			gettext_noop("A plan that a segment process already holds is dispatched to it by hash only.")
+		},
+		&gp_enable_qe_plan_cache,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -694,6 +719,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_batch_qual", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Evaluate simple comparisons in sequential scan quals over batches of tuples."),
+			gettext_noop("Comparisons of int4, int8, date, timestamp and float8 columns "
+						 "with constants are applied to many tuples at a time.")
+		},
+		&gp_enable_batch_qual,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_pushdown", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable predicate pushdown, some quals will be pushed down to lower data source for AO."),
@@ -703,6 +738,24 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_enable_predicate_pushdown,
 		true, NULL, NULL
 	},
+	{
+		{"gp_enable_aocs_bloom_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable skipping AOCO blocks using per-block bloom filters for equality quals."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_enable_aocs_bloom_filter,
+		true, NULL, NULL
+	},
+	{
+		{"gp_enable_aocs_late_materialization", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable reading the other columns of an AOCO scan only for rows passing the pushed down quals."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_enable_aocs_late_materialization,
+		true, NULL, NULL
+	},
 	{
 		{"debug_print_prelim_plan", PGC_USERSET, LOGGING_WHAT,
 			gettext_noop("Prints the preliminary execution plan to server log."),
@@ -833,6 +886,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_enable_radix_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable radix sorting of in-memory sorts on integer-like keys."),
+			gettext_noop("Sorts whose leading key is an integer, date, timestamp or uuid "
+						 "are ordered by the bytes of that key instead of by comparisons.")
+		},
+		&gp_enable_radix_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_motion_deadlock_sanity", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable verbose check at planning time."),
@@ -1791,6 +1855,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_shareinput_streaming", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Lets cross-slice shared scan consumers read tuples while the producer is still writing them."),
+			gettext_noop("The producer publishes its output in chunks, instead of making consumers wait for all of it."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_streaming,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_relsize_collection", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("This guc enables relsize collection when stats are not present. If disabled and stats are not present a default "
@@ -2859,6 +2934,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_copy_parse_on_segments", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Let the segments parse and redistribute the rows of \"COPY FROM\"."),
+			gettext_noop("The coordinator only splits the input into lines and spreads them over "
+						 "the segments, which then route each row to its own segment."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_copy_parse_on_segments,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_ignore_error_table", PGC_USERSET, COMPAT_OPTIONS_PREVIOUS,
 			gettext_noop("Ignore INTO error-table in external table and COPY (Deprecated)."),
@@ -3329,6 +3416,15 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_aocs_decompress_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Sets the number of threads a scan of an AOCO table uses to decompress blocks, and a multi-insert to compress them."),
+			gettext_noop("Zero decompresses and compresses all blocks in the backend itself.")
+		},
+		&gp_aocs_decompress_workers,
+		0, 0, 64, NULL, NULL
+	},
+
 	{
 		{"gp_predicate_pushdown_sample_rows", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Max sample rows during predicate pushdown"),
@@ -3456,6 +3552,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_compaction_max_segfiles", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Maximum number of segment files compacted by one vacuum of an append-optimized table."),
+			gettext_noop("The dirtiest segment files are compacted first, the others are left for "
+						 "the next vacuum. Zero means no limit.")
+		},
+		&gp_appendonly_compaction_max_segfiles,
+		0, 0, 127,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_appendonly_insert_files", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Number of segment files to insert for appendonly table within a transaction."
@@ -114,6 +114,7 @@
 #include "utils/sortsupport.h"
 #include "utils/tuplesort.h"
 
+#include "cdb/cdbvars.h"
 #include "utils/faultinjector.h"
 
 
@@ -146,6 +147,8 @@ bool		trace_sort = false;
 bool		optimize_bounded_sort = true;
 #endif
 
+bool		gp_enable_radix_sort = true;
+
 
 /*
  * The objects we actually sort are SortTuple structs.  These contain
@@ -626,6 +629,8 @@ static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
 static void tuplesort_sort_memtuples(Tuplesortstate *state);
+static bool tuplesort_bounded_reject(Tuplesortstate *state,
+									 TupleTableSlot *slot);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_delete_top(Tuplesortstate *state);
@@ -700,6 +705,233 @@ static void tuplesort_updatemax(Tuplesortstate *state);
 #define ST_DEFINE
 #include "lib/sort_template.h"
 
+/*
+ * Radix sort of SortTuples.
+ *
+ * When the leading key is compared with one of the ssup_datum_*_cmp()
+ * comparators, its datum1 can be mapped to an unsigned integer that sorts
+ * the same way, and the tuples can be distributed by the bytes of that
+ * integer, most significant first, without calling a comparator at all.
+ * This is an in-place MSD radix sort (American flag sort), so it needs no
+ * memory beyond the memtuples array itself.
+ *
+ * Buckets of fewer than RADIX_SORT_THRESHOLD tuples are finished with
+ * quicksort, as are groups of tuples whose leading keys are all equal, if
+ * further keys or an abbreviated key have to break the tie.  NULLs are
+ * partitioned off up front.
+ */
+#define RADIX_SORT_THRESHOLD	1024
+
+typedef enum
+{
+	RADIX_KEY_UNSIGNED,			/* ssup_datum_unsigned_cmp */
+	RADIX_KEY_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_KEY_INT32				/* ssup_datum_int32_cmp */
+} RadixKeyKind;
+
+typedef struct RadixSortContext
+{
+	Tuplesortstate *state;
+	RadixKeyKind kind;
+	bool		reverse;
+	bool		needTiebreak;	/* more than datum1 decides the order? */
+	int			startLevel;		/* first byte that can differ */
+} RadixSortContext;
+
+static inline uint64
+radix_sort_key(RadixSortContext *cxt, Datum datum)
+{
+	uint64		key;
+
+	switch (cxt->kind)
+	{
+#if SIZEOF_DATUM >= 8
+		case RADIX_KEY_SIGNED:
+			key = ((uint64) DatumGetInt64(datum)) ^ (UINT64CONST(1) << 63);
+			break;
+#endif
+		case RADIX_KEY_INT32:
+			key = (uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31);
+			break;
+		default:
+			key = (uint64) datum;
+			break;
+	}
+
+	return cxt->reverse ? ~key : key;
+}
+
+#define RADIX_SORT_BYTE(cxt, stup, level) \
+	((int) ((radix_sort_key((cxt), (stup)->datum1) >> ((7 - (level)) * 8)) & 0xFF))
+
+/* Sort tuples that could not be told apart by the radix sort so far */
+static void
+radix_sort_finish(RadixSortContext *cxt, SortTuple *tuples, size_t n)
+{
+	Tuplesortstate *state = cxt->state;
+
+	if (n < 2)
+		return;
+	if (state->onlyKey != NULL)
+		qsort_ssup(tuples, n, state->onlyKey);
+	else
+		qsort_tuple(tuples, n, state->comparetup, state);
+}
+
+static void
+radix_sort_level(RadixSortContext *cxt, SortTuple *tuples, size_t n, int level)
+{
+	size_t		count[256];
+	size_t		next[256];
+	size_t		end[256];
+	size_t		pos;
+	int			b;
+
+	CHECK_FOR_INTERRUPTS();
+
+	if (n < RADIX_SORT_THRESHOLD)
+	{
+		radix_sort_finish(cxt, tuples, n);
+		return;
+	}
+
+	/* Skip the bytes that are the same in all the keys */
+	for (;;)
+	{
+		memset(count, 0, sizeof(count));
+		for (pos = 0; pos < n; pos++)
+			count[RADIX_SORT_BYTE(cxt, &tuples[pos], level)]++;
+
+		if (count[RADIX_SORT_BYTE(cxt, &tuples[0], level)] < n)
+			break;
+		if (level == 7)
+		{
+			/* All the leading keys are equal */
+			if (cxt->needTiebreak)
+				radix_sort_finish(cxt, tuples, n);
+			return;
+		}
+		level++;
+	}
+
+	pos = 0;
+	for (b = 0; b < 256; b++)
+	{
+		next[b] = pos;
+		pos += count[b];
+		end[b] = pos;
+	}
+
+	/* Move every tuple into its bucket, cycle by cycle */
+	for (b = 0; b < 256; b++)
+	{
+		while (next[b] < end[b])
+		{
+			SortTuple	stup = tuples[next[b]];
+			int			dst = RADIX_SORT_BYTE(cxt, &stup, level);
+
+			while (dst != b)
+			{
+				SortTuple	tmp = tuples[next[dst]];
+
+				tuples[next[dst]++] = stup;
+				stup = tmp;
+				dst = RADIX_SORT_BYTE(cxt, &stup, level);
+			}
+			tuples[next[b]++] = stup;
+		}
+	}
+
+	for (b = 0; b < 256; b++)
+	{
+		SortTuple  *bucket = tuples + end[b] - count[b];
+
+		if (count[b] < 2)
+			continue;
+		if (level < 7)
+			radix_sort_level(cxt, bucket, count[b], level + 1);
+		else if (cxt->needTiebreak)
+			radix_sort_finish(cxt, bucket, count[b]);
+	}
+}
+
+/*
+ * Radix sort the memtuples, if the leading key allows it.  Returns false if
+ * the caller has to sort them some other way.
+ */
+static bool
+radix_sort_tuple(Tuplesortstate *state)
+{
+	SortSupport ssup = state->sortKeys;
+	RadixSortContext cxt;
+	SortTuple  *tuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	size_t		nnulls = 0;
+	size_t		i;
+
+	if (!gp_enable_radix_sort || ssup == NULL || n < RADIX_SORT_THRESHOLD)
+		return false;
+
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+		cxt.kind = RADIX_KEY_UNSIGNED;
+#if SIZEOF_DATUM >= 8
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+		cxt.kind = RADIX_KEY_SIGNED;
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+		cxt.kind = RADIX_KEY_INT32;
+	else
+		return false;
+
+	cxt.state = state;
+	cxt.reverse = ssup->ssup_reverse;
+	cxt.needTiebreak = (state->onlyKey == NULL);
+	cxt.startLevel = (cxt.kind == RADIX_KEY_INT32 || SIZEOF_DATUM < 8) ? 4 : 0;
+
+	/* Move the NULLs to the end, or to the front if they sort first */
+	if (ssup->ssup_nulls_first)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (tuples[i].isnull1)
+			{
+				SortTuple	tmp = tuples[i];
+
+				tuples[i] = tuples[nnulls];
+				tuples[nnulls++] = tmp;
+			}
+		}
+		if (cxt.needTiebreak)
+			radix_sort_finish(&cxt, tuples, nnulls);
+		radix_sort_level(&cxt, tuples + nnulls, n - nnulls, cxt.startLevel);
+	}
+	else
+	{
+		for (i = n; i > 0; i--)
+		{
+			if (tuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = tuples[i - 1];
+
+				nnulls++;
+				tuples[i - 1] = tuples[n - nnulls];
+				tuples[n - nnulls] = tmp;
+			}
+		}
+		radix_sort_level(&cxt, tuples, n - nnulls, cxt.startLevel);
+		if (cxt.needTiebreak)
+			radix_sort_finish(&cxt, tuples + n - nnulls, nnulls);
+	}
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG, "worker %d radix sorted %zu tuples: %s",
+			 state->worker, n, pg_rusage_show(&state->ru_start));
+#endif
+
+	return true;
+}
+
 /*
  *		tuplesort_begin_xxx
  *
@@ -1681,6 +1913,37 @@ noalloc:
 	return false;
 }
 
+/*
+ * Can a tuple be discarded by comparing its leading key with the top of the
+ * bounded heap?  The heap holds the best 'bound' tuples seen so far, with
+ * the sort direction reversed, so its top is the cutoff a new tuple must
+ * beat.  Ties on the leading key need the other keys, unless there are none.
+ *
+ * The cutoff is local to this sort.  In a distributed top-N, each segment
+ * prunes against its own heap only; the QD never sends the global cutoff
+ * back, because nothing carries data from the QD to a running QE, and the
+ * segments emit nothing to the merging Motion until their input is done.
+ */
+static bool
+tuplesort_bounded_reject(Tuplesortstate *state, TupleTableSlot *slot)
+{
+	SortSupport sortKey = state->sortKeys;
+	SortTuple  *top = &state->memtuples[0];
+	Datum		datum;
+	bool		isnull;
+	int			compare;
+
+	/* Abbreviation is disabled for bounded sorts, datum1 is the real key */
+	Assert(sortKey->abbrev_converter == NULL);
+
+	datum = slot_getattr(slot, sortKey->ssup_attno, &isnull);
+	compare = ApplySortComparator(datum, isnull,
+								  top->datum1, top->isnull1,
+								  sortKey);
+
+	return compare < 0 || (compare == 0 && state->nKeys == 1);
+}
+
 /*
  * Accept one tuple while collecting input data for sort.
  *
@@ -1692,6 +1955,19 @@ tuplesort_puttupleslot(Tuplesortstate *state, TupleTableSlot *slot)
 	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
 	SortTuple	stup;
 
+	/*
+	 * GPDB: once a top-N sort has filled its heap, most input tuples lose
+	 * against the top of the heap on the leading key alone.  Check that
+	 * before paying for copying them.  This uses the local heap only, see
+	 * tuplesort_bounded_reject().
+	 */
+	if (state->status == TSS_BOUNDED && tuplesort_bounded_reject(state, slot))
+	{
+		MemoryContextSwitchTo(oldcontext);
+		CHECK_FOR_INTERRUPTS();
+		return;
+	}
+
 	/*
 	 * Copy the given tuple into memory we control, and decrease availMem.
 	 * Then call the common code.
@@ -3647,6 +3923,10 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/* Can we sort on the bytes of the leading key? */
+		if (radix_sort_tuple(state))
+			return;
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -4869,3 +5149,47 @@ free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 		stup->tuple = NULL;
 	}
 }
+
+/*
+ * Datum comparators that radix_sort_tuple() recognizes.  See sortsupport.h.
+ */
+int
+ssup_datum_unsigned_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	if (x < y)
+		return -1;
+	else if (x > y)
+		return 1;
+	else
+		return 0;
+}
+
+#if SIZEOF_DATUM >= 8
+int
+ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int64		xx = DatumGetInt64(x);
+	int64		yy = DatumGetInt64(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+int
+ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int32		xx = DatumGetInt32(x);
+	int32		yy = DatumGetInt32(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
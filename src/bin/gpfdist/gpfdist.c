@@ -94,6 +94,12 @@ struct block_t
 	char*		cdata;
 };
 
+/* What do_write_blocks() leaves to the event loop */
+#define WRITE_AGAIN			0	/* wait for the socket to be writable again */
+#define WRITE_DONE			1	/* all data is sent, end the request */
+#define WRITE_FAILED		2	/* end the request with worker.errmsg */
+#define WRITE_READ_FAILED	3	/* the same, the data stream failed */
+
 typedef struct zstd_buffer zstd_buffer;
 struct zstd_buffer
 {
@@ -198,7 +204,8 @@ static struct
 	const char* ssl; /* path to certificates in case we use gpfdist with ssl */
 	int			w; /* The time used for session timeout in seconds */
 	int			compress; /* The flag to indicate whether comopression transmission is open */
-} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0};
+	int			threads; /* worker threads to read, compress and send data, 0 to do it in the event loop */
+} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0, 0};
 
 
 typedef union address
@@ -232,6 +239,20 @@ static struct
 	SSL_CTX 		*server_ctx;/* for SSL */
 #endif
 	int 			wdtimer; /* Kill gpfdist after k seconds of inactivity. 0 to disable. */
+#ifndef WIN32
+	/* worker threads serving GET requests, see do_write() */
+	struct
+	{
+		pthread_t*			threads;
+		pthread_mutex_t		lock;		/* protects the queue and the done list */
+		pthread_cond_t		cond;		/* signaled when a request is queued */
+		struct request_t*	queue;		/* requests waiting for a worker, oldest first */
+		struct request_t*	queue_tail;
+		struct request_t*	done;		/* requests the workers are done with */
+		int					notify[2];	/* pipe to wake up the event loop */
+		struct event		notify_event;
+	} worker;
+#endif
 } gcb;
 
 /*  A session */
@@ -257,6 +278,13 @@ struct session_t
 	struct timeval 	tm;             /* timeout for struct event */
 	struct event   	ev;             /* event we are watching for this session*/
 	apr_hash_t		*requests;
+	int				reading;		/* a worker thread reads from fstream, see
+									   session_get_block() */
+	int				close_on_read;	/* close fstream once that read is done */
+#ifndef WIN32
+	pthread_mutex_t	lock;			/* protects fstream, is_error and the above */
+	pthread_cond_t	read_done;		/* signaled when reading is cleared */
+#endif
 };
 
 typedef struct session_free_res session_free_res;
@@ -325,6 +353,23 @@ struct request_t
 	} in;
 
 	block_t	outblock;	/* next block to send out */
+
+	/*
+	 * Writing blocks with worker threads (--threads). While busy, only the
+	 * worker touches the request, and the things only the event loop may do
+	 * are left here for do_write_finish().
+	 */
+	struct
+	{
+		int			busy;			/* a worker thread owns the request */
+		int			status;			/* what do_write_blocks() returned */
+		const char*	errmsg;			/* error to end the request with */
+		int			end_session;	/* the session has to be ended */
+		int			session_error;	/* ... with an error */
+		apr_int64_t	read_bytes;		/* not yet added to gcb.read_bytes */
+		request_t*	next;			/* next request in the worker queue or done list */
+	} worker;
+
 	char*           line_delim_str;
 	int             line_delim_length;
 #ifdef USE_ZSTD
@@ -382,12 +427,17 @@ static void gp1_send_errfile(request_t* r, apr_file_t* errfile);
 
 static char* datetime_now(void);
 static char* datetime(apr_time_t t);
+static char* datetime_r(apr_time_t t, char* buf, size_t len);
 static int setup_read(request_t* r);
 static int setup_write(request_t* r);
 static void setup_do_close(request_t* r);
 static int session_attach(request_t* r);
 static void session_detach(request_t* r);
 static void session_end(session_t* s, int error);
+static void session_lock(session_t* s);
+static void session_wait_read(session_t* s);
+static void session_read_done(session_t* s);
+static void session_unlock(session_t* s);
 static void session_free(session_t* s, session_free_res* res);
 static void session_active_segs_dump(session_t* session);
 static int session_active_segs_isempty(session_t* session);
@@ -413,6 +463,9 @@ static int (*gpfdist_send)(const request_t *r, const void *buf, const size_t buf
 static int gpfdist_socket_receive(const request_t *r, void *buf, const size_t buflen);
 static int (*gpfdist_receive)(const request_t *r, void *buf, const size_t buflen); /* function pointer */
 static void request_cleanup(request_t *r);
+static void request_end_session(request_t* r, int error);
+static int do_write_blocks(request_t* r);
+static void do_write_finish(request_t* r, int status);
 #ifdef USE_SSL
 static int gpfdist_SSL_send(const request_t *r, const void *buf, const size_t buflen);
 static int gpfdist_SSL_receive(const request_t *r, void *buf, const size_t buflen);
@@ -437,6 +490,9 @@ static void delay_watchdog_timer(void);
 #ifndef WIN32
 static apr_time_t shutdown_time;
 static void* watchdog_thread(void*);
+static void worker_setup(void);
+static void* worker_thread(void*);
+static void do_worker_done(int fd, short event, void* arg);
 #endif
 
 static const char *EMPTY_HTTP_RES = "HTTP/1.0 200 ok\r\n"
@@ -579,7 +635,7 @@ static void usage_error(const char* msg, int print_usage)
 		{
 			fprintf(stderr,
 					"gpfdist -- file distribution web server\n\n"
-						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>]"
+						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>] [--threads <n>]"
 #ifdef GPFXDIST
 					    "[-c file]"
 #endif
@@ -605,7 +661,11 @@ static void usage_error(const char* msg, int print_usage)
 					    "        -c file    : configuration file for transformations\n"
 #endif
 						"        --version  : print version information\n"
-						"        -w timeout : timeout in seconds before close target file\n\n");
+						"        -w timeout : timeout in seconds before close target file\n"
+#ifndef WIN32
+						"        --threads n: read, compress and send data in n worker threads, default is 0\n"
+#endif
+						"\n");
 		}
 	}
 
@@ -669,6 +729,7 @@ static void parse_command_line(int argc, const char* const argv[],
 	{ "version", 256, 0, "print version number" },
 	{ NULL, 'w', 1, "wait for session timeout in seconds" },
 	{"compress", 258, 0, "turn on compressed transmission"},
+	{ "threads", 259, 1, "worker threads to read, compress and send data" },
 	{ 0 } };
 
 	status = apr_getopt_init(&os, pool, argc, argv);
@@ -761,6 +822,15 @@ static void parse_command_line(int argc, const char* const argv[],
 		case 258:
 			usage_error("ZSTD is not supported by this build", 0);
 			break;
+#endif
+#ifndef WIN32
+		case 259:
+			opt.threads = atoi(arg);
+			break;
+#else
+		case 259:
+			usage_error("--threads is not supported on this platform", 0);
+			break;
 #endif
 		}
 	}
@@ -790,6 +860,9 @@ static void parse_command_line(int argc, const char* const argv[],
     if (!is_valid_listen_queue_size(opt.z))
 		usage_error("Error: -z listen queue size must be between 16 and 512 (default is 256)", 0);
 
+	if (!is_valid_thread_count(opt.threads))
+		usage_error("Error: --threads must be between 0 and 256 (default is 0)", 0);
+
     /* get current directory, for ssl directory validation */
     if (0 != apr_filepath_get(&current_directory, APR_FILEPATH_NATIVE, pool))
 		usage_error(apr_psprintf(pool, "Error: cannot access directory '.'\n"
@@ -1272,14 +1345,14 @@ static int local_send(request_t *r, const char* buf, int buflen)
 			gwarning(r, "gpfdist_send failed - the connection was terminated by the client (%d: %s)", e, strerror(e));
 			/* close stream and release fd & flock on pipe file*/
 			if (r->session && r->is_get)
-				session_end(r->session, 0);
+				request_end_session(r, 0);
 			/* For post requests, the error msg may not be transmited
  			 * to the client side because of network failure. So the 
  			 * session has to be set an error to inform the client
  			 * through the following request response with an 
  			 * internal error. */
 			else if (r->session && !r->is_get)
-				session_end(r->session, 1);
+				request_end_session(r, 1);
 		} else {
 			if (!ok) {
 				gwarning(r, "gpfdist_send failed - due to (%d: %s)", e, strerror(e));
@@ -1396,48 +1469,70 @@ static void gp1_send_errfile(request_t* r, apr_file_t* errfile)
  *
  * Get a block out of the session. return error string. This includes a block
  * header (metadata for client such as filename, etc) and the data itself.
+ *
+ * This may run on a worker thread, concurrently with the other requests of
+ * the session, see do_write().
  */
 static const char*
-session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, int line_delim_length)
+session_get_block(request_t* r, block_t* retblock, char* line_delim_str, int line_delim_length)
 {
 	int 		size;
 	const int 	whole_rows = 1; /* gpfdist must not read data with partial rows */
 	struct fstream_filename_and_offset fos;
+	apr_int64_t	position;
 
 	session_t *session = r->session;
 
 	retblock->bot = retblock->top = 0;
 
+	/*
+	 * Take the fstream for one read. The lock is not held while reading, so
+	 * the event loop can end the session meanwhile, leaving the close to us.
+	 */
+	session_lock(session);
+	session_wait_read(session);
+
 	if (session->is_error || 0 == session->fstream)
 	{
+		session_unlock(session);
 		gprintln(NULL, "session_get_block: end session is_error: %d", session->is_error);
-		session_end(session, 0);
+		request_end_session(r, 0);
 		return 0;
 	}
 
-	gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
+	session->reading = 1;
+	session_unlock(session);
+
+	position = fstream_get_compressed_position(session->fstream);
 
 	/* read data from our filestream as a chunk with whole data rows */
 
 	size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
 	delay_watchdog_timer();
 
+	if (size == 0)
+		r->worker.read_bytes += fstream_get_compressed_size(session->fstream) - position;
+	else
+		r->worker.read_bytes += fstream_get_compressed_position(session->fstream) - position;
+
+	/* the fstream is closed with the session, keep a copy of the error */
+	if (size < 0)
+		apr_cpystrn(r->ferror, fstream_get_error(session->fstream), sizeof(r->ferror));
+
+	session_read_done(session);
+
 	if (size == 0)
 	{
 		gprintln(NULL, "session_get_block: end session due to EOF");
-		gcb.read_bytes += fstream_get_compressed_size(session->fstream);
-		session_end(session, 0);
+		request_end_session(r, 0);
 		return 0;
 	}
 
-	gcb.read_bytes += fstream_get_compressed_position(session->fstream);
-
 	if (size < 0)
 	{
-		const char* ferror = fstream_get_error(session->fstream);
-		gwarning(NULL, "session_get_block end session due to %s", ferror);
-		session_end(session, 1);
-		return ferror;
+		gwarning(NULL, "session_get_block end session due to %s", r->ferror);
+		request_end_session(r, 1);
+		return r->ferror;
 	}
 
 	retblock->top = size;
@@ -1486,9 +1581,83 @@ static void session_end(session_t* session, int error)
 			gprintln(NULL, "session(%ld) to remove stderr file %s", session->id, fs->fd.transform->errfilename);
 		}
 #endif
-		fstream_close(session->fstream);
+		/* a worker thread reading from it closes it when done */
+		session_lock(session);
+		if (session->reading)
+			session->close_on_read = 1;
+		else
+		{
+			fstream_close(session->fstream);
+			session->fstream = 0;
+		}
+		session_unlock(session);
+	}
+}
+
+/* Wait, holding the session lock, until no worker thread reads from fstream. */
+static void session_wait_read(session_t* session)
+{
+#ifndef WIN32
+	while (session->reading)
+		pthread_cond_wait(&session->read_done, &session->lock);
+#endif
+}
+
+/*
+ * A worker thread is done reading from fstream. Close it if the session was
+ * ended meanwhile.
+ */
+static void session_read_done(session_t* session)
+{
+	fstream_t*	fstream = 0;
+
+	session_lock(session);
+	session->reading = 0;
+	if (session->close_on_read)
+	{
+		fstream = session->fstream;
 		session->fstream = 0;
+		session->close_on_read = 0;
+	}
+#ifndef WIN32
+	pthread_cond_broadcast(&session->read_done);
+#endif
+	session_unlock(session);
+
+	if (fstream)
+	{
+		gprintln(NULL, "close fstream after read");
+		fstream_close(fstream);
+	}
+}
+
+/*
+ * End the session of a request. On a worker thread this is left to the event
+ * loop, which owns the sessions, see do_write_finish().
+ */
+static void request_end_session(request_t* r, int error)
+{
+	if (r->worker.busy)
+	{
+		r->worker.end_session = 1;
+		r->worker.session_error |= error;
 	}
+	else
+		session_end(r->session, error);
+}
+
+static void session_lock(session_t* session)
+{
+#ifndef WIN32
+	pthread_mutex_lock(&session->lock);
+#endif
+}
+
+static void session_unlock(session_t* session)
+{
+#ifndef WIN32
+	pthread_mutex_unlock(&session->lock);
+#endif
 }
 
 /* deallocate session, remove from hashtable */
@@ -1518,6 +1687,11 @@ static void session_free(session_t* session, session_free_res* res)
 
 	event_del(&session->ev);
 
+#ifndef WIN32
+	pthread_mutex_destroy(&session->lock);
+	pthread_cond_destroy(&session->read_done);
+#endif
+
 	apr_hash_set(gcb.session.tab, session->key, APR_HASH_KEY_STRING, 0);
 	apr_pool_destroy(session->pool);
 }
@@ -1796,6 +1970,10 @@ static int session_attach(request_t* r)
 		session->maxsegs = r->totalsegs;
 		session->requests = apr_hash_make(pool);
 		event_set(&session->ev, 0, 0, 0, 0);
+#ifndef WIN32
+		pthread_mutex_init(&session->lock, NULL);
+		pthread_cond_init(&session->read_done, NULL);
+#endif
 
 		if (session->tid == 0 || session->path == 0 || session->key == 0)
 			gfatal(r, "out of memory in session_attach");
@@ -1904,13 +2082,48 @@ pg_attribute_printf(1, 2);
 static void do_write(int fd, short event, void* arg)
 {
 	request_t* 	r = (request_t*) arg;
-	int 		n, i;
-	block_t* 	datablock;
 
 	if (fd != r->sock)
 		gfatal(r, "internal error - non matching fd (%d) "
 					  "and socket (%d)", fd, r->sock);
 
+#ifndef WIN32
+	/*
+	 * Reading, compressing and sending the blocks are left to a worker
+	 * thread, the event loop only waits for the socket to be writable.
+	 */
+	if (opt.threads > 0)
+	{
+		r->worker.busy = 1;
+		r->worker.next = NULL;
+
+		pthread_mutex_lock(&gcb.worker.lock);
+		if (gcb.worker.queue_tail)
+			gcb.worker.queue_tail->worker.next = r;
+		else
+			gcb.worker.queue = r;
+		gcb.worker.queue_tail = r;
+		pthread_cond_signal(&gcb.worker.cond);
+		pthread_mutex_unlock(&gcb.worker.lock);
+		return;
+	}
+#endif
+
+	do_write_finish(r, do_write_blocks(r));
+}
+
+/*
+ * do_write_blocks
+ *
+ * Write out the blocks of a request, getting new ones from the session. This
+ * may run on a worker thread: it must not end the request or the session, and
+ * returns what the event loop should do next instead.
+ */
+static int do_write_blocks(request_t* r)
+{
+	int 		n, i;
+	block_t* 	datablock;
+
 	/* Loop at most 3 blocks or until we choke on the socket */
 	for (i = 0; i < 3; i++)
 	{
@@ -1921,15 +2134,11 @@ static void do_write(int fd, short event, void* arg)
 
 			if (ferror)
 			{
-				request_end(r, 1, ferror, 0);
-				gfile_printf_then_putc_newline("ERROR: %s", ferror);
-				return;
+				r->worker.errmsg = ferror;
+				return WRITE_READ_FAILED;
 			}
 			if (!r->outblock.top)
-			{
-				request_end(r, 0, 0, 0);
-				return;
-			}
+				return WRITE_DONE;
 		}
 
 		datablock = &r->outblock;
@@ -1952,8 +2161,8 @@ static void do_write(int fd, short event, void* arg)
 					 */
 					if (errno == EPIPE || errno == ECONNRESET)
 						r->outblock.bot = r->outblock.top;
-					request_end(r, 1, "gpfdist send block header failure", 0);
-					return;
+					r->worker.errmsg = "gpfdist send block header failure";
+					return WRITE_FAILED;
 				}
 
 				gdebug(r, "send header bytes %d .. %d (top %d)",
@@ -1992,8 +2201,8 @@ static void do_write(int fd, short event, void* arg)
 			 */
 			if (errno == EPIPE || errno == ECONNRESET)
 				r->outblock.bot = r->outblock.top;
-			request_end(r, 1, "gpfdist send data failure", 0);
-			return;
+			r->worker.errmsg = "gpfdist send data failure";
+			return WRITE_FAILED;
 		}
 
 		gdebug(r, "send data bytes off buf %d .. %d (top %d)",
@@ -2010,10 +2219,144 @@ static void do_write(int fd, short event, void* arg)
 		}
 	}
 
-	/* Set up for this routine to be called again */
-	if (setup_write(r))
-		request_end(r, 1, 0, 0);
+	return WRITE_AGAIN;
+}
+
+/*
+ * do_write_finish
+ *
+ * Do in the event loop what do_write_blocks() left to it.
+ */
+static void do_write_finish(request_t* r, int status)
+{
+	gcb.read_bytes += r->worker.read_bytes;
+	r->worker.read_bytes = 0;
+
+	if (r->worker.end_session)
+	{
+		session_end(r->session, r->worker.session_error);
+		r->worker.end_session = 0;
+		r->worker.session_error = 0;
+	}
+
+	switch (status)
+	{
+		case WRITE_READ_FAILED:
+			request_end(r, 1, r->worker.errmsg, 0);
+			gfile_printf_then_putc_newline("ERROR: %s", r->worker.errmsg);
+			break;
+		case WRITE_FAILED:
+			request_end(r, 1, r->worker.errmsg, 0);
+			break;
+		case WRITE_DONE:
+			request_end(r, 0, 0, 0);
+			break;
+		default:
+			/* Set up for this routine to be called again */
+			if (setup_write(r))
+				request_end(r, 1, 0, 0);
+			break;
+	}
+}
+
+#ifndef WIN32
+/*
+ * worker_setup
+ *
+ * Start the worker threads of do_write(), and the event they wake up the
+ * event loop with when they are done with a request.
+ */
+static void worker_setup(void)
+{
+	int i;
+
+	pthread_mutex_init(&gcb.worker.lock, NULL);
+	pthread_cond_init(&gcb.worker.cond, NULL);
+
+	if (pipe(gcb.worker.notify) == -1)
+		gfatal(NULL, "cannot create pipe for worker threads: %s", strerror(errno));
+	if (fcntl(gcb.worker.notify[0], F_SETFL, O_NONBLOCK) == -1 ||
+		fcntl(gcb.worker.notify[1], F_SETFL, O_NONBLOCK) == -1)
+		gfatal(NULL, "fcntl(F_SETFL, O_NONBLOCK) failed for worker threads pipe");
+
+	event_set(&gcb.worker.notify_event, gcb.worker.notify[0], EV_READ | EV_PERSIST,
+			  do_worker_done, 0);
+	if (event_add(&gcb.worker.notify_event, 0))
+		gfatal(NULL, "cannot set up event for worker threads");
+
+	gcb.worker.threads = malloc(sizeof(pthread_t) * opt.threads);
+	if (!gcb.worker.threads)
+		gfatal(NULL, "out of memory in worker_setup");
+
+	for (i = 0; i < opt.threads; i++)
+	{
+		if (pthread_create(&gcb.worker.threads[i], 0, worker_thread, 0))
+			gfatal(NULL, "cannot create worker thread: %s", strerror(errno));
+	}
+
+	gprintln(NULL, "started %d worker threads", opt.threads);
+}
+
+static void* worker_thread(void* arg)
+{
+	request_t* 	r;
+	int 		wakeup;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&gcb.worker.lock);
+		while (!gcb.worker.queue)
+			pthread_cond_wait(&gcb.worker.cond, &gcb.worker.lock);
+
+		r = gcb.worker.queue;
+		gcb.worker.queue = r->worker.next;
+		if (!gcb.worker.queue)
+			gcb.worker.queue_tail = NULL;
+		pthread_mutex_unlock(&gcb.worker.lock);
+
+		r->worker.status = do_write_blocks(r);
+
+		pthread_mutex_lock(&gcb.worker.lock);
+		wakeup = (gcb.worker.done == NULL);
+		r->worker.next = gcb.worker.done;
+		gcb.worker.done = r;
+		pthread_mutex_unlock(&gcb.worker.lock);
+
+		/* a full pipe is fine, the event loop is to be woken up anyway */
+		if (wakeup && write(gcb.worker.notify[1], "", 1) < 0 && errno != EAGAIN)
+			gwarning(NULL, "cannot wake up event loop: %s", strerror(errno));
+	}
+
+	return NULL;
+}
+
+/*
+ * do_worker_done
+ *
+ * Callback when worker threads are done with requests.
+ */
+static void do_worker_done(int fd, short event, void* arg)
+{
+	char 		buf[64];
+	request_t* 	r;
+	request_t* 	next;
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+
+	pthread_mutex_lock(&gcb.worker.lock);
+	r = gcb.worker.done;
+	gcb.worker.done = NULL;
+	pthread_mutex_unlock(&gcb.worker.lock);
+
+	for (; r; r = next)
+	{
+		next = r->worker.next;
+		r->worker.busy = 0;
+		do_write_finish(r, r->worker.status);
+	}
 }
+#endif
 
 /*
  * Log request header
@@ -2925,19 +3268,26 @@ static char *gstring_trim(char* s)
 	return s;
 }
 
-static char *datetime(apr_time_t t)
+/* like datetime(), for the worker threads */
+static char *datetime_r(apr_time_t t, char* buf, size_t len)
 {
-	static char 	buf[100];
 	apr_time_exp_t 	texp;
 
 	apr_time_exp_lt(&texp, t);
 
-	sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d", 1900 + texp.tm_year, 1
+	snprintf(buf, len, "%04d-%02d-%02d %02d:%02d:%02d", 1900 + texp.tm_year, 1
 			+ texp.tm_mon, texp.tm_mday, texp.tm_hour, texp.tm_min, texp.tm_sec);
 
 	return buf;
 }
 
+static char *datetime(apr_time_t t)
+{
+	static char 	buf[100];
+
+	return datetime_r(t, buf, sizeof(buf));
+}
+
 static char* datetime_now(void)
 {
 	return datetime(apr_time_now());
@@ -2965,7 +3315,9 @@ pg_attribute_printf(3, 0);
 
 static void _gprint(const request_t *r, const char *level, const char *fmt, va_list args)
 {
-	printf("%s %d %s ", datetime_now(), ggetpid(), level);
+	char 		now[100];
+
+	printf("%s %d %s ", datetime_r(apr_time_now(), now, sizeof(now)), ggetpid(), level);
 	if (r != NULL)
 	{
 		printf("[%ld:%ld:%d:%d] ", GET_SID(r), r->id, r->segid, r->sock);
@@ -3886,6 +4238,11 @@ int gpfdist_init(int argc, const char* const argv[])
     signal_register();
 	http_setup();
 
+#ifndef WIN32
+	if (opt.threads > 0)
+		worker_setup();
+#endif
+
 #ifdef USE_SSL
 	if (opt.ssl)
 		printf("Serving HTTPS on port %d, directory %s\n", opt.p, opt.d);
@@ -33,3 +33,13 @@ bool is_valid_listen_queue_size(int listen_queue_size)
 	else
 		return true;
 }
+
+bool is_valid_thread_count(int thread_count)
+{
+	if (thread_count < 0)
+		return false;
+	else if (thread_count > 256)
+		return false;
+	else
+		return true;
+}
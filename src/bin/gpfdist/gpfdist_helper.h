@@ -4,4 +4,5 @@
 bool is_valid_timeout(int timeout_val);
 bool is_valid_session_timeout(int timeout_val);
 bool is_valid_listen_queue_size(int listen_queue_size);
+bool is_valid_thread_count(int thread_count);
 #endif
@@ -0,0 +1,132 @@
+#!/bin/bash
+#
+# Measure the aggregate read throughput of one gpfdist serving many segments.
+#
+# Every client is a curl process that requests the same file in the same
+# session, the way the segments of a readable external table do, so the rows
+# are split among them. For each --threads setting gpfdist is started afresh
+# and the file is read ROUNDS times.
+#
+# usage: throughput.bash [-g gpfdist] [-s size_mb] [-c clients] [-r rounds]
+#                        [-j "threads ..."] [-p port] [-z] [-k]
+#   -z  ask for zstd compressed blocks (gpfdist --compress)
+#   -k  use https (gpfdist --ssl), the certificates are taken from $SSL_DIR,
+#       clients present client.crt and client.key from there
+
+GPFDIST="gpfdist"
+SIZE_MB=1024
+CLIENTS=200
+ROUNDS=3
+THREADS="0 4 16 64"
+PORT=8090
+ZSTD=0
+SSL=0
+SSL_DIR=${SSL_DIR:-$HOME/certs}
+CURL_SSL=
+
+DATA_DIR=
+FILE="stress.txt"
+fdist_Pid=
+
+function usage() {
+  sed -n '/^# usage/,/^$/p' "$0" | sed 's/^# \{0,1\}//'
+  exit 1
+}
+
+function create_data() {
+  DATA_DIR=$(mktemp -d)
+  echo "generating ${SIZE_MB}MB of rows in $DATA_DIR/$FILE"
+  awk -v size=$((SIZE_MB * 1024 * 1024)) 'BEGIN {
+    for (i = 0; n < size; i++) {
+      row = i "\tname " i "\tcity " (i % 997) "\t" (i * 7919) % 1000003
+      print row
+      n += length(row) + 1
+    }
+  }' > "$DATA_DIR/$FILE"
+}
+
+function run_gpfdist() {
+  local args="-d $DATA_DIR -p $PORT -s --threads $1"
+
+  [ $ZSTD -eq 1 ] && args="$args --compress"
+  [ $SSL -eq 1 ] && args="$args --ssl $SSL_DIR"
+
+  $GPFDIST $args >> "$DATA_DIR/gpfdist.log" 2>&1 &
+  fdist_Pid=$!
+
+  # wait for it to listen
+  for i in $(seq 50); do
+    curl -s -o /dev/null $CURL_SSL "$SCHEME://127.0.0.1:$PORT/" && return 0
+    sleep 0.1
+  done
+  echo "ERROR: gpfdist did not start, see $DATA_DIR/gpfdist.log"
+  exit 1
+}
+
+function read_once() {
+  local sn=$1
+  local seg
+
+  for ((seg = 0; seg < CLIENTS; seg++)); do
+    curl -s -o /dev/null $CURL_SSL -w "%{size_download}\n" \
+      -H "X-GP-XID: stress" -H "X-GP-CID: 1" -H "X-GP-SN: $sn" \
+      -H "X-GP-PROTO: 1" -H "X-GP-ZSTD: $ZSTD" \
+      -H "X-GP-SEGMENT-COUNT: $CLIENTS" -H "X-GP-SEGMENT-ID: $seg" \
+      "$SCHEME://127.0.0.1:$PORT/$FILE" &
+  done | awk '{ n += $1 } END { print n }'
+  wait
+}
+
+function measure() {
+  local threads=$1
+  local bytes=0
+  local start end round
+
+  run_gpfdist $threads
+
+  start=$(date +%s.%N)
+  for ((round = 1; round <= ROUNDS; round++)); do
+    bytes=$((bytes + $(read_once "$threads.$round")))
+  done
+  end=$(date +%s.%N)
+
+  kill -15 $fdist_Pid
+  wait $fdist_Pid 2> /dev/null
+
+  awk -v t=$threads -v b=$bytes -v s=$start -v e=$end 'BEGIN {
+    printf "threads %4d: %8.2f GB in %7.2f s, %6.2f GB/s\n", t, b / 1e9, e - s, b / 1e9 / (e - s)
+  }'
+}
+
+function _main() {
+  while getopts "g:s:c:r:j:p:zkh" opt; do
+    case $opt in
+      g) GPFDIST=$OPTARG ;;
+      s) SIZE_MB=$OPTARG ;;
+      c) CLIENTS=$OPTARG ;;
+      r) ROUNDS=$OPTARG ;;
+      j) THREADS=$OPTARG ;;
+      p) PORT=$OPTARG ;;
+      z) ZSTD=1 ;;
+      k) SSL=1 ;;
+      *) usage ;;
+    esac
+  done
+
+  SCHEME=http
+  if [ $SSL -eq 1 ]; then
+    SCHEME=https
+    CURL_SSL="-k --cert $SSL_DIR/client.crt --key $SSL_DIR/client.key"
+  fi
+
+  create_data
+  echo "$CLIENTS clients, $ROUNDS rounds, zstd $ZSTD, ssl $SSL on $(nproc) cores"
+
+  for threads in $THREADS; do
+    measure $threads
+  done
+
+  rm -rf "$DATA_DIR"
+}
+
+_main "$@"
@@ -20,7 +20,7 @@ struct AOCSVPInfo;
 struct AOVacuumRelStats;
 extern void AOCSSegmentFileTruncateToEOF(Relation aorel, int segno, struct AOCSVPInfo *vpinfo, struct AOVacuumRelStats *vacrelstats);
 extern void AOCSCompaction_DropSegmentFile(Relation aorel, int segno, struct AOVacuumRelStats *vacrelstats);
-extern void AOCSCompact(Relation aorel,
+extern bool AOCSCompact(Relation aorel,
 						int compaction_segno,
 						int *insert_segno,
 						bool isFull,
@@ -0,0 +1,70 @@
+/*------------------------------------------------------------------------------
+ *
+ * aocsbloom.h
+ *	  Per-block bloom filters for append-optimized column oriented tables.
+ *
+ * A column with the bloomfilter_fpr storage option gets a bloom filter over
+ * the values of each of its blocks.  The filters are stored in the block
+ * directory relation (see AOBlkDirBloomColumnGroupNo()), and sequential scans
+ * use them to skip the blocks, in every projected column, that cannot satisfy
+ * an equality or IN-list qual on that column.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/access/aocsbloom.h
+ *
+ *------------------------------------------------------------------------------
+ */
+#ifndef AOCSBLOOM_H
+#define AOCSBLOOM_H
+
+#include "catalog/pg_attribute.h"
+#include "lib/stringinfo.h"
+#include "nodes/pg_list.h"
+#include "utils/relcache.h"
+#include "utils/snapshot.h"
+
+/*
+ * Filters are kept small enough to fit in a block directory tuple, which
+ * is never toasted.  Blocks with more distinct values than a filter of this
+ * size can usefully hold get no filter, and are always read.
+ */
+#define AOCS_BLOOM_MAX_BYTES		4096
+#define AOCS_BLOOM_MAX_DISTINCT		16384
+
+/* On-disk format, stored in the minipage column of pg_aoblkdir */
+typedef struct AOCSBloomFilter
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	int32		version;
+	int64		rowCount;		/* rows in the block */
+	uint32		nbits;			/* size of the bitmap, a multiple of 64 */
+	int32		nhashes;
+	uint64		words[FLEXIBLE_ARRAY_MEMBER];
+} AOCSBloomFilter;
+
+#define AOCS_BLOOM_VERSION		1
+
+typedef struct AOCSBloomBuilder AOCSBloomBuilder;
+typedef struct AOCSBloomScan AOCSBloomScan;
+
+/* Write side, driven by the datum stream of the column */
+extern AOCSBloomBuilder *aocs_bloom_builder_create(Form_pg_attribute attr,
+												   double fpr);
+extern void aocs_bloom_builder_add(AOCSBloomBuilder *builder, Datum value);
+extern struct varlena *aocs_bloom_builder_finish(AOCSBloomBuilder *builder,
+												 int64 rowCount);
+extern void aocs_bloom_builder_free(AOCSBloomBuilder *builder);
+
+/* Scan side */
+extern AOCSBloomScan *aocs_bloom_scan_prepare(Relation rel, List *qual);
+extern AttrNumber aocs_bloom_scan_attno(AOCSBloomScan *bloomScan);
+extern void aocs_bloom_scan_load_segment(AOCSBloomScan *bloomScan,
+										 Relation rel,
+										 Snapshot snapshot,
+										 int segno);
+extern int64 aocs_bloom_scan_skip_to(AOCSBloomScan *bloomScan, int64 rowNum);
+extern void aocs_bloom_scan_explain(AOCSBloomScan *bloomScan, StringInfo buf);
+extern void aocs_bloom_scan_end(AOCSBloomScan *bloomScan);
+
+#endif							/* AOCSBLOOM_H */
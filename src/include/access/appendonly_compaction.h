@@ -18,6 +18,7 @@
 #include "utils/rel.h"
 #include "access/memtup.h"
 #include "executor/tuptable.h"
+#include "datatype/timestamp.h"
 
 #define APPENDONLY_COMPACTION_SEGNO_INVALID (-1)
 
@@ -28,14 +29,16 @@
  */
 typedef struct AOVacuumRelStats
 {
-	int		nbytes_truncated;	/* current # of bytes truncated from segment file */
+	int64	nbytes_truncated;	/* current # of bytes truncated from segment file */
 	int		num_dead_tuples;	/* current # of dead tuples */
 	int		num_index_vacuumed; /* current # of indexes been vacuumed */
+	int		num_compacted;		/* current # of segment files compacted */
+	TimestampTz start_time;		/* when the VACUUM of the relation started */
 } AOVacuumRelStats;
 
 extern Bitmapset *AppendOptimizedCollectDeadSegments(Relation aorel);
 extern void AppendOptimizedDropDeadSegments(Relation aorel, Bitmapset *segnos, AOVacuumRelStats *vacrelstats);
-extern void AppendOnlyCompact(Relation aorel,
+extern bool AppendOnlyCompact(Relation aorel,
 							  int compaction_segno,
 							  int *insert_segno,
 							  bool isFull,
@@ -49,5 +52,7 @@ extern bool AppendOnlyCompaction_ShouldCompact(
 								   Snapshot appendOnlyMetaDataSnapshot);
 extern void AppendOnlyThrowAwayTuple(Relation rel, TupleTableSlot *slot, MemTupleBinding *mt_bind);
 extern void AppendOptimizedTruncateToEOF(Relation aorel, AOVacuumRelStats *vacrelstats);
+extern void AppendOptimizedReportBytesReclaimed(AOVacuumRelStats *vacrelstats);
+extern void AppendOptimizedCompactionDelayPoint(int64 bytesRead, int64 *bytesCharged);
 
 #endif
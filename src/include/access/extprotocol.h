@@ -23,7 +23,18 @@
 
 /* ------------------------- I/O function API -----------------------------*/
 
-struct ExternalSelectDescData;
+/*
+ * ExternalSelectDescData is used for storing state related
+ * to selecting data from an external table.  It is handed to the protocol
+ * functions, so that they can skip data the scan does not need.
+ */
+typedef struct ExternalSelectDescData
+{
+	struct ProjectionInfo *projInfo;	/* Information for column projection */
+	List	   *filter_quals;	/* Information for filter pushdown, only set
+								 * with gp_external_enable_filter_pushdown */
+} ExternalSelectDescData;
+
 typedef struct ExternalSelectDescData *ExternalSelectDesc;
 
 /*
@@ -43,6 +43,10 @@
 #define AO_DEFAULT_COMPRESSTYPE   "none"
 #endif
 #define AO_DEFAULT_CHECKSUM       true
+/* Per-column bloom filters are disabled unless a false positive rate is set. */
+#define AO_DEFAULT_BLOOMFILTER_FPR  0.0
+#define AO_MIN_BLOOMFILTER_FPR  0.0
+#define AO_MAX_BLOOMFILTER_FPR  0.5
 
 /* types supported by reloptions */
 typedef enum relopt_type
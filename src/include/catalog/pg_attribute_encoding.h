@@ -64,6 +64,7 @@ DECLARE_UNIQUE_INDEX(pg_attribute_encoding_attrelid_filenum_index, 6238, on pg_a
 
 extern PGFunction *get_funcs_for_compression(char *compresstype);
 extern StdRdOptions **RelationGetAttributeOptions(Relation rel);
+extern bool RelationHasBloomFilterColumns(Relation rel);
 extern List **RelationGetUntransformedAttributeOptions(Relation rel);
 
 extern void AddRelationAttributeEncodings(Relation rel, List *attr_encodings);
@@ -70,6 +70,10 @@ typedef struct AOCSInsertDescData
 
 	AppendOnlyBlockDirectory blockDirectory;
 
+	/* blocks handed to the compression worker pool, see gp_compress.h */
+	struct GpDecompressTask *compressTasks;
+	int			   *compressAtts;
+
 	/*
 	 * For multiple segment files insertion.
 	 */
@@ -203,6 +207,13 @@ typedef struct AOCSScanDescData
 	int				aos_scaned_rows;
 	int				*aos_qual_rows;
 
+	/* used to skip blocks with per-block bloom filters, see aocsbloom.h */
+	struct AOCSBloomScan *bloomScan;
+
+	/* blocks handed to the decompression worker pool, see gp_compress.h */
+	struct GpDecompressTask *decompressTasks;
+	AttrNumber	   *decompressAtts;
+
 	/*
 	 * The total number of bytes read, compressed, across all segment files, and
 	 * across all columns projected, so far. It is used for scan progress reporting.
@@ -356,6 +367,7 @@ extern void aocs_endscan(AOCSScanDesc scan);
 extern bool aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno);
 extern void aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
+extern void aocs_insert_multi(AOCSInsertDesc idesc, TupleTableSlot **slots, int ntuples);
 static inline void aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 {
 	slot_getallattrs(slot);
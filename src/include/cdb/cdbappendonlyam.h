@@ -28,6 +28,7 @@
 #include "access/xlog.h"
 #include "access/appendonly_visimap.h"
 #include "executor/tuptable.h"
+#include "jit/jit.h"
 #include "nodes/execnodes.h"
 #include "nodes/primnodes.h"
 #include "nodes/bitmapset.h"
@@ -128,6 +129,16 @@ typedef struct AppendOnlyExecutorReadBlock
 	AppendOnlyStorageRead	*storageRead;
 
 	MemTupleBinding *mt_bind;
+
+	/*
+	 * JIT compiled memtuple_deform() for mt_bind, if the scan runs under a
+	 * plan node with tuple deforming JIT enabled.  It is compiled for the
+	 * first tuple, and kept across rescans; jit_parent is cleared once that
+	 * was attempted.
+	 */
+	struct PlanState *jit_parent;
+	MemTupleDeformFunc jit_deform;
+
 	/*
 	 * When reading a segfile that's using version < AOSegfileFormatVersion_GP5,
 	 * that is, was created before GPDB 5.0 and upgraded with pg_upgrade, we need
@@ -95,6 +95,14 @@ typedef struct MinipagePerColumnGroup
 #define IsMinipageFull(minipagePerColumnGroup) \
 	((minipagePerColumnGroup)->numMinipageEntries == (uint32) gp_blockdirectory_minipage_size)
 
+/*
+ * Bloom filters of AOCO blocks are stored as block directory rows with a
+ * negative columngroup_no, one row per block, keyed by the block's first row
+ * number.  The minipage column holds the filter instead of a minipage.
+ */
+#define AOBlkDirBloomColumnGroupNo(columnGroupNo) (-(columnGroupNo) - 1)
+#define AOBlkDirIsBloomColumnGroupNo(columnGroupNo) ((columnGroupNo) < 0)
+
 /*
  * Define a structure for the append-only relation block directory.
  */
@@ -230,6 +238,11 @@ extern bool AppendOnlyBlockDirectory_InsertEntry(
 	int64 fileOffset,
 	int64 rowCount,
 	bool addColAction);
+extern void AppendOnlyBlockDirectory_InsertBloomFilter(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int64 firstRowNum,
+	struct varlena *filter);
 extern void AppendOnlyBlockDirectory_End_forInsert(
 	AppendOnlyBlockDirectory *blockDirectory);
 extern void AppendOnlyBlockDirectory_End_forSearch(
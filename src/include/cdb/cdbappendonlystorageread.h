@@ -225,6 +225,8 @@ extern int64 AppendOnlyStorageRead_CurrentHeaderOffsetInFile(AppendOnlyStorageRe
 extern int64 AppendOnlyStorageRead_CurrentCompressedLen(AppendOnlyStorageRead *storageRead);
 extern int64 AppendOnlyStorageRead_OverallBlockLen(AppendOnlyStorageRead *storageRead);
 extern uint8 *AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead);
+extern uint8 *AppendOnlyStorageRead_GetCompressedBuffer(AppendOnlyStorageRead *storageRead,
+										  int32 *compressedLen);
 extern void AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 							  uint8 *contentOut, int32 contentLen);
 extern void AppendOnlyStorageRead_SkipCurrentBlock(AppendOnlyStorageRead *storageRead);
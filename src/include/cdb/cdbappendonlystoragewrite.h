@@ -224,6 +224,15 @@ extern void AppendOnlyStorageWrite_FinishBuffer(
 									int32 contentLen,
 									int executorBlockKind,
 									int rowCount);
+extern uint8 *AppendOnlyStorageWrite_GetCompressBuffer(
+									AppendOnlyStorageWrite *storageWrite,
+									int32 *compressBufferLen);
+extern void AppendOnlyStorageWrite_FinishCompressedBuffer(
+									AppendOnlyStorageWrite *storageWrite,
+									int32 contentLen,
+									int32 compressedLen,
+									int executorBlockKind,
+									int rowCount);
 
 extern void AppendOnlyStorageWrite_CancelLastBuffer(AppendOnlyStorageWrite *storageWrite);
 
@@ -16,6 +16,8 @@
 #ifndef CDBCONN_H
 #define CDBCONN_H
 
+#include "cdb/cdbplancache.h"
+
 
 /* --------------------------------------------------------------------------------------------------
  * Structure for segment database definition and working values
@@ -55,6 +57,10 @@ typedef struct SegmentDatabaseDescriptor
 	int						identifier;		/* unique identifier in the cdbcomponent segment pool */
 	double					establishConnTime; /* the time of establish connection to the segment,
 												* -1 means this connection is cached */
+
+	/* Ids of the plans the QE has cached, see cdbplancache.c */
+	uint64					cachedPlans[CDB_PLAN_CACHE_SLOTS];
+	uint32					cachedPlansGeneration;
 } SegmentDatabaseDescriptor;
 
 SegmentDatabaseDescriptor *
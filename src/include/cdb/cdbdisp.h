@@ -51,6 +51,14 @@ typedef struct CdbDispatcherState
 	bool isGangDestroying;
 #endif
 	bool destroyIdleReaderGang;
+
+	/*
+	 * For plan dispatch: id of the plan, or 0 if it is not cached, and the
+	 * message to send instead to the QEs that already hold the plan.
+	 */
+	uint64 planId;
+	char *cachedPlanQueryText;
+	int cachedPlanQueryTextLen;
 } CdbDispatcherState;
 
 typedef struct DispatcherInternalFuncs
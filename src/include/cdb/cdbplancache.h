@@ -0,0 +1,43 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbplancache.h
+ *	  Cache of dispatched plans in the QEs.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBPLANCACHE_H
+#define CDBPLANCACHE_H
+
+#include "nodes/plannodes.h"
+
+struct SegmentDatabaseDescriptor;
+
+/*
+ * Number of plans each QE keeps.  The cache is direct mapped: a plan goes to
+ * slot (id % CDB_PLAN_CACHE_SLOTS), so the QD always knows which plans each
+ * of its QEs holds without asking them.
+ */
+#define CDB_PLAN_CACHE_SLOTS			16
+
+/* Plans bigger than this (serialized, uncompressed) are never cached */
+#define CDB_PLAN_CACHE_MAX_PLAN_SIZE	(64 * 1024)
+
+/* Dispatcher side */
+extern uint64 cdbplancache_plan_id(const char *splan, int splan_len,
+								   int splan_len_uncompressed);
+extern bool cdbplancache_qe_has_plan(struct SegmentDatabaseDescriptor *segdbDesc,
+									 uint64 planId);
+extern void cdbplancache_qe_add_plan(struct SegmentDatabaseDescriptor *segdbDesc,
+									 uint64 planId);
+extern void cdbplancache_qe_reset(struct SegmentDatabaseDescriptor *segdbDesc);
+
+/* Executor side */
+extern void cdbplancache_store(uint64 planId, PlannedStmt *plan);
+extern PlannedStmt *cdbplancache_fetch(uint64 planId);
+
+#endif   /* CDBPLANCACHE_H */
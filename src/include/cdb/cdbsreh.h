@@ -89,6 +89,8 @@ extern void HandleSingleRowError(CdbSreh *cdbsreh);
 extern void ReportSrehResults(CdbSreh *cdbsreh, uint64 total_rejected);
 extern void SendNumRows(int64 numrejected, int64 numcompleted);
 extern void ErrorIfRejectLimitReached(CdbSreh *cdbsreh);
+extern void ErrorIfTotalRejectLimitReached(CdbSreh *cdbsreh, uint64 total_rejected,
+										   uint64 total_processed);
 extern bool ExceedSegmentRejectHardLimit(CdbSreh *cdbsreh);
 extern bool IsRejectLimitReached(CdbSreh *cdbsreh);
 extern void VerifyRejectLimit(char rejectlimittype, int rejectlimit);
@@ -544,6 +544,12 @@ extern bool gp_adjust_selectivity_for_outerjoins;
  */
 extern int gp_hashjoin_tuples_per_bucket;
 
+/*
+ * Build a spilled hash join batch from the outer side, when only that side
+ * fits in memory.
+ */
+extern bool gp_hashjoin_role_reversal;
+
 /*
  * Damping of selectivities of clauses which pertain to the same base
  * relation; compensates for undetected correlation
@@ -632,6 +638,9 @@ extern int explain_memory_verbosity;
  */
 extern bool gp_enable_sort_limit;
 
+/* May in-memory sorts on integer-like leading keys use a radix sort? */
+extern bool gp_enable_radix_sort;
+
 extern bool trace_sort;
 
 /**
@@ -641,6 +650,8 @@ extern bool gp_dynamic_partition_pruning;
 
 /* Sharing of plan fragments for common table expressions */
 extern bool gp_cte_sharing;
+/* Let cross-slice ShareInputScan consumers read while the producer writes */
+extern bool gp_shareinput_streaming;
 /* Enable RECURSIVE clauses in common table expressions */
 extern bool gp_recursive_cte;
 
@@ -653,6 +664,9 @@ extern int gp_segworker_relative_priority;
 /*  Max size of dispatched plans; 0 if no limit */
 extern int gp_max_plan_size;
 
+/* Let QEs cache dispatched plans, and dispatch only their hash */
+extern bool gp_enable_qe_plan_cache;
+
 /* Get statistics for partitioned parent from a child */
 extern bool 	gp_statistics_pullup_from_child_partition;
 
@@ -120,6 +120,7 @@ typedef struct CopyFormatOptions
 	char	   *eol_str;		/* optional NEWLINE from command. before eol_type is defined */
 	char	   *tags;			/* directory table */
 	SingleRowErrorDesc *sreh;
+	Oid			stage_for;		/* loading the stage of this table */
 	/* end Apache Cloudberry specific variables */
 } CopyFormatOptions;
 
@@ -102,6 +102,10 @@ typedef struct CopyFromStateData
 
 	StringInfo  dispatch_msgbuf; /* used in COPY_DISPATCH mode, to construct message
 								  * to send to QE. */
+	StringInfo *dispatch_chunks; /* used in COPY_DISPATCH mode, the frames not
+								  * yet sent to each QE, indexed by segment */
+	int			stage_seg;	/* when loading a stage, the QE whose chunk is
+							 * being filled */
 
 	/* Error handling options */
 	CopyErrMode errMode;
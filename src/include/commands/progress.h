@@ -25,6 +25,9 @@
 #define PROGRESS_VACUUM_NUM_INDEX_VACUUMS		4
 #define PROGRESS_VACUUM_MAX_DEAD_TUPLES			5
 #define PROGRESS_VACUUM_NUM_DEAD_TUPLES			6
+/* Greenplum AO/AOCO tables only */
+#define PROGRESS_VACUUM_AO_BYTES_RECLAIMED		7
+#define PROGRESS_VACUUM_AO_BYTES_RECLAIMED_RATE	8
 
 /* Phases of vacuum (as advertised via PROGRESS_VACUUM_PHASE) */
 #define PROGRESS_VACUUM_PHASE_SCAN_HEAP			1
@@ -0,0 +1,26 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchQual.h
+ *	  Evaluation of simple scan quals over a batch of tuples at a time.
+ *
+ * IDENTIFICATION
+ *		src/include/executor/execBatchQual.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCHQUAL_H
+#define EXECBATCHQUAL_H
+
+#include "executor/tuptable.h"
+#include "nodes/pg_list.h"
+
+/* Number of tuples a scan collects before evaluating its batch qual */
+#define BATCH_QUAL_SIZE		128
+
+typedef struct BatchQual BatchQual;
+
+extern BatchQual *ExecInitBatchQual(List *qual, List **residual);
+extern int	ExecBatchQual(BatchQual *bq, TupleTableSlot **slots, int nslots,
+						  int *sel);
+
+#endif							/* EXECBATCHQUAL_H */
@@ -173,6 +173,7 @@ typedef struct HashJoinTableStats
 
     /* These statistics are cumulative over all nontrivial batches... */
     int                     nonemptybatches;    /* num of nontrivial batches */
+    int                     reversedbatches;    /* num built from outer side */
     Size                    workmem_max;        /* work_mem high water mark */
     CdbExplain_Agg          chainlength;        /* hash chain length stats */
 } HashJoinTableStats;
@@ -19,7 +19,7 @@
 
 extern SeqScanState *ExecInitSeqScan(SeqScan *node, EState *estate, int eflags);
 extern SeqScanState *ExecInitSeqScanForPartition(SeqScan *node, EState *estate,
-							Relation currentRelation);
+							Relation currentRelation, List **batchslots);
 extern void ExecEndSeqScan(SeqScanState *node);
 extern void ExecReScanSeqScan(SeqScanState *node);
 
@@ -70,11 +70,22 @@ typedef void (*JitProviderReleaseContextCB) (JitContext *context);
 struct ExprState;
 typedef bool (*JitProviderCompileExprCB) (struct ExprState *state);
 
+/* GPDB: deforming the memtuples of append-optimized row tables */
+struct PlanState;
+struct MemTupleBinding;
+struct MemTupleData;
+typedef void (*MemTupleDeformFunc) (struct MemTupleData *mtup,
+									short *null_saves,
+									Datum *values, bool *isnull);
+typedef MemTupleDeformFunc (*JitProviderCompileMemTupleDeformCB) (struct PlanState *parent,
+																	struct MemTupleBinding *pbind);
+
 struct JitProviderCallbacks
 {
 	JitProviderResetAfterErrorCB reset_after_error;
 	JitProviderReleaseContextCB release_context;
 	JitProviderCompileExprCB compile_expr;
+	JitProviderCompileMemTupleDeformCB compile_memtuple_deform;
 };
 
 
@@ -99,6 +110,8 @@ extern void jit_release_context(JitContext *context);
  * not be able to perform JIT (i.e. return false).
  */
 extern bool jit_compile_expr(struct ExprState *state);
+extern MemTupleDeformFunc jit_compile_memtuple_deform(struct PlanState *parent,
+													  struct MemTupleBinding *pbind);
 extern void InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add);
 
 
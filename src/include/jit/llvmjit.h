@@ -113,6 +113,8 @@ extern bool llvm_compile_expr(struct ExprState *state);
 struct TupleTableSlotOps;
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
 										const struct TupleTableSlotOps *ops, int natts);
+extern MemTupleDeformFunc llvm_compile_memtuple_deform(struct PlanState *parent,
+													   struct MemTupleBinding *pbind);
 
 /*
  ****************************************************************************
@@ -152,6 +152,7 @@ typedef struct Port
 	char	   *cmdline_options;
 	char	   *diff_options;
 	List	   *guc_options;
+	int			column_batches; /* PQ_COLUMN_BATCHES_xxx asked for */
 
 	/*
 	 * The startup packet application name, only used here for the "connection
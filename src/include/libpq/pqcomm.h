@@ -217,4 +217,21 @@ typedef struct CancelRequestPacket
 /* The same as CMDTAG_FAULT_INJECT in pqcomm.h */
 #define GPCONN_TYPE_FAULT "FAULT_INJECT"
 
+/*
+ * Protocol option asking the server to send query results in ColumnBatch
+ * ('b') messages, many rows per message with the values of each column
+ * stored together, instead of a DataRow message per row.  The value is
+ * "off", "on", or "zstd" to also let the server compress the batches.
+ * The values are in the same formats as DataRow would carry them.
+ */
+#define PQ_COLUMN_BATCHES_OPTION "_pq_.column_batches"
+
+#define PQ_COLUMN_BATCHES_OFF	0
+#define PQ_COLUMN_BATCHES_ON	1
+#define PQ_COLUMN_BATCHES_ZSTD	2
+
+/* Compression method of the payload of a ColumnBatch message */
+#define PQ_COLUMN_BATCH_UNCOMPRESSED	0
+#define PQ_COLUMN_BATCH_ZSTD			1
+
 #endif							/* PQCOMM_H */
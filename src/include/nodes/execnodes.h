@@ -1543,6 +1543,14 @@ typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+
+	/* GPDB: batch evaluation of the qual, see SeqNextBatch() */
+	struct BatchQual *batchqual;	/* NULL if not in use */
+	TupleTableSlot **batchslots;	/* the tuples of the current batch */
+	int		   *batchsel;		/* indexes of those that passed */
+	int			nbatchsel;		/* # of entries in batchsel */
+	int			batchpos;		/* next entry of batchsel to return */
+	bool		batchdone;		/* reached the end of the scan */
 } SeqScanState;
 
 /* ----------------
@@ -2210,6 +2218,9 @@ typedef struct DynamicSeqScanState
 	struct PartitionPruneState *as_prune_state; /* partition dynamic pruning state */
 	Bitmapset  *as_valid_subplans; /* used to determine partitions during dynamic pruning*/
 	bool 		did_pruning; /* flag that is set once dynamic pruning is performed */
+
+	/* batch qual slots shared by the partitions, see ExecSeqScanBatchSlots() */
+	List	   *batchslots;
 } DynamicSeqScanState;
 
 /*
@@ -2435,6 +2446,8 @@ typedef struct HashJoinState
 	bool		prefetch_joinqual;
 	bool		prefetch_qual;
 	bool		hj_nonequijoin;
+	bool		hj_BatchReversed;	/* current batch is built from the outer
+									 * side, see ExecHashJoinReverseBatch() */
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
@@ -2564,6 +2577,7 @@ typedef struct PresortedKeyData
  */
 struct shareinput_local_state;
 struct shareinput_Xslice_reference;
+struct shareinput_stream_reader;
 struct NTupleStore;
 struct NTupleStoreAccessor;
 
@@ -2577,6 +2591,9 @@ typedef struct ShareInputScanState
 	struct shareinput_local_state *local_state;
 	struct shareinput_Xslice_reference *ref;
 
+	/* Read position of this scanner, in a streaming cross-slice share */
+	struct shareinput_stream_reader *stream;
+
 	bool		isready;
 } ShareInputScanState;
 
@@ -4462,6 +4462,7 @@ typedef struct RetrieveStmt
 	char		*endpoint_name;
 	int64		count;
 	bool		is_all;
+	List		*options;		/* WITH options, a list of DefElem */
 } RetrieveStmt;
 
 /* ----------------------
@@ -1245,6 +1245,12 @@ typedef struct ShareInputScan
 
 	/* Discard the scan output? True for ORCA CTE producer, false otherwise. */
 	bool        discard_output;
+
+	/*
+	 * Let consumer slices read the tuples as the producer writes them,
+	 * instead of waiting for the whole input. Only for cross-slice shares.
+	 */
+	bool		streaming;
 } ShareInputScan;
 
 /* ----------------
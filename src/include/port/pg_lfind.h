@@ -0,0 +1,84 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_lfind.h
+ *	  Optimized linear search routines using SIMD intrinsics where
+ *	  available.
+ *
+ * Portions Copyright (c) 1996-2021, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/port/pg_lfind.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_LFIND_H
+#define PG_LFIND_H
+
+#include "port/pg_bitutils.h"
+#include "port/simd.h"
+
+/* the most keys pg_lfind8_any() looks for at once */
+#define PG_LFIND8_MAX_KEYS	6
+
+/*
+ * pg_lfind8_any
+ *
+ * Return a pointer to the first byte in [s, end) that is equal to one of
+ * the nkeys bytes in 'keys', or 'end' if there is none.  This is what the
+ * text and CSV parsers use to skip over the bytes that need no attention,
+ * such as everything but the delimiter, quote, escape and newline
+ * characters.
+ */
+static inline const char *
+pg_lfind8_any(const char *s, const char *end, const char *keys, int nkeys)
+{
+	Vector8		keyvecs[PG_LFIND8_MAX_KEYS];
+	int			i;
+
+	Assert(nkeys > 0 && nkeys <= PG_LFIND8_MAX_KEYS);
+
+	for (i = 0; i < nkeys; i++)
+		keyvecs[i] = vector8_broadcast((uint8) keys[i]);
+
+	while (end - s >= (ptrdiff_t) sizeof(Vector8))
+	{
+		Vector8		chunk;
+#ifndef USE_NO_SIMD
+		Vector8		hits;
+		uint32		mask;
+
+		vector8_load(&chunk, (const uint8 *) s);
+		hits = vector8_eq(chunk, keyvecs[0]);
+		for (i = 1; i < nkeys; i++)
+			hits = vector8_or(hits, vector8_eq(chunk, keyvecs[i]));
+
+		mask = vector8_highbit_mask(hits);
+		if (mask != 0)
+			return s + pg_rightmost_one_pos32(mask);
+#else
+		bool		found = false;
+
+		vector8_load(&chunk, (const uint8 *) s);
+		for (i = 0; i < nkeys; i++)
+			found |= vector8_has_zero(chunk ^ keyvecs[i]);
+
+		/* found, the scalar loop below will tell where */
+		if (found)
+			break;
+#endif
+		s += sizeof(Vector8);
+	}
+
+	for (; s < end; s++)
+	{
+		for (i = 0; i < nkeys; i++)
+		{
+			if (*s == keys[i])
+				return s;
+		}
+	}
+
+	return end;
+}
+
+#endif							/* PG_LFIND_H */
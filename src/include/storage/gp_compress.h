@@ -46,6 +46,38 @@ extern void gp_decompress(
 		CompressionState *compressionState,
 		int64 bufferCount);
 
+/*
+ * Decompression, and compression, of append-optimized blocks by a pool of
+ * worker threads, see gp_decompress_pool.c.
+ */
+typedef enum GpDecompressKind
+{
+	GP_DECOMPRESS_NONE,			/* not supported by the pool */
+	GP_DECOMPRESS_ZSTD,
+	GP_DECOMPRESS_ZLIB
+} GpDecompressKind;
+
+/*
+ * A block to decompress, or with 'compress' set, to compress.  When
+ * compressing, 'compressedLen' is the size of the 'compressed' buffer on
+ * input and the length of the compressed data on output.
+ */
+typedef struct GpDecompressTask
+{
+	GpDecompressKind kind;
+	bool		compress;
+	int			level;			/* compression level, if compressing */
+	uint8	   *compressed;
+	int32		compressedLen;
+	uint8	   *uncompressed;
+	int32		uncompressedLen;
+	bool		ok;				/* set by gp_decompress_pool_run() */
+} GpDecompressTask;
+
+extern GpDecompressKind gp_decompress_pool_kind(const char *compresstype);
+extern GpDecompressKind gp_compress_pool_kind(const char *compresstype, int level);
+extern void gp_decompress_pool_run(GpDecompressTask *tasks, int ntasks);
+
 /*
  * We use ZStandard compression in a few different places. These functions
  * provide support for tracking ZSTD compression/decompression contexts
@@ -65,6 +65,12 @@ typedef struct DatumStreamWrite
 
 	DatumStreamBlockWrite blockWrite;
 
+	/*
+	 * Per-block bloom filter builder, or NULL if the column doesn't have
+	 * bloomfilter_fpr set.  See access/aocsbloom.h.
+	 */
+	struct AOCSBloomBuilder *bloom;
+
 	/*
 	 * EOFs of current segment file.
 	 */
@@ -109,6 +115,12 @@ typedef struct DatumStreamRead
 		bool		isCompressed;
 	}			getBlockInfo;
 
+	/*
+	 * getBlockInfo already describes the next block, read ahead by
+	 * datumstreamread_peek_first_row(), and its content has not been read.
+	 */
+	bool		haveNextBlockInfo;
+
 	uint8	   *buffer_beginp;
 
 	/*-------------------------------------------------------------------------
@@ -242,6 +254,32 @@ datumstreamread_nth(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Row number that the next datumstreamread_advance() returns, provided the
+ * current block is not exhausted yet.
+ */
+inline static int64
+datumstreamread_next_rownum(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_None)
+		return acc->blockFirstRowNum + DatumStreamBlockRead_Nth(&acc->blockRead) + 1;
+	else if (acc->largeObjectState == DatumStreamLargeObjectState_HaveAoContent)
+		return acc->blockFirstRowNum;
+	else
+		return acc->blockFirstRowNum + 1;
+}
+
+/*
+ * Does the next datumstreamread_advance() need to read a new block of
+ * small content?
+ */
+inline static bool
+datumstreamread_block_exhausted(DatumStreamRead * acc)
+{
+	return acc->largeObjectState == DatumStreamLargeObjectState_None &&
+		DatumStreamBlockRead_Nth(&acc->blockRead) + 1 >= acc->blockRead.logical_row_count;
+}
+
 /* ------------------------------------------------------------------------------ */
 
 extern int datumstreamwrite_put(
@@ -305,6 +343,14 @@ extern int64 datumstreamwrite_block(DatumStreamWrite *ds,
 									AppendOnlyBlockDirectory *blockDirectory,
 									int columnGroupNo,
 									bool addColAction);
+struct GpDecompressTask;			/* see storage/gp_compress.h */
+extern bool datumstreamwrite_block_begin(DatumStreamWrite *ds,
+										 struct GpDecompressTask *task);
+extern int64 datumstreamwrite_block_finish(DatumStreamWrite *ds,
+										   AppendOnlyBlockDirectory *blockDirectory,
+										   int columnGroupNo,
+										   bool addColAction,
+										   struct GpDecompressTask *task);
 extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 								  Datum d,
 								  AppendOnlyBlockDirectory *blockDirectory,
@@ -313,6 +359,12 @@ extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern int	datumstreamread_block_begin(DatumStreamRead * ds,
+										AppendOnlyBlockDirectory *blockDirectory,
+										int colGroupNo,
+										struct GpDecompressTask *task);
+extern void datumstreamread_block_finish(DatumStreamRead * ds,
+										 struct GpDecompressTask *task);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
@@ -321,6 +373,8 @@ extern bool datumstreamread_find_block(DatumStreamRead * datumStream,
 						   int64 rowNum);
 extern void *datumstreamread_get_upgrade_space(DatumStreamRead *datumStream,
 											   size_t len);
+extern int64 datumstreamread_peek_first_row(DatumStreamRead * acc);
+extern bool datumstreamread_skip_to_row(DatumStreamRead * acc, int64 rowNum);
 
 /*
  * MPP-17061: make sure datumstream_read_block_info was called first for the CO block
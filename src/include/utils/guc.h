@@ -316,6 +316,7 @@ extern bool gp_enable_multiphase_limit;
  */
 extern int  gp_appendonly_compaction_threshold;
 extern int  gp_appendonly_compaction_segfile_limit;
+extern int  gp_appendonly_compaction_max_segfiles;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	debug_xlog_record_read;
 extern bool Debug_cancel_print;
@@ -627,6 +628,7 @@ extern char  *gp_default_storage_options;
 
 /* copy GUC */
 extern bool gp_enable_segment_copy_checking;
+extern bool gp_copy_parse_on_segments;
 
 extern int writable_external_table_bufsize;
 
@@ -640,6 +642,10 @@ extern bool	gp_enable_refresh_fast_path;
 
 extern bool gp_enable_predicate_pushdown;
 extern int  gp_predicate_pushdown_sample_rows;
+extern bool gp_enable_aocs_bloom_filter;
+extern bool gp_enable_aocs_late_materialization;
+extern int  gp_aocs_decompress_workers;
+extern bool gp_enable_batch_qual;
 
 extern bool gp_log_endpoints;
 
@@ -660,6 +666,7 @@ extern IndexCheckType gp_indexcheck_insert;
 #define SOPT_COMPTYPE      "compresstype"
 #define SOPT_COMPLEVEL     "compresslevel"
 #define SOPT_CHECKSUM      "checksum"
+#define SOPT_BLOOMFILTER_FPR "bloomfilter_fpr"
 
 /*
  * Functions exported by guc.c
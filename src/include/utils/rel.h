@@ -348,6 +348,8 @@ typedef struct StdRdOptions
 	int			compresslevel;  /* compression level (AO rels only) */
 	char		compresstype[NAMEDATALEN]; /* compression type (AO rels only) */
 	bool		checksum;		/* checksum (AO rels only) */
+	double		bloomfilter_fpr;	/* per-block bloom filter false positive
+									 * rate (AOCO columns only, 0 = off) */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -50,7 +50,9 @@
 		"gin_fuzzy_search_limit",
 		"gin_pending_list_limit",
 		"gp_allow_date_field_width_5digits",
+		"gp_aocs_decompress_workers",
 		"gp_appendonly_compaction",
+		"gp_appendonly_compaction_max_segfiles",
 		"gp_appendonly_compaction_segfile_limit",
 		"gp_appendonly_compaction_threshold",
 		"gp_appendonly_verify_block_checksums",
@@ -61,10 +63,15 @@
 		"gp_default_storage_options",
 		"gp_detect_data_correctness",
 		"gp_disable_tuple_hints",
+		"gp_enable_aocs_bloom_filter",
+		"gp_enable_aocs_late_materialization",
+		"gp_enable_batch_qual",
 		"gp_enable_interconnect_aggressive_retry",
+		"gp_enable_radix_sort",
 		"gp_enable_runtime_filter",
 		"gp_enable_segment_copy_checking",
 		"gp_external_enable_filter_pushdown",
+		"gp_hashjoin_role_reversal",
 		"gp_hashjoin_tuples_per_bucket",
 		"gp_ignore_error_table",
 		"gp_indexcheck_insert",
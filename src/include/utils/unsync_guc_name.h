@@ -161,6 +161,7 @@
 		"gp_command_count",
 		"gp_connection_send_timeout",
 		"gp_contentid",
+		"gp_copy_parse_on_segments",
 		"gp_cost_hashjoin_chainwalk",
 		"gp_create_table_random_default_distribution",
 		"gp_cte_sharing",
@@ -194,6 +195,7 @@
 		"gp_enable_predicate_propagation",
 		"gp_enable_predicate_pushdown",
 		"gp_enable_preunique",
+		"gp_enable_qe_plan_cache",
 		"gp_enable_query_metrics",
 		"gp_enable_refresh_fast_path",
 		"gp_enable_relsize_collection",
@@ -279,6 +281,7 @@
 		"gp_server_version_num",
 		"gp_session_id",
 		"gp_set_proc_affinity",
+		"gp_shareinput_streaming",
 		"gp_statistics_pullup_from_child_partition",
 		"gp_statistics_use_fkeys",
 		"gp_subtrans_warn_limit",
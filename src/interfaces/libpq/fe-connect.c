@@ -389,6 +389,17 @@ static const internalPQconninfoOption PQconninfoOptions[] = {
 		"Target-Session-Attrs", "", 15, /* sizeof("prefer-standby") = 15 */
 	offsetof(struct pg_conn, target_session_attrs)},
 
+#ifndef FRONTEND
+	/* Internal QD to QE communications send rows one by one */
+	{"column_batches", NULL, "off", NULL,
+		"Column-Batches", "", 5,	/* sizeof("zstd") == 5 */
+	offsetof(struct pg_conn, column_batches)},
+#else
+	{"column_batches", "PGCOLUMNBATCHES", "off", NULL,
+		"Column-Batches", "", 5,	/* sizeof("zstd") == 5 */
+	offsetof(struct pg_conn, column_batches)},
+#endif
+
     /* CDB: qExec wants some info from qDisp before GUCs are processed */
 	{"gpqeid", NULL, "", NULL,
 		"gp-debug-qeid", "D", 40,
@@ -491,6 +502,7 @@ static void pgpassfileWarning(PGconn *conn);
 static void default_threadlock(int acquire);
 static bool sslVerifyProtocolVersion(const char *version);
 static bool sslVerifyProtocolRange(const char *min, const char *max);
+static int	parse_column_batches(const char *value);
 
 
 /* global variable because fe-auth.c needs to access it */
@@ -1498,6 +1510,20 @@ connectOptions2(PGconn *conn)
 	else
 		conn->target_server_type = SERVER_TYPE_ANY;
 
+	/*
+	 * validate column_batches option
+	 */
+	if (conn->column_batches &&
+		parse_column_batches(conn->column_batches) < 0)
+	{
+		conn->status = CONNECTION_BAD;
+		appendPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("invalid %s value: \"%s\"\n"),
+						  "column_batches",
+						  conn->column_batches);
+		return false;
+	}
+
 	/*
 	 * Resolve special "auto" client_encoding from the locale
 	 */
@@ -2558,6 +2584,8 @@ keep_going:						/* We will come back to here until there is
 			conn->pversion = PG_PROTOCOL(3, 0);
 		}
 		conn->send_appname = true;
+		conn->columnBatches = conn->column_batches ?
+			parse_column_batches(conn->column_batches) : PQ_COLUMN_BATCHES_OFF;
 #ifdef USE_SSL
 		/* initialize these values based on SSL mode */
 		conn->allow_ssl_try = (conn->sslmode[0] != 'd');	/* "disable" */
@@ -3369,10 +3397,11 @@ keep_going:						/* We will come back to here until there is
 
 				/*
 				 * Validate message type: we expect only an authentication
-				 * request or an error here.  Anything else probably means
-				 * it's not Postgres on the other end at all.
+				 * request, a protocol negotiation or an error here.  Anything
+				 * else probably means it's not Postgres on the other end at
+				 * all.
 				 */
-				if (!(beresp == 'R' || beresp == 'E'))
+				if (!(beresp == 'R' || beresp == 'v' || beresp == 'E'))
 				{
 					appendPQExpBuffer(&conn->errorMessage,
 									  libpq_gettext("expected authentication request from server, but received %c\n"),
@@ -3397,7 +3426,8 @@ keep_going:						/* We will come back to here until there is
 				 * server also used the old protocol for errors that happened
 				 * before processing the startup packet.)
 				 */
-				if (beresp == 'R' && (msgLength < 8 || msgLength > 2000))
+				if ((beresp == 'R' || beresp == 'v') &&
+					(msgLength < 8 || msgLength > 2000))
 				{
 					appendPQExpBuffer(&conn->errorMessage,
 									  libpq_gettext("expected authentication request from server, but received %c\n"),
@@ -3529,6 +3559,19 @@ keep_going:						/* We will come back to here until there is
 					goto error_return;
 				}
 
+				/*
+				 * The server doesn't know some of the protocol options we
+				 * sent.  Go on without them, authentication comes next.
+				 */
+				if (beresp == 'v')
+				{
+					if (pqGetNegotiateProtocolVersion3(conn))
+						goto error_return;
+					/* OK, we read the message; mark data consumed */
+					conn->inStart = conn->inCursor;
+					goto keep_going;
+				}
+
 				/* It is an authentication request. */
 				conn->auth_req_received = true;
 
@@ -4299,6 +4342,12 @@ freePGconn(PGconn *conn)
 		free(conn->rowBuf);
 	if (conn->target_session_attrs)
 		free(conn->target_session_attrs);
+	if (conn->column_batches)
+		free(conn->column_batches);
+	if (conn->batchPos)
+		free(conn->batchPos);
+	if (conn->batchBuf)
+		free(conn->batchBuf);
 	termPQExpBuffer(&conn->errorMessage);
 	termPQExpBuffer(&conn->workBuffer);
 
@@ -7033,6 +7082,14 @@ PQpipelineStatus(const PGconn *conn)
 	return conn->pipelineStatus;
 }
 
+int
+PQcolumnBatches(const PGconn *conn)
+{
+	if (!conn || conn->status != CONNECTION_OK)
+		return 0;
+	return conn->columnBatches != PQ_COLUMN_BATCHES_OFF;
+}
+
 int
 PQconnectionNeedsPassword(const PGconn *conn)
 {
@@ -7462,6 +7519,32 @@ sslVerifyProtocolRange(const char *min, const char *max)
 }
 
 
+/*
+ * Convert a column_batches connection parameter to the PQ_COLUMN_BATCHES_xxx
+ * value to ask the server for, or -1 if it is not valid.  Without zstd we
+ * cannot read compressed batches, so don't let the server send them.
+ */
+static int
+parse_column_batches(const char *value)
+{
+	if (strlen(value) == 0 || strcmp(value, "off") == 0)
+		return PQ_COLUMN_BATCHES_OFF;
+	if (strcmp(value, "on") == 0)
+		return PQ_COLUMN_BATCHES_ON;
+	if (strcmp(value, "zstd") == 0)
+	{
+#ifdef USE_ZSTD
+		return PQ_COLUMN_BATCHES_ZSTD;
+#else
+		return PQ_COLUMN_BATCHES_ON;
+#endif
+	}
+
+	/* anything else is wrong */
+	return -1;
+}
+
+
 /*
  * Obtain user's home directory, return in given buffer
  *
@@ -52,7 +52,8 @@ char	   *const pgresStatus[] = {
 	"PGRES_COPY_BOTH",
 	"PGRES_SINGLE_TUPLE",
 	"PGRES_PIPELINE_SYNC",
-	"PGRES_PIPELINE_ABORTED"
+	"PGRES_PIPELINE_ABORTED",
+	"PGRES_COLUMN_BATCH"
 };
 
 /*
@@ -212,6 +213,7 @@ PQmakeEmptyPGresult(PGconn *conn, ExecStatusType status)
 			case PGRES_COPY_IN:
 			case PGRES_COPY_BOTH:
 			case PGRES_SINGLE_TUPLE:
+			case PGRES_COLUMN_BATCH:
 				/* non-error cases */
 				break;
 			default:
@@ -1723,8 +1725,9 @@ PQsendQueryStart(PGconn *conn, bool newQuery)
 		 */
 		pqClearAsyncResult(conn);
 
-		/* reset single-row processing mode */
+		/* reset single-row and column-batch processing modes */
 		conn->singleRowMode = false;
+		conn->columnBatchMode = false;
 
 	}
 	/* ready to send command message */
@@ -1924,12 +1927,45 @@ PQsetSingleRowMode(PGconn *conn)
 		return 0;
 	if (conn->result)
 		return 0;
+	if (conn->columnBatchMode)
+		return 0;
 
 	/* OK, set flag */
 	conn->singleRowMode = true;
 	return 1;
 }
 
+/*
+ * Select batch-by-batch processing mode, for a connection on which the
+ * server sends results in column batches
+ */
+int
+PQsetColumnBatchMode(PGconn *conn)
+{
+	/*
+	 * Only allow setting the flag when we have launched a query and not yet
+	 * received any results.
+	 */
+	if (!conn)
+		return 0;
+	if (conn->columnBatches == PQ_COLUMN_BATCHES_OFF)
+		return 0;
+	if (conn->asyncStatus != PGASYNC_BUSY)
+		return 0;
+	if (!conn->cmd_queue_head ||
+		(conn->cmd_queue_head->queryclass != PGQUERY_SIMPLE &&
+		 conn->cmd_queue_head->queryclass != PGQUERY_EXTENDED))
+		return 0;
+	if (conn->result)
+		return 0;
+	if (conn->singleRowMode)
+		return 0;
+
+	/* OK, set flag */
+	conn->columnBatchMode = true;
+	return 1;
+}
+
 /*
  * Consume any available input from the backend
  * 0 return: some kind of trouble
@@ -3059,10 +3095,11 @@ pqPipelineProcessQueue(PGconn *conn)
 	pqClearAsyncResult(conn);
 
 	/*
-	 * Reset single-row processing mode.  (Client has to set it up for each
-	 * query, if desired.)
+	 * Reset single-row and column-batch processing modes.  (Client has to
+	 * set them up for each query, if desired.)
 	 */
 	conn->singleRowMode = false;
+	conn->columnBatchMode = false;
 
 	if (conn->pipelineStatus == PQ_PIPELINE_ABORTED &&
 		conn->cmd_queue_head->queryclass != PGQUERY_SYNC)
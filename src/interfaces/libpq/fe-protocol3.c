@@ -40,6 +40,10 @@
 #include "mb/pg_wchar.h"
 #include "port/pg_bswap.h"
 
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 /*
  * This macro lists the backend message types that could be "long" (more
  * than a couple of kilobytes).
@@ -51,13 +55,14 @@
 #define VALID_LONG_MESSAGE_TYPE(id) \
 	((id) == 'T' || (id) == 'D' || (id) == 'd' || (id) == 'V' || \
 	 (id) == 'E' || (id) == 'N' || (id) == 'A' || (id) == 'Y' || \
-	 (id) == 'y' || (id) == 'o')
+	 (id) == 'y' || (id) == 'o' || (id) == 'b')
 
 
 static void handleSyncLoss(PGconn *conn, char id, int msgLength);
 static int	getRowDescriptions(PGconn *conn, int msgLength);
 static int	getParamDescriptions(PGconn *conn, int msgLength);
 static int	getAnotherTuple(PGconn *conn, int msgLength);
+static int	getColumnBatch(PGconn *conn, int msgLength);
 static int	getParameterStatus(PGconn *conn);
 static int	getNotify(PGconn *conn);
 static int	getCopyStart(PGconn *conn, ExecStatusType copytype);
@@ -439,6 +444,33 @@ pqParseInput3(PGconn *conn)
 						conn->inCursor += msgLength;
 					}
 					break;
+				case 'b':		/* Column Batch */
+					if (conn->result != NULL &&
+						conn->result->resultStatus == PGRES_TUPLES_OK)
+					{
+						/* Read a batch of tuples of a normal query response */
+						if (getColumnBatch(conn, msgLength))
+							return;
+					}
+					else if (conn->result != NULL &&
+							 conn->result->resultStatus == PGRES_FATAL_ERROR)
+					{
+						/*
+						 * We've already choked for some reason.  Just discard
+						 * tuples till we get to the end of the query.
+						 */
+						conn->inCursor += msgLength;
+					}
+					else
+					{
+						/* Set up to report error at end of query */
+						appendPQExpBufferStr(&conn->errorMessage,
+											 libpq_gettext("server sent data (\"b\" message) without prior row description (\"T\" message)\n"));
+						pqSaveErrorResult(conn);
+						/* Discard the unexpected message */
+						conn->inCursor += msgLength;
+					}
+					break;
 				case 'G':		/* Start Copy In */
 					if (getCopyStart(conn, PGRES_COPY_IN))
 						return;
@@ -1011,6 +1043,302 @@ advance_and_error:
 }
 
 
+/*
+ * parseInput subroutine to read a 'b' (column batch) message.
+ *
+ * The message holds the values of many rows, column by column.  We fill
+ * rowbuf with the column pointers of one row after another and call the row
+ * processor for each, keeping in conn->batchPos where the next value of each
+ * column is.  In single-row mode we return EOF after each row but the last,
+ * leaving the message unconsumed, so that the application gets the row
+ * before we come back for the next one.  In column-batch mode all the rows
+ * go to one PGresult of their own, made ready when the message is done.
+ * Returns: 0 if processed message successfully, EOF to suspend parsing.
+ */
+static int
+getColumnBatch(PGconn *conn, int msgLength)
+{
+	PGresult   *result = conn->result;
+	int			nfields = result->numAttributes;
+	const char *errmsg;
+	PGdataValue *rowbuf;
+	int			batchnfields;	/* # fields in the batch */
+	int			nrows;
+	char		compression;
+	const char *payload;
+	int			payloadlen;
+	int			compressedlen;
+	int		   *colend;
+	int			vlen;
+	int			i;
+
+	/* Get the header and make sure it's what we expect */
+	if (pqGetInt(&batchnfields, 2, conn) ||
+		pqGetInt(&nrows, 4, conn) ||
+		pqGetc(&compression, conn))
+	{
+		/* We should not run out of data here, so complain */
+		errmsg = libpq_gettext("insufficient data in \"b\" message");
+		goto advance_and_error;
+	}
+
+	if (batchnfields != nfields)
+	{
+		errmsg = libpq_gettext("unexpected field count in \"b\" message");
+		goto advance_and_error;
+	}
+
+	/* Resize row buffer and batch state if needed */
+	rowbuf = conn->rowBuf;
+	if (nfields > conn->rowBufLen)
+	{
+		rowbuf = (PGdataValue *) realloc(rowbuf,
+										 nfields * sizeof(PGdataValue));
+		if (!rowbuf)
+		{
+			errmsg = NULL;		/* means "out of memory", see below */
+			goto advance_and_error;
+		}
+		conn->rowBuf = rowbuf;
+		conn->rowBufLen = nfields;
+	}
+	if (nfields > conn->batchPosLen)
+	{
+		int		   *batchpos;
+
+		batchpos = (int *) realloc(conn->batchPos, 2 * nfields * sizeof(int));
+		if (!batchpos)
+		{
+			errmsg = NULL;
+			goto advance_and_error;
+		}
+		conn->batchPos = batchpos;
+		conn->batchPosLen = nfields;
+	}
+	colend = conn->batchPos + nfields;
+
+	/* Get the length of each column, which gives where the columns end */
+	payloadlen = 0;
+	for (i = 0; i < nfields; i++)
+	{
+		int			collen;
+
+		if (pqGetInt(&collen, 4, conn))
+		{
+			errmsg = libpq_gettext("insufficient data in \"b\" message");
+			goto advance_and_error;
+		}
+		if (collen < 0 || collen > PG_INT32_MAX - payloadlen)
+		{
+			errmsg = libpq_gettext("invalid column length in \"b\" message");
+			goto advance_and_error;
+		}
+		/* the first time we see this message, start at the first values */
+		if (conn->batchRow == 0)
+			conn->batchPos[i] = payloadlen;
+		payloadlen += collen;
+		colend[i] = payloadlen;
+	}
+	compressedlen = conn->inStart + 5 + msgLength - conn->inCursor;
+
+	/* Locate the values, decompressing them the first time */
+	if (compression == PQ_COLUMN_BATCH_UNCOMPRESSED)
+	{
+		if (compressedlen != payloadlen)
+		{
+			errmsg = libpq_gettext("insufficient data in \"b\" message");
+			goto advance_and_error;
+		}
+		payload = conn->inBuffer + conn->inCursor;
+	}
+#ifdef USE_ZSTD
+	else if (compression == PQ_COLUMN_BATCH_ZSTD)
+	{
+		if (conn->batchRow == 0)
+		{
+			size_t		ret;
+
+			if (payloadlen > conn->batchBufLen)
+			{
+				char	   *batchbuf = (char *) realloc(conn->batchBuf, payloadlen);
+
+				if (!batchbuf)
+				{
+					errmsg = NULL;
+					goto advance_and_error;
+				}
+				conn->batchBuf = batchbuf;
+				conn->batchBufLen = payloadlen;
+			}
+
+			ret = ZSTD_decompress(conn->batchBuf, payloadlen,
+								  conn->inBuffer + conn->inCursor,
+								  compressedlen);
+			if (ZSTD_isError(ret) || ret != payloadlen)
+			{
+				errmsg = libpq_gettext("could not decompress \"b\" message");
+				goto advance_and_error;
+			}
+		}
+		payload = conn->batchBuf;
+	}
+#endif
+	else
+	{
+		errmsg = libpq_gettext("unsupported compression in \"b\" message");
+		goto advance_and_error;
+	}
+
+	/*
+	 * In column-batch mode, collect the rows in a new PGresult; the original
+	 * conn->result is left unchanged as the template for the next batches.
+	 * pqPrepareAsyncResult() makes it active again.
+	 */
+	if (conn->columnBatchMode && conn->batchRow == 0 && nrows > 0)
+	{
+		PGresult   *res = PQcopyResult(result,
+									   PG_COPYRES_ATTRS | PG_COPYRES_EVENTS |
+									   PG_COPYRES_NOTICEHOOKS);
+
+		if (!res)
+		{
+			errmsg = NULL;
+			goto advance_and_error;
+		}
+		conn->next_result = conn->result;
+		conn->result = res;
+	}
+
+	while (conn->batchRow < nrows)
+	{
+		/* Pick the next value of each column */
+		for (i = 0; i < nfields; i++)
+		{
+			int			pos = conn->batchPos[i];
+			uint32		len;
+
+			if (colend[i] - pos < 4)
+			{
+				errmsg = libpq_gettext("insufficient data in \"b\" message");
+				goto advance_and_error;
+			}
+			memcpy(&len, payload + pos, 4);
+			vlen = (int) pg_ntoh32(len);
+			pos += 4;
+
+			rowbuf[i].len = vlen;
+			rowbuf[i].value = payload + pos;
+
+			if (vlen > 0)
+			{
+				if (colend[i] - pos < vlen)
+				{
+					errmsg = libpq_gettext("insufficient data in \"b\" message");
+					goto advance_and_error;
+				}
+				pos += vlen;
+			}
+			conn->batchPos[i] = pos;
+		}
+		conn->batchRow++;
+
+		/* Process the collected row */
+		errmsg = NULL;
+		if (!pqRowProcessor(conn, &errmsg))
+			goto advance_and_error;
+
+		/* In single-row mode, let the application have it first */
+		if (conn->singleRowMode && conn->batchRow < nrows)
+			return EOF;
+	}
+
+	/* All the values of the batch should have been used */
+	for (i = 0; i < nfields; i++)
+	{
+		if (conn->batchPos[i] != colend[i])
+		{
+			errmsg = libpq_gettext("extraneous data in \"b\" message");
+			goto advance_and_error;
+		}
+	}
+
+	if (conn->columnBatchMode && nrows > 0)
+	{
+		/* Change result status to special column-batch value */
+		conn->result->resultStatus = PGRES_COLUMN_BATCH;
+		/* And mark the result ready to return */
+		conn->asyncStatus = PGASYNC_READY_MORE;
+	}
+
+	conn->batchRow = 0;
+	conn->inCursor = conn->inStart + 5 + msgLength;
+	return 0;					/* normal, successful exit */
+
+advance_and_error:
+	conn->batchRow = 0;
+
+	/*
+	 * Replace partially constructed result with an error result, as
+	 * getAnotherTuple() does.
+	 */
+	pqClearAsyncResult(conn);
+
+	if (!errmsg)
+		errmsg = libpq_gettext("out of memory for query result");
+
+	appendPQExpBuffer(&conn->errorMessage, "%s\n", errmsg);
+	pqSaveErrorResult(conn);
+
+	/*
+	 * Show the message as fully consumed, else pqParseInput3 will overwrite
+	 * our error with a complaint about that.
+	 */
+	conn->inCursor = conn->inStart + 5 + msgLength;
+
+	return 0;
+}
+
+/*
+ * Attempt to read a NegotiateProtocolVersion message, sent by the server
+ * during startup when it doesn't know some of the protocol options in the
+ * startup packet.  We only send column_batches, which we can do without.
+ * Entry: 'v' message type and length have already been consumed.
+ * Exit: returns 0 if successfully consumed message.
+ *		 returns EOF if not enough data or the message is not valid.
+ */
+int
+pqGetNegotiateProtocolVersion3(PGconn *conn)
+{
+	int			their_version;
+	int			num;
+	int			i;
+
+	if (pqGetInt(&their_version, 4, conn) ||
+		pqGetInt(&num, 4, conn))
+		goto eof;
+
+	for (i = 0; i < num; i++)
+	{
+		if (pqGets(&conn->workBuffer, conn))
+			goto eof;
+		if (strcmp(conn->workBuffer.data, PQ_COLUMN_BATCHES_OPTION) != 0)
+		{
+			appendPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("server does not support protocol option \"%s\"\n"),
+							  conn->workBuffer.data);
+			return EOF;
+		}
+		conn->columnBatches = PQ_COLUMN_BATCHES_OFF;
+	}
+
+	return 0;
+
+eof:
+	appendPQExpBufferStr(&conn->errorMessage,
+						 libpq_gettext("received invalid protocol negotiation message\n"));
+	return EOF;
+}
+
 /*
  * Attempt to read an Error or Notice response message.
  * This is possible in several places, so we break it out as a subroutine.
@@ -2431,6 +2759,10 @@ build_startup_packet(const PGconn *conn, char *packet,
 	if (conn->gpqeid && conn->gpqeid[0])
 		ADD_STARTUP_OPTION("gpqeid", conn->gpqeid);
 
+	if (conn->columnBatches != PQ_COLUMN_BATCHES_OFF)
+		ADD_STARTUP_OPTION(PQ_COLUMN_BATCHES_OPTION,
+						   conn->columnBatches == PQ_COLUMN_BATCHES_ZSTD ? "zstd" : "on");
+
 	/* Add any environment-driven GUC settings needed */
 	for (next_eo = options; next_eo->envName; next_eo++)
 	{
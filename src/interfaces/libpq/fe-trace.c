@@ -482,6 +482,24 @@ pqTraceOutputT(FILE *f, const char *message, int *cursor, bool regress)
 	}
 }
 
+/* ColumnBatch */
+static void
+pqTraceOutputb(FILE *f, const char *message, int *cursor, int length)
+{
+	int			nfields;
+	int			i;
+
+	fprintf(f, "ColumnBatch\t");
+	nfields = pqTraceOutputInt16(f, message, cursor);
+	pqTraceOutputInt32(f, message, cursor, false);
+	pqTraceOutputByte1(f, message, cursor);
+	for (i = 0; i < nfields; i++)
+		pqTraceOutputInt32(f, message, cursor, false);
+
+	/* Drop the values, maybe compressed, to reduce the overhead of logging. */
+	*cursor = length + 1;
+}
+
 /* NegotiateProtocolVersion */
 static void
 pqTraceOutputv(FILE *f, const char *message, int *cursor)
@@ -580,6 +598,9 @@ pqTraceOutputMessage(PGconn *conn, const char *message, bool toServer)
 		case 'B':				/* Bind */
 			pqTraceOutputB(conn->Pfdebug, message, &logCursor);
 			break;
+		case 'b':				/* Column Batch */
+			pqTraceOutputb(conn->Pfdebug, message, &logCursor, length);
+			break;
 		case 'c':
 			fprintf(conn->Pfdebug, "CopyDone");
 			/* No message content */
@@ -441,6 +441,8 @@ struct pg_conn
 	char	   *ssl_min_protocol_version;	/* minimum TLS protocol version */
 	char	   *ssl_max_protocol_version;	/* maximum TLS protocol version */
 	char	   *target_session_attrs;	/* desired session properties */
+	char	   *column_batches; /* receive results in column batches (off,
+								 * on, zstd) */
 
 	/* Optional file to write trace info to */
 	FILE	   *Pfdebug;
@@ -464,6 +466,8 @@ struct pg_conn
 								 * sending semantics */
 	PGpipelineStatus pipelineStatus;	/* status of pipeline mode */
 	bool		singleRowMode;	/* return current query result row-by-row? */
+	bool		columnBatchMode;	/* return current query result
+									 * batch-by-batch? */
 	char		copy_is_binary; /* 1 = copy binary, 0 = copy text */
 	int			copy_already_done;	/* # bytes already returned in COPY OUT */
 	PGnotify   *notifyHead;		/* oldest unreported Notify msg */
@@ -501,6 +505,8 @@ struct pg_conn
 	bool		sigpipe_flag;	/* can we mask SIGPIPE via MSG_NOSIGNAL? */
 	bool		write_failed;	/* have we had a write failure on sock? */
 	char	   *write_err_msg;	/* write error message, or NULL if OOM */
+	int			columnBatches;	/* PQ_COLUMN_BATCHES_xxx asked of the server,
+								 * OFF if the server declined */
 
 	/* Transient state needed while establishing connection */
 	PGTargetServerType target_server_type;	/* desired session properties */
@@ -550,6 +556,14 @@ struct pg_conn
 	PGdataValue *rowBuf;		/* array for passing values to rowProcessor */
 	int			rowBufLen;		/* number of entries allocated in rowBuf */
 
+	/* State of the ColumnBatch message being read, see getColumnBatch() */
+	int			batchRow;		/* next row to pass to the row processor */
+	int		   *batchPos;		/* offset of the next value of each column,
+								 * followed by the end offset of each */
+	int			batchPosLen;	/* number of columns batchPos has room for */
+	char	   *batchBuf;		/* decompressed payload */
+	int			batchBufLen;	/* allocated size of batchBuf */
+
 	/* Status for asynchronous result construction */
 	PGresult   *result;			/* result being constructed */
 	PGresult   *next_result;	/* next result (used in single-row mode) */
@@ -740,6 +754,7 @@ extern char *pqBuildStartupPacket3(PGconn *conn, int *packetlen,
 								   const PQEnvironmentOption *options);
 extern void pqParseInput3(PGconn *conn);
 extern int	pqGetErrorNotice3(PGconn *conn, bool isError);
+extern int	pqGetNegotiateProtocolVersion3(PGconn *conn);
 extern void pqBuildErrorMessage3(PQExpBuffer msg, const PGresult *res,
 								 PGVerbosity verbosity, PGContextVisibility show_context);
 extern int	pqGetCopyData3(PGconn *conn, char **buffer, int async);
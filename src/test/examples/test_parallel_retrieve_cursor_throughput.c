@@ -0,0 +1,288 @@
+/*
+ * src/test/examples/test_parallel_retrieve_cursor_throughput.c
+ *
+ * this program measures how fast the results of a PARALLEL RETRIEVE CURSOR
+ * can be retrieved from all of its endpoints in parallel, one thread and one
+ * retrieve mode connection per endpoint.
+ *
+ * In the "row" format the rows are fetched as text, the way most clients
+ * read them, and every value is looked at. In the "arrow" format they come
+ * as the messages of an Arrow IPC stream, RETRIEVE ... WITH (FORMAT arrow),
+ * fetched in binary, which a client can use as they are. Run it once with
+ * each format on the same query to compare them, e.g.
+ *
+ *	test_parallel_retrieve_cursor_throughput user db "SELECT * FROM t" row
+ *	test_parallel_retrieve_cursor_throughput user db "SELECT * FROM t" arrow
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "libpq-fe.h"
+
+/* rows asked for by each RETRIEVE statement */
+#define DEFAULT_RETRIEVE_COUNT	100000
+
+typedef struct EndpointRetriever
+{
+	pthread_t	thread;
+	PGconn	   *conn;
+	char	   *endpoint_name;
+	int			index;
+
+	/* results */
+	int			failed;
+	int64_t		rows;
+	int64_t		bytes;
+} EndpointRetriever;
+
+static int	use_arrow = 0;
+static int	retrieve_count = DEFAULT_RETRIEVE_COUNT;
+
+static double
+now_seconds(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static uint64_t
+read_le(const char *p, int size)
+{
+	uint64_t	value = 0;
+	int			i;
+
+	for (i = size - 1; i >= 0; i--)
+		value = (value << 8) | (unsigned char) p[i];
+	return value;
+}
+
+/*
+ * Return the number of rows in an Arrow message, 0 for the Schema message
+ * and the end-of-stream marker. Only the Flatbuffers fields that lead to
+ * RecordBatch.length are followed, see Message.fbs in the Arrow sources.
+ */
+static int64_t
+arrow_message_rows(const char *msg, int len)
+{
+	const char *meta;
+	const char *table;
+	const char *vtable;
+
+	if (len < 8 || read_le(msg + 4, 4) == 0)
+		return 0;
+
+	meta = msg + 8;
+	table = meta + read_le(meta, 4);
+	vtable = table - (int32_t) read_le(table, 4);
+
+	/* Message.header_type is field 1, RecordBatch is 3 */
+	if (read_le(table + read_le(vtable + 6, 2), 1) != 3)
+		return 0;
+
+	/* Message.header is field 2, RecordBatch.length is field 0 */
+	table = table + read_le(vtable + 8, 2);
+	table = table + read_le(table, 4);
+	vtable = table - (int32_t) read_le(table, 4);
+	return (int64_t) read_le(table + read_le(vtable + 4, 2), 8);
+}
+
+static void *
+retrieve_endpoint_threadfunc(void *arg)
+{
+	EndpointRetriever *r = (EndpointRetriever *) arg;
+	char		sql[256];
+
+	snprintf(sql, sizeof(sql), "RETRIEVE %d FROM ENDPOINT %s%s;",
+			 retrieve_count, r->endpoint_name,
+			 use_arrow ? " WITH (FORMAT arrow)" : "");
+
+	for (;;)
+	{
+		PGresult   *res;
+		int			ntup;
+		int			nfields;
+		int			i,
+					j;
+
+		res = PQexecParams(r->conn, sql, 0, NULL, NULL, NULL, NULL,
+						   use_arrow ? 1 : 0);
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		{
+			fprintf(stderr, "RETRIEVE failed on endpoint %d: %s",
+					r->index, PQerrorMessage(r->conn));
+			PQclear(res);
+			r->failed = 1;
+			return NULL;
+		}
+
+		ntup = PQntuples(res);
+		nfields = PQnfields(res);
+		for (i = 0; i < ntup; i++)
+		{
+			if (use_arrow)
+			{
+				r->bytes += PQgetlength(res, i, 0);
+				r->rows += arrow_message_rows(PQgetvalue(res, i, 0),
+											  PQgetlength(res, i, 0));
+				continue;
+			}
+
+			/* look at every value, as a client converting them would */
+			for (j = 0; j < nfields; j++)
+				r->bytes += strlen(PQgetvalue(res, i, j));
+			r->rows++;
+		}
+		PQclear(res);
+
+		if (ntup == 0)
+			break;
+	}
+
+	return NULL;
+}
+
+static int
+exec_sql_without_resultset(PGconn *conn, const char *sql)
+{
+	PGresult   *res;
+
+	res = PQexec(conn, sql);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		fprintf(stderr, "execute sql failed: \"%s\"\nfailed %s", sql, PQerrorMessage(conn));
+		PQclear(res);
+		return 1;
+	}
+	PQclear(res);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	char	   *dbUser,
+			   *dbName,
+			   *query;
+	char	   *declare_sql;
+	PGconn	   *master_conn;
+	PGresult   *res;
+	EndpointRetriever *retrievers = NULL;
+	int			nendpoints = 0;
+	int64_t		total_rows = 0;
+	int64_t		total_bytes = 0;
+	double		start,
+				elapsed;
+	int			retVal = 1;
+	int			i;
+
+	if (argc < 5 || argc > 6 ||
+		(strcmp(argv[4], "row") != 0 && strcmp(argv[4], "arrow") != 0))
+	{
+		fprintf(stderr, "usage: %s dbUser dbName query {row|arrow} [count]\n", argv[0]);
+		fprintf(stderr, "      measure the throughput of retrieving the results of query from all the endpoints\n"
+				"      of a PARALLEL RETRIEVE CURSOR in parallel, count rows per RETRIEVE (default %d).\n",
+				DEFAULT_RETRIEVE_COUNT);
+		exit(1);
+	}
+	dbUser = argv[1];
+	dbName = argv[2];
+	query = argv[3];
+	use_arrow = (strcmp(argv[4], "arrow") == 0);
+	if (argc == 6)
+		retrieve_count = atoi(argv[5]);
+
+	master_conn = PQsetdb(NULL, NULL, NULL, NULL, dbName);
+	if (PQstatus(master_conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database \"%s\" failed: %s",
+				dbName, PQerrorMessage(master_conn));
+		exit(1);
+	}
+
+	if (exec_sql_without_resultset(master_conn, "BEGIN;"))
+		goto LABEL_FINISH;
+	declare_sql = malloc(strlen(query) + 64);
+	sprintf(declare_sql, "DECLARE bench PARALLEL RETRIEVE CURSOR FOR %s;", query);
+	if (exec_sql_without_resultset(master_conn, declare_sql))
+		goto LABEL_FINISH;
+	free(declare_sql);
+
+	res = PQexec(master_conn, "SELECT hostname, port, auth_token, endpointname "
+				 "FROM pg_catalog.gp_get_endpoints() WHERE cursorname = 'bench';");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) <= 0)
+	{
+		fprintf(stderr, "Cannot get the endpoint information: %s", PQerrorMessage(master_conn));
+		PQclear(res);
+		goto LABEL_FINISH;
+	}
+
+	nendpoints = PQntuples(res);
+	retrievers = calloc(nendpoints, sizeof(EndpointRetriever));
+	for (i = 0; i < nendpoints; i++)
+	{
+		retrievers[i].index = i;
+		retrievers[i].endpoint_name = strdup(PQgetvalue(res, i, 3));
+		retrievers[i].conn = PQsetdbLogin(PQgetvalue(res, i, 0), PQgetvalue(res, i, 1),
+										  "-c gp_retrieve_conn=true", NULL, dbName,
+										  dbUser, PQgetvalue(res, i, 2));
+		if (PQstatus(retrievers[i].conn) != CONNECTION_OK)
+		{
+			fprintf(stderr, "Connection to endpoint %d failed: %s",
+					i, PQerrorMessage(retrievers[i].conn));
+			PQclear(res);
+			goto LABEL_FINISH;
+		}
+	}
+	PQclear(res);
+
+	start = now_seconds();
+	for (i = 0; i < nendpoints; i++)
+	{
+		if (pthread_create(&retrievers[i].thread, NULL,
+						   retrieve_endpoint_threadfunc, &retrievers[i]))
+		{
+			fprintf(stderr, "cannot create thread\n");
+			exit(1);
+		}
+	}
+	for (i = 0; i < nendpoints; i++)
+		pthread_join(retrievers[i].thread, NULL);
+	elapsed = now_seconds() - start;
+
+	for (i = 0; i < nendpoints; i++)
+	{
+		if (retrievers[i].failed)
+			goto LABEL_FINISH;
+		printf("endpoint %d: %ld rows, %.1f MB\n", i, (long) retrievers[i].rows,
+			   retrievers[i].bytes / 1e6);
+		total_rows += retrievers[i].rows;
+		total_bytes += retrievers[i].bytes;
+	}
+	printf("%s format, %d endpoints: %ld rows, %.1f MB in %.2f s, %.0f rows/s, %.1f MB/s\n",
+		   use_arrow ? "arrow" : "row", nendpoints, (long) total_rows,
+		   total_bytes / 1e6, elapsed, total_rows / elapsed,
+		   total_bytes / 1e6 / elapsed);
+
+	if (exec_sql_without_resultset(master_conn, "CLOSE bench;") ||
+		exec_sql_without_resultset(master_conn, "END;"))
+		goto LABEL_FINISH;
+
+	retVal = 0;
+
+LABEL_FINISH:
+	PQfinish(master_conn);
+	for (i = 0; i < nendpoints; i++)
+	{
+		if (retrievers[i].conn)
+			PQfinish(retrievers[i].conn);
+		free(retrievers[i].endpoint_name);
+	}
+	free(retrievers);
+
+	return retVal;
+}
@@ -0,0 +1,528 @@
+/*
+ * src/test/isolation2/test_parallel_retrieve_cursor_arrow.c
+ *
+ * this program retrieves the endpoints of a PARALLEL RETRIEVE CURSOR in the
+ * Arrow format, RETRIEVE ... WITH (FORMAT arrow), and checks the streams.
+ *
+ * The rows of each RETRIEVE are fetched in binary format and concatenated,
+ * which gives an Arrow IPC stream per endpoint. Every stream is walked
+ * message by message: a Schema first, then RecordBatches, then the
+ * end-of-stream marker, and the columns of the batches are added up to be
+ * compared with what the table holds.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "libpq-fe.h"
+
+#define MASTER_CONNECT_INDEX -1
+
+/* rows in the table, and rows asked for by each RETRIEVE */
+#define NUM_ROWS		10000
+#define RETRIEVE_COUNT	3000
+
+#define ARROW_HEADER_SCHEMA			1
+#define ARROW_HEADER_RECORDBATCH	3
+
+typedef struct ArrowTotals
+{
+	int64_t		rows;
+	int64_t		id_sum;
+	int64_t		name_nulls;
+	int64_t		flag_trues;
+	double		price_sum;
+} ArrowTotals;
+
+typedef struct ArrowStream
+{
+	char	   *data;
+	size_t		len;
+	size_t		size;
+} ArrowStream;
+
+static void
+finish_conn_nicely(PGconn *master_conn, PGconn *endpoint_conns[], size_t endpoint_conns_num)
+{
+	int			i;
+
+	if (master_conn)
+		PQfinish(master_conn);
+
+	for (i = 0; i < endpoint_conns_num; i++)
+	{
+		if (endpoint_conns[i])
+			PQfinish(endpoint_conns[i]);
+	}
+
+	free(endpoint_conns);
+}
+
+static void
+check_prepare_conn(PGconn *conn, const char *dbName, int conn_idx)
+{
+	PGresult   *res;
+
+	/* check to see that the backend connection was successfully made */
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database \"%s\" failed: %s",
+				dbName, PQerrorMessage(conn));
+		exit(1);
+	}
+
+	if (conn_idx == MASTER_CONNECT_INDEX)
+	{
+		/*
+		 * Set always-secure search path, so malicous users can't take
+		 * control.
+		 */
+		res = PQexec(conn,
+					 "SELECT pg_catalog.set_config('search_path', '', false)");
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		{
+			fprintf(stderr, "SET failed: %s", PQerrorMessage(conn));
+			PQclear(res);
+			exit(1);
+		}
+		PQclear(res);
+	}
+}
+
+/* execute sql and check it is a command without result set returned */
+static int
+exec_sql_without_resultset(PGconn *conn, const char *sql, int conn_idx)
+{
+	PGresult   *res1;
+
+	if (conn_idx == MASTER_CONNECT_INDEX)
+		printf("\nExec SQL on Master:\n\t> %s\n", sql);
+	else
+		printf("\nExec SQL on EndPoint[%d]:\n\t> %s\n", conn_idx, sql);
+
+	res1 = PQexec(conn, sql);
+	if (PQresultStatus(res1) != PGRES_COMMAND_OK)
+	{
+		fprintf(stderr, "execute sql failed: \"%s\"\nfailed %s", sql, PQerrorMessage(conn));
+		PQclear(res1);
+		return 1;
+	}
+
+	PQclear(res1);
+	return 0;
+}
+
+/* execute sql and check that it fails */
+static int
+exec_sql_expect_error(PGconn *conn, const char *sql, int conn_idx)
+{
+	PGresult   *res1;
+	int			result = 0;
+
+	printf("\nExec SQL on EndPoint[%d], expecting an error:\n\t> %s\n", conn_idx, sql);
+
+	res1 = PQexec(conn, sql);
+	if (PQresultStatus(res1) != PGRES_FATAL_ERROR)
+	{
+		fprintf(stderr, "\"%s\" didn't fail\n", sql);
+		result = 1;
+	}
+	else
+		printf("%s", PQerrorMessage(conn));
+
+	PQclear(res1);
+	return result;
+}
+
+/*
+ * Read little-endian scalars, and follow Flatbuffers offsets.
+ */
+static uint64_t
+read_le(const char *p, int size)
+{
+	uint64_t	value = 0;
+	int			i;
+
+	for (i = size - 1; i >= 0; i--)
+		value = (value << 8) | (unsigned char) p[i];
+	return value;
+}
+
+static const char *
+fb_deref(const char *p)
+{
+	return p + read_le(p, 4);
+}
+
+/* return the address of a field of a table, or NULL if it is absent */
+static const char *
+fb_field(const char *table, int field)
+{
+	const char *vtable = table - (int32_t) read_le(table, 4);
+	int			vsize = read_le(vtable, 2);
+	int			off;
+
+	if (4 + 2 * field >= vsize)
+		return NULL;
+	off = read_le(vtable + 4 + 2 * field, 2);
+	return off ? table + off : NULL;
+}
+
+/* check the Schema message of the stream */
+static int
+check_schema(const char *schema)
+{
+	static const char *names[] = {"id", "name", "price", "flag"};
+	/* Int, Utf8, FloatingPoint, Bool */
+	static const int types[] = {2, 5, 3, 6};
+	const char *fields = fb_deref(fb_field(schema, 1));
+	int			i;
+
+	if (read_le(fields, 4) != 4)
+	{
+		fprintf(stderr, "expected 4 fields in the schema, got %d\n",
+				(int) read_le(fields, 4));
+		return 1;
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		const char *field = fb_deref(fields + 4 + i * 4);
+		const char *name = fb_deref(fb_field(field, 0));
+
+		if (read_le(name, 4) != strlen(names[i]) ||
+			memcmp(name + 4, names[i], strlen(names[i])) != 0 ||
+			read_le(fb_field(field, 2), 1) != types[i])
+		{
+			fprintf(stderr, "unexpected field %d in the schema\n", i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* add up the columns of a RecordBatch message */
+static int
+add_batch(const char *batch, const char *body, ArrowTotals *totals)
+{
+	int64_t		length = read_le(fb_field(batch, 0), 8);
+	const char *nodes = fb_deref(fb_field(batch, 1));
+	const char *buffers = fb_deref(fb_field(batch, 2));
+	const char *values;
+	int64_t		i;
+
+	/* id: validity, values; name: validity, offsets, values; ... */
+#define BUFFER(n)	(body + read_le(buffers + 4 + (n) * 16, 8))
+#define NULL_COUNT(n)	((int64_t) read_le(nodes + 4 + (n) * 16 + 8, 8))
+
+	if (read_le(buffers, 4) != 9 || length <= 0)
+	{
+		fprintf(stderr, "unexpected RecordBatch of %ld rows, %d buffers\n",
+				(long) length, (int) read_le(buffers, 4));
+		return 1;
+	}
+	if (NULL_COUNT(0) != 0 || NULL_COUNT(2) != 0 || NULL_COUNT(3) != 0)
+	{
+		fprintf(stderr, "unexpected nulls\n");
+		return 1;
+	}
+
+	values = BUFFER(1);
+	for (i = 0; i < length; i++)
+		totals->id_sum += (int32_t) read_le(values + i * 4, 4);
+
+	totals->name_nulls += NULL_COUNT(1);
+
+	for (i = 0; i < length; i++)
+	{
+		double		price;
+
+		memcpy(&price, BUFFER(6) + i * 8, sizeof(double));
+		totals->price_sum += price;
+	}
+
+	values = BUFFER(8);
+	for (i = 0; i < length; i++)
+		totals->flag_trues += (values[i / 8] >> (i % 8)) & 1;
+
+	totals->rows += length;
+	return 0;
+}
+
+/*
+ * Walk the messages of a stream: a Schema, RecordBatches, and the
+ * end-of-stream marker at the very end.
+ */
+static int
+check_arrow_stream(const ArrowStream *stream, ArrowTotals *totals)
+{
+	size_t		pos = 0;
+	int			nmessages = 0;
+
+	for (;;)
+	{
+		const char *p = stream->data + pos;
+		const char *message;
+		int64_t		metalen;
+		int64_t		bodylen;
+		int			headertype;
+
+		if (pos + 8 > stream->len || read_le(p, 4) != 0xFFFFFFFF)
+		{
+			fprintf(stderr, "no continuation marker at %zu\n", pos);
+			return 1;
+		}
+		metalen = read_le(p + 4, 4);
+		if (metalen == 0)
+			break;
+		if (metalen % 8 != 0)
+		{
+			fprintf(stderr, "metadata of %ld bytes is not padded\n", (long) metalen);
+			return 1;
+		}
+
+		message = fb_deref(p + 8);
+		headertype = read_le(fb_field(message, 1), 1);
+		bodylen = read_le(fb_field(message, 3), 8);
+
+		if (nmessages == 0 ? headertype != ARROW_HEADER_SCHEMA :
+			headertype != ARROW_HEADER_RECORDBATCH)
+		{
+			fprintf(stderr, "unexpected message type %d\n", headertype);
+			return 1;
+		}
+		if (headertype == ARROW_HEADER_SCHEMA)
+		{
+			if (check_schema(fb_deref(fb_field(message, 2))))
+				return 1;
+		}
+		else if (add_batch(fb_deref(fb_field(message, 2)), p + 8 + metalen, totals))
+			return 1;
+
+		pos += 8 + metalen + bodylen;
+		nmessages++;
+	}
+
+	if (pos + 8 != stream->len)
+	{
+		fprintf(stderr, "%zu bytes after the end-of-stream marker\n",
+				stream->len - pos - 8);
+		return 1;
+	}
+
+	printf("stream of %zu bytes, %d messages\n", stream->len, nmessages + 1);
+	return 0;
+}
+
+/*
+ * Retrieve all the rows of an endpoint in the Arrow format, RETRIEVE_COUNT
+ * at a time, and append them to the stream.
+ */
+static int
+retrieve_arrow_stream(PGconn *conn, const char *endpoint_name, int conn_idx,
+					  ArrowStream *stream)
+{
+	char		sql[256];
+
+	snprintf(sql, sizeof(sql),
+			 "RETRIEVE %d FROM ENDPOINT %s WITH (FORMAT arrow);",
+			 RETRIEVE_COUNT, endpoint_name);
+	printf("\nExec SQL on EndPoint[%d] until no rows:\n\t> %s\n", conn_idx, sql);
+
+	for (;;)
+	{
+		PGresult   *res1;
+		int			ntup;
+		int			i;
+
+		/* ask for binary results, the messages as they are */
+		res1 = PQexecParams(conn, sql, 0, NULL, NULL, NULL, NULL, 1);
+		if (PQresultStatus(res1) != PGRES_TUPLES_OK)
+		{
+			fprintf(stderr, "RETRIEVE failed: %s", PQerrorMessage(conn));
+			PQclear(res1);
+			return 1;
+		}
+
+		ntup = PQntuples(res1);
+		for (i = 0; i < ntup; i++)
+		{
+			size_t		len = PQgetlength(res1, i, 0);
+
+			if (stream->len + len > stream->size)
+			{
+				stream->size = (stream->len + len) * 2;
+				stream->data = realloc(stream->data, stream->size);
+			}
+			memcpy(stream->data + stream->len, PQgetvalue(res1, i, 0), len);
+			stream->len += len;
+		}
+		PQclear(res1);
+
+		if (ntup == 0)
+			break;
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	char	   *pgoptions_retrieve_mode;
+	char	   *dbName,
+			   *dbUser;
+	int			i;
+	int			retVal;			/* return value for this func */
+
+	PGconn	   *master_conn,
+			  **endpoint_conns = NULL;
+	size_t		endpoint_conns_num = 0;
+	char	  **tokens = NULL,
+			  **endpoint_names = NULL;
+	ArrowTotals totals;
+	PGresult   *res1;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s dbUser dbName\n", argv[0]);
+		fprintf(stderr, "      retrieve the endpoints of a PARALLEL RETRIEVE CURSOR in the Arrow format and check the streams.\n");
+		exit(1);
+	}
+	dbUser = argv[1];
+	dbName = argv[2];
+
+	pgoptions_retrieve_mode = "-c gp_retrieve_conn=true";	/* specify this
+															 * connection is for
+															 * retrieve only */
+
+	/* make a connection to the database */
+	master_conn = PQsetdb(NULL, NULL, NULL, NULL, dbName);
+	check_prepare_conn(master_conn, dbName, MASTER_CONNECT_INDEX);
+
+	/* do some preparation for test */
+	if (exec_sql_without_resultset(master_conn, "DROP TABLE IF EXISTS public.tab_parallel_cursor_arrow;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+	if (exec_sql_without_resultset(master_conn,
+								   "CREATE TABLE public.tab_parallel_cursor_arrow AS "
+								   "SELECT i AS id, "
+								   "CASE WHEN i % 10 = 0 THEN NULL ELSE 'name ' || i END AS name, "
+								   "i * 0.5::float8 AS price, "
+								   "i % 3 = 0 AS flag "
+								   "FROM pg_catalog.generate_series(1, 10000) i DISTRIBUTED BY (id);",
+								   MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+
+	if (exec_sql_without_resultset(master_conn, "BEGIN;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+	if (exec_sql_without_resultset(master_conn, "DECLARE myportal PARALLEL RETRIEVE CURSOR FOR select * from public.tab_parallel_cursor_arrow;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+
+	res1 = PQexec(master_conn, "select hostname,port,auth_token,endpointname from pg_catalog.gp_get_endpoints() where cursorname='myportal';");
+	if (PQresultStatus(res1) != PGRES_TUPLES_OK || PQntuples(res1) <= 0)
+	{
+		fprintf(stderr, "Cannot get the endpoint information for cursor myportal\n");
+		PQclear(res1);
+		goto LABEL_ERR;
+	}
+
+	endpoint_conns_num = PQntuples(res1);
+	endpoint_conns = calloc(endpoint_conns_num, sizeof(PGconn *));
+	tokens = calloc(endpoint_conns_num, sizeof(char *));
+	endpoint_names = calloc(endpoint_conns_num, sizeof(char *));
+
+	for (i = 0; i < endpoint_conns_num; i++)
+	{
+		char	   *host = PQgetvalue(res1, i, 0);
+		char	   *port = PQgetvalue(res1, i, 1);
+
+		tokens[i] = strdup(PQgetvalue(res1, i, 2));
+		endpoint_names[i] = strdup(PQgetvalue(res1, i, 3));
+
+		endpoint_conns[i] = PQsetdbLogin(host, port, pgoptions_retrieve_mode,
+										 NULL, dbName,
+										 dbUser, tokens[i]);
+		check_prepare_conn(endpoint_conns[i], dbName, i);
+	}
+	PQclear(res1);
+
+	memset(&totals, 0, sizeof(totals));
+	for (i = 0; i < endpoint_conns_num; i++)
+	{
+		ArrowStream stream = {NULL, 0, 0};
+		char		sql[256];
+		int			failed;
+
+		printf("\n------ Begin retrieving data from Endpoint %d# ------\n", i);
+
+		/* an unknown format is rejected before anything is retrieved */
+		snprintf(sql, sizeof(sql), "RETRIEVE ALL FROM ENDPOINT %s WITH (FORMAT parquet);",
+				 endpoint_names[i]);
+		if (exec_sql_expect_error(endpoint_conns[i], sql, i))
+			goto LABEL_ERR;
+
+		failed = retrieve_arrow_stream(endpoint_conns[i], endpoint_names[i], i, &stream) ||
+			check_arrow_stream(&stream, &totals);
+		free(stream.data);
+		if (failed)
+			goto LABEL_ERR;
+
+		/* the format of an endpoint cannot change once it is retrieved */
+		snprintf(sql, sizeof(sql), "RETRIEVE ALL FROM ENDPOINT %s;", endpoint_names[i]);
+		if (exec_sql_expect_error(endpoint_conns[i], sql, i))
+			goto LABEL_ERR;
+
+		printf("\n------ End retrieving data from Endpoint %d# ------.\n", i);
+	}
+
+	printf("\nrows: %ld, id sum: %ld, name nulls: %ld, flag trues: %ld, price sum: %.1f\n",
+		   (long) totals.rows, (long) totals.id_sum, (long) totals.name_nulls,
+		   (long) totals.flag_trues, totals.price_sum);
+	if (totals.rows != NUM_ROWS ||
+		totals.id_sum != (int64_t) NUM_ROWS * (NUM_ROWS + 1) / 2 ||
+		totals.name_nulls != NUM_ROWS / 10 ||
+		totals.flag_trues != NUM_ROWS / 3 ||
+		totals.price_sum != (double) NUM_ROWS * (NUM_ROWS + 1) / 4)
+	{
+		fprintf(stderr, "the streams don't match the table\n");
+		goto LABEL_ERR;
+	}
+
+	/* all endpoints have been fully retrieved */
+	res1 = PQexec(master_conn, "SELECT * FROM pg_catalog.gp_wait_parallel_retrieve_cursor('myportal', 0);");
+	if (PQresultStatus(res1) != PGRES_TUPLES_OK || strcmp(PQgetvalue(res1, 0, 0), "t") != 0)
+	{
+		fprintf(stderr, "the parallel retrieve cursor is not finished: %s", PQerrorMessage(master_conn));
+		PQclear(res1);
+		goto LABEL_ERR;
+	}
+	PQclear(res1);
+
+	if (exec_sql_without_resultset(master_conn, "CLOSE myportal;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+	if (exec_sql_without_resultset(master_conn, "END;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+	if (exec_sql_without_resultset(master_conn, "DROP TABLE public.tab_parallel_cursor_arrow;", MASTER_CONNECT_INDEX) != 0)
+		goto LABEL_ERR;
+
+	retVal = 0;
+	goto LABEL_FINISH;
+
+LABEL_ERR:
+	retVal = 1;
+
+LABEL_FINISH:
+	/* close the connections to the database and cleanup */
+	finish_conn_nicely(master_conn, endpoint_conns, endpoint_conns_num);
+
+	for (i = 0; i < endpoint_conns_num; i++)
+	{
+		free(tokens[i]);
+		free(endpoint_names[i]);
+	}
+	free(tokens);
+	free(endpoint_names);
+
+	return retVal;
+}
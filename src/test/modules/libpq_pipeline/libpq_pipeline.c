@@ -86,6 +86,245 @@ pg_fatal_impl(int line, const char *fmt,...)
 	exit(1);
 }
 
+/*
+ * Query results in column batches.  The query returns more rows than fit in
+ * one batch, with text values and NULLs.
+ */
+#define COLUMN_BATCH_ROWS	20000
+
+static const char *const column_batch_sql =
+"SELECT g, CASE WHEN g % 10 <> 0 THEN 'name' || g END "
+"FROM generate_series(0, 19999) g";
+
+/*
+ * Check the rows of a result of column_batch_sql, or of a FETCH from a
+ * cursor over it; *seen counts the rows checked so far.
+ */
+static void
+check_column_batch_rows(PGresult *res, int *seen)
+{
+	char		buf[32];
+	int			i;
+
+	for (i = 0; i < PQntuples(res); i++, (*seen)++)
+	{
+		/* results are in text, unless asked otherwise */
+		if (PQfformat(res, 0) != 0 || PQfformat(res, 1) != 0)
+			pg_fatal("expected text results, got format %d", PQfformat(res, 0));
+
+		snprintf(buf, sizeof(buf), "%d", *seen);
+		if (strcmp(PQgetvalue(res, i, 0), buf) != 0)
+			pg_fatal("row %d: unexpected value \"%s\"", *seen,
+					 PQgetvalue(res, i, 0));
+
+		if (*seen % 10 == 0)
+		{
+			if (!PQgetisnull(res, i, 1))
+				pg_fatal("row %d: expected null", *seen);
+		}
+		else
+		{
+			snprintf(buf, sizeof(buf), "name%d", *seen);
+			if (PQgetisnull(res, i, 1) ||
+				PQgetlength(res, i, 1) != (int) strlen(buf) ||
+				strcmp(PQgetvalue(res, i, 1), buf) != 0)
+				pg_fatal("row %d: unexpected value \"%s\"", *seen,
+						 PQgetvalue(res, i, 1));
+		}
+	}
+}
+
+/*
+ * Consume the results of the query in progress, checking its rows.  Returns
+ * the number of PGRES_COLUMN_BATCH results seen.
+ */
+static int
+consume_column_batch_results(PGconn *conn, ExecStatusType expected, int *seen)
+{
+	PGresult   *res;
+	int			nbatches = 0;
+
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		ExecStatusType est = PQresultStatus(res);
+
+		if (est == PGRES_TUPLES_OK)
+		{
+			/* the last result of row-at-a-time modes carries no rows */
+			if (expected != PGRES_TUPLES_OK && PQntuples(res) != 0)
+				pg_fatal("expected no rows in the final result, got %d",
+						 PQntuples(res));
+		}
+		else if (est != expected)
+			pg_fatal("expected %s, got %s: %s", PQresStatus(expected),
+					 PQresStatus(est), PQerrorMessage(conn));
+		else if (est == PGRES_SINGLE_TUPLE && PQntuples(res) != 1)
+			pg_fatal("expected one row, got %d", PQntuples(res));
+		else if (est == PGRES_COLUMN_BATCH)
+			nbatches++;
+
+		check_column_batch_rows(res, seen);
+		PQclear(res);
+	}
+
+	return nbatches;
+}
+
+static void
+test_column_batches(const char *conninfo)
+{
+	static const char *const modes[] = {"off", "on", "zstd"};
+	int			m;
+
+	for (m = 0; m < lengthof(modes); m++)
+	{
+		PGconn	   *conn;
+		PGresult   *res;
+		bool		batches = strcmp(modes[m], "off") != 0;
+		int			seen;
+		int			nbatches;
+		int			i;
+
+		fprintf(stderr, "column batches %s... ", modes[m]);
+
+		conn = PQconnectdb(psprintf("%s column_batches=%s", conninfo, modes[m]));
+		if (PQstatus(conn) != CONNECTION_OK)
+			pg_fatal("connection to database failed: %s", PQerrorMessage(conn));
+		if (PQcolumnBatches(conn) != batches)
+			pg_fatal("PQcolumnBatches() returned %d", PQcolumnBatches(conn));
+
+		/* all the batches end up in one result */
+		res = PQexec(conn, column_batch_sql);
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			pg_fatal("query failed: %s", PQerrorMessage(conn));
+		if (PQntuples(res) != COLUMN_BATCH_ROWS)
+			pg_fatal("expected %d rows, got %d", COLUMN_BATCH_ROWS, PQntuples(res));
+		seen = 0;
+		check_column_batch_rows(res, &seen);
+		PQclear(res);
+
+		/* single-row mode still returns one row at a time */
+		if (PQsendQuery(conn, column_batch_sql) != 1)
+			pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+		if (PQsetSingleRowMode(conn) != 1)
+			pg_fatal("PQsetSingleRowMode() failed");
+		if (PQsetColumnBatchMode(conn) != 0)
+			pg_fatal("PQsetColumnBatchMode() succeeded in single-row mode");
+		seen = 0;
+		consume_column_batch_results(conn, PGRES_SINGLE_TUPLE, &seen);
+		if (seen != COLUMN_BATCH_ROWS)
+			pg_fatal("expected %d rows, got %d", COLUMN_BATCH_ROWS, seen);
+
+		/* column-batch mode returns the batches as they come */
+		if (PQsendQuery(conn, column_batch_sql) != 1)
+			pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+		if (PQsetColumnBatchMode(conn) != batches)
+			pg_fatal("PQsetColumnBatchMode() did not return %d", batches);
+		if (batches && PQsetSingleRowMode(conn) != 0)
+			pg_fatal("PQsetSingleRowMode() succeeded in column-batch mode");
+		seen = 0;
+		nbatches = consume_column_batch_results(conn,
+												batches ? PGRES_COLUMN_BATCH : PGRES_TUPLES_OK,
+												&seen);
+		if (seen != COLUMN_BATCH_ROWS)
+			pg_fatal("expected %d rows, got %d", COLUMN_BATCH_ROWS, seen);
+		if (batches && (nbatches < 2 || nbatches >= COLUMN_BATCH_ROWS))
+			pg_fatal("expected the rows in a few batches, got %d", nbatches);
+
+		/*
+		 * Each FETCH gets its rows in a batch of its own, sent when the FETCH
+		 * ends; the last one finds no rows at all.
+		 */
+		res = PQexec(conn, "BEGIN");
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			pg_fatal("BEGIN failed: %s", PQerrorMessage(conn));
+		PQclear(res);
+		res = PQexec(conn, psprintf("DECLARE cb CURSOR FOR %s", column_batch_sql));
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			pg_fatal("DECLARE failed: %s", PQerrorMessage(conn));
+		PQclear(res);
+
+		seen = 0;
+		for (i = 0; i <= COLUMN_BATCH_ROWS / 3000 + 1; i++)
+		{
+			int			before = seen;
+			int			expected = Min(3000, COLUMN_BATCH_ROWS - before);
+
+			if (PQsendQuery(conn, "FETCH 3000 FROM cb") != 1)
+				pg_fatal("failed to send FETCH: %s", PQerrorMessage(conn));
+			if (PQsetColumnBatchMode(conn) != batches)
+				pg_fatal("PQsetColumnBatchMode() did not return %d", batches);
+			nbatches = consume_column_batch_results(conn,
+													batches ? PGRES_COLUMN_BATCH : PGRES_TUPLES_OK,
+													&seen);
+			if (seen - before != expected)
+				pg_fatal("FETCH %d: expected %d rows, got %d", i, expected,
+						 seen - before);
+			if (batches && nbatches != (expected > 0 ? 1 : 0))
+				pg_fatal("FETCH %d: expected %d batch, got %d", i,
+						 expected > 0 ? 1 : 0, nbatches);
+		}
+
+		/* a binary cursor still returns binary values */
+		res = PQexec(conn, "DECLARE cbb BINARY CURSOR FOR SELECT 42::int4");
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			pg_fatal("DECLARE failed: %s", PQerrorMessage(conn));
+		PQclear(res);
+		res = PQexec(conn, "FETCH ALL FROM cbb");
+		if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+			pg_fatal("FETCH failed: %s", PQerrorMessage(conn));
+		if (PQfformat(res, 0) != 1 || PQgetlength(res, 0, 0) != 4 ||
+			memcmp(PQgetvalue(res, 0, 0), "\0\0\0\x2a", 4) != 0)
+			pg_fatal("expected a binary int4 from the binary cursor");
+		PQclear(res);
+
+		res = PQexec(conn, "COMMIT");
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			pg_fatal("COMMIT failed: %s", PQerrorMessage(conn));
+		PQclear(res);
+
+		PQfinish(conn);
+		fprintf(stderr, "ok\n");
+	}
+}
+
+/*
+ * Connected with column_batches=on to a server that declines the option,
+ * see 001_libpq_pipeline.pl: the rows come one by one as usual.
+ */
+static void
+test_column_batches_declined(PGconn *conn)
+{
+	PGresult   *res;
+	int			nrows = 0;
+
+	fprintf(stderr, "column batches declined... ");
+
+	if (PQcolumnBatches(conn) != 0)
+		pg_fatal("PQcolumnBatches() returned %d", PQcolumnBatches(conn));
+
+	res = PQexec(conn, "SELECT generate_series(1, 3)");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 3)
+		pg_fatal("query failed: %s", PQerrorMessage(conn));
+	PQclear(res);
+
+	if (PQsendQuery(conn, "SELECT generate_series(1, 3)") != 1)
+		pg_fatal("failed to send query: %s", PQerrorMessage(conn));
+	if (PQsetColumnBatchMode(conn) != 0)
+		pg_fatal("PQsetColumnBatchMode() succeeded without column batches");
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			pg_fatal("query failed: %s", PQerrorMessage(conn));
+		nrows += PQntuples(res);
+		PQclear(res);
+	}
+	if (nrows != 3)
+		pg_fatal("expected 3 rows, got %d", nrows);
+
+	fprintf(stderr, "ok\n");
+}
+
 static void
 test_disallowed_in_pipeline(PGconn *conn)
 {
@@ -1545,6 +1784,8 @@ usage(const char *progname)
 static void
 print_test_list(void)
 {
+	printf("column_batches\n");
+	printf("column_batches_declined\n");
 	printf("disallowed_in_pipeline\n");
 	printf("multi_pipelines\n");
 	printf("nosync\n");
@@ -1642,7 +1883,11 @@ main(int argc, char **argv)
 						PQTRACE_SUPPRESS_TIMESTAMPS | PQTRACE_REGRESS_MODE);
 	}
 
-	if (strcmp(testname, "disallowed_in_pipeline") == 0)
+	if (strcmp(testname, "column_batches") == 0)
+		test_column_batches(conninfo);
+	else if (strcmp(testname, "column_batches_declined") == 0)
+		test_column_batches_declined(conn);
+	else if (strcmp(testname, "disallowed_in_pipeline") == 0)
 		test_disallowed_in_pipeline(conn);
 	else if (strcmp(testname, "multi_pipelines") == 0)
 		test_multi_pipelines(conn);
@@ -5,6 +5,7 @@ use strict;
 use warnings;
 
 use Config;
+use IO::Socket::INET;
 use PostgresNode;
 use TestLib;
 use Test::More;
@@ -23,6 +24,9 @@ mkdir "$TestLib::tmp_check/traces";
 
 for my $testname (@tests)
 {
+	# needs a server that doesn't know column batches, see below
+	next if $testname eq 'column_batches_declined';
+
 	my @extraargs = ('-r', $numrows);
 	my $cmptrace = grep(/^$testname$/,
 		qw(simple_pipeline nosync multi_pipelines prepared singlerow
@@ -58,10 +62,100 @@ for my $testname (@tests)
 	}
 }
 
+# A server that doesn't know the column_batches protocol option declines it
+# with NegotiateProtocolVersion, and libpq falls back to rows one by one.
+# Fake such a server, which answers any query with three rows.
+my $listener = IO::Socket::INET->new(
+	LocalAddr => '127.0.0.1',
+	LocalPort => 0,
+	Proto     => 'tcp',
+	Listen    => 1)
+  or die "could not listen: $!";
+my $port = $listener->sockport;
+
+my $pid = fork();
+die "fork failed: $!" unless defined $pid;
+if ($pid == 0)
+{
+	my $client = $listener->accept or exit 1;
+	serve_declining_column_batches($client);
+	exit 0;
+}
+close $listener;
+
+command_ok(
+	[
+		'libpq_pipeline', 'column_batches_declined',
+		"host=127.0.0.1 port=$port dbname=postgres sslmode=disable "
+		  . "gssencmode=disable column_batches=on"
+	],
+	"libpq_pipeline column_batches_declined");
+waitpid($pid, 0);
+is($?, 0, "column_batches_declined server");
+
 $node->stop('fast');
 
 done_testing();
 
+sub read_exactly
+{
+	my ($sock, $len) = @_;
+	my $buf = '';
+
+	while (length($buf) < $len)
+	{
+		my $n = sysread($sock, $buf, $len - length($buf), length($buf));
+		die "short read" unless $n;
+	}
+	return $buf;
+}
+
+sub send_message
+{
+	my ($sock, $type, $body) = @_;
+
+	syswrite($sock, $type . pack('N', length($body) + 4) . $body);
+}
+
+sub serve_declining_column_batches
+{
+	my $sock = shift;
+
+	# startup packet, carrying _pq_.column_batches
+	my $len = unpack('N', read_exactly($sock, 4));
+	my $startup = read_exactly($sock, $len - 4);
+	exit 1 unless $startup =~ /_pq_\.column_batches\0on\0/;
+
+	# NegotiateProtocolVersion: version 3.0, one option not recognized
+	send_message($sock, 'v', pack('NN', 0, 1) . "_pq_.column_batches\0");
+	send_message($sock, 'R', pack('N', 0));
+	send_message($sock, 'Z', 'I');
+
+	while (1)
+	{
+		my $type = read_exactly($sock, 1);
+		my $body = read_exactly($sock, unpack('N', read_exactly($sock, 4)) - 4);
+
+		last if $type eq 'X';
+		exit 1 unless $type eq 'Q';
+
+		if ($body =~ /^SET /)
+		{
+			send_message($sock, 'C', "SET\0");
+		}
+		else
+		{
+			# one int4 column in text, no ColumnBatch messages
+			send_message($sock, 'T',
+				pack('n', 1) . "g\0" . pack('NnNnNn', 0, 0, 23, 4, 0xffffffff, 0));
+			send_message($sock, 'D', pack('nN', 1, 1) . $_) for (1 .. 3);
+			send_message($sock, 'C', "SELECT 3\0");
+		}
+		send_message($sock, 'Z', 'I');
+	}
+	close $sock;
+}
+
 sub slurp_file_eval
 {
 	my $filepath = shift;
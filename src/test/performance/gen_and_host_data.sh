@@ -19,6 +19,9 @@ killall gpfdist
 sleep 5
 gpfdist -p $2 -d $MASTER_DATA_DIRECTORY/perfdataset -l $MASTER_DATA_DIRECTORY/perfdataset/gpfdist.log &
 
-# Update sql and ans file with hostname and gpfdist port
-cat ./sql/setup.sql.template | sed "s/@hostname@:@gpfdist_port@/${HOSTNAME}:${2}/" > ./sql/setup.sql
-cat ./expected/setup.out.template | sed "s/@hostname@:@gpfdist_port@/${HOSTNAME}:${2}/" > ./expected/setup.out
+# Update sql and ans files with hostname, gpfdist port and dataset directory
+for template in ./sql/*.sql.template ./expected/*.out.template; do
+  sed -e "s/@hostname@:@gpfdist_port@/${HOSTNAME}:${2}/" \
+      -e "s|@perfdataset@|$MASTER_DATA_DIRECTORY/perfdataset|" \
+      $template > ${template%.template}
+done
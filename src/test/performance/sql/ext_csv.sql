@@ -0,0 +1,2 @@
+TRUNCATE copy_parse;
+INSERT INTO copy_parse SELECT * FROM ext_base_table_csv;
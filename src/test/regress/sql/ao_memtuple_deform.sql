@@ -0,0 +1,58 @@
+--
+-- Deforming append-only row tuples with nulls spread over several bytes of
+-- the null bitmap, and columns of every alignment.
+--
+CREATE TABLE ao_deform_heap (a int, c1 int2, c2 int8, c3 text, c4 float8, c5 bool,
+  c6 char(3), c7 numeric, c8 int4, c9 date, c10 varchar, c11 int2, c12 float4,
+  c13 text, c14 int8, c15 bool, c16 timestamp, c17 int4, c18 bytea, c19 int8)
+  DISTRIBUTED BY (a);
+INSERT INTO ao_deform_heap
+  SELECT i,
+    CASE WHEN i % 2 = 0 THEN NULL ELSE i::int2 END,
+    CASE WHEN i % 3 = 0 THEN NULL ELSE i * 100000000::int8 END,
+    CASE WHEN i % 5 = 0 THEN NULL ELSE repeat('t', i % 40) END,
+    CASE WHEN i % 7 = 0 THEN NULL ELSE i / 3.0 END,
+    CASE WHEN i % 11 = 0 THEN NULL ELSE i % 2 = 1 END,
+    CASE WHEN i % 13 = 0 THEN NULL ELSE (i % 1000)::text END,
+    CASE WHEN i % 4 = 0 THEN NULL ELSE i * 1.25 END,
+    CASE WHEN i % 6 = 0 THEN NULL ELSE -i END,
+    CASE WHEN i % 8 = 0 THEN NULL ELSE '2000-01-01'::date + i END,
+    CASE WHEN i % 9 = 0 THEN NULL ELSE 'v' || i END,
+    CASE WHEN i % 10 = 0 THEN NULL ELSE (i % 300)::int2 END,
+    CASE WHEN i % 12 = 0 THEN NULL ELSE i / 8.0 END,
+    CASE WHEN i % 14 = 0 THEN NULL ELSE repeat('x', 300 + i % 10) END,
+    CASE WHEN i % 15 = 0 THEN NULL ELSE -i::int8 END,
+    CASE WHEN i % 16 = 0 THEN NULL ELSE i % 3 = 0 END,
+    CASE WHEN i % 17 = 0 THEN NULL ELSE '2000-01-01'::timestamp + i * interval '1 minute' END,
+    CASE WHEN i % 18 = 0 THEN NULL ELSE i * 7 END,
+    CASE WHEN i % 19 = 0 THEN NULL ELSE decode(md5(i::text), 'hex') END,
+    CASE WHEN i % 20 = 0 THEN NULL ELSE i::int8 END
+  FROM generate_series(1, 2000) i;
+INSERT INTO ao_deform_heap (a) VALUES (0);
+
+CREATE TABLE ao_deform_row WITH (appendonly=true, orientation=row)
+  AS SELECT * FROM ao_deform_heap DISTRIBUTED BY (a);
+
+-- Also tuples longer than 64kB, which use 4 byte offsets for their varlena
+-- attributes
+ALTER TABLE ao_deform_row ALTER COLUMN c3 SET STORAGE PLAIN;
+INSERT INTO ao_deform_heap (a, c3, c10, c19)
+  SELECT i, repeat('L', 70000 + i), 'long' || i, i FROM generate_series(2001, 2003) i;
+INSERT INTO ao_deform_row SELECT * FROM ao_deform_heap WHERE a > 2000;
+
+SELECT count(*) FROM ao_deform_row;
+SELECT count(*) FROM (SELECT * FROM ao_deform_row EXCEPT ALL SELECT * FROM ao_deform_heap) d;
+SELECT count(*) FROM (SELECT * FROM ao_deform_heap EXCEPT ALL SELECT * FROM ao_deform_row) d;
+-- The same through JIT compiled deforming, where the server supports JIT
+SET optimizer = off;
+SET jit = on;
+SET jit_above_cost = 0;
+SET jit_tuple_deforming = on;
+SELECT count(*) FROM (SELECT * FROM ao_deform_row EXCEPT ALL SELECT * FROM ao_deform_heap) d;
+SELECT count(*) FROM (SELECT * FROM ao_deform_heap EXCEPT ALL SELECT * FROM ao_deform_row) d;
+RESET jit_tuple_deforming;
+RESET jit_above_cost;
+RESET jit;
+RESET optimizer;
+DROP TABLE ao_deform_heap;
+DROP TABLE ao_deform_row;
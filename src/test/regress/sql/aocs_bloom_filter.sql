@@ -0,0 +1,77 @@
+--
+-- Per-block bloom filters on AOCS columns
+--
+CREATE TABLE aocs_bloom (id int, v int ENCODING (bloomfilter_fpr=0.01, blocksize=8192), t text)
+  WITH (appendonly=true, orientation=column) DISTRIBUTED BY (id);
+
+-- the block directory holding the filters is created with the table
+SELECT blkdirrelid <> 0 AS has_blkdir FROM pg_appendonly WHERE relid = 'aocs_bloom'::regclass;
+
+INSERT INTO aocs_bloom SELECT i, i / 100, 'row ' || i FROM generate_series(1, 100000) i;
+INSERT INTO aocs_bloom SELECT i, NULL, 'null ' || i FROM generate_series(1, 10) i;
+
+SELECT count(*) > 0 AS has_filters FROM
+  (SELECT (gp_toolkit.__gp_aoblkdir('aocs_bloom')).* FROM gp_dist_random('gp_id')) b
+  WHERE columngroup_no < 0;
+
+-- equality and IN-list quals use the filters
+SELECT count(*), min(id), max(id) FROM aocs_bloom WHERE v = 42;
+SELECT count(*), sum(id) FROM aocs_bloom WHERE v IN (7, 500, 999);
+SELECT count(*) FROM aocs_bloom WHERE v = 123456;
+SELECT count(*) FROM aocs_bloom WHERE v = 42 AND t = 'row 4250';
+SELECT count(*) FROM aocs_bloom WHERE v IS NULL;
+
+-- and skip the blocks that cannot match, as EXPLAIN ANALYZE shows
+CREATE FUNCTION aocs_bloom_skipped(query text) RETURNS bool LANGUAGE plpgsql AS $$
+DECLARE
+  ln text;
+  skipped bool := false;
+BEGIN
+  FOR ln IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+  LOOP
+    IF ln ~ 'Bloom filter skipped [1-9]' THEN
+      skipped := true;
+    END IF;
+  END LOOP;
+  RETURN skipped;
+END;
+$$;
+SELECT aocs_bloom_skipped('SELECT count(*) FROM aocs_bloom WHERE v = 42');
+SELECT aocs_bloom_skipped('SELECT count(*) FROM aocs_bloom WHERE v IN (7, 500, 999)');
+
+-- same answers without them
+SET gp_enable_aocs_bloom_filter = off;
+SELECT count(*), min(id), max(id) FROM aocs_bloom WHERE v = 42;
+SELECT count(*), sum(id) FROM aocs_bloom WHERE v IN (7, 500, 999);
+SELECT count(*) FROM aocs_bloom WHERE v = 123456;
+SELECT aocs_bloom_skipped('SELECT count(*) FROM aocs_bloom WHERE v = 42');
+RESET gp_enable_aocs_bloom_filter;
+
+-- rows deleted after the filters were built stay invisible
+DELETE FROM aocs_bloom WHERE id = 4250;
+SELECT count(*) FROM aocs_bloom WHERE v = 42;
+
+-- filters follow a table rewrite
+ALTER TABLE aocs_bloom SET WITH (reorganize=true);
+SELECT count(*) FROM aocs_bloom WHERE v = 42;
+
+-- and newly added columns
+ALTER TABLE aocs_bloom ADD COLUMN w int DEFAULT 5 ENCODING (bloomfilter_fpr=0.05);
+SELECT count(*) FROM aocs_bloom WHERE w = 5 AND v = 42;
+SELECT count(*) FROM aocs_bloom WHERE w = 6;
+
+-- bloom filtered columns read only for the rows passing the quals
+SELECT count(*), sum(w), min(t) FROM aocs_bloom WHERE v = 42;
+SELECT aocs_bloom_skipped('SELECT count(*), sum(w), min(t) FROM aocs_bloom WHERE v = 42');
+SET gp_enable_aocs_late_materialization = off;
+SELECT count(*), sum(w), min(t) FROM aocs_bloom WHERE v = 42;
+RESET gp_enable_aocs_late_materialization;
+
+-- the option is validated, and only applies to columns
+CREATE TABLE aocs_bloom_bad (a int ENCODING (bloomfilter_fpr=0.9))
+  WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+CREATE TABLE aocs_bloom_bad (a int)
+  WITH (appendonly=true, orientation=column, bloomfilter_fpr=0.01) DISTRIBUTED BY (a);
+
+DROP TABLE aocs_bloom;
+DROP FUNCTION aocs_bloom_skipped(text);
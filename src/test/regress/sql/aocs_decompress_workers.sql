@@ -0,0 +1,48 @@
+--
+-- Decompressing the blocks of an AOCS scan with worker threads
+--
+CREATE TABLE aocs_decomp (a int, b text, c numeric, d int ENCODING (compresstype=none))
+  WITH (appendonly=true, orientation=column, compresstype=zlib, compresslevel=1, blocksize=8192)
+  DISTRIBUTED BY (a);
+
+INSERT INTO aocs_decomp SELECT i, repeat('x', i % 100), i * 1.5, i % 7 FROM generate_series(1, 50000) i;
+
+SELECT count(*), sum(a), sum(length(b)), sum(c), sum(d) FROM aocs_decomp;
+
+SET gp_aocs_decompress_workers = 4;
+SELECT count(*), sum(a), sum(length(b)), sum(c), sum(d) FROM aocs_decomp;
+SELECT a, length(b), c, d FROM aocs_decomp WHERE a IN (1, 4242, 49999) ORDER BY a;
+RESET gp_aocs_decompress_workers;
+
+-- Setting the GUC back to 0 stops the threads of the QEs.  The scans and
+-- the thread counts all run in the writer QE of each segment.
+CREATE FUNCTION aocs_decomp_threads() RETURNS int LANGUAGE sql AS
+  $$ SELECT substring(pg_read_file('/proc/self/status') from 'Threads:\s*(\d+)')::int $$;
+SET gp_aocs_decompress_workers = 4;
+SELECT count(*) FROM aocs_decomp;
+SELECT sum(aocs_decomp_threads()) AS threads_with_workers FROM gp_dist_random('gp_id') \gset
+SET gp_aocs_decompress_workers = 0;
+SELECT count(*) FROM aocs_decomp;
+SELECT (:threads_with_workers - sum(aocs_decomp_threads())) / count(*) AS stopped_per_segment
+  FROM gp_dist_random('gp_id');
+RESET gp_aocs_decompress_workers;
+DROP FUNCTION aocs_decomp_threads();
+
+DROP TABLE aocs_decomp;
+
+--
+-- Compressing the blocks of a COPY into an AOCS table with the same threads.
+-- Column e has a few values larger than the blocksize.
+--
+CREATE TABLE aocs_comp (a int, b text, c numeric, d int ENCODING (compresstype=none), e text)
+  WITH (appendonly=true, orientation=column, compresstype=zlib, compresslevel=1, blocksize=8192)
+  DISTRIBUTED BY (a);
+
+SET gp_aocs_decompress_workers = 4;
+COPY aocs_comp FROM PROGRAM 'awk ''BEGIN { x = "x"; while (length(x) < 99) x = x x; y = "y"; while (length(y) < 20000) y = y y; y = substr(y, 1, 20000); for (i = 1; i <= 50000; i++) printf "%d\t%s\t%.1f\t%d\t%s\n", i, substr(x, 1, i % 100), i * 1.5, i % 7, (i % 5000 == 0 ? y : "e") }''';
+SELECT count(*), sum(a), sum(length(b)), sum(c), sum(d), sum(length(e)) FROM aocs_comp;
+SELECT a, length(b), c, d, length(e) FROM aocs_comp WHERE a IN (1, 5000, 49999) ORDER BY a;
+RESET gp_aocs_decompress_workers;
+SELECT count(*), sum(a), sum(length(b)), sum(c), sum(d), sum(length(e)) FROM aocs_comp;
+
+DROP TABLE aocs_comp;
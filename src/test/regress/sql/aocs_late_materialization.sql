@@ -0,0 +1,21 @@
+--
+-- Late materialization of AOCS columns that are not used by the quals
+--
+CREATE TABLE aocs_latemat (a int, b int, c text, d numeric)
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO aocs_latemat SELECT i, i % 1000, 'c' || i, i / 3.0 FROM generate_series(1, 100000) i;
+-- some values larger than a block
+INSERT INTO aocs_latemat SELECT i, 7, repeat('z', 20000), i FROM generate_series(100001, 100005) i;
+DELETE FROM aocs_latemat WHERE a = 3007;
+
+SELECT count(*), sum(a), sum(length(c)), round(sum(d), 2) FROM aocs_latemat WHERE b = 7;
+SELECT a, c, round(d, 2) FROM aocs_latemat WHERE b = 999 AND a > 99000 ORDER BY a;
+SELECT count(*), sum(length(c)) FROM aocs_latemat WHERE b = 7 AND a % 2 = 1;
+
+SET gp_enable_aocs_late_materialization = off;
+SELECT count(*), sum(a), sum(length(c)), round(sum(d), 2) FROM aocs_latemat WHERE b = 7;
+SELECT a, c, round(d, 2) FROM aocs_latemat WHERE b = 999 AND a > 99000 ORDER BY a;
+SELECT count(*), sum(length(c)) FROM aocs_latemat WHERE b = 7 AND a % 2 = 1;
+RESET gp_enable_aocs_late_materialization;
+
+DROP TABLE aocs_latemat;
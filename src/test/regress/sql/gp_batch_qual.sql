@@ -0,0 +1,95 @@
+-- Sequential scans evaluate comparisons of columns with constants over
+-- batches of tuples (gp_enable_batch_qual).  Check the result of each
+-- supported kind of comparison, alone and with clauses that are not
+-- batched, and the same queries with the regular evaluation.
+create table batch_qual_tbl (a int4, b int8, c date, d timestamp, e timestamptz, f float8)
+  distributed by (a);
+insert into batch_qual_tbl
+  select i, i * 1000, '2020-01-01'::date + i,
+         '2020-01-01'::timestamp + i * interval '1 hour',
+         '2020-01-01 00:00:00+00'::timestamptz + i * interval '1 minute',
+         i / 4.0
+  from generate_series(1, 1000) i;
+insert into batch_qual_tbl values (0, 0, null, null, null, 'NaN');
+insert into batch_qual_tbl values (null, null, null, null, null, null);
+select count(*) from batch_qual_tbl where a > 500;
+select count(*) from batch_qual_tbl where 500 >= a;
+select count(*) from batch_qual_tbl where b between 100000 and 200000;
+select count(*) from batch_qual_tbl where c = date '2020-02-01';
+select count(*) from batch_qual_tbl where d < timestamp '2020-01-02 00:00';
+select count(*) from batch_qual_tbl where e >= '2020-01-01 00:10:00+00';
+select count(*) from batch_qual_tbl where f > 200;
+select count(*) from batch_qual_tbl where f = 'NaN';
+select count(*) from batch_qual_tbl where f <= 1.5::float4;
+select count(*) from batch_qual_tbl where a < 3000000000;
+select count(*) from batch_qual_tbl where a < 100 and a % 2 = 0;
+-- EXPLAIN (ANALYZE, VERBOSE) shows how many rows the batch removed
+create function batch_qual_used(query text) returns bool language plpgsql as $$
+declare
+  ln text;
+  used bool := false;
+begin
+  for ln in execute 'explain (analyze, verbose, costs off, timing off, summary off) ' || query
+  loop
+    if ln ~ 'Rows Removed by Batch Filter: [1-9]' then
+      used := true;
+    end if;
+  end loop;
+  return used;
+end;
+$$;
+select batch_qual_used('select * from batch_qual_tbl where a > 500');
+set gp_enable_batch_qual = off;
+select count(*) from batch_qual_tbl where f > 200;
+select count(*) from batch_qual_tbl where a < 100 and a % 2 = 0;
+select batch_qual_used('select * from batch_qual_tbl where a > 500');
+reset gp_enable_batch_qual;
+drop table batch_qual_tbl;
+-- append-optimized tables, row and column oriented
+create table batch_qual_ao (a int, b int) with (appendonly=true) distributed by (a);
+create table batch_qual_co (a int, b int) with (appendonly=true, orientation=column)
+  distributed by (a);
+insert into batch_qual_ao select i, i % 7 from generate_series(1, 1000) i;
+insert into batch_qual_co select * from batch_qual_ao;
+select count(*) from batch_qual_ao where a > 500 and b = 3;
+select batch_qual_used('select * from batch_qual_ao where a > 500 and b = 3');
+-- column oriented scans push the qual down instead, unless that is off
+select batch_qual_used('select * from batch_qual_co where a > 500 and b = 3');
+set gp_enable_predicate_pushdown = off;
+select count(*) from batch_qual_co where a > 500 and b = 3;
+select batch_qual_used('select * from batch_qual_co where a > 500 and b = 3');
+reset gp_enable_predicate_pushdown;
+-- partitions of different table types and column layouts
+create table batch_qual_part (a int, b int, c int) distributed by (a)
+  partition by range (a) (start (0) end (1000) every (100));
+create table batch_qual_part_ao (a int, dropped int, b int, c int)
+  with (appendonly=true) distributed by (a);
+alter table batch_qual_part_ao drop column dropped;
+alter table batch_qual_part attach partition batch_qual_part_ao
+  for values from (1000) to (1100);
+insert into batch_qual_part select i, i % 50, i % 700 from generate_series(0, 1099) i;
+select count(*), sum(b) from batch_qual_part where b > 10 and c < 500;
+select count(*), sum(c) from batch_qual_part where a >= 950 and b < 5;
+-- the rows of a batch keep their table OID and TID, for tableoid and DML
+select tableoid::regclass, count(*) from batch_qual_part where b > 45
+  group by 1 order by 1;
+update batch_qual_part set c = -1 where b = 7;
+delete from batch_qual_part where b = 8;
+select tableoid::regclass, count(*) from batch_qual_part where c = -1
+  group by 1 order by 1;
+select count(*) from batch_qual_part where b = 8;
+create table batch_qual_dml (a int, b int) distributed by (a);
+create table batch_qual_dml_ao (a int, b int) with (appendonly=true) distributed by (a);
+insert into batch_qual_dml select i, i % 10 from generate_series(1, 1000) i;
+insert into batch_qual_dml_ao select * from batch_qual_dml;
+update batch_qual_dml set b = -1 where b = 3;
+delete from batch_qual_dml where b = 4;
+select b, count(*) from batch_qual_dml where b < 0 or b between 3 and 5
+  group by b order by b;
+update batch_qual_dml_ao set b = -1 where b = 3;
+delete from batch_qual_dml_ao where b = 4;
+select b, count(*) from batch_qual_dml_ao where b < 0 or b between 3 and 5
+  group by b order by b;
+drop table batch_qual_ao, batch_qual_co, batch_qual_part, batch_qual_dml,
+  batch_qual_dml_ao;
+drop function batch_qual_used(text);
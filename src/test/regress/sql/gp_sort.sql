@@ -12,3 +12,61 @@ insert into uuid_tbl values
 (0, 'ffffffffffffffffffffffffffffffff'),
 (0, '11111111111111111111111111111111');
 select * from uuid_tbl order by uid;
+
+-- Large in-memory sorts on integer-like leading keys are radix sorted.
+-- Check that they come out the same as with the comparison sort, for each
+-- kind of key, with NULLs, descending order, ties broken by a second key,
+-- abbreviated uuid keys and single-Datum sorts.
+create table radix_sort_tbl (f int, a int4, b int8, c date, d timestamp, e uuid) distributed by (f);
+insert into radix_sort_tbl
+  select 0,
+         case when i % 997 = 0 then null else (i * 7919) % 20011 - 10000 end,
+         (i::int8 * 2654435761) % 1000000007 - 500000000,
+         '2000-01-01'::date + (i * 31) % 5000,
+         '2000-01-01'::timestamp + ((i * 7717) % 100000) * interval '1 minute',
+         md5(i::text)::uuid
+  from generate_series(1, 30000) i;
+set gp_enable_radix_sort = off;
+create table radix_sort_expected as
+  select string_agg(coalesce(a::text, '-'), ',' order by a) as a_asc,
+         string_agg(coalesce(a::text, '-'), ',' order by a desc nulls last) as a_desc,
+         string_agg(b::text, ',' order by b) as b_asc,
+         array_agg(b order by b desc)::text as b_desc,
+         string_agg(c || '/' || coalesce(a::text, '-'), ',' order by c desc, a nulls first) as c_a,
+         string_agg(d::text, ',' order by d) as d_asc,
+         string_agg(e::text, ',' order by e) as e_asc
+  from radix_sort_tbl distributed randomly;
+set gp_enable_radix_sort = on;
+create table radix_sort_actual as
+  select string_agg(coalesce(a::text, '-'), ',' order by a) as a_asc,
+         string_agg(coalesce(a::text, '-'), ',' order by a desc nulls last) as a_desc,
+         string_agg(b::text, ',' order by b) as b_asc,
+         array_agg(b order by b desc)::text as b_desc,
+         string_agg(c || '/' || coalesce(a::text, '-'), ',' order by c desc, a nulls first) as c_a,
+         string_agg(d::text, ',' order by d) as d_asc,
+         string_agg(e::text, ',' order by e) as e_asc
+  from radix_sort_tbl distributed randomly;
+select e.a_asc = a.a_asc as a_asc, e.a_desc = a.a_desc as a_desc,
+       e.b_asc = a.b_asc as b_asc, e.b_desc = a.b_desc as b_desc,
+       e.c_a = a.c_a as c_a, e.d_asc = a.d_asc as d_asc,
+       e.e_asc = a.e_asc as e_asc
+  from radix_sort_expected e, radix_sort_actual a;
+-- Building a unique index still notices duplicates among equal keys
+create table radix_sort_uniq (a int, b int) distributed by (b);
+insert into radix_sort_uniq select i, 0 from generate_series(1, 5000) i;
+insert into radix_sort_uniq values (4242, 0);
+create unique index radix_sort_uniq_idx on radix_sort_uniq (a, b);
+reset gp_enable_radix_sort;
+drop table radix_sort_tbl, radix_sort_expected, radix_sort_actual, radix_sort_uniq;
+
+-- Each segment's top-N sort discards tuples that lose on the leading key
+-- against its own heap before copying them; ties on it must still be decided
+-- by the other keys.  The cutoff is per segment, not the global one.
+create table topn_tbl (a int, b int) distributed by (b);
+insert into topn_tbl select i % 10, i from generate_series(1, 10000) i;
+insert into topn_tbl values (null, 0);
+select a, b from topn_tbl order by a desc, b limit 3;
+select a, b from topn_tbl order by a, b desc limit 3;
+select a, b from topn_tbl order by a desc nulls last, b limit 2 offset 999;
+select a from topn_tbl order by a limit 3;
+drop table topn_tbl;
@@ -257,3 +257,37 @@ COPY copydisttest(id, d) FROM STDIN LOG ERRORS SEGMENT REJECT LIMIT 3;
 
 DROP TABLE copydisttest;
 DROP FUNCTION copydisttest_ignore_even();
+
+RESET test_copy_qd_qe_split;
+
+-- Enough rows to fill several chunks of frames for each QE, with errors
+-- found both in the QD (column a) and in the QEs (column b). All of them
+-- must be counted, and logged.
+CREATE TABLE copychunktest (a int, b int) DISTRIBUTED BY (a);
+\set QUIET off
+-- expect 'COPY 19973'
+COPY copychunktest FROM PROGRAM 'awk ''BEGIN { for (i = 1; i <= 20000; i++) print (i % 1000 == 0 ? "x" : i) "\t" (i % 1500 == 0 ? "y" : i) }''' LOG ERRORS SEGMENT REJECT LIMIT 100;
+\set QUIET on
+SELECT count(*), count(DISTINCT b) FROM copychunktest;
+SELECT count(*) FROM gp_read_error_log('copychunktest');
+ALTER TABLE copychunktest RENAME TO copychunkref;
+
+-- With gp_copy_parse_on_segments, the QD only cuts the input into chunks of
+-- lines. The segments parse them, and route the rows among themselves.
+CREATE TABLE copychunktest (a int, b int) DISTRIBUTED BY (a);
+SET gp_copy_parse_on_segments = on;
+\set QUIET off
+-- expect 'COPY 19973'
+COPY copychunktest FROM PROGRAM 'awk ''BEGIN { for (i = 1; i <= 20000; i++) print (i % 1000 == 0 ? "x" : i) "\t" (i % 1500 == 0 ? "y" : i) }''' LOG ERRORS SEGMENT REJECT LIMIT 100;
+\set QUIET on
+SELECT count(*) FROM gp_read_error_log('copychunktest');
+-- every row is on the segment of its distribution key, and the stage is gone
+SELECT count(*) FROM copychunktest t JOIN copychunkref r USING (a, b)
+WHERE t.gp_segment_id = r.gp_segment_id;
+SELECT count(*) FROM pg_class WHERE relname LIKE 'gp_copy_stage%';
+-- no segment reaches the limit on its own, but all of them together do
+COPY copychunktest FROM PROGRAM 'awk ''BEGIN { for (i = 1; i <= 20000; i++) print (i % 1000 == 0 ? "x" : i) "\t" (i % 1500 == 0 ? "y" : i) }''' LOG ERRORS SEGMENT REJECT LIMIT 20;
+SELECT count(*) FROM copychunktest;
+RESET gp_copy_parse_on_segments;
+DROP TABLE copychunktest;
+DROP TABLE copychunkref;
@@ -0,0 +1,60 @@
+--
+-- Plans cached in the QEs, and dispatched by id only when executed again
+--
+CREATE SCHEMA qe_plan_cache;
+SET search_path = qe_plan_cache;
+
+CREATE TABLE qpc_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO qpc_t SELECT i, i % 10 FROM generate_series(1, 1000) i;
+
+SET gp_enable_qe_plan_cache = on;
+SET plan_cache_mode = force_generic_plan;
+
+PREPARE qpc_sum(int) AS SELECT count(*), sum(a) FROM qpc_t WHERE b = $1;
+EXECUTE qpc_sum(1);
+EXECUTE qpc_sum(2);
+EXECUTE qpc_sum(3);
+
+-- A multi-slice plan
+PREPARE qpc_join(int) AS
+  SELECT count(*) FROM qpc_t t1 JOIN qpc_t t2 ON t1.b = t2.a WHERE t1.b = $1;
+EXECUTE qpc_join(4);
+EXECUTE qpc_join(5);
+
+-- Catalog changes make the plans be shipped again
+ALTER TABLE qpc_t ADD COLUMN c int DEFAULT 7;
+EXECUTE qpc_sum(1);
+PREPARE qpc_c(int) AS SELECT sum(c) FROM qpc_t WHERE b = $1;
+EXECUTE qpc_c(1);
+EXECUTE qpc_c(1);
+
+-- Errors in the QEs do not leave the QD and QEs out of sync
+PREPARE qpc_div(int) AS SELECT count(*) FROM qpc_t WHERE a / $1 > 0;
+EXECUTE qpc_div(1);
+EXECUTE qpc_div(0);
+EXECUTE qpc_div(1);
+
+-- Also when a QE fails before storing a plan, in a subtransaction that
+-- is rolled back while the QEs are kept
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+PREPARE qpc_sub(int) AS SELECT count(*) FROM qpc_t WHERE b = $1 AND a > 0;
+SELECT gp_inject_fault('exec_mpp_query_start', 'error', dbid)
+  FROM gp_segment_configuration WHERE content = 0 AND role = 'p';
+BEGIN;
+SAVEPOINT sp;
+EXECUTE qpc_sub(1);
+ROLLBACK TO SAVEPOINT sp;
+EXECUTE qpc_sub(1);
+EXECUTE qpc_sub(1);
+COMMIT;
+SELECT gp_inject_fault('exec_mpp_query_start', 'reset', dbid)
+  FROM gp_segment_configuration WHERE content = 0 AND role = 'p';
+
+-- Same results without the cache
+SET gp_enable_qe_plan_cache = off;
+EXECUTE qpc_sum(1);
+EXECUTE qpc_join(4);
+
+RESET plan_cache_mode;
+RESET gp_enable_qe_plan_cache;
+DROP SCHEMA qe_plan_cache CASCADE;
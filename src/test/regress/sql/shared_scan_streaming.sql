@@ -0,0 +1,45 @@
+--
+-- Cross-slice shared scans that stream their input to the consumers,
+-- instead of making them wait until it is all written.
+--
+CREATE SCHEMA shared_scan_streaming;
+SET search_path = shared_scan_streaming;
+
+CREATE TABLE sss_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO sss_t SELECT i, i % 1000 FROM generate_series(1, 200000) i;
+ANALYZE sss_t;
+
+SET gp_cte_sharing = on;
+
+SELECT $query$
+WITH cte AS (SELECT a, b FROM sss_t)
+SELECT count(*), sum(c1.a), sum(c2.b)
+FROM cte c1 JOIN cte c2 ON c1.b = c2.a;
+$query$ AS qry \gset
+
+-- The producer publishes several chunks of this one
+SET gp_shareinput_streaming = on;
+:qry ;
+
+-- Same result without streaming
+SET gp_shareinput_streaming = off;
+:qry ;
+
+-- Consumers that stop early must not make the producer or the other
+-- consumers hang
+SET gp_shareinput_streaming = on;
+SET statement_timeout = '60s';
+WITH cte AS (SELECT a, b FROM sss_t)
+SELECT count(*) FROM (SELECT * FROM cte c1 JOIN cte c2 ON c1.b = c2.a LIMIT 10) s;
+
+WITH cte AS (SELECT a, b FROM sss_t)
+SELECT count(*) FROM cte c1 JOIN (SELECT * FROM cte WHERE a <= 5 LIMIT 5) c2 ON c1.a = c2.b;
+RESET statement_timeout;
+
+-- An empty input publishes no chunk at all
+WITH cte AS (SELECT a, b FROM sss_t WHERE a < 0)
+SELECT count(*) FROM cte c1 JOIN cte c2 ON c1.b = c2.a;
+
+RESET gp_shareinput_streaming;
+RESET gp_cte_sharing;
+DROP SCHEMA shared_scan_streaming CASCADE;
@@ -0,0 +1,22 @@
+-- @Description Tests incremental compaction with gp_appendonly_compaction_max_segfiles.
+CREATE TABLE uao_max_segfiles (a INT, b INT) WITH (appendonly=true) distributed by (b);
+-- three segfiles of 100 tuples each
+SET gp_appendonly_insert_files = 3;
+SET gp_appendonly_insert_files_tuples_range = 100;
+INSERT INTO uao_max_segfiles SELECT i as a, 1 as b FROM generate_series(1, 300) AS i;
+RESET gp_appendonly_insert_files;
+RESET gp_appendonly_insert_files_tuples_range;
+-- hide 30%, 60% and 50% of them
+DELETE FROM uao_max_segfiles WHERE a <= 30 OR a BETWEEN 101 AND 160 OR a BETWEEN 201 AND 250;
+SELECT tupcount, state FROM gp_toolkit.__gp_aoseg('uao_max_segfiles') ORDER BY tupcount;
+
+-- only the dirtiest segfile is compacted by each vacuum
+SET gp_appendonly_compaction_max_segfiles = 1;
+VACUUM uao_max_segfiles;
+SELECT tupcount, state FROM gp_toolkit.__gp_aoseg('uao_max_segfiles') ORDER BY tupcount;
+VACUUM uao_max_segfiles;
+SELECT tupcount, state FROM gp_toolkit.__gp_aoseg('uao_max_segfiles') ORDER BY tupcount;
+RESET gp_appendonly_compaction_max_segfiles;
+VACUUM uao_max_segfiles;
+SELECT tupcount, state FROM gp_toolkit.__gp_aoseg('uao_max_segfiles') ORDER BY tupcount;
+SELECT count(*), sum(a) FROM uao_max_segfiles;
@@ -60,4 +60,58 @@ select count(1) from generate_series(1, 1000000) t1 left join generate_series(1,
 set gp_workfile_compression = off;
 select count(1) from generate_series(1, 1000000) t1 left join generate_series(1, 50000) t2 on t1 = t2;
 
+-- EXPLAIN (ANALYZE, BUFFERS) reports how much the workfiles were compressed
+create function hashjoin_spill.workfile_compressed(query text) returns bool as
+$$
+declare
+	plan jsonb;
+	result bool;
+begin
+	execute 'explain (analyze, buffers, format json) ' || query into plan;
+	select bool_or((n->>'Temp Raw Bytes')::bigint > (n->>'Temp Compressed Bytes')::bigint)
+	  into result
+	  from jsonb_path_query(plan, 'strict $.** ? (exists (@."Temp Raw Bytes"))') n;
+	return result;
+end;
+$$ language plpgsql;
+set gp_workfile_compression = on;
+select hashjoin_spill.workfile_compressed('SELECT t1.* FROM test_hj_spill AS t1 RIGHT JOIN test_hj_spill AS t2 ON t1.i1=t2.i2');
+set gp_workfile_compression = off;
+
+-- A spilled batch of an inner join whose outer side is much smaller than
+-- its inner side is built from the outer side.  The planner believes that
+-- the function returns a few rows, so it hashes its result.
+create function hashjoin_spill.many_rows(n int) returns setof int rows 10 as
+$$ begin return query select generate_series(1, n); end $$ language plpgsql;
+create table test_hj_reverse (a int, b int) distributed by (a);
+insert into test_hj_reverse select i, i from generate_series(1, 3000) i;
+set gp_hashjoin_role_reversal = on;
+select count(*), sum(r.b) from test_hj_reverse r join hashjoin_spill.many_rows(300000) m on r.a = m % 5000;
+set gp_hashjoin_role_reversal = off;
+select count(*), sum(r.b) from test_hj_reverse r join hashjoin_spill.many_rows(300000) m on r.a = m % 5000;
+reset gp_hashjoin_role_reversal;
+
+-- EXPLAIN ANALYZE tells whether that happened, also with compressed
+-- workfiles, whose size on disk is not the size of their tuples
+create function hashjoin_spill.batches_reversed(query text) returns bool as
+$$
+declare
+	line text;
+begin
+	for line in execute 'explain (analyze) ' || query loop
+		if line ~ 'Built \d+ batches from the outer side' then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+select hashjoin_spill.batches_reversed('select count(*) from test_hj_reverse r join hashjoin_spill.many_rows(300000) m on r.a = m % 5000');
+set gp_workfile_compression = on;
+select hashjoin_spill.batches_reversed('select count(*) from test_hj_reverse r join hashjoin_spill.many_rows(300000) m on r.a = m % 5000');
+set gp_workfile_compression = off;
+set gp_hashjoin_role_reversal = off;
+select hashjoin_spill.batches_reversed('select count(*) from test_hj_reverse r join hashjoin_spill.many_rows(300000) m on r.a = m % 5000');
+reset gp_hashjoin_role_reversal;
+
 drop schema hashjoin_spill cascade;